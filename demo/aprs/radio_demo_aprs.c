@@ -27,6 +27,7 @@
 static xAx25 *ax25;
 static xAx25Frame *xTxFrame;
 static xAx25Frame *xRxFrame;
+static xAx25Template *xTxTemplate;
 static int iSerialFd;
 
 /* private functions ======================================================== */
@@ -39,6 +40,7 @@ vSigIntHandler (int sig) {
   printf ("\nserial port closed.\nHave a nice day !\n");
   vAx25FrameDelete (xTxFrame);
   vAx25FrameDelete (xRxFrame);
+  vAx25TemplateDelete (xTxTemplate);
   vAx25Delete (ax25);
   vSerialClose (iSerialFd);
   exit (EXIT_SUCCESS);
@@ -54,10 +56,10 @@ vSigSendHandler (int sig) {
 
   snprintf (cInfo, 80, APRS_MSG, ++usFrameCounter);
   iInfoLen = strlen (cInfo) + 1;
-  iAx25FrameSetInfo (xTxFrame, cInfo, iInfoLen);
 
-  printf ("Send Frame: [%s]\n", xAx25FrameToStr (xTxFrame));
-  iAx25Send (ax25, xTxFrame);
+  // Only the info field is encoded, the path comes from the template
+  printf ("Send Frame: [%s]\n", cInfo);
+  iAx25TemplateSend (ax25, xTxTemplate, cInfo, iInfoLen);
 }
 
 // ------------------------------------------------------------------------------
@@ -90,6 +92,11 @@ vSetup (const char * cDev, int iBaudrate) {
   iAx25FrameSetSrc (xTxFrame, "nocall", 0);
   iAx25FrameAddRepeater (xTxFrame, "test", 0);
   iAx25FrameSetRepeaterFlag (xTxFrame, 0, true);
+  if ( (xTxTemplate = xAx25TemplateNew (xTxFrame)) == NULL) {
+
+    printf ("xAx25TemplateNew failed\n");
+    exit (EXIT_FAILURE);
+  }
 
   // Initialize the data ax25 layer on the physical layer
   ax25 = xAx25New();
@@ -0,0 +1,495 @@
+/**
+ * @file demo_replay.c
+ * @brief Replay of capture logs through the AX25 and TNC decoders
+ *
+ * The frames of capture logs (see xCapture) are encoded as an AX25 or TNC
+ * stream and fed to bAx25Poll() or iTncPoll() as fast as possible or at the
+ * recorded pace, through a pipe, a pty or directly from memory (memfd).
+ * Files which are not capture logs are fed as raw streams.
+ * The decode throughput, the per-frame latency and a digest of the decoded
+ * frames are displayed, so that the results of two builds can be compared.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <termios.h>
+#include <pty.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+
+#include <radio/ax25.h>
+#include <radio/tnc.h>
+#include <radio/crc.h>
+#include <radio/capture.h>
+
+/* constants ================================================================ */
+#define INPUT_MEM  0
+#define INPUT_PIPE 1
+#define INPUT_PTY  2
+
+#define TNC_RXBUFSIZE 1024
+
+// Maximum size of a write at full speed
+#define CHUNK_SIZE (16 * 1024)
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME  0x100000001B3ULL
+
+/* private variables ======================================================== */
+static bool bTnc;
+static bool bPace;
+static int iInput = INPUT_MEM;
+static unsigned uRepeat = 1;
+
+// Stream to replay
+static uint8_t *ucStream;
+static size_t uStreamLen;
+static size_t uStreamSize;
+static size_t *uFrameEnd;   // end offset of each frame in the stream
+static uint64_t *ullFrameTime; // recorded monotonic time of each frame
+static size_t uFrames;
+static size_t uFramesSize;
+static bool bRaw;
+
+// Time at which each frame was written by the producer
+static uint64_t *ullSent;
+
+// Slave side of the pty input
+static int iPtySlave = -1;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vUsage (const char *myname) {
+
+  printf ("usage: %s [options] file...\n"
+          "Replays capture logs (or raw streams) through the decoders.\n"
+          "  -t ax25|tnc     decoder (ax25 by default)\n"
+          "  -i mem|pipe|pty input of the decoder (mem by default)\n"
+          "  -p              replay at the recorded pace (pipe and pty)\n"
+          "  -n count        number of times the files are replayed\n",
+          myname);
+}
+
+// -----------------------------------------------------------------------------
+static uint64_t
+ullNow (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+static uint8_t *
+pucReserve (size_t len) {
+
+  if (uStreamLen + len > uStreamSize) {
+
+    uStreamSize = (uStreamLen + len) * 2;
+    ucStream = realloc (ucStream, uStreamSize);
+    if (!ucStream) {
+
+      perror ("realloc");
+      exit (EXIT_FAILURE);
+    }
+  }
+  return &ucStream[uStreamLen];
+}
+
+// -----------------------------------------------------------------------------
+static void
+vAddFrame (const uint8_t *frame, size_t len, uint64_t mono) {
+  uint8_t *p;
+
+  if (uFrames == uFramesSize) {
+
+    uFramesSize = uFramesSize ? uFramesSize * 2 : 1024;
+    uFrameEnd = realloc (uFrameEnd, uFramesSize * sizeof (size_t));
+    ullFrameTime = realloc (ullFrameTime, uFramesSize * sizeof (uint64_t));
+    if ( (!uFrameEnd) || (!ullFrameTime)) {
+
+      perror ("realloc");
+      exit (EXIT_FAILURE);
+    }
+  }
+
+  if (bTnc) {
+
+    p = pucReserve (TNC_MSG_SIZE (len));
+    uStreamLen += uTncEncode (p, frame, len);
+  }
+  else {
+    uint16_t fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, frame, len) ^ 0xFFFF;
+    uint8_t c;
+
+    // Flag, escaped frame and FCS, flag
+    p = pucReserve ( (len + 2) * 2 + 2);
+    *p++ = HDLC_FLAG;
+    for (size_t i = 0; i < len + 2; i++) {
+
+      c = (i < len) ? frame[i] : (i == len) ? (fcs & 0xFF) : (fcs >> 8);
+      if ( (c == HDLC_FLAG) || (c == HDLC_RESET) || (c == AX25_ESC)) {
+
+        *p++ = AX25_ESC;
+      }
+      *p++ = c;
+    }
+    *p++ = HDLC_FLAG;
+    uStreamLen = p - ucStream;
+  }
+  uFrameEnd[uFrames] = uStreamLen;
+  ullFrameTime[uFrames] = mono;
+  uFrames++;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vLoad (const char *file) {
+  xCaptureReader *r = xCaptureReaderNew (file);
+
+  if (r) {
+    xCaptureRecord rec;
+
+    while (iCaptureRead (r, &rec) == 1) {
+
+      vAddFrame (rec.frame, rec.len, rec.mono);
+    }
+    vCaptureReaderDelete (r);
+  }
+  else {
+    FILE *f = fopen (file, "rb");
+    size_t n;
+
+    if (!f) {
+
+      perror (file);
+      exit (EXIT_FAILURE);
+    }
+    // Raw stream, fed as is
+    do {
+
+      n = fread (pucReserve (CHUNK_SIZE), 1, CHUNK_SIZE, f);
+      uStreamLen += n;
+    }
+    while (n > 0);
+    fclose (f);
+    bRaw = true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+vWriteAll (int fd, const uint8_t *buf, size_t len) {
+
+  while (len) {
+    ssize_t n = write (fd, buf, len);
+
+    if (n < 0) {
+
+      perror ("write");
+      return;
+    }
+    buf += n;
+    len -= n;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Producer of the pipe and pty inputs
+static void *
+pvProducer (void *arg) {
+  int fd = * (int *) arg;
+  size_t total = bRaw ? 0 : uFrames * uRepeat;
+  uint64_t t0 = ullNow();
+
+  if (bRaw) {
+
+    for (unsigned r = 0; r < uRepeat; r++) {
+
+      vWriteAll (fd, ucStream, uStreamLen);
+    }
+  }
+
+  for (size_t k = 0; k < total; ) {
+    size_t i = k % uFrames;
+    size_t start = (i == 0) ? 0 : uFrameEnd[i - 1];
+    size_t end = uFrameEnd[i];
+    size_t n = 1;
+
+    if (bPace) {
+      uint64_t due = t0 + (k / uFrames) * (ullFrameTime[uFrames - 1] - ullFrameTime[0]) +
+                     ullFrameTime[i] - ullFrameTime[0];
+      uint64_t now = ullNow();
+
+      if (due > now) {
+        struct timespec ts = { (due - now) / 1000000000ULL, (due - now) % 1000000000ULL };
+
+        nanosleep (&ts, NULL);
+      }
+    }
+    else {
+
+      // Consecutive frames are grouped in a single write
+      while ( (i + n < uFrames) && (k + n < total) &&
+              (uFrameEnd[i + n] - start <= CHUNK_SIZE)) {
+        n++;
+      }
+      end = uFrameEnd[i + n - 1];
+    }
+
+    uint64_t now = ullNow();
+    for (size_t j = 0; j < n; j++) {
+
+      __atomic_store_n (&ullSent[k + j], now, __ATOMIC_RELEASE);
+    }
+    vWriteAll (fd, &ucStream[start], end - start);
+    k += n;
+  }
+
+  if (iPtySlave >= 0) {
+    int pending;
+
+    // Closing the master discards the data not yet read from the slave
+    do {
+
+      usleep (1000);
+      if ( (ioctl (fd, TIOCOUTQ, &pending) < 0) || (pending == 0)) {
+
+        if (ioctl (iPtySlave, FIONREAD, &pending) < 0) {
+          pending = 0;
+        }
+      }
+    }
+    while (pending > 0);
+  }
+  close (fd);
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static int
+iCompare (const void *a, const void *b) {
+  uint64_t x = * (const uint64_t *) a, y = * (const uint64_t *) b;
+
+  return (x > y) - (x < y);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int opt, fdin, fdout = -1;
+  pthread_t producer;
+  uint64_t t0, t1, last, digest = FNV_OFFSET;
+  uint64_t *latency;
+  size_t decoded = 0, expected;
+  unsigned long errors = 0;
+
+  while ( (opt = getopt (argc, argv, "t:i:pn:h")) != -1) {
+
+    switch (opt) {
+
+      case 't':
+        bTnc = (strcmp (optarg, "tnc") == 0);
+        break;
+      case 'i':
+        iInput = (strcmp (optarg, "pipe") == 0) ? INPUT_PIPE :
+                 (strcmp (optarg, "pty") == 0) ? INPUT_PTY : INPUT_MEM;
+        break;
+      case 'p':
+        bPace = true;
+        break;
+      case 'n':
+        uRepeat = atoi (optarg) > 0 ? atoi (optarg) : 1;
+        break;
+      default:
+        vUsage (argv[0]);
+        exit (opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if (optind >= argc) {
+
+    fprintf (stderr, "Error: you must give at least one file !\n");
+    vUsage (argv[0]);
+    exit (EXIT_FAILURE);
+  }
+
+  for (int i = optind; i < argc; i++) {
+
+    vLoad (argv[i]);
+  }
+  if (bRaw) {
+
+    // Raw streams are fed as is, the frames can not be timed
+    uFrames = 0;
+    bPace = false;
+  }
+  expected = uFrames * uRepeat;
+  ullSent = calloc (expected + 1, sizeof (uint64_t));
+  latency = calloc (expected + 1, sizeof (uint64_t));
+  if ( (!ullSent) || (!latency)) {
+
+    perror ("calloc");
+    exit (EXIT_FAILURE);
+  }
+
+  // Input of the decoder
+  if (iInput == INPUT_MEM) {
+
+    if ( (fdin = memfd_create ("radio-replay", 0)) < 0) {
+
+      perror ("memfd_create");
+      exit (EXIT_FAILURE);
+    }
+    for (unsigned r = 0; r < uRepeat; r++) {
+
+      vWriteAll (fdin, ucStream, uStreamLen);
+    }
+    lseek (fdin, 0, SEEK_SET);
+  }
+  else if (iInput == INPUT_PIPE) {
+    int io[2];
+
+    if (pipe (io) < 0) {
+
+      perror ("pipe");
+      exit (EXIT_FAILURE);
+    }
+    fdin = io[0];
+    fdout = io[1];
+  }
+  else {
+    struct termios tios;
+
+    if (openpty (&fdout, &fdin, NULL, NULL, NULL) < 0) {
+
+      perror ("openpty");
+      exit (EXIT_FAILURE);
+    }
+    tcgetattr (fdin, &tios);
+    cfmakeraw (&tios);
+    tcsetattr (fdin, TCSANOW, &tios);
+    iPtySlave = fdin;
+  }
+
+  xAx25 *ax25 = xAx25New();
+  xTnc *tnc = xTncNew (TNC_RXBUFSIZE);
+  iAx25SetFdin (ax25, fdin);
+  iTncSetFdin (tnc, fdin);
+
+  t0 = last = ullNow();
+  if (fdout >= 0) {
+
+    pthread_create (&producer, NULL, pvProducer, &fdout);
+  }
+
+  for (;;) {
+    const uint8_t *frame;
+    size_t len;
+
+    if (bTnc) {
+      int ret = iTncPoll (tnc);
+
+      if (ret == TNC_CRC_ERROR) {
+
+        errors++;
+        continue;
+      }
+      if (ret != TNC_EOT) {
+        break;
+      }
+      frame = tnc->rxbuf;
+      len = tnc->len;
+    }
+    else {
+
+      if (!bAx25Poll (ax25)) {
+        break;
+      }
+      frame = ax25->dec.buf;
+      len = ax25->dec.len - 2;
+    }
+
+    // Latency from the write of the frame, or decoding time from memory
+    uint64_t now = ullNow();
+    if (decoded < expected) {
+      uint64_t sent = __atomic_load_n (&ullSent[decoded], __ATOMIC_ACQUIRE);
+
+      latency[decoded] = (fdout >= 0) ? now - sent : now - last;
+    }
+    last = now;
+
+    for (size_t i = 0; i < len; i++) {
+
+      digest = (digest ^ frame[i]) * FNV_PRIME;
+    }
+    decoded++;
+    if (!bTnc) {
+
+      iAx25Discard (ax25);
+    }
+  }
+  t1 = ullNow();
+
+  if (fdout >= 0) {
+
+    pthread_join (producer, NULL);
+  }
+
+  double secs = (t1 - t0) / 1e9;
+  printf ("decoder     : %s from %s%s\n", bTnc ? "tnc" : "ax25",
+          iInput == INPUT_MEM ? "memory" : iInput == INPUT_PIPE ? "pipe" : "pty",
+          bPace ? " at recorded pace" : "");
+  if (bRaw) {
+
+    printf ("frames      : %zu decoded\n", decoded);
+  }
+  else {
+
+    printf ("frames      : %zu decoded / %zu sent\n", decoded, expected);
+  }
+  if (errors) {
+
+    printf ("crc errors  : %lu\n", errors);
+  }
+  printf ("time        : %.3f s\n", secs);
+  printf ("throughput  : %.0f frames/s, %.2f MB/s\n", decoded / secs,
+          (double) uStreamLen * uRepeat / secs / 1e6);
+
+  size_t n = (decoded < expected) ? decoded : expected;
+  if (n) {
+    uint64_t sum = 0;
+
+    qsort (latency, n, sizeof (uint64_t), iCompare);
+    for (size_t i = 0; i < n; i++) {
+
+      sum += latency[i];
+    }
+    printf ("%s: min %.1f avg %.1f p99 %.1f max %.1f us\n",
+            (fdout >= 0) ? "latency     " : "decode time ",
+            latency[0] / 1e3, sum / 1e3 / n, latency[ (n * 99) / 100] / 1e3,
+            latency[n - 1] / 1e3);
+  }
+  printf ("digest      : %016llx\n", (unsigned long long) digest);
+
+  vAx25Delete (ax25);
+  vTncDelete (tnc);
+  close (fdin);
+  free (latency);
+  free (ullSent);
+  free (ucStream);
+  free (uFrameEnd);
+  free (ullFrameTime);
+  return (bRaw || (decoded == expected)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/* ========================================================================== */
@@ -67,6 +67,8 @@ vSetup (const char * cDev, int iBaudrate) {
   }
 
   tnc = new Tnc(256);
+  // Les images SSDV reçues sont réassemblées par le TNC
+  tnc->enableSsdvCache();
   // Initialize the data tnc layer on the serial port
   tnc->setFdout (serial->fileno());
   tnc->setFdin  (serial->fileno());
@@ -129,7 +131,8 @@ main (int argc, char **argv) {
   for (;;) {
     int iPacketType;
 
-    iPacketType = tnc->poll();
+    // Waits for a message without spinning, the loop runs at least once per second
+    iPacketType = tnc->poll (std::chrono::seconds (1));
     switch (iPacketType) {
 
       case Tnc::APRS_PACKET:
@@ -137,6 +140,23 @@ main (int argc, char **argv) {
         break;
       case Tnc::SSDV_PACKET:
         printf ("SSDV: %d-%d\n", tnc->getSsdvImageId(), tnc->getSsdvPacketId());
+        if (tnc->isSsdvImageComplete()) {
+          static uint8_t ucJpeg[256 * 1024];
+          int iLen = tnc->getSsdvImage (ucJpeg, sizeof (ucJpeg));
+
+          if (iLen > 0) {
+            char cName[32];
+            FILE * f;
+
+            snprintf (cName, sizeof (cName), "ssdv-%d.jpg", tnc->getSsdvImageId());
+            if ( (f = fopen (cName, "wb")) != NULL) {
+
+              fwrite (ucJpeg, 1, iLen, f);
+              fclose (f);
+              printf ("SSDV: image %s complete\n", cName);
+            }
+          }
+        }
         break;
       default:
         break;
@@ -0,0 +1,245 @@
+/**
+ * @file aprs.h
+ * @brief Décodeur de paquets APRS
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_APRS_H_
+#define _SYSIO_APRS_H_
+
+#include <radio/ax25.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_aprs Décodeur APRS
+ *
+ *  Ce module décode le champ info des paquets APRS sans le copier : les
+ *  valeurs numériques sont stockées dans une structure de taille fixe et les
+ *  textes (nom, commentaire, message...) sont des vues (xAprsStr) qui pointent
+ *  dans le champ info. Aucune allocation dynamique n'est effectuée. \n
+ *  Les formats décodés sont :
+ *  - les positions non compressées, compressées et Mic-E,
+ *  - les objets et les items,
+ *  - les messages, bulletins et accusés de réception (ack/rej),
+ *  - la télémétrie,
+ *  - la météo (rapport sans position ou position avec le symbole _),
+ *  - les status.
+ *  .
+ *  Les vues ne sont valides que tant que le champ info décodé l'est.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Type of an APRS packet
+ */
+typedef enum {
+
+  APRS_UNKNOWN   = 0, ///< not decoded
+  APRS_POSITION  = 1, ///< position report
+  APRS_OBJECT    = 2, ///< object report
+  APRS_ITEM      = 3, ///< item report
+  APRS_MESSAGE   = 4, ///< message, bulletin, ack or rej
+  APRS_TELEMETRY = 5, ///< telemetry report
+  APRS_WEATHER   = 6, ///< positionless weather report
+  APRS_STATUS    = 7  ///< status report
+} eAprsType;
+
+/**
+ * Format of a position
+ */
+typedef enum {
+
+  APRS_POS_UNCOMPRESSED = 0,
+  APRS_POS_COMPRESSED   = 1,
+  APRS_POS_MICE         = 2
+} eAprsPosFormat;
+
+/**
+ * Kind of message
+ */
+typedef enum {
+
+  APRS_MSG_TEXT = 0,  ///< text message or bulletin
+  APRS_MSG_ACK  = 1,  ///< acknowledgement of the message xAprsMessage::id
+  APRS_MSG_REJ  = 2   ///< reject of the message xAprsMessage::id
+} eAprsMsgKind;
+
+/**
+ * @name Fields present in a xAprs object
+ * @{
+ */
+#define APRS_HAS_POSITION  0x0001 ///< xAprs::pos
+#define APRS_HAS_TIMESTAMP 0x0002 ///< xAprs::timestamp
+#define APRS_HAS_COURSE    0x0004 ///< xAprsPosition::course and speed
+#define APRS_HAS_ALTITUDE  0x0008 ///< xAprsPosition::altitude
+#define APRS_HAS_WEATHER   0x0010 ///< xAprs::wx
+#define APRS_HAS_MESSAGING 0x0020 ///< the station is message capable
+/**
+ * @}
+ */
+
+/**
+ * @name Fields present in a xAprsWeather object
+ * @{
+ */
+#define APRS_WX_WIND_DIR      0x0001
+#define APRS_WX_WIND_SPEED    0x0002
+#define APRS_WX_GUST          0x0004
+#define APRS_WX_TEMP          0x0008
+#define APRS_WX_RAIN_1H       0x0010
+#define APRS_WX_RAIN_24H      0x0020
+#define APRS_WX_RAIN_MIDNIGHT 0x0040
+#define APRS_WX_HUMIDITY      0x0080
+#define APRS_WX_PRESSURE      0x0100
+#define APRS_WX_LUMINOSITY    0x0200
+/**
+ * @}
+ */
+
+/**
+ * Number of analog values of a telemetry report
+ */
+#define APRS_TLM_VALUES 5
+
+//##############################################################################
+//#                                                                            #
+//#                              xAprs Class                                   #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * View on a part of the info field, not null terminated
+ */
+typedef struct xAprsStr {
+
+  const char *str;  ///< first character, NULL if not present
+  size_t len;       ///< number of characters
+} xAprsStr;
+
+/**
+ * Position
+ */
+typedef struct xAprsPosition {
+
+  double lat;         ///< latitude in degrees, positive north
+  double lon;         ///< longitude in degrees, positive east
+  uint8_t format;     ///< eAprsPosFormat
+  uint8_t ambiguity;  ///< number of digits omitted (0 to 4)
+  char symbol_table;  ///< symbol table identifier or overlay
+  char symbol_code;   ///< symbol code
+  uint16_t course;    ///< course in degrees, 0 if unknown
+  uint16_t speed;     ///< speed in knots
+  int32_t altitude;   ///< altitude in feet
+  uint8_t mice_msg;   ///< Mic-E message bits (0 to 7), 0x08 set if custom
+} xAprsPosition;
+
+/**
+ * Weather report, see APRS_WX_xxx for the units
+ */
+typedef struct xAprsWeather {
+
+  uint16_t fields;      ///< APRS_WX_xxx fields present
+  uint16_t wind_dir;    ///< wind direction in degrees
+  uint16_t wind_speed;  ///< sustained one-minute wind speed in mph
+  uint16_t gust;        ///< gust (peak wind speed in last 5 minutes) in mph
+  int16_t  temp;        ///< temperature in degrees Fahrenheit
+  uint16_t rain_1h;     ///< rainfall in the last hour in 1/100 inch
+  uint16_t rain_24h;    ///< rainfall in the last 24 hours in 1/100 inch
+  uint16_t rain_midnight; ///< rainfall since midnight in 1/100 inch
+  uint8_t  humidity;    ///< humidity in %
+  uint16_t pressure;    ///< barometric pressure in 1/10 mbar
+  uint16_t luminosity;  ///< luminosity in W/m²
+} xAprsWeather;
+
+/**
+ * Message, bulletin or acknowledgement
+ */
+typedef struct xAprsMessage {
+
+  xAprsStr addressee; ///< addressee without trailing spaces
+  xAprsStr text;      ///< text of the message
+  xAprsStr id;        ///< message number, acked or rejected number
+  uint8_t kind;       ///< eAprsMsgKind
+} xAprsMessage;
+
+/**
+ * Telemetry report
+ */
+typedef struct xAprsTelemetry {
+
+  uint16_t seq;       ///< sequence number
+  uint8_t nvalues;    ///< number of analog values decoded
+  float values[APRS_TLM_VALUES]; ///< analog values
+  bool has_bits;      ///< true if bits is present
+  uint8_t bits;       ///< digital values, first bit in the MSB
+} xAprsTelemetry;
+
+/**
+ * Decoded APRS packet
+ */
+typedef struct xAprs {
+
+  uint8_t type;       ///< eAprsType
+  char dti;           ///< data type identifier, first character of the info field
+  uint16_t flags;     ///< APRS_HAS_xxx fields present
+  xAprsStr timestamp; ///< timestamp (DDHHMMz, DDHHMM/, HHMMSSh or MMDDHHMM)
+  xAprsStr name;      ///< object or item name
+  bool killed;        ///< true if the object or item is killed
+  xAprsPosition pos;  ///< position
+  xAprsWeather wx;    ///< weather data
+  xAprsMessage msg;   ///< message
+  xAprsTelemetry tlm; ///< telemetry
+  xAprsStr comment;   ///< comment or status text
+} xAprs;
+
+/**
+ * Decode the info field of an APRS packet
+ *
+ * @param aprs object where the packet is decoded
+ * @param dst destination callsign of the frame, used by Mic-E positions, may
+ * be NULL
+ * @param info info field, not copied, the views of @a aprs point in it
+ * @param len length of the info field
+ * @return AX25_SUCCESS, AX25_INVALID_FRAME if the packet can not be decoded,
+ * the xAprs::type is then APRS_UNKNOWN
+ */
+int iAprsParse (xAprs *aprs, const char *dst, const void *info, size_t len);
+
+/**
+ * Decode an APRS packet from a frame
+ *
+ * @param aprs object where the packet is decoded
+ * @param frame decoded frame, the views of @a aprs point in its info field
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAprsParseFrame (xAprs *aprs, const xAx25Frame *frame);
+
+/**
+ * Decode an APRS packet from a view on a raw frame
+ *
+ * @param aprs object where the packet is decoded
+ * @param view view on a raw frame, the views of @a aprs point in this frame
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAprsParseView (xAprs *aprs, const xAx25View *view);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_APRS_H_ */
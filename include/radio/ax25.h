@@ -49,20 +49,35 @@
  */
 #define AX25_FRAME_BUF_LEN ((AX25_CALL_LEN+1)*(2+AX25_MAX_RPT)+AX25_INFO_LEN+4)
 
+/**
+ * Size of the buffer of the bytes read from the input at once
+ */
+#define AX25_STAGE_LEN 256
+
+/**
+ * Maximum size of a raw frame of n bytes once escaped between two flags
+ */
+#define AX25_RAW_SIZE(n) (2 * (n) + 2)
+
 /**
  * Control field: UI
- * This is the only value used in this lib so it is not possible to manage
- * frames of another type.
+ * This is the only type of frame decoded by iAx25Read(), the other frames are
+ * handled by the connected mode link (radio/link.h).
  */
 #define AX25_CTRL_UI      0x03
 
 /**
  * Protocol ID: No layer 3 protocol
- * This is the only value used in this lib so it is not possible to manage
- * frames of another type.
+ * This is the only PID accepted by iAx25Read() by default, see iAx25SetPid().
  */
 #define AX25_PID_NOLAYER3 0xF0
 
+/**
+ * Protocol ID: IPv4 and ARP
+ */
+#define AX25_PID_IP       0xCC
+#define AX25_PID_ARP      0xCD
+
 /**
  * @name HDLC flags.
  * These should be moved in
@@ -87,7 +102,10 @@ typedef enum {
   AX25_OBJECT_NOT_FOUND         = -7,
   AX25_FILE_NOT_FOUND           = -8,
   AX25_ILLEGAL_REPEATER         = -9,
-  AX25_NO_FRAME_RECEIVED        = -10
+  AX25_NO_FRAME_RECEIVED        = -10,
+  AX25_ILLEGAL_FILTER           = -11,
+  AX25_CONNECTION_REFUSED       = -12,
+  AX25_CONNECTION_LOST          = -13
 
 } eAx25Error;
 
@@ -98,12 +116,20 @@ typedef enum {
 //##############################################################################
 /**
  * AX25 Node Class
+ *
+ * The on-air encoding of the address is computed once by
+ * iAx25NodeSetCallsign() and iAx25NodeSetSsid(), iAx25NodeEncode() copies it.
+ * The callsign, ssid and flag fields can still be written directly: the
+ * address is then encoded again by iAx25NodeEncode().
  */
 typedef struct xAx25Node {
 
   char callsign[AX25_CALL_LEN+1];  ///< Callsign, max 6 character
   uint8_t ssid; ///< SSID (secondary station ID) for the call
   bool flag; ///< boolean flag: has-been-repeated, general purpose ...
+  uint8_t addr[AX25_CALL_LEN+1]; ///< on-air address, without the last and H bits
+  char addr_call[AX25_CALL_LEN]; ///< callsign encoded in addr, not null terminated
+  int8_t addr_valid; ///< 1 if addr is computed, AX25_ILLEGAL_CALLSIGN if the callsign is illegal, 0 otherwise
 } xAx25Node;
 
 /**
@@ -138,6 +164,38 @@ int iAx25NodeClear (xAx25Node *n);
  */
 int iAx25NodeSetCallsign (xAx25Node *n, const char * callsign);
 
+/**
+ * Sets the SSID of the node
+ *
+ * @param n node object to operate on.
+ * @param ssid the new SSID, from 0 to 15
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25NodeSetSsid (xAx25Node *n, uint8_t ssid);
+
+/**
+ * Sets the flag of the node
+ *
+ * @param n node object to operate on.
+ * @param flag the new flag, encoded in the H bit
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25NodeSetFlag (xAx25Node *n, bool flag);
+
+/**
+ * Encode the node address in the on-air format
+ *
+ * The callsign is converted to upper case, padded with spaces and shifted
+ * left by one bit, it is followed by the SSID byte. The address extension
+ * bit (bit 0 of the SSID byte) is cleared, the H bit is set from the flag.
+ * The address is copied from the cache of the node if it is computed.
+ *
+ * @param n node object to operate on.
+ * @param addr buffer of AX25_CALL_LEN+1 bytes where the address is stored
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25NodeEncode (const xAx25Node *n, uint8_t *addr);
+
 /**
  * Convert a node to a string for display
  *
@@ -207,6 +265,7 @@ void vAx25FrameDelete (xAx25Frame *frame);
  * src and dst are cleared with iAx25NodeClear()
  * All the repeaters are removed.
  * The ctrl is set to AX25_CTRL_UI, the pid to AX25_PID_NOLAYER3.
+ * The info field is emptied, its buffer is not cleared.
  *
  * @return AX25_SUCCESS, negative value on error
  */
@@ -283,12 +342,231 @@ int iAx25FrameFilePrint (const xAx25Frame *frame, FILE *f);
  */
 int iAx25FramePrint (const xAx25Frame *frame);
 
+//##############################################################################
+//#                                                                            #
+//#                           xAx25View Class                                  #
+//#                                                                            #
+//##############################################################################
+/**
+ * AX25 Frame View Class
+ *
+ * Gives access to the fields of a raw frame (xAx25Decoder::buf, see
+ * iAx25ReadView()) without decoding or copying it. The view points in the raw frame and is only valid as long as
+ * the frame is.
+ */
+typedef struct xAx25View {
+
+  const uint8_t *frame; ///< raw frame, starting with the destination address
+  size_t len;           ///< length of the frame without the FCS
+  uint8_t naddr;        ///< number of addresses (destination, source, repeaters)
+  uint8_t ctrl;         ///< AX25 control field
+  uint8_t pid;          ///< AX25 PID field, 0 if the frame has no PID field
+  const uint8_t *info;  ///< info field
+  size_t info_len;      ///< info field length
+} xAx25View;
+
+/**
+ * Initialize a view on a raw frame
+ *
+ * @param view view object to operate on.
+ * @param frame raw frame, starting with the destination address
+ * @param len length of the frame without the FCS
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25ViewInit (xAx25View *view, const uint8_t *frame, size_t len);
+
+/**
+ * Decode an address of a view
+ *
+ * @param view view object to operate on.
+ * @param index 0 for the destination, 1 for the source, 2 and more for the
+ * repeaters
+ * @param n node where the address is decoded
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25ViewGetNode (const xAx25View *view, unsigned index, xAx25Node *n);
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Decoder Class                               #
+//#                                                                            #
+//##############################################################################
+/**
+ * AX25 Decoder Class
+ *
+ * Decodes the HDLC framing of bytes given by the caller, whatever their
+ * origin (file descriptor, socket, USB endpoint, capture file...). All the
+ * state is in the object, the bytes can be given by spans of any length.
+ */
+typedef struct xAx25Decoder {
+
+  uint8_t buf[AX25_FRAME_BUF_LEN]; ///< frame being received, FCS included
+  size_t len;     ///< number of bytes in buf
+  uint16_t crc;   ///< CRC of the bytes in buf
+  bool sync;      ///< True if we have received a HDLC flag.
+  bool escape;    ///< True when we have to escape the following char.
+  bool ready;     ///< True if a frame is received, until it is discarded
+} xAx25Decoder;
+
+/**
+ * Create and initialize a new xAx25Decoder object
+ *
+ * This object should be deleted with vAx25DecoderDelete()
+ * @return pointer on the object, NULL on error
+ */
+xAx25Decoder * xAx25DecoderNew (void);
+
+/**
+ * Delete a xAx25Decoder object
+ *
+ * @param d object to operate on.
+ */
+void vAx25DecoderDelete (xAx25Decoder *d);
+
+/**
+ * Clear all fields of the object, for a decoder which is not allocated by
+ * xAx25DecoderNew()
+ *
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25DecoderClear (xAx25Decoder *d);
+
+/**
+ * Decode bytes
+ *
+ * The decoding stops as soon as a frame whose CRC is correct is received: the
+ * frame is in buf, it must be discarded with iAx25DecoderDiscard() before the
+ * next call, the remaining bytes being given again.
+ *
+ * @param d decoder object to operate on.
+ * @param buf received bytes
+ * @param len number of bytes in buf
+ * @param used number of bytes decoded, may be NULL
+ * @return true if a frame is received
+ */
+bool bAx25DecoderFeed (xAx25Decoder *d, const void *buf, size_t len, size_t *used);
+
+/**
+ * Gives a view on the frame received
+ *
+ * @param d decoder object to operate on.
+ * @param view view on the frame, valid until the frame is discarded
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25DecoderView (const xAx25Decoder *d, xAx25View *view);
+
+/**
+ * Release the frame received, the decoding can go on
+ *
+ * @param d decoder object to operate on.
+ * @return AX25_SUCCESS, AX25_NO_FRAME_RECEIVED if no frame is received
+ */
+int iAx25DecoderDiscard (xAx25Decoder *d);
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Encoder Class                               #
+//#                                                                            #
+//##############################################################################
+/**
+ * AX25 Encoder Class
+ *
+ * Encodes a frame in the HDLC framing into buffers of the caller. The
+ * encoding can be resumed across calls when the buffer is smaller than the
+ * encoded frame, the number of bytes still to be produced is known up front.
+ */
+typedef struct xAx25Encoder {
+
+  uint8_t frame[AX25_FRAME_BUF_LEN]; ///< raw frame, FCS included
+  size_t len;     ///< length of the raw frame
+  size_t pos;     ///< index of the next byte of frame to encode
+  size_t size;    ///< number of bytes not yet produced
+  bool flag;      ///< True when the opening flag is produced
+  bool escape;    ///< True when the escape character of frame[pos] is produced
+} xAx25Encoder;
+
+/**
+ * Create and initialize a new xAx25Encoder object
+ *
+ * This object should be deleted with vAx25EncoderDelete()
+ * @return pointer on the object, NULL on error
+ */
+xAx25Encoder * xAx25EncoderNew (void);
+
+/**
+ * Delete a xAx25Encoder object
+ *
+ * @param e object to operate on.
+ */
+void vAx25EncoderDelete (xAx25Encoder *e);
+
+/**
+ * Clear all fields of the object, for an encoder which is not allocated by
+ * xAx25EncoderNew()
+ *
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25EncoderClear (xAx25Encoder *e);
+
+/**
+ * Sets the frame to encode, the FCS is computed
+ *
+ * The previous frame is dropped if it was not entirely produced.
+ *
+ * @param e encoder object to operate on.
+ * @param frame frame to encode
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25EncoderSetFrame (xAx25Encoder *e, const xAx25Frame *frame);
+
+/**
+ * Sets the raw frame to encode
+ *
+ * @param e encoder object to operate on.
+ * @param frame raw frame from the destination address to the FCS included
+ * @param len length of the frame, FCS included
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25EncoderSetRaw (xAx25Encoder *e, const uint8_t *frame, size_t len);
+
+/**
+ * Number of bytes still to be produced by uAx25EncoderRead()
+ *
+ * @param e encoder object to operate on.
+ */
+size_t uAx25EncoderSize (const xAx25Encoder *e);
+
+/**
+ * Produce the encoded frame
+ *
+ * @param e encoder object to operate on.
+ * @param out buffer where the bytes are stored
+ * @param size size of out
+ * @return number of bytes stored, 0 when the frame is entirely produced
+ */
+size_t uAx25EncoderRead (xAx25Encoder *e, void *out, size_t size);
+
 //##############################################################################
 //#                                                                            #
 //#                             xAx25 Class                                    #
 //#                                                                            #
 //##############################################################################
 
+struct xAx25Filter;
+struct xAx25;
+
+/**
+ * Handler called for each frame received
+ *
+ * The view points in the receive buffer of the controller and is only valid
+ * until the handler returns: the frame must be copied to be kept.
+ *
+ * @param ax25 AX25 object which received the frame
+ * @param frame view on the frame received, without the FCS
+ * @param ctx context given to iAx25SetRxHandler()
+ */
+typedef void (*vAx25RxHandler) (struct xAx25 *ax25, const xAx25View *frame, void *ctx);
+
 /**
  * AX25 Controller Class
  */
@@ -296,14 +574,20 @@ typedef struct xAx25 {
 
   int fin;      ///< stream used to access the physical input
   int fout;     ///< stream used to access the physical output
-  uint8_t buf[AX25_FRAME_BUF_LEN]; ///< buffer for payload
-  size_t  len;    ///< buffer length
-  uint16_t crc_in;  ///< CRC for current received frame
-  uint16_t crc_out; ///< CRC of current sent frame
-  bool sync;      ///< True if we have received a HDLC flag.
-  bool escape;    ///< True when we have to escape the following char.
+  xAx25Decoder dec; ///< decoder of the received bytes
   bool frm_recv;  ///< True if we have received a valid frame
   int error;
+  const struct xAx25Filter *filter; ///< filter applied to received frames
+  struct xCapture *capture; ///< log of the received frames
+  struct xPcap *pcap; ///< pcap export of the received frames
+  uint16_t port;  ///< port number recorded in the capture log and pcap file
+  uint8_t stage[AX25_STAGE_LEN]; ///< bytes read from the input not yet decoded
+  size_t stage_pos; ///< index of the next byte to decode in stage
+  size_t stage_len; ///< number of bytes in stage
+  vAx25RxHandler rx_handler; ///< handler of the received frames, NULL if none
+  void *rx_ctx;   ///< context given to rx_handler
+  unsigned long rx_frames; ///< number of frames given to rx_handler
+  uint8_t pid[32];  ///< bitmap of the PID accepted by iAx25Read()
 } xAx25;
 
 /**
@@ -344,6 +628,89 @@ int iAx25SetFdin (xAx25 *p, int fdin);
  */
 int iAx25SetFdout (xAx25 *p, int fdout);
 
+/**
+ * Sets the filter applied to received frames
+ *
+ * Frames rejected by the filter are discarded by bAx25Poll() before being
+ * decoded. The filter object is not copied and must remain valid as long as
+ * it is used.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param filter compiled filter, NULL to accept all frames
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SetFilter (xAx25 *ax25, const struct xAx25Filter *filter);
+
+/**
+ * Sets the capture log of the received frames
+ *
+ * Each frame whose CRC is correct is appended to the log by bAx25Poll(),
+ * before being filtered. The log object is not copied and must remain valid
+ * as long as it is used.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param capture capture log, NULL to stop the capture
+ * @param port port number recorded with the frames
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SetCapture (xAx25 *ax25, struct xCapture *capture, uint16_t port);
+
+/**
+ * Sets the pcap writer of the received frames
+ *
+ * Each frame whose CRC is correct is queued to the writer by bAx25Poll(),
+ * before being filtered. The writer object is not copied and must remain
+ * valid as long as it is used.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param pcap pcap writer, NULL to stop the export
+ * @param port port number recorded with the frames, also used by the
+ * capture log
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SetPcap (xAx25 *ax25, struct xPcap *pcap, uint16_t port);
+
+/**
+ * Sets the handler of the received frames
+ *
+ * When a handler is set, each frame accepted by the filter is given to the
+ * handler by bAx25Poll(), bAx25PollTimeout() and bAx25Feed() as soon as it is
+ * decoded, and the decoding goes on: one call can deliver any number of
+ * frames, without iAx25Read(). The handler must not call these functions on
+ * the same object.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param handler handler called for each frame, NULL to read the frames with
+ * iAx25Read()
+ * @param ctx context given to the handler
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SetRxHandler (xAx25 *ax25, vAx25RxHandler handler, void *ctx);
+
+/**
+ * Accepts or rejects a PID in the frames read by iAx25Read()
+ *
+ * Only AX25_PID_NOLAYER3 is accepted after iAx25Clear(). iAx25Read() releases
+ * a frame whose PID is rejected and returns AX25_INVALID_FRAME, such a frame
+ * can only be read with iAx25ReadView() before iAx25Read() is called. The
+ * views given to the handler are not concerned.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param pid protocol ID
+ * @param accept true to accept the frames of this PID
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SetPid (xAx25 *ax25, uint8_t pid, bool accept);
+
+/**
+ * Accepts or rejects all the PID in the frames read by iAx25Read()
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param accept true to accept the frames of any PID, false to reject all
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SetAllPid (xAx25 *ax25, bool accept);
+
 /**
  * Check if there are any AX25 messages to be processed.
  * This function read available characters from the medium and search for
@@ -358,6 +725,40 @@ int iAx25SetFdout (xAx25 *p, int fdout);
  */
 bool bAx25Poll(xAx25 *ax25);
 
+/**
+ * Wait for an AX25 frame until a deadline
+ *
+ * Same as bAx25Poll(), but the input is waited with poll(), the function
+ * returns as soon as a frame is received or when the timeout is elapsed,
+ * whether the file descriptor is blocking or not. No CPU time is used while
+ * waiting.
+ * With a handler (see iAx25SetRxHandler()), the function returns when the
+ * input is no longer readable once at least one frame has been delivered.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param timeout_ms timeout in milliseconds, negative value to wait forever
+ * @return true if a frame is received, false on timeout, end of file or error
+ */
+bool bAx25PollTimeout (xAx25 *ax25, int timeout_ms);
+
+/**
+ * Decode bytes received by the caller
+ *
+ * Same as bAx25Poll(), but the bytes are given by the caller instead of being
+ * read from the input, for an application that does its own I/O (see
+ * xMux). The decoding stops as soon as a frame is received: it must be read
+ * or discarded before the next call, the remaining bytes being given again.
+ * With a handler (see iAx25SetRxHandler()), all the bytes are decoded and
+ * the frames are given to the handler.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param buf received bytes
+ * @param len number of bytes in buf
+ * @param used number of bytes decoded, may be NULL
+ * @return true if a frame is received and can be read with iAx25Read()
+ */
+bool bAx25Feed (xAx25 *ax25, const void *buf, size_t len, size_t *used);
+
 /**
  * Send an AX25 frame on the channel through a specific frame.
  *
@@ -370,17 +771,149 @@ int iAx25Send (xAx25 *ax25, const xAx25Frame *frame);
 /**
  * Read the last AX25 frame received on the channel.
  *
+ * Only the UI frames whose PID is accepted (see iAx25SetPid()) are read: any
+ * other frame is released and AX25_INVALID_FRAME is returned, the next frame
+ * can then be received.
+ *
  * @param ax25 AX25 object to operate on.
  * @param frame copy of the last received message
  * @return AX25_SUCCESS, negative value on error
  */
 int iAx25Read (xAx25 *ax25, xAx25Frame *frame);
 
+/**
+ * Gives a view on the last AX25 frame received on the channel.
+ *
+ * The frame is neither decoded nor copied, the view is valid until the frame
+ * is released with iAx25Discard().
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param view view on the last received frame
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25ReadView (xAx25 *ax25, xAx25View *view);
+
+/**
+ * Discard the last AX25 frame received on the channel without decoding it.
+ *
+ * This allows to process the raw frame (xAx25Decoder::buf of ax25->dec, see
+ * iAx25ReadView()) and then to release it.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25Discard (xAx25 *ax25);
+
+/**
+ * Send a raw AX25 frame on the channel.
+ *
+ * The frame is escaped and written with a single write, no decoding or CRC
+ * computation is done.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param frame raw frame from the destination address to the FCS included
+ * @param len length of the frame, FCS included
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SendRaw (xAx25 *ax25, const uint8_t *frame, size_t len);
+
+/**
+ * Escape a raw AX25 frame between two HDLC flags
+ *
+ * @param out buffer where the frame is encoded, it must contain at least
+ * AX25_RAW_SIZE(len) bytes
+ * @param frame raw frame from the destination address to the FCS included
+ * @param len length of the frame, FCS included
+ * @return length of the encoded frame
+ */
+size_t uAx25Encode (uint8_t *out, const uint8_t *frame, size_t len);
+
+/**
+ * Send frames already encoded by uAx25Encode()
+ *
+ * Several frames encoded one after the other are written with a single
+ * write, which is much faster than successive calls to iAx25SendRaw().
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param buf encoded frames
+ * @param len number of bytes
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25SendEncoded (xAx25 *ax25, const void *buf, size_t len);
+
 /**
  * Retruns the last error code.
  */
 int iAx25Error (xAx25 *ax25);
 
+//##############################################################################
+//#                                                                            #
+//#                          xAx25Template Class                               #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * Maximum length of the escaped header of a template: leading flag, address,
+ * ctrl and pid fields, each byte may be escaped.
+ */
+#define AX25_TEMPLATE_HDR_LEN (((AX25_CALL_LEN+1)*(2+AX25_MAX_RPT)+2)*2+1)
+
+/**
+ * AX25 Frame Template Class
+ *
+ * A template holds the address, ctrl and pid fields of a frame already
+ * encoded and escaped, and the CRC register computed over them. Sending a
+ * frame from a template only escapes and computes the CRC of the info field,
+ * this is intended for periodic beacons whose path never changes.
+ */
+typedef struct xAx25Template {
+
+  uint8_t hdr[AX25_TEMPLATE_HDR_LEN]; ///< leading flag and escaped header
+  size_t  hdr_len;  ///< number of bytes in hdr
+  uint16_t crc;     ///< CRC register after the ctrl and pid fields
+} xAx25Template;
+
+/**
+ * Create a new xAx25Template object from a frame
+ *
+ * This object should be deleted with vAx25TemplateDelete()
+ * @param frame frame whose addresses, ctrl and pid are used, its info field
+ * is ignored
+ * @return pointer on the object, NULL on error
+ */
+xAx25Template * xAx25TemplateNew (const xAx25Frame *frame);
+
+/**
+ * Delete a xAx25Template object
+ *
+ * @param t template object to operate on.
+ */
+void vAx25TemplateDelete (xAx25Template *t);
+
+/**
+ * Encode the header of a frame in a template
+ *
+ * @param t template object to operate on.
+ * @param frame frame whose addresses, ctrl and pid are used, its info field
+ * is ignored
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25TemplateSet (xAx25Template *t, const xAx25Frame *frame);
+
+/**
+ * Send a frame built from a template and an info field
+ *
+ * The frame is written with a single write.
+ *
+ * @param ax25 AX25 object to operate on.
+ * @param t template object to use.
+ * @param info info field
+ * @param info_len length of the info field
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25TemplateSend (xAx25 *ax25, const xAx25Template *t,
+                       const void *info, size_t info_len);
+
 /**
  *  @}
  * @}
@@ -10,10 +10,14 @@
 #define _SYSIO_AX25_HPP_
 
 #include <string>
+#include <chrono>
+#include <radio/loop.hpp>
 
 struct xAx25Node;
 struct xAx25Frame;
 struct xAx25;
+struct xAx25Filter;
+template <size_t MaxInfo, size_t MaxRepeaters> class Ax25FrameT;
 
 /**
  *  @addtogroup radio_ax25
@@ -116,6 +120,8 @@ public:
   enum {
     CTRL_UI                  = 0x03,
     PID_NOLAYER3             = 0xF0,
+    PID_IP                   = 0xCC,
+    PID_ARP                  = 0xCD,
     SUCCESS                  =  0,
     FILE_ACCESS_ERROR        = -1,
     ILLEGAL_CALLSIGN         = -2,
@@ -126,7 +132,10 @@ public:
     OBJECT_NOT_FOUND         = -7,
     FILE_NOT_FOUND           = -8,
     ILLEGAL_REPEATER         = -9,
-    NO_FRAME_RECEIVED        = -10
+    NO_FRAME_RECEIVED        = -10,
+    ILLEGAL_FILTER           = -11,
+    CONNECTION_REFUSED       = -12,
+    CONNECTION_LOST          = -13
   };
 
   Ax25();
@@ -139,15 +148,155 @@ public:
   void setFdin  (int fdi);
   int getFdin() const;
 
+  int setFilter (const char *expr);
+  /**
+   * Accept or reject a PID in the frames read, only PID_NOLAYER3 is accepted
+   * after clear()
+   */
+  int setPid (unsigned char pid, bool accept = true);
+  int setAllPid (bool accept = true);
+
   bool poll();
+  /**
+   * Wait for a frame until a deadline, without using CPU time
+   *
+   * @param timeout maximum waiting time, negative to wait forever
+   * @return true if a frame is received, false on timeout
+   */
+  template <class Rep, class Period>
+  bool poll (const std::chrono::duration<Rep, Period> &timeout) {
+    return pollTimeout (std::chrono::duration_cast<std::chrono::milliseconds> (timeout).count());
+  }
+  bool pollTimeout (int timeoutMs);
   void send (const Ax25Frame &f);
   void send (const Ax25Frame *f);
   void read (Ax25Frame  &f);
   void read (Ax25Frame  *f);
 
+  /**
+   * Send a frame of fixed capacity, defined in radio/ax25frame.hpp
+   *
+   * The frame is encoded in the on-air format and written at once.
+   * @return SUCCESS or a negative value
+   */
+  template <size_t MaxInfo, size_t MaxRepeaters>
+  int send (const Ax25FrameT<MaxInfo, MaxRepeaters> &f);
+
+  /**
+   * Read the last frame received in a frame of fixed capacity, defined in
+   * radio/ax25frame.hpp
+   *
+   * The frame is decoded without an intermediate copy, then discarded.
+   * @return SUCCESS, NO_FRAME_RECEIVED, or a negative value if the frame
+   * exceeds the capacity of f
+   */
+  template <size_t MaxInfo, size_t MaxRepeaters>
+  int read (Ax25FrameT<MaxInfo, MaxRepeaters> &f);
+
+#if defined(__cpp_impl_coroutine)
+  class ReceiveAwaiter;
+  class SendAwaiter;
+
+  /**
+   * Wait for a frame in a coroutine
+   *
+   * @code bool ok = co_await ax25.asyncReceive (frame); @endcode
+   * @param f frame where the received frame is copied
+   * @param loop event loop, NULL for the current loop of the thread
+   * @return awaitable operation whose result is true if a frame is received,
+   * false at end of file or if there is no loop
+   */
+  ReceiveAwaiter asyncReceive (Ax25Frame &f, EventLoop *loop = nullptr);
+
+  /**
+   * Send a frame in a coroutine, when the output is writable
+   *
+   * @code int err = co_await ax25.asyncSend (frame); @endcode
+   * @param f frame to send, it must remain valid until the end of co_await
+   * @param loop event loop, NULL for the current loop of the thread
+   * @return awaitable operation whose result is SUCCESS or a negative value
+   */
+  SendAwaiter asyncSend (const Ax25Frame &f, EventLoop *loop = nullptr);
+#endif
+
 private:
   struct xAx25 *p;
+  struct xAx25Filter *filter;
+};
+
+#if defined(__cpp_impl_coroutine)
+// -----------------------------------------------------------------------------
+class Ax25::ReceiveAwaiter : public FdAwaiter<Ax25::ReceiveAwaiter> {
+
+public:
+  ReceiveAwaiter (Ax25 &ax25, Ax25Frame &f, EventLoop *loop) :
+    FdAwaiter (loop, ax25.getFdin() ? ax25.getFdin() : -1, EventLoop::READ),
+    ax25 (ax25), frame (f), got (false) {}
+
+  bool attempt (unsigned events) {
+    got = ax25.pollTimeout (0);
+    return got || (events & EventLoop::HANGUP);
+  }
+
+  bool await_resume() {
+    if (got) {
+      ax25.read (frame);
+    }
+    return got;
+  }
+
+private:
+  Ax25 &ax25;
+  Ax25Frame &frame;
+  bool got;
+};
+
+// -----------------------------------------------------------------------------
+class Ax25::SendAwaiter : public FdAwaiter<Ax25::SendAwaiter> {
+
+public:
+  SendAwaiter (Ax25 &ax25, const Ax25Frame &f, EventLoop *loop) :
+    FdAwaiter (loop, ax25.getFdout() ? ax25.getFdout() : -1, EventLoop::WRITE),
+    ax25 (ax25), frame (f), error (FILE_NOT_FOUND) {}
+
+  bool attempt (unsigned events) {
+    if (events == 0) {
+      events = FdAwaiter::events (fd, event);
+    }
+    if (events & EventLoop::HANGUP) {
+      error = FILE_ACCESS_ERROR;
+      return true;
+    }
+    if (events & EventLoop::WRITE) {
+      ax25.send (frame);
+      error = ax25.getError();
+      return true;
+    }
+    return false;
+  }
+
+  int await_resume() {
+    return error;
+  }
+
+private:
+  Ax25 &ax25;
+  const Ax25Frame &frame;
+  int error;
 };
+
+// -----------------------------------------------------------------------------
+inline Ax25::ReceiveAwaiter
+Ax25::asyncReceive (Ax25Frame &f, EventLoop *loop) {
+  return ReceiveAwaiter (*this, f, loop);
+}
+
+// -----------------------------------------------------------------------------
+inline Ax25::SendAwaiter
+Ax25::asyncSend (const Ax25Frame &f, EventLoop *loop) {
+  return SendAwaiter (*this, f, loop);
+}
+#endif /* __cpp_impl_coroutine */
 /**
  *  @}
  * @}
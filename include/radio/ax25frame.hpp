@@ -0,0 +1,248 @@
+/**
+ * @file ax25frame.hpp
+ * @brief Trames AX.25 de capacité fixée à la compilation (C++)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_AX25FRAME_HPP_
+#define _SYSIO_AX25FRAME_HPP_
+
+#include <string.h>
+#include <radio/ax25.h>
+#include <radio/ax25.hpp>
+#include <radio/crc.h>
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_frame Trames de capacité fixe
+ *
+ *  Ax25FrameT est une trame dont la taille du champ d'information et le
+ *  nombre de répéteurs sont fixés à la compilation : les adresses et le champ
+ *  d'information sont dans l'objet, sans allocation dynamique. Un capteur
+ *  qui n'émet que quelques octets utilise une trame de quelques dizaines
+ *  d'octets, une passerelle une trame de taille maximale. La trame est codée
+ *  et décodée directement au format de la liaison, les méthodes send() et
+ *  read() de la classe Ax25 l'utilisent sans passer par xAx25Frame.
+ *  @{
+ */
+
+//##############################################################################
+//#                                                                            #
+//#                           Ax25FrameT Class                                 #
+//#                                                                            #
+//##############################################################################
+/**
+ * AX25 Frame Class with a fixed capacity
+ *
+ * @param MaxInfo maximum length of the info field, up to AX25_INFO_LEN
+ * @param MaxRepeaters maximum number of repeaters, up to AX25_MAX_RPT
+ */
+template <size_t MaxInfo = AX25_INFO_LEN, size_t MaxRepeaters = AX25_MAX_RPT>
+class Ax25FrameT {
+
+public:
+  static_assert (MaxInfo <= AX25_INFO_LEN, "MaxInfo must not exceed AX25_INFO_LEN");
+  static_assert (MaxRepeaters <= AX25_MAX_RPT, "MaxRepeaters must not exceed AX25_MAX_RPT");
+
+  enum {
+    maxInfo = MaxInfo,
+    maxRepeater = MaxRepeaters,
+    /// Maximum length of the raw frame, FCS included
+    rawSize = (AX25_CALL_LEN + 1) * (2 + MaxRepeaters) + 2 + MaxInfo + 2
+  };
+
+  Ax25FrameT (const char *dst = "nocall", const char *src = "nocall") {
+    clear();
+    iAx25NodeSetCallsign (&_dst, dst);
+    iAx25NodeSetCallsign (&_src, src);
+  }
+
+  /**
+   * Clears the addresses and empties the info field, the buffers are not
+   * cleared
+   */
+  void clear() {
+    iAx25NodeClear (&_dst);
+    iAx25NodeClear (&_src);
+    _replen = 0;
+    _ctrl = AX25_CTRL_UI;
+    _pid = AX25_PID_NOLAYER3;
+    _infolen = 0;
+    _info[0] = 0;
+  }
+
+  xAx25Node & getDst() {
+    return _dst;
+  }
+  xAx25Node & getSrc() {
+    return _src;
+  }
+  xAx25Node & repeater (unsigned char index) {
+    return _rep[index];
+  }
+  unsigned char getReplen() const {
+    return _replen;
+  }
+
+  /**
+   * Adds a repeater
+   *
+   * @return AX25_SUCCESS, AX25_NOT_ENOUGH_REPEATER if the frame is full
+   */
+  int addRepeater (const char *str, unsigned char ssid = 0) {
+    if (_replen >= MaxRepeaters) {
+      return AX25_NOT_ENOUGH_REPEATER;
+    }
+    xAx25Node &n = _rep[_replen++];
+    iAx25NodeClear (&n);
+    iAx25NodeSetCallsign (&n, str);
+    iAx25NodeSetSsid (&n, ssid);
+    return AX25_SUCCESS;
+  }
+
+  void setCtrl (unsigned char ctrl) {
+    _ctrl = ctrl;
+  }
+  unsigned char getCtrl() const {
+    return _ctrl;
+  }
+  void setPid (unsigned char pid) {
+    _pid = pid;
+  }
+  unsigned char getPid() const {
+    return _pid;
+  }
+
+  /**
+   * Sets the info field, truncated to MaxInfo bytes
+   */
+  void setInfo (const void *msg, size_t len) {
+    _infolen = (len < MaxInfo) ? len : MaxInfo;
+    memcpy (_info, msg, _infolen);
+    _info[_infolen] = 0;
+  }
+  const char * getInfo() const {
+    return _info;
+  }
+  size_t getInfolen() const {
+    return _infolen;
+  }
+
+  /**
+   * Encodes the frame in the on-air format
+   *
+   * @param out buffer of rawSize bytes where the frame is stored, from the
+   * destination address to the FCS included
+   * @return length of the raw frame, 0 if a callsign is illegal
+   */
+  size_t encode (uint8_t *out) const {
+    uint8_t *b = out;
+    uint16_t fcs;
+
+    if ( (!prvAddr (b, _dst, false)) || (!prvAddr (b, _src, _replen == 0))) {
+      return 0;
+    }
+    for (unsigned i = 0; i < _replen; i++) {
+      if (!prvAddr (b, _rep[i], i == _replen - 1u)) {
+        return 0;
+      }
+    }
+    *b++ = _ctrl;
+    // Only I and UI frames have a PID field
+    if ( ( (_ctrl & 0x01) == 0) || ( (_ctrl & ~0x10) == AX25_CTRL_UI)) {
+      *b++ = _pid;
+    }
+    memcpy (b, _info, _infolen);
+    b += _infolen;
+    fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, out, b - out) ^ 0xFFFF;
+    *b++ = fcs & 0xFF;
+    *b++ = fcs >> 8;
+    return b - out;
+  }
+
+  /**
+   * Decodes a frame from a view
+   *
+   * @return AX25_SUCCESS, AX25_NOT_ENOUGH_REPEATER or AX25_INVALID_FRAME if
+   * the frame exceeds the capacity
+   */
+  int decode (const xAx25View &v) {
+    if (v.naddr > MaxRepeaters + 2) {
+      return AX25_NOT_ENOUGH_REPEATER;
+    }
+    if (v.info_len > MaxInfo) {
+      return AX25_INVALID_FRAME;
+    }
+    iAx25ViewGetNode (&v, 0, &_dst);
+    iAx25ViewGetNode (&v, 1, &_src);
+    _replen = v.naddr - 2;
+    for (unsigned i = 0; i < _replen; i++) {
+      iAx25ViewGetNode (&v, i + 2, &_rep[i]);
+    }
+    _ctrl = v.ctrl;
+    _pid = v.pid;
+    _infolen = v.info_len;
+    memcpy (_info, v.info, _infolen);
+    _info[_infolen] = 0;
+    return AX25_SUCCESS;
+  }
+
+private:
+  static bool prvAddr (uint8_t *&b, const xAx25Node &n, bool last) {
+    if (iAx25NodeEncode (&n, b) != AX25_SUCCESS) {
+      return false;
+    }
+    if (last) {
+      b[AX25_CALL_LEN] |= 0x01;
+    }
+    b += AX25_CALL_LEN + 1;
+    return true;
+  }
+
+  xAx25Node _dst;
+  xAx25Node _src;
+  xAx25Node _rep[MaxRepeaters ? MaxRepeaters : 1];
+  unsigned char _replen;
+  unsigned char _ctrl;
+  unsigned char _pid;
+  size_t _infolen;
+  char _info[MaxInfo + 1];
+};
+
+// -----------------------------------------------------------------------------
+template <size_t MaxInfo, size_t MaxRepeaters> int
+Ax25::send (const Ax25FrameT<MaxInfo, MaxRepeaters> &f) {
+  uint8_t raw[Ax25FrameT<MaxInfo, MaxRepeaters>::rawSize];
+  size_t len = f.encode (raw);
+
+  return len ? iAx25SendRaw (p, raw, len) : AX25_ILLEGAL_CALLSIGN;
+}
+
+// -----------------------------------------------------------------------------
+template <size_t MaxInfo, size_t MaxRepeaters> int
+Ax25::read (Ax25FrameT<MaxInfo, MaxRepeaters> &f) {
+  xAx25View v;
+  int ret = iAx25ReadView (p, &v);
+
+  // A frame which can not be decoded is also discarded
+  if (ret != AX25_NO_FRAME_RECEIVED) {
+
+    if (ret == AX25_SUCCESS) {
+
+      ret = f.decode (v);
+    }
+    iAx25Discard (p);
+  }
+  return ret;
+}
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /* _SYSIO_AX25FRAME_HPP_ */
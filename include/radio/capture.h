@@ -0,0 +1,201 @@
+/**
+ * @file capture.h
+ * @brief Journal de capture des trames reçues
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_CAPTURE_H_
+#define _SYSIO_CAPTURE_H_
+
+#include <radio/ax25.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_capture Journal de capture
+ *
+ *  Ce module enregistre les trames reçues dans des fichiers segments projetés
+ *  en mémoire (mmap). Chaque segment est préalloué à sa création, l'écriture
+ *  d'une trame se limite donc à une copie en mémoire, sans appel système : les
+ *  horodatages sont lus avec clock_gettime() (vDSO) et les pages modifiées sont
+ *  transmises au noyau par msync() tous les AX25_CAPTURE_SYNC_SIZE octets. \n
+ *  Lorsqu'un segment est plein, le suivant est créé (path.0000, path.0001...).
+ *  \n
+ *  Un enregistrement est composé d'un entête (xCaptureRecordHdr) suivi de la
+ *  trame, aligné sur 8 octets. La longueur de la trame est écrite en dernier,
+ *  un lecteur peut donc suivre un segment en cours d'écriture par un seul
+ *  écrivain, sans verrou : un enregistrement de longueur nulle marque la fin
+ *  des données. A la fermeture, l'espace préalloué inutilisé est libéré mais
+ *  la page contenant cet enregistrement nul est conservée : un lecteur qui
+ *  suit le segment s'arrête sur la fin des données, sans SIGBUS. \n
+ *  bAx25Poll() et iTncPoll() enregistrent les trames dont le CRC est correct
+ *  si un journal leur est associé par iAx25SetCapture() ou iTncSetCapture().
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Default size of a segment file
+ */
+#define AX25_CAPTURE_SEGMENT_SIZE (64 * 1024 * 1024)
+
+/**
+ * Number of bytes written between two msync() calls
+ */
+#define AX25_CAPTURE_SYNC_SIZE (1024 * 1024)
+
+/**
+ * Magic number at the start of a segment file
+ */
+#define AX25_CAPTURE_MAGIC "AX25CAP1"
+
+//##############################################################################
+//#                                                                            #
+//#                             xCapture Class                                 #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * Segment file header
+ */
+typedef struct xCaptureFileHdr {
+
+  char magic[8];        ///< AX25_CAPTURE_MAGIC
+  uint32_t hdr_size;    ///< size of this header, offset of the first record
+  uint32_t segment;     ///< index of the segment
+  uint64_t created;     ///< creation time, nanoseconds since the Epoch
+  uint64_t reserved;
+} xCaptureFileHdr;
+
+/**
+ * Record header, followed by the frame
+ */
+typedef struct xCaptureRecordHdr {
+
+  uint32_t len;         ///< frame length, written last, 0 at the end of data
+  uint16_t port;        ///< port the frame was received from
+  uint16_t reserved;
+  uint64_t mono;        ///< CLOCK_MONOTONIC time in nanoseconds
+  uint64_t wall;        ///< CLOCK_REALTIME time in nanoseconds
+} xCaptureRecordHdr;
+
+/**
+ * Capture log writer
+ */
+typedef struct xCapture {
+
+  char *path;           ///< segment files prefix
+  size_t seg_size;      ///< size of a segment
+  unsigned segment;     ///< index of the current segment
+  int fd;               ///< current segment file
+  uint8_t *map;         ///< current segment mapping
+  size_t pos;           ///< offset of the next record
+  size_t synced;        ///< offset up to which msync() was called
+  unsigned long frames; ///< number of frames written
+} xCapture;
+
+/**
+ * Create a capture log, the first segment is created
+ *
+ * This object should be deleted with vCaptureDelete()
+ * @param path prefix of the segment files, the segment index is appended
+ * @param seg_size size of a segment, 0 for AX25_CAPTURE_SEGMENT_SIZE
+ * @return pointer on the object, NULL on error
+ */
+xCapture * xCaptureNew (const char *path, size_t seg_size);
+
+/**
+ * Close a capture log
+ *
+ * The current segment is synchronized and truncated after the page holding
+ * the null record which ends the data, so a reader following it stops there.
+ * @param c object to operate on.
+ */
+void vCaptureDelete (xCapture *c);
+
+/**
+ * Append a frame
+ *
+ * @param c object to operate on.
+ * @param port port the frame was received from
+ * @param frame frame without FCS
+ * @param len frame length
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iCaptureWrite (xCapture *c, uint16_t port, const void *frame, size_t len);
+
+/**
+ * Synchronously flush the current segment to the disk
+ *
+ * @param c object to operate on.
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iCaptureSync (xCapture *c);
+
+/**
+ * Record read from a capture log
+ */
+typedef struct xCaptureRecord {
+
+  uint64_t mono;        ///< CLOCK_MONOTONIC time in nanoseconds
+  uint64_t wall;        ///< CLOCK_REALTIME time in nanoseconds
+  uint16_t port;        ///< port the frame was received from
+  size_t len;           ///< frame length
+  const uint8_t *frame; ///< frame, valid until the reader is closed
+} xCaptureRecord;
+
+/**
+ * Capture log reader
+ */
+typedef struct xCaptureReader {
+
+  int fd;               ///< segment file
+  const uint8_t *map;   ///< segment mapping
+  size_t size;          ///< segment size
+  size_t pos;           ///< offset of the next record
+  unsigned segment;     ///< index of the segment
+} xCaptureReader;
+
+/**
+ * Open a segment file for reading
+ *
+ * This object should be deleted with vCaptureReaderDelete()
+ * @param file segment file name (path.0000...)
+ * @return pointer on the object, NULL on error
+ */
+xCaptureReader * xCaptureReaderNew (const char *file);
+
+/**
+ * Close a segment file
+ *
+ * @param r object to operate on.
+ */
+void vCaptureReaderDelete (xCaptureReader *r);
+
+/**
+ * Read the next record
+ *
+ * @param r object to operate on.
+ * @param rec record read
+ * @return 1 if a record was read, 0 at the end of data, negative value on error
+ */
+int iCaptureRead (xCaptureReader *r, xCaptureRecord *rec);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_CAPTURE_H_ */
@@ -0,0 +1,836 @@
+/**
+ * @file codec.hpp
+ * @brief Codage et décodage des trames par politiques (C++)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_CODEC_HPP_
+#define _SYSIO_CODEC_HPP_
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <atomic>
+#include <utility>
+#include <radio/ax25.h>
+#include <radio/tnc.h>
+#include <radio/crc.h>
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_codec Codec par politiques
+ *
+ *  radio::Codec<Framing, Transport, Checksum> code et décode des trames
+ *  entièrement dans les en-têtes : le tramage (Hdlc pour AX.25, Kiss, Tnc
+ *  pour les messages hexadécimaux du TNC), le transport (FdTransport,
+ *  MemoryTransport, RingTransport) et la somme de contrôle (Fcs16, Crc16,
+ *  NoChecksum) sont des politiques choisies à la compilation. La boucle de
+ *  décodage de chaque configuration est ainsi compilée en une seule fonction,
+ *  sans appel de fonction par octet. \n
+ *  Hdlc avec Fcs16 et Tnc avec Crc16 produisent et acceptent exactement les
+ *  mêmes octets que bAx25Feed()/uAx25Encode() et iTncFeed()/uTncEncode().
+ *  @{
+ */
+namespace radio {
+
+//##############################################################################
+//#                                                                            #
+//#                           Checksum policies                                #
+//#                                                                            #
+//##############################################################################
+/**
+ * AX25 frame check sequence: CRC-CCITT, inverted, sent LSB first
+ */
+struct Fcs16 {
+  enum { size = 2 };
+  static uint16_t init() {
+    return CRC_CCITT_INIT_VAL;
+  }
+  static uint16_t update (uint16_t crc, uint8_t c) {
+    return usCrcCcittUpdate (c, crc);
+  }
+  static uint16_t value (uint16_t crc) {
+    return crc ^ 0xFFFF;
+  }
+};
+
+/**
+ * CRC-CCITT without inversion, as used by the TNC messages
+ */
+struct Crc16 {
+  enum { size = 2 };
+  static uint16_t init() {
+    return CRC_CCITT_INIT_VAL;
+  }
+  static uint16_t update (uint16_t crc, uint8_t c) {
+    return usCrcCcittUpdate (c, crc);
+  }
+  static uint16_t value (uint16_t crc) {
+    return crc;
+  }
+};
+
+/**
+ * No checksum
+ */
+struct NoChecksum {
+  enum { size = 0 };
+  static uint16_t init() {
+    return 0;
+  }
+  static uint16_t update (uint16_t crc, uint8_t) {
+    return crc;
+  }
+  static uint16_t value (uint16_t crc) {
+    return crc;
+  }
+};
+
+//##############################################################################
+//#                                                                            #
+//#                           Framing policies                                 #
+//#                                                                            #
+//##############################################################################
+/**
+ * Receive buffer of the framings
+ *
+ * The checksum is computed on the fly, Checksum::size bytes behind the last
+ * byte stored, so that it covers the frame without its checksum when the end
+ * of frame is received.
+ */
+template <class Checksum>
+class FrameBuffer {
+
+public:
+  enum { maxFrame = AX25_FRAME_BUF_LEN };
+
+  void clear() {
+    len = 0;
+    crc = Checksum::init();
+  }
+  bool full() const {
+    return len >= maxFrame;
+  }
+  void append (uint8_t c) {
+    if (len >= (size_t) Checksum::size) {
+      crc = Checksum::update (crc, buf[len - Checksum::size]);
+    }
+    buf[len++] = c;
+  }
+  // The checksum received at the end of the buffer, LSB first
+  bool valid() const {
+    uint16_t fcs = 0;
+
+    for (int i = 0; i < Checksum::size; i++) {
+      fcs |= (uint16_t) buf[len - Checksum::size + i] << (8 * i);
+    }
+    return Checksum::value (crc) == fcs;
+  }
+
+  uint8_t buf[maxFrame];
+  size_t len;
+  uint16_t crc;
+};
+
+// -----------------------------------------------------------------------------
+/**
+ * HDLC framing of the AX25 frames: flags, escape character and reset
+ */
+template <class Checksum>
+class Hdlc {
+
+public:
+  enum {
+    maxFrame = AX25_FRAME_BUF_LEN - Checksum::size,
+    /// 2 addresses and control field, as the S and U frames
+    minFrame = 2 * (AX25_CALL_LEN + 1) + 1 + Checksum::size
+  };
+
+  Hdlc() : sync (false), escape (false), flen (0) {
+    rx.clear();
+  }
+
+  static constexpr size_t encodedSize (size_t len) {
+    return 2 * (len + Checksum::size) + 2;
+  }
+
+  static size_t encode (uint8_t *out, const uint8_t *frame, size_t len) {
+    uint16_t crc = Checksum::init();
+    uint8_t *o = out;
+
+    *o++ = HDLC_FLAG;
+    for (size_t i = 0; i < len; i++) {
+      crc = Checksum::update (crc, frame[i]);
+      o = put (o, frame[i]);
+    }
+    crc = Checksum::value (crc);
+    for (int i = 0; i < Checksum::size; i++) {
+      o = put (o, crc >> (8 * i));
+    }
+    *o++ = HDLC_FLAG;
+    return o - out;
+  }
+
+  /**
+   * Decodes a byte, returns true when a frame is received
+   */
+  bool push (uint8_t c) {
+    if (!escape) {
+      if (c == HDLC_FLAG) {
+        bool ok = (rx.len >= (size_t) minFrame) && rx.valid();
+
+        if (ok) {
+          flen = rx.len - Checksum::size;
+        }
+        sync = true;
+        rx.clear();
+        return ok;
+      }
+      if (c == HDLC_RESET) {
+        sync = false;
+        return false;
+      }
+      if (c == AX25_ESC) {
+        escape = true;
+        return false;
+      }
+    }
+    if (sync) {
+      if (!rx.full()) {
+        rx.append (c);
+      }
+      else {
+        sync = false;
+      }
+    }
+    escape = false;
+    return false;
+  }
+
+  const uint8_t * frame() const {
+    return rx.buf;
+  }
+  size_t length() const {
+    return flen;
+  }
+
+private:
+  static uint8_t * put (uint8_t *o, uint8_t c) {
+    if ( (c == HDLC_FLAG) || (c == HDLC_RESET) || (c == AX25_ESC)) {
+      *o++ = AX25_ESC;
+    }
+    *o++ = c;
+    return o;
+  }
+
+  FrameBuffer<Checksum> rx;
+  bool sync;
+  bool escape;
+  size_t flen;
+};
+
+// -----------------------------------------------------------------------------
+/**
+ * KISS framing, the data frames of all the ports are received, the frames
+ * are sent on port 0
+ */
+template <class Checksum>
+class Kiss {
+
+public:
+  enum {
+    FEND = 0xC0,
+    FESC = 0xDB,
+    TFEND = 0xDC,
+    TFESC = 0xDD,
+    maxFrame = AX25_FRAME_BUF_LEN - Checksum::size - 1
+  };
+
+  Kiss() : sync (false), escape (false), flen (0) {
+    rx.clear();
+  }
+
+  static constexpr size_t encodedSize (size_t len) {
+    return 2 * (len + Checksum::size) + 3;
+  }
+
+  static size_t encode (uint8_t *out, const uint8_t *frame, size_t len) {
+    uint16_t crc = Checksum::update (Checksum::init(), 0x00);
+    uint8_t *o = out;
+
+    *o++ = FEND;
+    *o++ = 0x00;
+    for (size_t i = 0; i < len; i++) {
+      crc = Checksum::update (crc, frame[i]);
+      o = put (o, frame[i]);
+    }
+    crc = Checksum::value (crc);
+    for (int i = 0; i < Checksum::size; i++) {
+      o = put (o, crc >> (8 * i));
+    }
+    *o++ = FEND;
+    return o - out;
+  }
+
+  bool push (uint8_t c) {
+    if (c == FEND) {
+      // The command byte is followed by the frame, only data frames are kept
+      bool ok = (sync) && (rx.len > (size_t) Checksum::size) &&
+                ( (rx.buf[0] & 0x0F) == 0) && rx.valid();
+
+      if (ok) {
+        flen = rx.len - Checksum::size - 1;
+      }
+      sync = true;
+      escape = false;
+      rx.clear();
+      return ok;
+    }
+    if (!sync) {
+      return false;
+    }
+    if (escape) {
+      escape = false;
+      if (c == TFEND) {
+        c = FEND;
+      }
+      else if (c == TFESC) {
+        c = FESC;
+      }
+      else {
+        // Protocol error, the frame is dropped
+        sync = false;
+        return false;
+      }
+    }
+    else if (c == FESC) {
+      escape = true;
+      return false;
+    }
+    if (!rx.full()) {
+      rx.append (c);
+    }
+    else {
+      sync = false;
+    }
+    return false;
+  }
+
+  const uint8_t * frame() const {
+    return rx.buf + 1;
+  }
+  size_t length() const {
+    return flen;
+  }
+
+private:
+  static uint8_t * put (uint8_t *o, uint8_t c) {
+    if (c == FEND) {
+      *o++ = FESC;
+      *o++ = TFEND;
+    }
+    else if (c == FESC) {
+      *o++ = FESC;
+      *o++ = TFESC;
+    }
+    else {
+      *o++ = c;
+    }
+    return o;
+  }
+
+  FrameBuffer<Checksum> rx;
+  bool sync;
+  bool escape;
+  size_t flen;
+};
+
+// -----------------------------------------------------------------------------
+/**
+ * TNC framing: SOH, STX, hexadecimal bytes, ETX, hexadecimal checksum, EOT
+ *
+ * The checksum is computed on the hexadecimal characters.
+ */
+template <class Checksum>
+class Tnc {
+
+public:
+  enum {
+    ILLEGAL = TNC_ILLEGAL_MSG,
+    bits = 8 * Checksum::size,
+    maxFrame = AX25_FRAME_BUF_LEN
+  };
+
+  Tnc() : state (0), len (0), crc_rx (Checksum::init()), crc_tx (0), cnt (0), msb (0) {}
+
+  static constexpr size_t encodedSize (size_t len) {
+    return 2 * (len + Checksum::size) + 4;
+  }
+
+  static size_t encode (uint8_t *out, const uint8_t *frame, size_t len) {
+    static const char hex[] = "0123456789ABCDEF";
+    uint16_t crc = Checksum::init();
+    uint8_t *o = out;
+
+    *o++ = TNC_SOH;
+    *o++ = TNC_STX;
+    for (size_t i = 0; i < len; i++) {
+      o[0] = hex[frame[i] >> 4];
+      o[1] = hex[frame[i] & 0x0F];
+      crc = Checksum::update (Checksum::update (crc, o[0]), o[1]);
+      o += 2;
+    }
+    *o++ = TNC_ETX;
+    crc = Checksum::value (crc);
+    for (int i = bits - 4; i >= 0; i -= 4) {
+      *o++ = hex[ (crc >> i) & 0x0F];
+    }
+    *o++ = TNC_EOT;
+    return o - out;
+  }
+
+  bool push (uint8_t c) {
+    if (state == TNC_EOT) {
+      state = 0;
+    }
+    switch (c) {
+
+      case TNC_SOH:
+        crc_rx = Checksum::init();
+        state = TNC_SOH;
+        len = 0;
+        break;
+
+      case TNC_STX:
+        if (state == TNC_SOH) {
+          cnt = 0;
+          state = TNC_STX;
+        }
+        else {
+          state = 0;
+        }
+        break;
+
+      case TNC_ETX:
+        if (state == TNC_STX) {
+          cnt = 0;
+          crc_tx = 0;
+          state = TNC_ETX;
+        }
+        else {
+          state = 0;
+        }
+        break;
+
+      case TNC_EOT:
+        if (state == TNC_ETX) {
+          state = TNC_EOT;
+          return Checksum::value (crc_rx) == crc_tx;
+        }
+        state = 0;
+        break;
+
+      default:
+        if (isHex (c)) {
+          switch (state) {
+
+            case TNC_STX:
+              crc_rx = Checksum::update (crc_rx, c);
+              if (cnt++ & 1) {
+                if (len < (size_t) maxFrame) {
+                  buf[len++] = msb + htoi (c);
+                }
+                else {
+                  state = 0;
+                }
+              }
+              else {
+                msb = htoi (c) << 4;
+              }
+              break;
+
+            case TNC_ETX:
+              if ( (int) cnt <= bits - 4) {
+                crc_tx += ( (uint16_t) htoi (c)) << (bits - 4 - cnt);
+                cnt += 4;
+              }
+              else {
+                state = ILLEGAL;
+              }
+              break;
+
+            default:
+              // Hexadecimal digit out of a message, ignored
+              state = 0;
+              break;
+          }
+        }
+        break;
+    }
+    return false;
+  }
+
+  const uint8_t * frame() const {
+    return buf;
+  }
+  size_t length() const {
+    return len;
+  }
+
+private:
+  static bool isHex (uint8_t c) {
+    return ( (c >= '0') && (c <= '9')) || ( (c >= 'A') && (c <= 'F')) ||
+           ( (c >= 'a') && (c <= 'f'));
+  }
+  static uint8_t htoi (uint8_t c) {
+    return (c <= '9') ? c - '0' : (c & ~0x20) - 'A' + 10;
+  }
+
+  int state;
+  size_t len;
+  uint16_t crc_rx;
+  uint16_t crc_tx;
+  uint8_t cnt;
+  uint8_t msb;
+  uint8_t buf[maxFrame];
+};
+
+//##############################################################################
+//#                                                                            #
+//#                          Transport policies                                #
+//#                                                                            #
+//##############################################################################
+/**
+ * Transport by file descriptors, the input is read by chunks
+ */
+class FdTransport {
+
+public:
+  enum { bufferSize = 1024 };
+
+  FdTransport (int fdin = -1, int fdout = -1) : fdin (fdin), fdout (fdout) {}
+
+  /**
+   * Reads the next chunk of input
+   *
+   * @param data set to the bytes read
+   * @return number of bytes, 0 at end of file, on error or if nothing can be
+   * read from a non-blocking input
+   */
+  size_t read (const uint8_t *&data) {
+    ssize_t n;
+
+    do {
+      n = ::read (fdin, buf, sizeof (buf));
+    }
+    while ( (n < 0) && (errno == EINTR));
+    data = buf;
+    return (n > 0) ? n : 0;
+  }
+
+  /**
+   * Writes all the bytes, returns false on error
+   */
+  bool write (const uint8_t *data, size_t len) {
+    while (len) {
+      ssize_t n = ::write (fdout, data, len);
+
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  int getFdin() const {
+    return fdin;
+  }
+  int getFdout() const {
+    return fdout;
+  }
+
+private:
+  int fdin;
+  int fdout;
+  uint8_t buf[bufferSize];
+};
+
+// -----------------------------------------------------------------------------
+/**
+ * Transport in memory: the input is decoded in place, the output is written
+ * in a buffer of the caller
+ */
+class MemoryTransport {
+
+public:
+  MemoryTransport (const void *in = nullptr, size_t inlen = 0,
+                   void *out = nullptr, size_t outsize = 0) :
+    in ( (const uint8_t *) in), inlen (inlen), out ( (uint8_t *) out),
+    outsize (outsize), outlen (0) {}
+
+  void setInput (const void *data, size_t len) {
+    in = (const uint8_t *) data;
+    inlen = len;
+  }
+  void setOutput (void *data, size_t size) {
+    out = (uint8_t *) data;
+    outsize = size;
+    outlen = 0;
+  }
+  /// Number of bytes written in the output buffer
+  size_t written() const {
+    return outlen;
+  }
+
+  size_t read (const uint8_t *&data) {
+    size_t n = inlen;
+
+    data = in;
+    in += n;
+    inlen = 0;
+    return n;
+  }
+
+  bool write (const uint8_t *data, size_t len) {
+    if (outsize - outlen < len) {
+      return false;
+    }
+    memcpy (out + outlen, data, len);
+    outlen += len;
+    return true;
+  }
+
+private:
+  const uint8_t *in;
+  size_t inlen;
+  uint8_t *out;
+  size_t outsize;
+  size_t outlen;
+};
+
+// -----------------------------------------------------------------------------
+/**
+ * Byte ring buffer with one producer and one consumer, which can be two
+ * threads
+ *
+ * @param Size capacity, a power of 2
+ */
+template <size_t Size>
+class Ring {
+
+public:
+  static_assert ( (Size & (Size - 1)) == 0, "Size must be a power of 2");
+
+  Ring() : head (0), tail (0) {}
+
+  /**
+   * Writes all the bytes, or none if there is not enough room
+   */
+  bool write (const uint8_t *data, size_t len) {
+    size_t h = head.load (std::memory_order_relaxed);
+    size_t t = tail.load (std::memory_order_acquire);
+
+    if (Size - (h - t) < len) {
+      return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+      buf[ (h + i) & (Size - 1)] = data[i];
+    }
+    head.store (h + len, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Contiguous bytes which can be read, released by release()
+   */
+  size_t peek (const uint8_t *&data) const {
+    size_t t = tail.load (std::memory_order_relaxed);
+    size_t n = head.load (std::memory_order_acquire) - t;
+    size_t end = Size - (t & (Size - 1));
+
+    data = &buf[t & (Size - 1)];
+    return (n < end) ? n : end;
+  }
+
+  void release (size_t len) {
+    tail.store (tail.load (std::memory_order_relaxed) + len, std::memory_order_release);
+  }
+
+  size_t size() const {
+    return head.load (std::memory_order_acquire) - tail.load (std::memory_order_acquire);
+  }
+
+private:
+  uint8_t buf[Size];
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+};
+
+/**
+ * Transport by ring buffers, the input is decoded in place
+ *
+ * The bytes of a chunk are released at the next read.
+ */
+template <size_t Size>
+class RingTransport {
+
+public:
+  RingTransport (Ring<Size> *in = nullptr, Ring<Size> *out = nullptr) :
+    in (in), out (out), pending (0) {}
+
+  size_t read (const uint8_t *&data) {
+    in->release (pending);
+    pending = in->peek (data);
+    return pending;
+  }
+
+  bool write (const uint8_t *data, size_t len) {
+    return out->write (data, len);
+  }
+
+private:
+  Ring<Size> *in;
+  Ring<Size> *out;
+  size_t pending;
+};
+
+//##############################################################################
+//#                                                                            #
+//#                              Codec Class                                   #
+//#                                                                            #
+//##############################################################################
+/**
+ * Frame codec whose framing, transport and checksum are chosen at compile
+ * time
+ *
+ * @code
+ * radio::Codec<radio::Hdlc, radio::FdTransport, radio::Fcs16> c (fdin, fdout);
+ * while (c.poll()) {
+ *   process (c.frame(), c.length());
+ * }
+ * @endcode
+ */
+template <template <class> class Framing, class Transport, class Checksum>
+class Codec {
+
+public:
+  typedef Framing<Checksum> framing_type;
+  enum {
+    SUCCESS           =  0,
+    FILE_ACCESS_ERROR = -1,
+    INVALID_FRAME     = -3,
+    maxFrame = framing_type::maxFrame
+  };
+
+  /**
+   * The arguments are given to the constructor of the transport
+   */
+  template <class... Args>
+  explicit Codec (Args &&... args) :
+    _transport (std::forward<Args> (args)...), _data (nullptr), _len (0) {}
+
+  Transport & transport() {
+    return _transport;
+  }
+
+  /**
+   * Size of a frame of len bytes once encoded
+   */
+  static constexpr size_t encodedSize (size_t len) {
+    return framing_type::encodedSize (len);
+  }
+
+  /**
+   * Encodes a frame, the checksum is added
+   *
+   * @param out buffer of encodedSize(len) bytes
+   * @return length of the encoded frame
+   */
+  static size_t encode (uint8_t *out, const void *frame, size_t len) {
+    return framing_type::encode (out, (const uint8_t *) frame, len);
+  }
+
+  /**
+   * Encodes a frame and writes it at once
+   *
+   * @return SUCCESS, negative value on error
+   */
+  int send (const void *frame, size_t len) {
+    uint8_t out[framing_type::encodedSize (maxFrame)];
+
+    if (len > (size_t) maxFrame) {
+      return INVALID_FRAME;
+    }
+    return _transport.write (out, encode (out, frame, len)) ? SUCCESS : FILE_ACCESS_ERROR;
+  }
+
+  /**
+   * Decodes the input until a frame is received
+   *
+   * @return true if a frame is received, it is valid until the next call,
+   * false when the transport has no more input
+   */
+  bool poll() {
+    for (;;) {
+      while (_len) {
+        _len--;
+        if (_framing.push (*_data++)) {
+          return true;
+        }
+      }
+      _len = _transport.read (_data);
+      if (_len == 0) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * Decodes all the input and calls handler (frame, length) for each frame
+   *
+   * @return number of frames received
+   */
+  template <class Handler>
+  unsigned receive (Handler handler) {
+    unsigned n = 0;
+
+    while (poll()) {
+      handler (frame(), length());
+      n++;
+    }
+    return n;
+  }
+
+  /**
+   * Last frame received, without checksum
+   */
+  const uint8_t * frame() const {
+    return _framing.frame();
+  }
+  size_t length() const {
+    return _framing.length();
+  }
+
+private:
+  Transport _transport;
+  framing_type _framing;
+  const uint8_t *_data;
+  size_t _len;
+};
+
+}
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /* _SYSIO_CODEC_HPP_ */
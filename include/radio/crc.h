@@ -65,6 +65,50 @@
  */
 uint16_t usCrcCcitt (uint16_t usCrc, const void *pvBuf, size_t uLen);
 
+/**
+ * Feeds zero bytes to a CRC-CCITT register without processing them.
+ *
+ * The register transformation is linear, it is applied with precomputed GF(2)
+ * matrices for 2^k bytes, the cost depends on the number of bits set in
+ * @a uLen and not on its value.
+ *
+ * @param usCrc Register value.
+ * @param uLen  Number of zero bytes (less than 2^32).
+ *
+ * @return The register value after uLen zero bytes.
+ */
+uint16_t usCrcCcittShift (uint16_t usCrc, size_t uLen);
+
+/**
+ * Computes the CRC-CCITT of the concatenation of two buffers A and B.
+ *
+ * @param usCrc1 usCrcCcitt (CRC_CCITT_INIT_VAL, A, length of A)
+ * @param usCrc2 usCrcCcitt (CRC_CCITT_INIT_VAL, B, uLen2)
+ * @param uLen2  Length of B.
+ *
+ * @return usCrcCcitt (CRC_CCITT_INIT_VAL, A followed by B, length of A + uLen2)
+ */
+uint16_t usCrcCcittCombine (uint16_t usCrc1, uint16_t usCrc2, size_t uLen2);
+
+/**
+ * Updates the CRC-CCITT of a buffer after some of its bytes have changed.
+ *
+ * Only the changed bytes are processed. As the CRC difference does not depend
+ * on the initial and final values, @a usCrc can be the register value or its
+ * complement (AX25 FCS).
+ *
+ * @param usCrc   CRC of the buffer before the change.
+ * @param uLen    Length of the buffer.
+ * @param uOffset Offset of the changed bytes in the buffer.
+ * @param pvOld   Bytes before the change.
+ * @param pvNew   Bytes after the change.
+ * @param uCount  Number of changed bytes.
+ *
+ * @return The CRC of the buffer after the change.
+ */
+uint16_t usCrcCcittPatch (uint16_t usCrc, size_t uLen, size_t uOffset,
+                          const void *pvOld, const void *pvNew, size_t uCount);
+
 /* inline public functions ================================================ */
 
 /* CRC table */
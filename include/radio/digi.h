@@ -0,0 +1,184 @@
+/**
+ * @file digi.h
+ * @brief Digipeater AX.25
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_DIGI_H_
+#define _SYSIO_DIGI_H_
+
+#include <radio/ax25.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_digi Digipeater
+ *
+ *  Ce module fournit un digipeater qui traite directement les trames brutes
+ *  reçues dans le tampon du décodeur (xAx25Decoder::buf, voir
+ *  iAx25ReadView()), sans décodage ni réencodage. \n
+ *  Le premier répéteur non utilisé du chemin est traité :
+ *  - s'il correspond à l'indicatif du digipeater, son bit H est positionné,
+ *  - s'il correspond à un alias, il est remplacé par l'indicatif du
+ *  digipeater et son bit H est positionné,
+ *  - s'il est de la forme WIDEn-N (ou TRACEn-N...), N est décrémenté, le bit
+ *  H est positionné lorsque N atteint 0 et l'indicatif du digipeater est
+ *  inséré devant si le préfixe est configuré en mode trace.
+ *  .
+ *  Le FCS est mis à jour à partir des seuls octets modifiés. \n
+ *  Un objet xAx25Digi est configuré pour chaque port.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Maximum number of aliases of a digipeater
+ */
+#define AX25_DIGI_MAX_ALIAS 4
+
+/**
+ * Maximum number of WIDEn-N like prefixes of a digipeater
+ */
+#define AX25_DIGI_MAX_WIDE 4
+
+/**
+ * Number of frames remembered for duplicate detection
+ */
+#define AX25_DIGI_DUPE_LEN 32
+
+/**
+ * Default time during which a frame already repeated is not repeated again
+ */
+#define AX25_DIGI_DUPE_TIME 30
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Digi Class                                  #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * WIDEn-N like path prefix
+ */
+typedef struct xAx25DigiWide {
+
+  uint8_t call[AX25_CALL_LEN];  ///< on-air (shifted) prefix
+  uint8_t len;      ///< prefix length
+  uint8_t max_hops; ///< maximum n value accepted in a prefixn-N path
+  bool trace;       ///< true if the digipeater callsign is inserted
+} xAx25DigiWide;
+
+/**
+ * AX25 Digipeater Class
+ */
+typedef struct xAx25Digi {
+
+  uint8_t mycall[AX25_CALL_LEN + 1]; ///< on-air digipeater address
+  uint8_t alias[AX25_DIGI_MAX_ALIAS][AX25_CALL_LEN + 1]; ///< on-air aliases
+  uint8_t alias_len;  ///< number of aliases
+  xAx25DigiWide wide[AX25_DIGI_MAX_WIDE]; ///< WIDEn-N like prefixes
+  uint8_t wide_len;   ///< number of prefixes
+  unsigned dupe_time; ///< duplicate detection time in seconds, 0 to disable
+  struct {
+    uint16_t hash;    ///< CRC of the frame without the path
+    long time;        ///< time at which the frame was repeated
+  } dupe[AX25_DIGI_DUPE_LEN];
+  uint8_t dupe_idx;   ///< next entry of dupe to be used
+  unsigned long repeated;   ///< number of repeated frames
+  unsigned long duplicated; ///< number of duplicate frames dropped
+} xAx25Digi;
+
+/**
+ * Create and initialize a new xAx25Digi object
+ *
+ * This object should be deleted with vAx25DigiDelete()
+ * @param callsign digipeater callsign
+ * @param ssid digipeater SSID
+ * @return pointer on the object, NULL on error
+ */
+xAx25Digi * xAx25DigiNew (const char *callsign, uint8_t ssid);
+
+/**
+ * Delete a xAx25Digi object
+ *
+ * @param d digipeater object to operate on.
+ */
+void vAx25DigiDelete (xAx25Digi *d);
+
+/**
+ * Adds an alias replaced by the digipeater callsign (RELAY, WIDE...)
+ *
+ * @param d digipeater object to operate on.
+ * @param callsign alias callsign
+ * @param ssid alias SSID
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25DigiAddAlias (xAx25Digi *d, const char *callsign, uint8_t ssid);
+
+/**
+ * Adds a WIDEn-N like prefix
+ *
+ * @param d digipeater object to operate on.
+ * @param prefix path prefix, eg. "WIDE" or "TRACE"
+ * @param max_hops maximum n value accepted, paths with a greater n are not
+ * repeated
+ * @param trace true if the digipeater callsign has to be inserted in the path
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25DigiAddWide (xAx25Digi *d, const char *prefix, uint8_t max_hops, bool trace);
+
+/**
+ * Sets the duplicate detection time
+ *
+ * @param d digipeater object to operate on.
+ * @param seconds time during which a frame already repeated is dropped, 0
+ * to disable duplicate detection
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25DigiSetDupeTime (xAx25Digi *d, unsigned seconds);
+
+/**
+ * Process a raw frame in place
+ *
+ * @param d digipeater object to operate on.
+ * @param frame raw frame from the destination address to the FCS included,
+ * modified in place
+ * @param len pointer on the length of the frame, FCS included, updated if
+ * the digipeater callsign is inserted
+ * @param size size of the frame buffer
+ * @return 1 if the frame has to be repeated, 0 if not, negative value on error
+ */
+int iAx25DigiProcess (xAx25Digi *d, uint8_t *frame, size_t *len, size_t size);
+
+/**
+ * Repeat the frames received on a port
+ *
+ * Polls @a rx with bAx25Poll(), processes the received frame in place with
+ * iAx25DigiProcess(), sends it on @a tx with iAx25SendRaw() if it has to be
+ * repeated and then discards it.
+ *
+ * @param d digipeater object to operate on.
+ * @param rx AX25 port on which frames are received
+ * @param tx AX25 port on which frames are repeated, NULL to use rx
+ * @return 1 if a frame has been repeated, 0 if not, negative value on error
+ */
+int iAx25DigiPoll (xAx25Digi *d, xAx25 *rx, xAx25 *tx);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_DIGI_H_ */
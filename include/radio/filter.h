@@ -0,0 +1,145 @@
+/**
+ * @file filter.h
+ * @brief Filtre de trames AX.25 compilé
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_FILTER_H_
+#define _SYSIO_FILTER_H_
+
+#include <radio/ax25.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_filter Filtre de trames
+ *
+ *  Ce module permet de sélectionner les trames reçues avant leur décodage. \n
+ *  Une expression textuelle est compilée en un programme de tests dont chaque
+ *  instruction indique l'instruction suivante en cas de succès ou d'échec.
+ *  Le programme est exécuté directement sur la trame brute, dans le tampon du
+ *  décodeur (xAx25Decoder::buf), une trame rejetée ne coûte donc que quelques
+ *  comparaisons. \n
+ *  Syntaxe des expressions :
+ *  - dst:CALL   adresse destination
+ *  - src:CALL   adresse source
+ *  - via:CALL   un des répéteurs
+ *  - used:CALL  un des répéteurs dont le bit H est positionné (CALL*)
+ *  - unused:CALL un des répéteurs dont le bit H n'est pas positionné
+ *  - type:CHARS premier octet du champ info parmi CHARS
+ *  - info:TEXT  le champ info contient TEXT (TEXT peut être entre guillemets)
+ *  .
+ *  CALL peut être de la forme F4ABC (SSID 0), F4ABC-9, F4ABC-* (tout SSID),
+ *  F4* (tout indicatif commençant par F4, tout SSID) ou * (tout indicatif). \n
+ *  Les termes se combinent avec ! (ou not), & (ou and, ou juxtaposition),
+ *  | (ou or) et des parenthèses, par exemple :
+ *  @code dst:APRS-* & !(via:WIDE2-* | info:"test") @endcode
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Maximum number of terms in a filter expression
+ */
+#define AX25_FILTER_MAX_TERMS 16
+
+/**
+ * Maximum length of the text of an info: or type: term
+ */
+#define AX25_FILTER_STR_LEN 32
+
+//##############################################################################
+//#                                                                            #
+//#                          xAx25Filter Class                                 #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * Instruction of a compiled filter
+ *
+ * The @a jt and @a jf fields are indexes of the next instruction, or one of
+ * the AX25_FILTER_ACCEPT/AX25_FILTER_REJECT terminal values.
+ */
+typedef struct xAx25FilterInsn {
+
+  uint8_t op;   ///< test performed by the instruction
+  uint8_t jt;   ///< next instruction if the test succeeds
+  uint8_t jf;   ///< next instruction if the test fails
+  uint8_t h;    ///< required H-bit state for repeater tests (0, 1, other: any)
+  uint8_t call[AX25_CALL_LEN]; ///< on-air (shifted) callsign pattern
+  uint8_t call_len; ///< number of significant bytes in call
+  int8_t  ssid; ///< ssid to match, -1 for any ssid
+  uint8_t str_len;  ///< length of str
+  char    str[AX25_FILTER_STR_LEN + 1]; ///< info text or type characters
+} xAx25FilterInsn;
+
+/** Terminal value of xAx25FilterInsn::jt/jf: the frame is accepted */
+#define AX25_FILTER_ACCEPT 0xFF
+/** Terminal value of xAx25FilterInsn::jt/jf: the frame is rejected */
+#define AX25_FILTER_REJECT 0xFE
+
+/**
+ * AX25 Frame Filter Class
+ */
+typedef struct xAx25Filter {
+
+  xAx25FilterInsn insn[AX25_FILTER_MAX_TERMS]; ///< compiled program
+  uint8_t len;    ///< number of instructions
+  uint8_t entry;  ///< index of the first instruction to execute
+  bool need_path; ///< true if the program has to walk through the address field
+} xAx25Filter;
+
+/**
+ * Create a new xAx25Filter object and compile an expression
+ *
+ * This object should be deleted with vAx25FilterDelete()
+ * @param expr filter expression, NULL or empty to accept all frames
+ * @return pointer on the object, NULL on error
+ */
+xAx25Filter * xAx25FilterNew (const char * expr);
+
+/**
+ * Delete a xAx25Filter object
+ *
+ * @param f filter object to operate on.
+ */
+void vAx25FilterDelete (xAx25Filter *f);
+
+/**
+ * Compile an expression in a filter object
+ *
+ * @param f filter object to operate on.
+ * @param expr filter expression, NULL or empty to accept all frames
+ * @return AX25_SUCCESS, negative value on error (AX25_ILLEGAL_FILTER if the
+ * expression is incorrect)
+ */
+int iAx25FilterCompile (xAx25Filter *f, const char * expr);
+
+/**
+ * Run a filter on a raw frame
+ *
+ * @param f filter object to operate on.
+ * @param frame raw frame, starting with the destination address
+ * @param len length of the frame without the FCS
+ * @return true if the frame is accepted
+ */
+bool bAx25FilterMatch (const xAx25Filter *f, const uint8_t *frame, size_t len);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_FILTER_H_ */
@@ -0,0 +1,385 @@
+/**
+ * @file link.h
+ * @brief Liaison AX.25 en mode connecté
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_LINK_H_
+#define _SYSIO_LINK_H_
+
+#include <radio/ax25.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_link Liaison en mode connecté
+ *
+ *  Ce module fournit la couche liaison de données AX.25 2.2 en mode
+ *  connecté, au-dessus d'un port xAx25 : établissement et libération des
+ *  connexions (SABM, SABME, UA, DISC, DM), transfert fiable de trames I avec
+ *  une fenêtre de k trames en modulo 8 (k jusqu'à 7) ou en modulo 128 (k
+ *  jusqu'à 127), acquittements et contrôle de flux par RR, RNR, REJ et SREJ,
+ *  temporisateurs T1 (adapté au temps d'aller-retour mesuré, SRTT), T2 et
+ *  T3. \n
+ *  Un objet xAx25Link est créé pour chaque port et indicatif local, il gère
+ *  un nombre quelconque de connexions simultanées (xAx25Conn) avec des
+ *  stations distantes différentes. Les trames reçues sont données par
+ *  iAx25LinkInput() (ou lues sur le port par iAx25LinkPoll()), les
+ *  temporisateurs sont traités par lAx25LinkTimer(). Les événements
+ *  (connexion, déconnexion, données reçues) sont donnés à un gestionnaire. \n
+ *  La réjection sélective (SREJ) n'est utilisée qu'en modulo 128, les
+ *  paramètres ne sont pas négociés par XID.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Control fields of the U and S frames, the P/F bit is AX25_CTRL_PF
+ */
+#define AX25_CTRL_SABM    0x2F
+#define AX25_CTRL_SABME   0x6F
+#define AX25_CTRL_DISC    0x43
+#define AX25_CTRL_DM      0x0F
+#define AX25_CTRL_UA      0x63
+#define AX25_CTRL_FRMR    0x87
+#define AX25_CTRL_RR      0x01
+#define AX25_CTRL_RNR     0x05
+#define AX25_CTRL_REJ     0x09
+#define AX25_CTRL_SREJ    0x0D
+#define AX25_CTRL_PF      0x10
+
+/**
+ * Default maximum length of the info field of the I frames (N1)
+ */
+#define AX25_LINK_N1 256
+/**
+ * Default window size in modulo 8 and modulo 128 (k)
+ */
+#define AX25_LINK_K 4
+#define AX25_LINK_K_EXT 32
+/**
+ * Default maximum number of retries (N2)
+ */
+#define AX25_LINK_N2 10
+/**
+ * Default timers in milliseconds: initial T1 (acknowledgement), T2 (delay
+ * of the acknowledgements) and T3 (inactive link)
+ */
+#define AX25_LINK_T1 3000
+#define AX25_LINK_T2 100
+#define AX25_LINK_T3 300000
+
+/**
+ * States of a connection
+ */
+typedef enum {
+
+  AX25_LINK_DISCONNECTED        = 0,
+  AX25_LINK_AWAITING_CONNECTION = 1,
+  AX25_LINK_AWAITING_RELEASE    = 2,
+  AX25_LINK_CONNECTED           = 3,
+  AX25_LINK_TIMER_RECOVERY      = 4
+
+} eAx25LinkState;
+
+/**
+ * Events given to the handler
+ */
+typedef enum {
+
+  AX25_LINK_EV_CONNECTED    = 1, ///< connection established
+  AX25_LINK_EV_DISCONNECTED = 2, ///< connection released, see xAx25Conn::reason
+  AX25_LINK_EV_DATA         = 3  ///< info field of an I frame received in sequence
+
+} eAx25LinkEvent;
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Link Class                                  #
+//#                                                                            #
+//##############################################################################
+
+struct xAx25Link;
+struct xAx25Conn;
+struct xAx25LinkBuf;
+
+/**
+ * Handler of the events of the connections
+ *
+ * A connection released is deleted when the handler returns from the
+ * AX25_LINK_EV_DISCONNECTED event.
+ *
+ * @param conn connection of the event
+ * @param event event, see eAx25LinkEvent
+ * @param data info field received for AX25_LINK_EV_DATA, NULL otherwise,
+ * only valid until the handler returns
+ * @param len length of data
+ * @param ctx context given to xAx25LinkNew()
+ */
+typedef void (*vAx25LinkHandler) (struct xAx25Conn *conn, int event,
+                                  const uint8_t *data, size_t len, void *ctx);
+
+/**
+ * AX25 Connection Class
+ */
+typedef struct xAx25Conn {
+
+  struct xAx25Link *link;   ///< link of the connection
+  struct xAx25Conn *next;   ///< next connection of the link
+  uint8_t remote[AX25_CALL_LEN + 1]; ///< on-air address of the remote station
+  uint8_t path[AX25_MAX_RPT][AX25_CALL_LEN + 1]; ///< on-air repeaters, H bits cleared
+  uint8_t path_len;   ///< number of repeaters
+  int state;          ///< state, see eAx25LinkState
+  int reason;         ///< AX25_SUCCESS, or reason of the release
+  unsigned modulo;    ///< 8 or 128
+  unsigned k;         ///< window size
+  size_t n1;          ///< maximum length of the info field
+  unsigned n2;        ///< maximum number of retries
+  unsigned vs;        ///< send state variable V(S)
+  unsigned va;        ///< acknowledge state variable V(A)
+  unsigned vr;        ///< receive state variable V(R)
+  unsigned rc;        ///< retry count
+  bool srej;          ///< true if the selective reject is used
+  bool peer_busy;     ///< true if RNR received
+  bool own_busy;      ///< true if the application can not receive
+  bool rej_sent;      ///< reject exception condition
+  bool ack_pending;   ///< an acknowledgement has to be sent
+  long srtt;          ///< smoothed round trip time in ms
+  long t1v;           ///< current T1 value in ms
+  long long t1;       ///< T1 expiry time in ms, 0 if stopped
+  long long t2;       ///< T2 expiry time in ms, 0 if stopped
+  long long t3;       ///< T3 expiry time in ms, 0 if stopped
+  long long rtt_time; ///< time at which the frame rtt_seq has been sent
+  unsigned rtt_seq;   ///< N(S) of the frame whose round trip time is measured
+  bool rtt_valid;     ///< true while the round trip time of rtt_seq is measured
+  struct xAx25LinkBuf *tx[128]; ///< frames sent not yet acknowledged, by N(S)
+  struct xAx25LinkBuf *rx[128]; ///< frames received out of sequence, by N(S)
+  bool srej_sent[128]; ///< true if the frame N(S) has been requested by SREJ
+  struct xAx25LinkBuf *txq;     ///< queue of the frames not yet sent
+  struct xAx25LinkBuf *txq_tail; ///< last frame of txq
+  void *udata;        ///< user data
+} xAx25Conn;
+
+/**
+ * AX25 Connected Mode Link Class
+ */
+typedef struct xAx25Link {
+
+  xAx25 *port;        ///< port on which the frames are sent and received
+  uint8_t mycall[AX25_CALL_LEN + 1]; ///< on-air local address
+  xAx25Conn *conn;    ///< list of the connections
+  vAx25LinkHandler handler; ///< handler of the events
+  void *ctx;          ///< context given to handler
+  bool listen;        ///< true if the incoming connections are accepted
+  bool srej;          ///< true if the selective reject is used in modulo 128
+  unsigned k;         ///< window size in modulo 8
+  unsigned k_ext;     ///< window size in modulo 128
+  size_t n1;          ///< maximum length of the info field
+  unsigned n2;        ///< maximum number of retries
+  long t1;            ///< initial T1 in ms
+  long t2;            ///< T2 in ms
+  long t3;            ///< T3 in ms
+  unsigned long frames_sent; ///< number of frames sent
+  unsigned long frames_resent; ///< number of I frames sent again
+} xAx25Link;
+
+/**
+ * Create and initialize a new xAx25Link object
+ *
+ * This object should be deleted with vAx25LinkDelete()
+ * @param port port on which the frames are sent and received
+ * @param callsign local callsign
+ * @param ssid local SSID
+ * @param handler handler of the events
+ * @param ctx context given to the handler
+ * @return pointer on the object, NULL on error
+ */
+xAx25Link * xAx25LinkNew (xAx25 *port, const char *callsign, uint8_t ssid,
+                          vAx25LinkHandler handler, void *ctx);
+
+/**
+ * Delete a xAx25Link object
+ *
+ * The connections are deleted without being released.
+ *
+ * @param l link object to operate on.
+ */
+void vAx25LinkDelete (xAx25Link *l);
+
+/**
+ * Accept or refuse the incoming connections, refused by default
+ *
+ * @param l link object to operate on.
+ * @param listen true to accept the incoming connections
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25LinkListen (xAx25Link *l, bool listen);
+
+/**
+ * Sets the window size of the new connections
+ *
+ * @param l link object to operate on.
+ * @param k window size in modulo 8, from 1 to 7
+ * @param k_ext window size in modulo 128, from 1 to 127
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25LinkSetWindow (xAx25Link *l, unsigned k, unsigned k_ext);
+
+/**
+ * Sets the maximum length of the info field and the maximum number of
+ * retries of the new connections
+ *
+ * @param l link object to operate on.
+ * @param n1 maximum length of the info field, up to AX25_INFO_LEN
+ * @param n2 maximum number of retries
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25LinkSetLimits (xAx25Link *l, size_t n1, unsigned n2);
+
+/**
+ * Sets the timers of the new connections
+ *
+ * @param l link object to operate on.
+ * @param t1 initial T1 in milliseconds, it is then adapted to the round trip
+ * time measured
+ * @param t2 delay of the acknowledgements in milliseconds, 0 to acknowledge
+ * at once
+ * @param t3 inactive link timer in milliseconds
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25LinkSetTimers (xAx25Link *l, long t1, long t2, long t3);
+
+/**
+ * Enable or disable the selective reject in modulo 128, enabled by default
+ *
+ * @param l link object to operate on.
+ * @param srej true to use SREJ, false to use REJ
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25LinkSetSrej (xAx25Link *l, bool srej);
+
+/**
+ * Process a received frame
+ *
+ * The frames which are not addressed to the local station, and the UI frames,
+ * are not processed.
+ *
+ * @param l link object to operate on.
+ * @param frame view on the received frame
+ * @return 1 if the frame is processed, 0 if not, negative value on error
+ */
+int iAx25LinkInput (xAx25Link *l, const xAx25View *frame);
+
+/**
+ * Process the expired timers and send the pending frames
+ *
+ * @param l link object to operate on.
+ * @return time in milliseconds until the next timer expires, -1 if no timer
+ * is running
+ */
+long lAx25LinkTimer (xAx25Link *l);
+
+/**
+ * Wait for frames on the port and process them
+ *
+ * The frames are read on the port with bAx25PollTimeout() and iAx25ReadView(),
+ * they are processed by iAx25LinkInput() and discarded. The timers are
+ * processed by lAx25LinkTimer(). The function returns when frames have been
+ * processed or when the timeout is elapsed.
+ *
+ * @param l link object to operate on.
+ * @param timeout_ms timeout in milliseconds, negative value to wait forever
+ * @return number of frames processed, negative value on error
+ */
+int iAx25LinkPoll (xAx25Link *l, int timeout_ms);
+
+/**
+ * Connect to a remote station
+ *
+ * @param l link object to operate on.
+ * @param remote remote station
+ * @param path repeaters, NULL if none
+ * @param path_len number of repeaters
+ * @param extended true for the modulo 128 (SABME), false for the modulo 8
+ * @return the connection, in the state AX25_LINK_AWAITING_CONNECTION until
+ * the AX25_LINK_EV_CONNECTED event, NULL on error
+ */
+xAx25Conn * xAx25LinkConnect (xAx25Link *l, const xAx25Node *remote,
+                              const xAx25Node *path, unsigned path_len,
+                              bool extended);
+
+/**
+ * Returns the connection with a remote station, NULL if none
+ *
+ * @param l link object to operate on.
+ * @param remote remote station
+ */
+xAx25Conn * xAx25LinkFind (xAx25Link *l, const xAx25Node *remote);
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Conn Class                                  #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * Send data on a connection
+ *
+ * The data are copied and split in I frames of at most n1 bytes, which are
+ * sent as soon as the window and the state of the connection allow it.
+ *
+ * @param c connection object to operate on.
+ * @param data data to send
+ * @param len number of bytes
+ * @return number of bytes queued, negative value on error
+ */
+ssize_t iAx25ConnSend (xAx25Conn *c, const void *data, size_t len);
+
+/**
+ * Number of I frames queued or sent and not yet acknowledged
+ *
+ * @param c connection object to operate on.
+ */
+unsigned uAx25ConnPending (const xAx25Conn *c);
+
+/**
+ * Sets the busy condition of the application
+ *
+ * While busy, the received I frames are dropped and the remote station is
+ * told to stop sending by RNR frames.
+ *
+ * @param c connection object to operate on.
+ * @param busy true if the application can not receive
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25ConnSetBusy (xAx25Conn *c, bool busy);
+
+/**
+ * Release a connection
+ *
+ * The frames not yet acknowledged are dropped, the AX25_LINK_EV_DISCONNECTED
+ * event is given when the remote station confirms or after N2 retries.
+ *
+ * @param c connection object to operate on.
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25ConnDisconnect (xAx25Conn *c);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_LINK_H_ */
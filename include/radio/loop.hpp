@@ -0,0 +1,256 @@
+/**
+ * @file loop.hpp
+ * @brief Boucle d'événements et opérations asynchrones (C++)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_LOOP_HPP_
+#define _SYSIO_LOOP_HPP_
+
+#include <unordered_map>
+#include <poll.h>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#endif
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_loop Boucle d'événements
+ *
+ *  Une boucle d'événements surveille les descripteurs de fichiers des ports
+ *  et réveille les opérations en attente. Avec un compilateur C++20, les
+ *  méthodes asyncReceive() et asyncSend() des classes Ax25 et Tnc
+ *  retournent des opérations qui peuvent être attendues par co_await dans une
+ *  coroutine Task : des milliers de ports ne coûtent alors qu'une trame de
+ *  coroutine chacun, et non un thread. \n
+ *  EventLoop est l'interface implémentée par la boucle : EpollLoop est
+ *  fournie, une application peut implémenter la sienne pour intégrer les
+ *  ports dans sa propre boucle.
+ *  @{
+ */
+
+//##############################################################################
+//#                                                                            #
+//#                            EventLoop Class                                 #
+//#                                                                            #
+//##############################################################################
+/**
+ * Event loop interface
+ */
+class EventLoop {
+
+public:
+  enum {
+    READ   = 1, ///< the file descriptor is readable
+    WRITE  = 2, ///< the file descriptor is writable
+    HANGUP = 4  ///< end of file or error
+  };
+
+  /**
+   * Operation waiting for a file descriptor
+   *
+   * ready() is called by the loop with the events received, as long as the
+   * waiter is not removed with unwatch().
+   */
+  struct Waiter {
+    void (*ready) (Waiter *w, unsigned events);
+  };
+
+  virtual ~EventLoop() {}
+
+  /**
+   * Wait for an event on a file descriptor
+   *
+   * Only one waiter can wait for an event on a file descriptor, but a reader
+   * and a writer can wait for the same file descriptor.
+   * @param fd file descriptor
+   * @param event READ or WRITE
+   * @param w waiter called when the event occurs
+   * @return 0, negative value on error
+   */
+  virtual int watch (int fd, unsigned event, Waiter *w) = 0;
+
+  /**
+   * Stop waiting for an event on a file descriptor
+   *
+   * @param fd file descriptor
+   * @param event READ or WRITE
+   */
+  virtual void unwatch (int fd, unsigned event) = 0;
+
+  /**
+   * Loop running in the calling thread, NULL if none
+   */
+  static EventLoop * current();
+
+  /**
+   * Sets the loop running in the calling thread
+   */
+  static void setCurrent (EventLoop *loop);
+};
+
+//##############################################################################
+//#                                                                            #
+//#                            EpollLoop Class                                 #
+//#                                                                            #
+//##############################################################################
+/**
+ * Event loop based on epoll
+ */
+class EpollLoop : public EventLoop {
+
+public:
+  EpollLoop();
+  ~EpollLoop();
+
+  int watch (int fd, unsigned event, Waiter *w);
+  void unwatch (int fd, unsigned event);
+
+  /**
+   * Runs the loop in the calling thread
+   *
+   * The loop is the current loop of the thread until the return, which
+   * occurs when no more waiter is waiting or when stop() is called.
+   * @return 0, negative value on error
+   */
+  int run();
+
+  /**
+   * Waits for the events once and calls the waiters
+   *
+   * @param timeoutMs maximum wait in milliseconds, negative value to wait
+   * forever
+   * @return number of waiters called, negative value on error
+   */
+  int runOnce (int timeoutMs);
+
+  /**
+   * Stops run()
+   */
+  void stop();
+
+  /**
+   * Number of waiters
+   */
+  unsigned waiters() const;
+
+private:
+  struct Watch {
+    Waiter *reader;
+    Waiter *writer;
+  };
+  int update (int fd, const Watch &w, bool added);
+
+  int epfd;
+  bool stopped;
+  unsigned count;
+  std::unordered_map<int, Watch> fds;
+};
+
+#if defined(__cpp_impl_coroutine)
+//##############################################################################
+//#                                                                            #
+//#                               Task Class                                   #
+//#                                                                            #
+//##############################################################################
+/**
+ * Coroutine started at once and destroyed when it ends
+ *
+ * A function returning a Task can use co_await on the asynchronous operations
+ * of Ax25 and Tnc, it returns to its caller at the first suspension.
+ */
+class Task {
+
+public:
+  struct promise_type {
+    Task get_return_object() {
+      return Task();
+    }
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+    void return_void() {}
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+};
+
+//##############################################################################
+//#                                                                            #
+//#                             FdAwaiter Class                                #
+//#                                                                            #
+//##############################################################################
+/**
+ * Operation waiting for a file descriptor in a coroutine
+ *
+ * T must provide bool attempt (unsigned events), called with 0 before the
+ * suspension then with the events received, which returns true when the
+ * operation is done.
+ */
+template <class T>
+class FdAwaiter : public EventLoop::Waiter {
+
+public:
+  FdAwaiter (EventLoop *loop, int fd, unsigned event) :
+    loop (loop ? loop : EventLoop::current()), fd (fd), event (event) {
+    ready = &FdAwaiter::wakeup;
+  }
+
+  bool await_ready() {
+    return (fd < 0) || static_cast<T *> (this)->attempt (0);
+  }
+
+  bool await_suspend (std::coroutine_handle<> h) {
+    handle = h;
+    // Without loop, the coroutine is resumed at once and the operation fails
+    return (loop) && (loop->watch (fd, event, this) == 0);
+  }
+
+  /**
+   * Events of a file descriptor, without waiting
+   */
+  static unsigned events (int fd, unsigned event) {
+    struct pollfd pfd = { fd, (short) ( (event == EventLoop::READ) ? POLLIN : POLLOUT), 0 };
+    unsigned ev = 0;
+
+    if (::poll (&pfd, 1, 0) > 0) {
+      ev |= (pfd.revents & POLLIN) ? EventLoop::READ : 0;
+      ev |= (pfd.revents & POLLOUT) ? EventLoop::WRITE : 0;
+      ev |= (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) ? EventLoop::HANGUP : 0;
+    }
+    return ev;
+  }
+
+protected:
+  EventLoop *loop;
+  int fd;
+  unsigned event;
+
+private:
+  static void wakeup (EventLoop::Waiter *w, unsigned ev) {
+    FdAwaiter *a = static_cast<FdAwaiter *> (w);
+
+    if (static_cast<T *> (a)->attempt (ev)) {
+      a->loop->unwatch (a->fd, a->event);
+      a->handle.resume();
+    }
+  }
+  std::coroutine_handle<> handle;
+};
+#endif /* __cpp_impl_coroutine */
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#endif /* _SYSIO_LOOP_HPP_ */
@@ -0,0 +1,202 @@
+/**
+ * @file mux.h
+ * @brief Multiplexeur d'entrées-sorties de plusieurs ports
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_MUX_H_
+#define _SYSIO_MUX_H_
+
+#include <radio/ax25.h>
+#include <radio/tnc.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_mux Multiplexeur de ports
+ *
+ *  Ce module gère les entrées-sorties de plusieurs ports AX.25 ou TNC depuis
+ *  un seul thread. Les octets reçus sont décodés par bAx25Feed() ou
+ *  iTncFeed() et chaque trame reçue est passée au gestionnaire du port. Les
+ *  trames à émettre sont mises en file et écrites lors de l'appel suivant à
+ *  iMuxPoll(). \n
+ *  Lorsque le noyau le permet, io_uring est utilisé : une lecture multishot
+ *  par port dans un anneau de tampons fournis, les écritures d'un port étant
+ *  chaînées, et toutes les complétions disponibles traitées en une fois, ce
+ *  qui ne coûte qu'un appel système par itération quel que soit le nombre de
+ *  ports. Sinon, epoll est utilisé avec une lecture et une écriture par port
+ *  prêt.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Backend of the multiplexer
+ */
+typedef enum {
+
+  AX25_MUX_AUTO  = 0, ///< io_uring if available, epoll otherwise
+  AX25_MUX_URING = 1, ///< io_uring
+  AX25_MUX_EPOLL = 2  ///< epoll
+} eAx25MuxBackend;
+
+/**
+ * Default number of receive buffers
+ */
+#define AX25_MUX_BUFFERS 64
+
+/**
+ * Size of a receive buffer
+ */
+#define AX25_MUX_BUFFER_SIZE 1024
+
+//##############################################################################
+//#                                                                            #
+//#                               xMux Class                                   #
+//#                                                                            #
+//##############################################################################
+
+struct xMux;
+struct xMuxPort;
+struct xMuxTx;
+
+/**
+ * Handler called for each frame received on a port
+ *
+ * For an AX25 port, the frame is read with iAx25Read() or iAx25ReadView(), it
+ * is discarded after the return of the handler. For a TNC port, the message
+ * is in the rxbuf field of the xTnc object. This handler is not called for
+ * the ports whose object has its own receive handler (see iAx25SetRxHandler()
+ * and iTncSetRxHandler()), the frames are then given to that handler.
+ *
+ * @param mux multiplexer
+ * @param port port number returned by iMuxAddAx25() or iMuxAddTnc()
+ * @param udata pointer given when the port was added
+ */
+typedef void (*vMuxHandler) (struct xMux *mux, int port, void *udata);
+
+/**
+ * Multiplexer Class
+ */
+typedef struct xMux {
+
+  int backend;          ///< eAx25MuxBackend used, never AX25_MUX_AUTO
+  int fd;               ///< io_uring or epoll file descriptor
+  struct xMuxPort *port; ///< ports
+  int nports;           ///< number of ports
+  int nopen;            ///< number of ports whose input is not closed
+  void *uring;          ///< io_uring rings, NULL for epoll
+  uint8_t *bufs;        ///< receive buffers
+  unsigned nbufs;       ///< number of receive buffers
+  unsigned long frames; ///< number of frames received
+  unsigned long errors; ///< number of frames received with a CRC error
+  unsigned long syscalls; ///< number of system calls done by iMuxPoll()
+} xMux;
+
+/**
+ * Create a multiplexer
+ *
+ * This object should be deleted with vMuxDelete()
+ * @param backend eAx25MuxBackend, with AX25_MUX_AUTO, epoll is used if
+ * io_uring is not available
+ * @param nbufs number of receive buffers, 0 for AX25_MUX_BUFFERS
+ * @return pointer on the object, NULL on error or if the backend is not
+ * available
+ */
+xMux * xMuxNew (int backend, unsigned nbufs);
+
+/**
+ * Delete a multiplexer
+ *
+ * The frames not yet sent are lost, the file descriptors of the ports are not
+ * closed.
+ * @param mux object to operate on.
+ */
+void vMuxDelete (xMux *mux);
+
+/**
+ * Add an AX25 port
+ *
+ * The frames are received from the fin file descriptor of @a ax25 and sent to
+ * its fout file descriptor. The object is not copied and must remain valid as
+ * long as the multiplexer is used.
+ * @param mux object to operate on.
+ * @param ax25 AX25 object of the port
+ * @param handler function called for each received frame
+ * @param udata pointer given to the handler
+ * @return port number, negative value on error
+ */
+int iMuxAddAx25 (xMux *mux, xAx25 *ax25, vMuxHandler handler, void *udata);
+
+/**
+ * Add a TNC port
+ *
+ * Same as iMuxAddAx25() for a TNC object.
+ * @param mux object to operate on.
+ * @param tnc TNC object of the port
+ * @param handler function called for each received message
+ * @param udata pointer given to the handler
+ * @return port number, negative value on error
+ */
+int iMuxAddTnc (xMux *mux, xTnc *tnc, vMuxHandler handler, void *udata);
+
+/**
+ * Queue a frame to send on a port
+ *
+ * The frame is encoded at once, and written during the next call to
+ * iMuxPoll(). The frames of a port are written in order.
+ * @param mux object to operate on.
+ * @param port port number
+ * @param frame for an AX25 port, raw frame from the destination address to
+ * the FCS included (see iAx25SendRaw()), for a TNC port, message
+ * @param len length of the frame
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iMuxSend (xMux *mux, int port, const void *frame, size_t len);
+
+/**
+ * Write the queued frames, wait for input and call the handlers
+ *
+ * @param mux object to operate on.
+ * @param timeout_ms maximum wait in milliseconds, 0 to return at once,
+ * negative value to wait forever
+ * @return number of frames received, 0 on timeout, negative value on error
+ */
+int iMuxPoll (xMux *mux, int timeout_ms);
+
+/**
+ * Number of ports whose input is not closed
+ *
+ * The input of a port is closed when the end of file is read.
+ * @param mux object to operate on.
+ * @return number of ports, negative value on error
+ */
+int iMuxOpenPorts (const xMux *mux);
+
+/**
+ * Number of bytes queued and not yet written on a port
+ *
+ * @param mux object to operate on.
+ * @param port port number
+ * @return number of bytes, negative value on error
+ */
+ssize_t iMuxPending (const xMux *mux, int port);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_MUX_H_ */
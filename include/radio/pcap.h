@@ -0,0 +1,144 @@
+/**
+ * @file pcap.h
+ * @brief Export de trames au format pcap/pcapng
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_PCAP_H_
+#define _SYSIO_PCAP_H_
+
+#include <radio/ax25.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_pcap Export pcap/pcapng
+ *
+ *  Ce module enregistre les trames AX.25 dans des fichiers lisibles par
+ *  Wireshark ou tcpdump, au format pcapng (une interface par port) ou pcap,
+ *  avec le type de lien LINKTYPE_AX25 (3) ou LINKTYPE_AX25_KISS (202), dont
+ *  l'octet KISS contient le numéro de port. Les trames sont horodatées à la
+ *  nanoseconde. \n
+ *  iPcapWrite() ne fait que copier la trame dans un tampon circulaire sans
+ *  verrou, un thread se chargeant de l'écriture du fichier. Le tampon n'admet
+ *  qu'un seul producteur : plusieurs ports doivent être lus par le même
+ *  thread. Lorsque le tampon est plein, les trames sont perdues et comptées
+ *  dans xPcap::dropped. \n
+ *  Pour une capture permanente, un nouveau fichier (path.0000, path.0001...)
+ *  est créé chaque fois que la taille maximale est atteinte.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Link type of the AX.25 frames
+ */
+#define AX25_LINKTYPE_AX25      3
+
+/**
+ * Link type of the AX.25 frames preceded by a KISS byte
+ */
+#define AX25_LINKTYPE_AX25_KISS 202
+
+/**
+ * Default size of the ring buffer
+ */
+#define AX25_PCAP_RING_SIZE (256 * 1024)
+
+/**
+ * Maximum number of ports (interfaces of a pcapng file)
+ */
+#define AX25_PCAP_MAX_PORTS 16
+
+/**
+ * File format
+ */
+typedef enum {
+
+  AX25_PCAP   = 0,  ///< pcap with nanosecond timestamps
+  AX25_PCAPNG = 1   ///< pcapng, one interface per port
+} eAx25PcapFormat;
+
+//##############################################################################
+//#                                                                            #
+//#                               xPcap Class                                  #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * pcap/pcapng writer Class
+ */
+typedef struct xPcap {
+
+  uint8_t *ring;        ///< ring buffer
+  size_t size;          ///< ring buffer size, power of 2
+  size_t head;          ///< write index, updated by the producer
+  size_t tail;          ///< read index, updated by the writer thread
+  bool stop;            ///< true to stop the writer thread
+  pthread_t thread;     ///< writer thread
+  FILE *file;           ///< current file
+  char *path;           ///< file name or prefix if rotated
+  unsigned index;       ///< index of the current file
+  size_t file_len;      ///< length of the current file
+  size_t rotate;        ///< maximum length of a file, 0 if not rotated
+  int format;           ///< eAx25PcapFormat
+  int linktype;         ///< AX25_LINKTYPE_AX25 or AX25_LINKTYPE_AX25_KISS
+  int ifid[AX25_PCAP_MAX_PORTS]; ///< pcapng interface of each port, -1 if none
+  int nif;              ///< number of interfaces of the current file
+  unsigned long frames; ///< number of frames written
+  unsigned long dropped; ///< number of frames lost, ring buffer full
+} xPcap;
+
+/**
+ * Create a pcap writer, the file is created and the writer thread started
+ *
+ * This object should be deleted with vPcapDelete()
+ * @param path file name, prefix of the files if @a rotate is not 0
+ * @param format eAx25PcapFormat
+ * @param kiss true for LINKTYPE_AX25_KISS, false for LINKTYPE_AX25
+ * @param ring_size size of the ring buffer, 0 for AX25_PCAP_RING_SIZE
+ * @param rotate maximum length of a file, 0 for a single file
+ * @return pointer on the object, NULL on error
+ */
+xPcap * xPcapNew (const char *path, int format, bool kiss, size_t ring_size,
+                  size_t rotate);
+
+/**
+ * Delete a pcap writer
+ *
+ * The frames in the ring buffer are written before the file is closed.
+ * @param p object to operate on.
+ */
+void vPcapDelete (xPcap *p);
+
+/**
+ * Queue a frame
+ *
+ * @param p object to operate on.
+ * @param port port the frame was received from (0 to AX25_PCAP_MAX_PORTS - 1)
+ * @param frame frame without FCS
+ * @param len frame length
+ * @return AX25_SUCCESS, AX25_NOT_ENOUGH_MEMORY if the ring buffer is full,
+ * negative value on error
+ */
+int iPcapWrite (xPcap *p, uint16_t port, const void *frame, size_t len);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_PCAP_H_ */
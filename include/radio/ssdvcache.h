@@ -0,0 +1,180 @@
+/**
+ * @file ssdvcache.h
+ * @brief Réassemblage d'images SSDV
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_SSDVCACHE_H_
+#define _SYSIO_SSDVCACHE_H_
+
+#include <radio/tnc.h>
+#include <ssdv/ssdv.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25_tnc
+ *  @{
+ *  @defgroup radio_ax25_tnc_ssdv Réassemblage d'images SSDV
+ *
+ *  Ce module réassemble les images SSDV reçues par paquets, plusieurs images
+ *  pouvant être reçues simultanément depuis plusieurs indicatifs. \n
+ *  Toute la mémoire est allouée à la création du cache : un nombre fixe
+ *  d'emplacements, chacun pouvant contenir une image d'un nombre maximal de
+ *  paquets. Une image est identifiée par l'indicatif et le numéro d'image
+ *  contenus dans l'entête des paquets. Lorsque tous les emplacements sont
+ *  occupés, l'image la moins récemment mise à jour est remplacée. \n
+ *  Les paquets reçus dans l'ordre sont décodés au fil de l'eau, l'image JPEG
+ *  est donc disponible dès la réception du dernier paquet. Une image
+ *  incomplète peut être obtenue à tout moment, les paquets manquants étant
+ *  remplacés par des blocs vides.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Default number of images in a cache
+ */
+#define SSDV_CACHE_SLOTS 4
+
+/**
+ * Default maximum number of packets of an image
+ */
+#define SSDV_CACHE_MAX_PACKETS 512
+
+/**
+ * Default size of the JPEG buffer of an image
+ */
+#define SSDV_CACHE_JPEG_SIZE (256 * 1024)
+
+/**
+ * Length of a decoded SSDV callsign with its terminating null character
+ */
+#define SSDV_CALL_LEN 11
+
+//##############################################################################
+//#                                                                            #
+//#                            xSsdvCache Class                                #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * Image being reassembled
+ */
+typedef struct xSsdvSlot {
+
+  bool used;            ///< true if the slot holds an image
+  bool complete;        ///< true if all packets have been received
+  uint32_t callsign;    ///< encoded callsign of the image
+  char call[SSDV_CALL_LEN]; ///< decoded callsign
+  uint8_t image_id;     ///< image number
+  uint16_t width;       ///< image width in pixels
+  uint16_t height;      ///< image height in pixels
+  uint16_t received;    ///< number of different packets received
+  uint16_t last_id;     ///< id of the last packet of the image, 0xFFFF if unknown
+  uint16_t next_id;     ///< id of the next packet to be decoded
+  unsigned long tick;   ///< time of the last update, used for LRU eviction
+  uint32_t *bitmap;     ///< bit n set if the packet n has been received
+  uint8_t *packets;     ///< packets received, SSDV_PKT_SIZE bytes per packet
+  uint8_t *jpeg;        ///< JPEG buffer of the progressive decoder
+  size_t jpeg_len;      ///< JPEG length when complete
+  ssdv_t dec;           ///< progressive decoder
+} xSsdvSlot;
+
+/**
+ * SSDV Reassembly Cache Class
+ */
+typedef struct xSsdvCache {
+
+  xSsdvSlot *slot;        ///< slots
+  unsigned slots;         ///< number of slots
+  unsigned max_packets;   ///< maximum number of packets of an image
+  size_t jpeg_size;       ///< size of the JPEG buffer of each slot
+  unsigned long tick;     ///< incremented for each packet received
+  unsigned long evicted;  ///< number of images evicted before completion
+  ssdv_t scratch;         ///< decoder used for the partial images
+} xSsdvCache;
+
+/**
+ * Create a new xSsdvCache object, all the memory is allocated
+ *
+ * This object should be deleted with vSsdvCacheDelete()
+ * @param slots number of images which can be reassembled at once
+ * @param max_packets maximum number of packets of an image
+ * @param jpeg_size size of the JPEG buffer of each image
+ * @return pointer on the object, NULL on error
+ */
+xSsdvCache * xSsdvCacheNew (unsigned slots, unsigned max_packets, size_t jpeg_size);
+
+/**
+ * Delete a xSsdvCache object
+ *
+ * @param c cache object to operate on.
+ */
+void vSsdvCacheDelete (xSsdvCache *c);
+
+/**
+ * Adds a received packet
+ *
+ * @param c cache object to operate on.
+ * @param packet SSDV packet already checked and corrected by
+ * ssdv_dec_is_packet()
+ * @return 1 if the image of the packet is now complete, 0 if not, negative
+ * value on error
+ */
+int iSsdvCacheFeed (xSsdvCache *c, const uint8_t *packet);
+
+/**
+ * Look for an image
+ *
+ * @param c cache object to operate on.
+ * @param callsign encoded callsign, as in ssdv_packet_info_t
+ * @param image_id image number
+ * @return pointer on the slot of the image, NULL if not found
+ */
+const xSsdvSlot * xSsdvCacheFind (const xSsdvCache *c, uint32_t callsign, uint8_t image_id);
+
+/**
+ * Copy an image
+ *
+ * If the image is not complete, it is decoded with the packets received so
+ * far, the missing packets are replaced by empty blocks.
+ *
+ * @param c cache object to operate on.
+ * @param callsign encoded callsign, as in ssdv_packet_info_t
+ * @param image_id image number
+ * @param buf buffer where the JPEG image is copied
+ * @param size size of buf
+ * @param len length of the JPEG image
+ * @return 1 if the image is complete, 0 if it is partial, negative value on
+ * error
+ */
+int iSsdvCacheGetImage (xSsdvCache *c, uint32_t callsign, uint8_t image_id,
+                        uint8_t *buf, size_t size, size_t *len);
+
+/**
+ * Release the slot of an image
+ *
+ * @param c cache object to operate on.
+ * @param callsign encoded callsign, as in ssdv_packet_info_t
+ * @param image_id image number
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iSsdvCacheRelease (xSsdvCache *c, uint32_t callsign, uint8_t image_id);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_SSDVCACHE_H_ */
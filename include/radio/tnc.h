@@ -26,6 +26,9 @@
  *  des contrôleur de noeud terminal Ax25. \n
  *  Le format des trames TNC est : \n
  *  @code SOH STX <TXT: ASCII Hex bytes> ETX CRC3..0 EOT @endcode
+ *  Le codage et le décodage sont faits par xTncEncoder et xTncDecoder, qui
+ *  travaillent en mémoire et peuvent être utilisés sans xTnc, par exemple
+ *  dans la boucle d'événements d'une application.
  *  @{
  */
 
@@ -37,6 +40,17 @@
 #define TNC_TXT 5
 #define TNC_CRC 6
 
+/**
+ * Size of a TNC message carrying @a n bytes: SOH, STX, 2 hexadecimal
+ * characters per byte, ETX, 4 characters of CRC and EOT
+ */
+#define TNC_MSG_SIZE(n) (2 * (n) + 8)
+
+/**
+ * Size of the buffer of the bytes read from the input at once
+ */
+#define TNC_STAGE_LEN 256
+
 /**
  * List of error codes returned by the functions.
  */
@@ -52,12 +66,178 @@ typedef enum {
 
 } eTncError;
 
+//##############################################################################
+//#                                                                            #
+//#                           xTncDecoder Class                                #
+//#                                                                            #
+//##############################################################################
+/**
+ * TNC Decoder Class
+ *
+ * Decodes the TNC messages from bytes given by the caller, whatever their
+ * origin. All the state is in the object, the bytes can be given by spans of
+ * any length and the decoding is resumed across calls.
+ */
+typedef struct xTncDecoder {
+
+  uint8_t *buf;     ///< message being received
+  size_t size;      ///< size of buf
+  size_t len;       ///< number of bytes in buf
+  uint16_t crc_rx;  ///< computed rx CRC
+  uint16_t crc_tx;  ///< received from tx CRC
+  int state;
+  uint8_t cnt;
+  uint8_t msb;
+} xTncDecoder;
+
+/**
+ * Create and initialize a new xTncDecoder object
+ *
+ * This object should be deleted with vTncDecoderDelete()
+ * @param iBufferSize size of the largest message received
+ * @return pointer on the object, NULL on error
+ */
+xTncDecoder * xTncDecoderNew (size_t iBufferSize);
+
+/**
+ * Delete a xTncDecoder object
+ *
+ * @param d object to operate on.
+ */
+void vTncDecoderDelete (xTncDecoder *d);
+
+/**
+ * Initialize a decoder which is not allocated by xTncDecoderNew()
+ *
+ * @param d decoder object to operate on.
+ * @param buf buffer where the messages are received, not copied
+ * @param size size of buf
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncDecoderInit (xTncDecoder *d, uint8_t *buf, size_t size);
+
+/**
+ * Reset the decoding, the message being received is dropped
+ *
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncDecoderClear (xTncDecoder *d);
+
+/**
+ * Decode bytes
+ *
+ * The decoding stops as soon as a message is received: the message is in
+ * buf until the next call, the remaining bytes being given again. A message
+ * longer than the buffer is dropped.
+ *
+ * @param d decoder object to operate on.
+ * @param buf received bytes
+ * @param len number of bytes in buf
+ * @param used number of bytes decoded, may be NULL
+ * @return TNC_EOT if a message is received, TNC_CRC_ERROR if a message is
+ * received with a CRC error, other positive or null value if the message is
+ * not complete, negative value on error
+ */
+int iTncDecoderFeed (xTncDecoder *d, const void *buf, size_t len, size_t *used);
+
+//##############################################################################
+//#                                                                            #
+//#                           xTncEncoder Class                                #
+//#                                                                            #
+//##############################################################################
+/**
+ * TNC Encoder Class
+ *
+ * Encodes a message into buffers of the caller. The encoding can be resumed
+ * across calls when the buffer is smaller than the encoded message, the
+ * number of bytes still to be produced is known up front.
+ */
+typedef struct xTncEncoder {
+
+  const uint8_t *msg; ///< bytes to encode, not copied
+  size_t count;   ///< number of bytes in msg
+  size_t pos;     ///< index of the next character of the encoded message
+  size_t size;    ///< length of the encoded message
+  uint16_t crc;   ///< CRC of the characters produced
+} xTncEncoder;
+
+/**
+ * Create and initialize a new xTncEncoder object
+ *
+ * This object should be deleted with vTncEncoderDelete()
+ * @return pointer on the object, NULL on error
+ */
+xTncEncoder * xTncEncoderNew (void);
+
+/**
+ * Delete a xTncEncoder object
+ *
+ * @param e object to operate on.
+ */
+void vTncEncoderDelete (xTncEncoder *e);
+
+/**
+ * Clear all fields of the object, for an encoder which is not allocated by
+ * xTncEncoderNew()
+ *
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncEncoderClear (xTncEncoder *e);
+
+/**
+ * Sets the message to encode
+ *
+ * The bytes are not copied, they must remain valid until the message is
+ * entirely produced. The previous message is dropped if it was not entirely
+ * produced.
+ *
+ * @param e encoder object to operate on.
+ * @param buf bytes to encode
+ * @param count number of bytes
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncEncoderSetMsg (xTncEncoder *e, const void *buf, size_t count);
+
+/**
+ * Number of bytes still to be produced by uTncEncoderRead()
+ *
+ * Just after iTncEncoderSetMsg(), this is TNC_MSG_SIZE(count).
+ *
+ * @param e encoder object to operate on.
+ */
+size_t uTncEncoderSize (const xTncEncoder *e);
+
+/**
+ * Produce the encoded message
+ *
+ * @param e encoder object to operate on.
+ * @param out buffer where the bytes are stored
+ * @param size size of out
+ * @return number of bytes stored, 0 when the message is entirely produced
+ */
+size_t uTncEncoderRead (xTncEncoder *e, void *out, size_t size);
+
 //##############################################################################
 //#                                                                            #
 //#                              xTnc Class                                    #
 //#                                                                            #
 //##############################################################################
 
+struct xTnc;
+
+/**
+ * Handler called for each message received
+ *
+ * The message is in the receive buffer of the controller and is only valid
+ * until the handler returns: it must be copied to be kept.
+ *
+ * @param tnc TNC object which received the message
+ * @param msg message received
+ * @param len length of the message
+ * @param ctx context given to iTncSetRxHandler()
+ */
+typedef void (*vTncRxHandler) (struct xTnc *tnc, const uint8_t *msg, size_t len, void *ctx);
+
 /**
  * Tnc Class
  */
@@ -67,11 +247,16 @@ typedef struct xTnc {
   int fout;     ///< stream used to access the physical output
   uint8_t *rxbuf;    ///< buffer for payload
   size_t  len;        ///< buffer length
-  uint16_t crc_rx;  ///< computed rx CRC
-  uint16_t crc_tx;  ///< received from tx CRC
+  xTncDecoder dec;  ///< decoder of the received bytes, in rxbuf
   int state;
-  uint8_t cnt;
-  uint8_t msb;
+  struct xCapture *capture; ///< log of the received messages
+  uint16_t port;  ///< port number recorded in the capture log
+  uint8_t stage[TNC_STAGE_LEN]; ///< bytes read from the input not yet decoded
+  size_t stage_pos; ///< index of the next byte to decode in stage
+  size_t stage_len; ///< number of bytes in stage
+  vTncRxHandler rx_handler; ///< handler of the received messages, NULL if none
+  void *rx_ctx;   ///< context given to rx_handler
+  unsigned long rx_msgs; ///< number of messages given to rx_handler
 } xTnc;
 
 /**
@@ -112,6 +297,36 @@ int iTncSetFdin (xTnc *p, int fdin);
  */
 int iTncSetFdout (xTnc *p, int fdout);
 
+/**
+ * Sets the capture log of the received messages
+ *
+ * Each message whose CRC is correct is appended to the log by iTncPoll().
+ * The log object is not copied and must remain valid as long as it is used.
+ *
+ * @param tnc TNC object to operate on.
+ * @param capture capture log, NULL to stop the capture
+ * @param port port number recorded with the messages
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncSetCapture (xTnc *tnc, struct xCapture *capture, uint16_t port);
+
+/**
+ * Sets the handler of the received messages
+ *
+ * When a handler is set, each message whose CRC is correct is given to the
+ * handler by iTncPoll(), iTncPollTimeout() and iTncFeed() as soon as it is
+ * decoded, and the decoding goes on: one call can deliver any number of
+ * messages, without iTncRead(). The messages with a CRC error are dropped.
+ * The handler must not call these functions on the same object.
+ *
+ * @param tnc TNC object to operate on.
+ * @param handler handler called for each message, NULL to read the messages
+ * with iTncRead()
+ * @param ctx context given to the handler
+ * @return TNC_SUCCESS, negative value on error
+ */
+int iTncSetRxHandler (xTnc *tnc, vTncRxHandler handler, void *ctx);
+
 /**
  * Check if there are any TNC messages to be processed.
  * This function read available characters from the medium and search for
@@ -126,15 +341,78 @@ int iTncSetFdout (xTnc *p, int fdout);
  */
 int iTncPoll(xTnc *tnc);
 
+/**
+ * Wait for a TNC message until a deadline
+ *
+ * Same as iTncPoll(), but the input is waited with poll(), the function
+ * returns as soon as a message is received or when the timeout is elapsed,
+ * whether the file descriptor is blocking or not. No CPU time is used while
+ * waiting.
+ * With a handler (see iTncSetRxHandler()), the function returns when the
+ * input is no longer readable once at least one message has been delivered.
+ *
+ * @param tnc TNC object to operate on.
+ * @param timeout_ms timeout in milliseconds, negative value to wait forever
+ * @return TNC_EOT if a message is received, other positive or null value
+ * on timeout or end of file, negative value on error
+ */
+int iTncPollTimeout (xTnc *tnc, int timeout_ms);
+
+/**
+ * Decode bytes received by the caller
+ *
+ * Same as iTncPoll(), but the bytes are given by the caller instead of being
+ * read from the input, for an application that does its own I/O (see
+ * xMux). The decoding stops as soon as a message is received, the remaining
+ * bytes must be given again. With a handler (see iTncSetRxHandler()), all the
+ * bytes are decoded and the messages are given to the handler.
+ *
+ * @param tnc TNC object to operate on.
+ * @param buf received bytes
+ * @param len number of bytes in buf
+ * @param used number of bytes decoded, may be NULL
+ * @return TNC_EOT if a message is received in tnc->rxbuf, other positive or
+ * null value if the message is not complete, negative value on error
+ */
+int iTncFeed (xTnc *tnc, const void *buf, size_t len, size_t *used);
+
 /**
  * Send an TNC message
  *
+ * The pending input of the output file descriptor is flushed before sending.
+ *
  * @param tnc TNC object to operate on.
  * @param frame message to send
  * @return TNC_SUCCESS, negative value on error
  */
 ssize_t iTncWrite (xTnc *tnc, const void *buf, size_t count);
 
+/**
+ * Send several TNC messages of the same size at once
+ *
+ * The messages are encoded in a single buffer written in one go, which is
+ * much faster than successive calls to iTncWrite(). Unlike iTncWrite(), the
+ * pending input is not flushed.
+ *
+ * @param tnc TNC object to operate on.
+ * @param buf @a count messages of @a size bytes, one after the other
+ * @param size size of each message
+ * @param count number of messages
+ * @return number of bytes sent (size * count), negative value on error
+ */
+ssize_t iTncWriteBatch (xTnc *tnc, const void *buf, size_t size, unsigned count);
+
+/**
+ * Encode a TNC message
+ *
+ * @param msg buffer where the message is encoded, it must contain at least
+ * TNC_MSG_SIZE(count) bytes
+ * @param buf bytes to send
+ * @param count number of bytes
+ * @return length of the encoded message
+ */
+size_t uTncEncode (uint8_t *msg, const void *buf, size_t count);
+
 /**
  * Returns the last error code.
  */
@@ -10,10 +10,15 @@
 #define _SYSIO_TNC_HPP_
 
 #include <string>
+#include <chrono>
+#include <radio/loop.hpp>
 #include <stdio.h>
 #include <sysio/defs.h>
 
 struct xTnc;
+struct xAprs;
+struct xSsdvCache;
+struct xTncWorkers;
 
 /**
  *  @addtogroup radio_ax25_tnc
@@ -62,10 +67,75 @@ public:
   int getFdin() const;
 
   int poll();
+  /**
+   * Wait for a message until a deadline, without using CPU time
+   *
+   * @param timeout maximum waiting time, negative to wait forever
+   * @return same as poll(), NO_PACKET on timeout
+   */
+  template <class Rep, class Period>
+  int poll (const std::chrono::duration<Rep, Period> &timeout) {
+    return pollTimeout (std::chrono::duration_cast<std::chrono::milliseconds> (timeout).count());
+  }
+  int pollTimeout (int timeoutMs);
   int getRxlen();
   int getPacketType() const;
+  /**
+   * APRS packet decoded from the last message received
+   *
+   * A message starting with '@' or '/' is an APRS_PACKET, its info field is
+   * then decoded by iAprsParse() without destination address, so that Mic-E
+   * is not decoded.
+   *
+   * @return decoded packet, 0 if the last message is not an APRS_PACKET or
+   * if its info field can not be decoded
+   */
+  const struct xAprs * getAprs() const;
   int getSsdvImageId() const;
   int getSsdvPacketId() const;
+  unsigned long getSsdvCallsign() const;
+
+  int enableSsdvCache (unsigned slots = 4, unsigned maxPackets = 512,
+                       unsigned jpegSize = 256 * 1024);
+  bool isSsdvImageComplete() const;
+  int getSsdvImage (void *buf, unsigned size);
+  int getSsdvImage (unsigned long callsign, int imageId, void *buf, unsigned size);
+  /**
+   * Check the SSDV-length messages by a pool of threads
+   *
+   * poll() then delivers the messages in arrival order once checked. The
+   * messages received and not yet delivered by poll() are lost when the pool
+   * is changed or stopped.
+   *
+   * @param count number of threads, 0 to stop the pool
+   * @param depth maximum number of messages queued
+   * @return SUCCESS, NOT_ENOUGH_MEMORY if the threads can not be started
+   */
+  int setSsdvWorkers (unsigned count, unsigned depth = 16);
+  /**
+   * Encode a JPEG image in SSDV packets and send them
+   *
+   * The packets are encoded by a thread while the previous ones are sent,
+   * by batches of @a batch messages written at once. The packets are sent
+   * by windows of interleave * batch packets in stride order: each batch
+   * takes one packet out of @a interleave, consecutive packets of a window
+   * are then one batch (@a batch packets) apart, so that a burst of errors
+   * is spread over several non-consecutive packets.
+   *
+   * @param jpeg JPEG image
+   * @param len length of the image
+   * @param callsign callsign of the transmitter (up to 6 characters)
+   * @param imageId image number (0 to 255)
+   * @param quality JPEG quality level (0 to 7)
+   * @param interleave packet interleaving stride, 1 to send the packets in order
+   * @param headerRepeat number of extra copies of the first packet, one is
+   * sent after each of the first windows
+   * @param batch number of packets written at once
+   * @return number of packets sent, negative value on error
+   */
+  int writeSsdvImage (const void *jpeg, unsigned len, const char *callsign,
+                      int imageId, int quality = 4, unsigned interleave = 1,
+                      unsigned headerRepeat = 0, unsigned batch = 8);
   const char * read() const;
   int write (const char *buf);
 
@@ -82,15 +152,69 @@ public:
   int feof(FILE * f);
   int ferror(FILE * f);
 
+#if defined(__cpp_impl_coroutine)
+  class ReceiveAwaiter;
+
+  /**
+   * Wait for a message in a coroutine
+   *
+   * @code int type = co_await tnc.asyncReceive(); @endcode
+   * @param loop event loop, NULL for the current loop of the thread
+   * @return awaitable operation whose result is the same as poll(),
+   * NO_PACKET at end of file or if there is no loop
+   */
+  ReceiveAwaiter asyncReceive (EventLoop *loop = nullptr);
+#endif
+
 private:
+  int pollReady();
+  int pollInput (bool timed, int timeoutMs);
+  int pollMessage (bool timed, int timeoutMs);
+  int pollWorkers (bool timed, int timeoutMs);
+  int received (bool ssdv, int image_id, int packet_id, unsigned long callsign);
+
   struct xTnc *p;
   unsigned char *rx_buf;
   unsigned rx_buf_size;
   unsigned rx_len;
   ePacketType pkt_type;
+  struct xAprs *aprs;
   int ssdv_image_id;
   int ssdv_packet_id;
+  unsigned long ssdv_callsign;
+  bool ssdv_complete;
+  struct xSsdvCache *ssdv_cache;
+  struct xTncWorkers *workers;
+};
+
+#if defined(__cpp_impl_coroutine)
+// -----------------------------------------------------------------------------
+class Tnc::ReceiveAwaiter : public FdAwaiter<Tnc::ReceiveAwaiter> {
+
+public:
+  ReceiveAwaiter (Tnc &tnc, EventLoop *loop) :
+    FdAwaiter (loop, tnc.getFdin(), EventLoop::READ), tnc (tnc), type (NO_PACKET) {}
+
+  bool attempt (unsigned events) {
+    type = tnc.pollReady();
+    return (type != NO_PACKET) || (events & EventLoop::HANGUP);
+  }
+
+  int await_resume() {
+    return type;
+  }
+
+private:
+  Tnc &tnc;
+  int type;
 };
+
+// -----------------------------------------------------------------------------
+inline Tnc::ReceiveAwaiter
+Tnc::asyncReceive (EventLoop *loop) {
+  return ReceiveAwaiter (*this, loop);
+}
+#endif /* __cpp_impl_coroutine */
 /**
  *  @}
  * @}
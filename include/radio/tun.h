@@ -0,0 +1,209 @@
+/**
+ * @file tun.h
+ * @brief Passerelle IPv4 sur AX.25 par interface TUN
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+
+#ifndef _SYSIO_TUN_H_
+#define _SYSIO_TUN_H_
+
+#include <radio/ax25.h>
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+/* ========================================================================== */
+
+/**
+ *  @addtogroup radio_ax25
+ *  @{
+ *  @defgroup radio_ax25_tun Passerelle IPv4
+ *
+ *  Ce module transporte des paquets IPv4 dans des trames UI de PID
+ *  AX25_PID_IP, entre une interface TUN de Linux et un port xAx25, sans
+ *  utiliser la pile AX.25 du noyau. \n
+ *  Les paquets lus sur l'interface sont placés directement derrière l'en-tête
+ *  de la trame, précalculé avec son CRC pour chaque route, puis un lot de
+ *  trames est encodé dans un seul tampon écrit en une fois sur le port. Le
+ *  champ d'information des trames reçues est écrit sur l'interface depuis le
+ *  tampon du décodeur. \n
+ *  La destination AX.25 d'un paquet est donnée par la route dont le préfixe
+ *  correspond le plus longuement à son adresse IPv4 de destination, les
+ *  paquets sans route sont abandonnés. Seules les trames adressées à
+ *  l'indicatif de la passerelle sont transmises à l'interface. \n
+ *  L'interface est configurée (adresse, état) par les outils du système, la
+ *  taille maximale des paquets (MTU) est AX25_INFO_LEN.
+ *  @{
+ */
+
+/* constants ================================================================ */
+/**
+ * Maximum number of routes
+ */
+#define AX25_TUN_MAX_ROUTE 16
+
+/**
+ * Maximum number of packets read from the interface and sent at once
+ */
+#define AX25_TUN_BATCH 16
+
+/**
+ * Maximum length of the name of the interface, terminating null included
+ */
+#define AX25_TUN_IFNAME_LEN 16
+
+/**
+ * Maximum length of the header of a frame: addresses, control and PID fields
+ */
+#define AX25_TUN_HDR_LEN ((AX25_CALL_LEN + 1) * (AX25_MAX_RPT + 2) + 2)
+
+//##############################################################################
+//#                                                                            #
+//#                             xAx25Tun Class                                 #
+//#                                                                            #
+//##############################################################################
+
+/**
+ * Route to a remote station
+ */
+typedef struct xAx25TunRoute {
+
+  uint32_t net;   ///< IPv4 network, host byte order
+  uint32_t mask;  ///< IPv4 netmask, host byte order
+  unsigned prefix_len; ///< number of bits of the netmask
+  uint8_t hdr[AX25_TUN_HDR_LEN]; ///< address, control and PID fields
+  size_t hdr_len; ///< number of bytes in hdr
+  uint16_t crc;   ///< CRC register after hdr
+} xAx25TunRoute;
+
+/**
+ * IPv4 over AX25 Bridge Class
+ */
+typedef struct xAx25Tun {
+
+  xAx25 *port;    ///< port on which the frames are sent and received
+  int fd;         ///< file descriptor of the interface, -1 if none
+  bool own_fd;    ///< true if fd has been opened by iAx25TunOpen()
+  char ifname[AX25_TUN_IFNAME_LEN]; ///< name of the interface
+  uint8_t mycall[AX25_CALL_LEN + 1]; ///< on-air local address
+  xAx25TunRoute route[AX25_TUN_MAX_ROUTE]; ///< routes, longest prefix first
+  unsigned route_len; ///< number of routes
+  uint8_t frame[AX25_TUN_HDR_LEN + AX25_INFO_LEN + 2]; ///< frame being sent, packets are read at AX25_TUN_HDR_LEN
+  uint8_t out[AX25_TUN_BATCH * AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)]; ///< encoded frames
+  unsigned long tx_packets; ///< number of packets sent on the port
+  unsigned long rx_packets; ///< number of packets written on the interface
+  unsigned long dropped;    ///< number of packets dropped
+} xAx25Tun;
+
+/**
+ * Create and initialize a new xAx25Tun object
+ *
+ * This object should be deleted with vAx25TunDelete()
+ * @param port port on which the frames are sent and received
+ * @param callsign local callsign
+ * @param ssid local SSID
+ * @return pointer on the object, NULL on error
+ */
+xAx25Tun * xAx25TunNew (xAx25 *port, const char *callsign, uint8_t ssid);
+
+/**
+ * Delete a xAx25Tun object
+ *
+ * The interface is closed if it has been opened by iAx25TunOpen().
+ *
+ * @param t bridge object to operate on.
+ */
+void vAx25TunDelete (xAx25Tun *t);
+
+/**
+ * Open a TUN interface
+ *
+ * The interface is created if it does not exist, which needs the
+ * CAP_NET_ADMIN capability, its MTU is set to AX25_INFO_LEN.
+ *
+ * @param t bridge object to operate on.
+ * @param ifname name of the interface, "tun%d" to let the kernel choose it,
+ * the name given is stored in t->ifname
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25TunOpen (xAx25Tun *t, const char *ifname);
+
+/**
+ * Sets the file descriptor of an interface opened by the caller
+ *
+ * Each read and each write must transfer a whole IPv4 packet without header,
+ * as a TUN interface opened with IFF_TUN | IFF_NO_PI. The file descriptor is
+ * set in non-blocking mode and is not closed by vAx25TunDelete().
+ *
+ * @param t bridge object to operate on.
+ * @param fd file descriptor
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25TunSetFd (xAx25Tun *t, int fd);
+
+/**
+ * Adds a route to a remote station
+ *
+ * @param t bridge object to operate on.
+ * @param addr IPv4 network, network byte order (in_addr_t)
+ * @param prefix_len number of bits of the netmask, 0 for the default route
+ * @param dst remote station
+ * @param path repeaters, NULL if none
+ * @param path_len number of repeaters
+ * @return AX25_SUCCESS, negative value on error
+ */
+int iAx25TunAddRoute (xAx25Tun *t, uint32_t addr, unsigned prefix_len,
+                      const xAx25Node *dst, const xAx25Node *path,
+                      unsigned path_len);
+
+/**
+ * Process a received frame
+ *
+ * The info field of the UI frames of PID AX25_PID_IP addressed to the local
+ * station, and repeated by all the repeaters of their path, is written on
+ * the interface. This function can be called by the handler of the port.
+ *
+ * @param t bridge object to operate on.
+ * @param frame view on the received frame
+ * @return 1 if a packet is written, 0 if the frame is not processed, negative
+ * value on error
+ */
+int iAx25TunInput (xAx25Tun *t, const xAx25View *frame);
+
+/**
+ * Send the packets read on the interface
+ *
+ * Up to AX25_TUN_BATCH packets are read, framed and written on the port at
+ * once. This function does not block.
+ *
+ * @param t bridge object to operate on.
+ * @return number of packets sent, negative value on error
+ */
+int iAx25TunRead (xAx25Tun *t);
+
+/**
+ * Wait for packets on the interface and frames on the port and bridge them
+ *
+ * The frames received on the port which are not processed by iAx25TunInput()
+ * are discarded.
+ *
+ * @param t bridge object to operate on.
+ * @param timeout_ms timeout in milliseconds, negative value to wait forever
+ * @return number of packets bridged in both directions, negative value on
+ * error
+ */
+int iAx25TunPoll (xAx25Tun *t, int timeout_ms);
+
+/**
+ *  @}
+ * @}
+ */
+
+/* ========================================================================== */
+#ifdef __cplusplus
+  }
+#endif
+
+#endif /* _SYSIO_TUN_H_ */
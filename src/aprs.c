@@ -0,0 +1,997 @@
+/**
+ * @file src/aprs.c
+ * @brief Décodeur de paquets APRS (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <string.h>
+
+#include <radio/aprs.h>
+
+/* constants ================================================================ */
+#define TIMESTAMP_LEN 7
+#define UNCOMPRESSED_LEN 19
+#define COMPRESSED_LEN 13
+#define MICE_LEN 9
+#define MESSAGE_ADDR_LEN 9
+#define OBJECT_NAME_LEN 9
+#define ITEM_NAME_MIN 3
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+static inline bool
+prvbIsDigit (char c) {
+
+  return (c >= '0') && (c <= '9');
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the n decimal digits at s
+static bool
+prvbNum (const char *s, int n, int *v) {
+  int x = 0;
+
+  for (int i = 0; i < n; i++) {
+
+    if (!prvbIsDigit (s[i])) {
+
+      return false;
+    }
+    x = x * 10 + s[i] - '0';
+  }
+  *v = x;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the n characters at s, the first one may be a minus sign
+static bool
+prvbSignedNum (const char *s, int n, int *v) {
+
+  if (*s == '-') {
+
+    if ( (n < 2) || !prvbNum (s + 1, n - 1, v)) {
+
+      return false;
+    }
+    *v = -*v;
+    return true;
+  }
+  return prvbNum (s, n, v);
+}
+
+// -----------------------------------------------------------------------------
+// True if the n characters at s mean "no data" (dots or spaces)
+static bool
+prvbNoData (const char *s, int n) {
+
+  for (int i = 0; i < n; i++) {
+
+    if ( (s[i] != '.') && (s[i] != ' ')) {
+
+      return false;
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the n base 91 characters at s
+static bool
+prvbBase91 (const char *s, int n, long *v) {
+  long x = 0;
+
+  for (int i = 0; i < n; i++) {
+
+    if ( (s[i] < '!') || (s[i] > '{')) {
+
+      return false;
+    }
+    x = x * 91 + s[i] - '!';
+  }
+  *v = x;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static double
+prvdPow (double b, unsigned n) {
+  double r = 1.0;
+
+  while (n) {
+
+    if (n & 1) {
+      r *= b;
+    }
+    b *= b;
+    n >>= 1;
+  }
+  return r;
+}
+
+// -----------------------------------------------------------------------------
+static inline xAprsStr
+prvxStr (const char *s, const char *end) {
+  xAprsStr str = { s, end - s };
+
+  return str;
+}
+
+// -----------------------------------------------------------------------------
+// Removes the trailing spaces of a name
+static xAprsStr
+prvxTrim (const char *s, size_t len) {
+
+  while ( (len > 0) && (s[len - 1] == ' ')) {
+    len--;
+  }
+  return prvxStr (s, s + len);
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbTimestamp (xAprs *a, const char *s) {
+  int v;
+
+  if ( (prvbNum (s, 6, &v)) &&
+       ( (s[6] == 'z') || (s[6] == '/') || (s[6] == 'h'))) {
+
+    a->timestamp = prvxStr (s, s + TIMESTAMP_LEN);
+    a->flags |= APRS_HAS_TIMESTAMP;
+    return true;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes n digits of a latitude or longitude, digits replaced by spaces are
+// counted in ambiguity, the '.' is at the index dot.
+static bool
+prvbDegrees (const char *s, int n, int dot, double *deg, uint8_t *ambiguity) {
+  int d = 0, m = 0, c;
+
+  *ambiguity = 0;
+  for (int i = 0; i < n; i++) {
+
+    if (i == dot) {
+
+      if (s[i] != '.') {
+
+        return false;
+      }
+      continue;
+    }
+    c = s[i];
+    if (c == ' ') {
+
+      (*ambiguity)++;
+      c = '0';
+    }
+    else if (!prvbIsDigit (c)) {
+
+      return false;
+    }
+    // degrees are before the 2 digits of minutes
+    if (i < dot - 2) {
+
+      d = d * 10 + c - '0';
+    }
+    else {
+
+      m = m * 10 + c - '0';
+    }
+  }
+  if (m >= 6000) {
+
+    return false;
+  }
+  *deg = d + m / 6000.0;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbUncompressed (xAprsPosition *pos, const char *s) {
+  uint8_t amb;
+
+  // DDMM.hhN/DDDMM.hhW$
+  if (!prvbDegrees (s, 7, 4, &pos->lat, &pos->ambiguity) || (pos->lat > 90.0)) {
+
+    return false;
+  }
+  if (s[7] == 'S') {
+
+    pos->lat = -pos->lat;
+  }
+  else if (s[7] != 'N') {
+
+    return false;
+  }
+  if (!prvbDegrees (s + 9, 8, 5, &pos->lon, &amb) || (pos->lon > 180.0)) {
+
+    return false;
+  }
+  if (s[17] == 'W') {
+
+    pos->lon = -pos->lon;
+  }
+  else if (s[17] != 'E') {
+
+    return false;
+  }
+  pos->format = APRS_POS_UNCOMPRESSED;
+  pos->symbol_table = s[8];
+  pos->symbol_code = s[18];
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbCompressed (xAprs *a, const char *s) {
+  xAprsPosition *pos = &a->pos;
+  long x, y;
+
+  // /YYYYXXXX$csT
+  if ( (s[0] != '/') && (s[0] != '\\') && ( (s[0] < 'A') || (s[0] > 'Z')) &&
+       ( (s[0] < 'a') || (s[0] > 'j'))) {
+
+    return false;
+  }
+  if (!prvbBase91 (s + 1, 4, &y) || !prvbBase91 (s + 5, 4, &x)) {
+
+    return false;
+  }
+  pos->format = APRS_POS_COMPRESSED;
+  pos->lat = 90.0 - y / 380926.0;
+  pos->lon = -180.0 + x / 190463.0;
+  pos->symbol_table = ( (s[0] >= 'a') && (s[0] <= 'j')) ? s[0] - 'a' + '0' : s[0];
+  pos->symbol_code = s[9];
+
+  if (s[10] != ' ') {
+    long cs;
+
+    if ( ( (s[12] - '!') & 0x18) == 0x10) {
+
+      // GGA source, cs is the altitude
+      if (prvbBase91 (s + 10, 2, &cs)) {
+
+        pos->altitude = (int32_t) prvdPow (1.002, cs);
+        a->flags |= APRS_HAS_ALTITUDE;
+      }
+    }
+    else if ( (s[10] >= '!') && (s[10] <= 'z') && (s[11] >= '!') && (s[11] <= '{')) {
+
+      pos->course = (s[10] - '!') * 4;
+      pos->speed = (uint16_t) (prvdPow (1.08, s[11] - '!') - 1.0 + 0.5);
+      a->flags |= APRS_HAS_COURSE;
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbMicE (xAprs *a, const char *dst, const char *s) {
+  xAprsPosition *pos = &a->pos;
+  int digit[6], d, m, h, sp, dc, se;
+  uint8_t std = 0, custom = 0;
+
+  if ( (!dst) || (strnlen (dst, AX25_CALL_LEN) != AX25_CALL_LEN)) {
+
+    return false;
+  }
+
+  // Latitude, message bits and flags are in the destination address
+  pos->ambiguity = 0;
+  for (int i = 0; i < 6; i++) {
+    char c = dst[i];
+
+    if (prvbIsDigit (c)) {
+
+      digit[i] = c - '0';
+    }
+    else if ( (c >= 'A') && (c <= 'J')) {
+
+      digit[i] = c - 'A';
+      custom |= (i < 3) ? (4 >> i) : 0;
+    }
+    else if ( (c >= 'P') && (c <= 'Y')) {
+
+      digit[i] = c - 'P';
+      std |= (i < 3) ? (4 >> i) : 0;
+    }
+    else if ( (c == 'K') || (c == 'L') || (c == 'Z')) {
+
+      digit[i] = 0;
+      pos->ambiguity++;
+      if (c == 'K') {
+        custom |= (i < 3) ? (4 >> i) : 0;
+      }
+      else if (c == 'Z') {
+        std |= (i < 3) ? (4 >> i) : 0;
+      }
+    }
+    else {
+
+      return false;
+    }
+  }
+  pos->lat = digit[0] * 10 + digit[1] +
+             (digit[2] * 1000 + digit[3] * 100 + digit[4] * 10 + digit[5]) / 6000.0;
+  if (dst[3] <= 'L') {
+
+    pos->lat = -pos->lat;
+  }
+  pos->mice_msg = custom ? (custom | 0x08) : std;
+
+  // Longitude, speed and course are in the info field
+  for (int i = 0; i < 6; i++) {
+    uint8_t c = s[i];
+
+    if ( (c < 28) || (c > 127)) {
+
+      return false;
+    }
+  }
+  d = s[0] - 28;
+  if (dst[4] >= 'P') {
+
+    d += 100;
+  }
+  if ( (d >= 180) && (d <= 189)) {
+
+    d -= 80;
+  }
+  else if ( (d >= 190) && (d <= 199)) {
+
+    d -= 190;
+  }
+  m = s[1] - 28;
+  if (m >= 60) {
+
+    m -= 60;
+  }
+  h = s[2] - 28;
+  if ( (d > 180) || (h > 99)) {
+
+    return false;
+  }
+  pos->lon = d + (m * 100 + h) / 6000.0;
+  if (dst[5] >= 'P') {
+
+    pos->lon = -pos->lon;
+  }
+
+  sp = (s[3] - 28) * 10;
+  dc = s[4] - 28;
+  se = s[5] - 28;
+  sp += dc / 10;
+  if (sp >= 800) {
+
+    sp -= 800;
+  }
+  dc = (dc % 10) * 100 + se;
+  if (dc >= 400) {
+
+    dc -= 400;
+  }
+  pos->speed = sp;
+  pos->course = dc;
+  a->flags |= APRS_HAS_COURSE;
+
+  pos->format = APRS_POS_MICE;
+  pos->symbol_code = s[6];
+  pos->symbol_table = s[7];
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the weather fields at p, returns the first character which is not
+// a weather field
+static const char *
+prvpWeather (xAprs *a, const char *p, const char *end) {
+  static const struct {
+    char c;
+    uint8_t width;
+    uint16_t field;
+  } xFields[] = {
+    { 'c', 3, APRS_WX_WIND_DIR },
+    { 's', 3, APRS_WX_WIND_SPEED },
+    { 'g', 3, APRS_WX_GUST },
+    { 't', 3, APRS_WX_TEMP },
+    { 'r', 3, APRS_WX_RAIN_1H },
+    { 'p', 3, APRS_WX_RAIN_24H },
+    { 'P', 3, APRS_WX_RAIN_MIDNIGHT },
+    { 'h', 2, APRS_WX_HUMIDITY },
+    { 'b', 5, APRS_WX_PRESSURE },
+    { 'L', 3, APRS_WX_LUMINOSITY },
+    { 'l', 3, APRS_WX_LUMINOSITY },
+  };
+  xAprsWeather *wx = &a->wx;
+
+  while (p < end) {
+    unsigned i;
+    int v;
+
+    for (i = 0; i < COUNTOF (xFields); i++) {
+
+      if (xFields[i].c == *p) {
+        break;
+      }
+    }
+    if ( (i == COUNTOF (xFields)) || (p + 1 + xFields[i].width > end)) {
+      break;
+    }
+
+    if (!prvbSignedNum (p + 1, xFields[i].width, &v)) {
+
+      if (!prvbNoData (p + 1, xFields[i].width)) {
+        break;
+      }
+    }
+    else {
+
+      switch (xFields[i].c) {
+        case 'c':
+          wx->wind_dir = v;
+          break;
+        case 's':
+          wx->wind_speed = v;
+          break;
+        case 'g':
+          wx->gust = v;
+          break;
+        case 't':
+          wx->temp = v;
+          break;
+        case 'r':
+          wx->rain_1h = v;
+          break;
+        case 'p':
+          wx->rain_24h = v;
+          break;
+        case 'P':
+          wx->rain_midnight = v;
+          break;
+        case 'h':
+          wx->humidity = (v == 0) ? 100 : v;
+          break;
+        case 'b':
+          wx->pressure = v;
+          break;
+        case 'L':
+          wx->luminosity = v;
+          break;
+        case 'l':
+          wx->luminosity = v + 1000;
+          break;
+      }
+      wx->fields |= xFields[i].field;
+    }
+    p += 1 + xFields[i].width;
+  }
+  if (wx->fields) {
+
+    a->flags |= APRS_HAS_WEATHER;
+  }
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the course/speed extension of an uncompressed position (CSE/SPD or
+// wind direction/speed for a weather station)
+static const char *
+prvpCourseSpeed (xAprs *a, const char *p, const char *end) {
+  int c, s;
+
+  if ( (p + 7 > end) || (p[3] != '/')) {
+
+    return p;
+  }
+  if (a->pos.symbol_code == '_') {
+
+    if (prvbNum (p, 3, &c)) {
+
+      a->wx.wind_dir = c;
+      a->wx.fields |= APRS_WX_WIND_DIR;
+    }
+    else if (!prvbNoData (p, 3)) {
+
+      return p;
+    }
+    if (prvbNum (p + 4, 3, &s)) {
+
+      a->wx.wind_speed = s;
+      a->wx.fields |= APRS_WX_WIND_SPEED;
+    }
+    else if (!prvbNoData (p + 4, 3)) {
+
+      return p;
+    }
+    return p + 7;
+  }
+  if (prvbNum (p, 3, &c) && prvbNum (p + 4, 3, &s)) {
+
+    a->pos.course = c;
+    a->pos.speed = s;
+    a->flags |= APRS_HAS_COURSE;
+    return p + 7;
+  }
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+// Looks for an altitude /A=aaaaaa in the comment
+static void
+prvvAltitude (xAprs *a) {
+  const char *p = a->comment.str;
+  const char *end = p + a->comment.len;
+  int v;
+
+  for (; p + 9 <= end; p++) {
+
+    if ( (p[0] == '/') && (p[1] == 'A') && (p[2] == '=') &&
+         (prvbSignedNum (p + 3, 6, &v))) {
+
+      a->pos.altitude = v;
+      a->flags |= APRS_HAS_ALTITUDE;
+      return;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Decodes an uncompressed or compressed position and what follows it
+static bool
+prvbPosition (xAprs *a, const char *p, const char *end) {
+
+  if ( (p < end) && (prvbIsDigit (*p) || (*p == ' '))) {
+
+    if ( (p + UNCOMPRESSED_LEN > end) || !prvbUncompressed (&a->pos, p)) {
+
+      return false;
+    }
+    p = prvpCourseSpeed (a, p + UNCOMPRESSED_LEN, end);
+  }
+  else {
+
+    if ( (p + COMPRESSED_LEN > end) || !prvbCompressed (a, p)) {
+
+      return false;
+    }
+    p += COMPRESSED_LEN;
+    if ( (a->pos.symbol_code == '_') && (a->flags & APRS_HAS_COURSE)) {
+
+      // The course and speed of a weather station are the wind
+      a->wx.wind_dir = a->pos.course;
+      a->wx.wind_speed = a->pos.speed;
+      a->wx.fields |= APRS_WX_WIND_DIR | APRS_WX_WIND_SPEED;
+      a->flags &= ~APRS_HAS_COURSE;
+    }
+  }
+  a->flags |= APRS_HAS_POSITION;
+
+  if (a->pos.symbol_code == '_') {
+
+    p = prvpWeather (a, p, end);
+  }
+  a->comment = prvxStr (p, end);
+  prvvAltitude (a);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static inline bool
+prvbIsAlnum (char c) {
+
+  return prvbIsDigit (c) || ( (c >= 'A') && (c <= 'Z')) || ( (c >= 'a') && (c <= 'z'));
+}
+
+// -----------------------------------------------------------------------------
+// True if the n characters at s are alphanumeric
+static bool
+prvbAlnum (const char *s, int n) {
+
+  for (int i = 0; i < n; i++) {
+
+    if (!prvbIsAlnum (s[i])) {
+
+      return false;
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// True if p..end is the id of an ack or a reject: 1 to 5 alphanumeric
+// characters, followed by }AA in the reply-ack format, *id_end is set to the
+// end of the id
+static bool
+prvbMessageId (const char *p, const char *end, const char **id_end) {
+  const char *q = p;
+
+  while ( (q < end) && (q - p < 5) && prvbIsAlnum (*q)) {
+    q++;
+  }
+  if ( (q == p) || ( (q < end) && ( (*q != '}') || (end - q > 3) ||
+                                    !prvbAlnum (q + 1, end - q - 1)))) {
+
+    return false;
+  }
+  *id_end = q;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbMessage (xAprs *a, const char *p, const char *end) {
+  xAprsMessage *msg = &a->msg;
+  const char *text, *id_end;
+
+  // :ADDRESSEE:text{id
+  if ( (p + MESSAGE_ADDR_LEN + 1 > end) || (p[MESSAGE_ADDR_LEN] != ':')) {
+
+    return false;
+  }
+  msg->addressee = prvxTrim (p, MESSAGE_ADDR_LEN);
+  text = p + MESSAGE_ADDR_LEN + 1;
+
+  if ( (end - text >= 3) && (memcmp (text, "ack", 3) == 0) &&
+       prvbMessageId (text + 3, end, &id_end)) {
+
+    msg->kind = APRS_MSG_ACK;
+  }
+  else if ( (end - text >= 3) && (memcmp (text, "rej", 3) == 0) &&
+            prvbMessageId (text + 3, end, &id_end)) {
+
+    msg->kind = APRS_MSG_REJ;
+  }
+
+  if (msg->kind != APRS_MSG_TEXT) {
+
+    // ackMM}AA of the reply-ack format, only MM is kept
+    msg->id = prvxStr (text + 3, id_end);
+    msg->text = prvxStr (text, end);
+  }
+  else {
+    const char *q = end;
+
+    while ( (q > text) && (q[-1] != '{')) {
+      q--;
+    }
+    if (q > text) {
+      const char *id = q;
+
+      while ( (q < end) && (*q != '}')) {
+        q++;
+      }
+      msg->id = prvxStr (id, q);
+      msg->text = prvxStr (text, id - 1);
+    }
+    else {
+
+      msg->text = prvxStr (text, end);
+    }
+  }
+  a->type = APRS_MESSAGE;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes a decimal number which may have a sign and a fractional part
+static const char *
+prvpFloat (const char *p, const char *end, float *v) {
+  const char *start;
+  bool neg = false;
+  float x = 0, scale = 1;
+
+  if ( (p < end) && (*p == '-')) {
+
+    neg = true;
+    p++;
+  }
+  start = p;
+  while ( (p < end) && prvbIsDigit (*p)) {
+
+    x = x * 10 + *p++ - '0';
+  }
+  if ( (p < end) && (*p == '.')) {
+
+    p++;
+    while ( (p < end) && prvbIsDigit (*p)) {
+
+      scale /= 10;
+      x += (*p++ - '0') * scale;
+    }
+  }
+  if (p == start) {
+
+    return NULL;
+  }
+  *v = neg ? -x : x;
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbTelemetry (xAprs *a, const char *p, const char *end) {
+  xAprsTelemetry *tlm = &a->tlm;
+  int seq = 0;
+
+  // T#sss,111,222,333,444,555,xxxxxxxx
+  if ( (p + 1 > end) || (*p++ != '#')) {
+
+    return false;
+  }
+  if ( (p + 3 <= end) && (p[0] == 'M') && (p[1] == 'I') && (p[2] == 'C')) {
+
+    p += 3;
+  }
+  else {
+
+    while ( (p < end) && prvbIsDigit (*p)) {
+
+      seq = seq * 10 + *p++ - '0';
+    }
+  }
+  tlm->seq = seq;
+
+  while ( (p < end) && (*p == ',')) {
+    const char *q;
+
+    p++;
+    if (tlm->nvalues == APRS_TLM_VALUES) {
+      int i;
+
+      for (i = 0; (i < 8) && (p + i < end) && ( (p[i] == '0') || (p[i] == '1')); i++) {
+
+        tlm->bits = (tlm->bits << 1) | (p[i] - '0');
+      }
+      if (i == 8) {
+
+        tlm->has_bits = true;
+        p += 8;
+      }
+      else {
+
+        tlm->bits = 0;
+      }
+      break;
+    }
+    q = prvpFloat (p, end, &tlm->values[tlm->nvalues]);
+    if (!q) {
+      break;
+    }
+    tlm->nvalues++;
+    p = q;
+  }
+  if (tlm->nvalues == 0) {
+
+    return false;
+  }
+  a->comment = prvxStr (p, end);
+  a->type = APRS_TELEMETRY;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbMicEReport (xAprs *a, const char *dst, const char *p, const char *end) {
+  long alt;
+
+  if ( (p + MICE_LEN - 1 > end) || !prvbMicE (a, dst, p)) {
+
+    return false;
+  }
+  p += MICE_LEN - 1;
+  a->flags |= APRS_HAS_POSITION;
+  a->comment = prvxStr (p, end);
+
+  // Altitude xxx} in meters, may follow a type character
+  for (int i = 0; i < 2; i++) {
+
+    if ( (p + i + 4 <= end) && (p[i + 3] == '}') && prvbBase91 (p + i, 3, &alt)) {
+      double ft = (alt - 10000) * 3.28084;
+
+      a->pos.altitude = (int32_t) (ft < 0 ? ft - 0.5 : ft + 0.5);
+      a->flags |= APRS_HAS_ALTITUDE;
+      a->comment = prvxStr (p + i + 4, end);
+      break;
+    }
+  }
+  a->type = APRS_POSITION;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbObject (xAprs *a, const char *p, const char *end) {
+
+  // ;NAME_____*DDHHMMzposition
+  if ( (p + OBJECT_NAME_LEN + 1 + TIMESTAMP_LEN > end) ||
+       ( (p[OBJECT_NAME_LEN] != '*') && (p[OBJECT_NAME_LEN] != '_'))) {
+
+    return false;
+  }
+  a->name = prvxTrim (p, OBJECT_NAME_LEN);
+  a->killed = (p[OBJECT_NAME_LEN] == '_');
+  p += OBJECT_NAME_LEN + 1;
+  if (!prvbTimestamp (a, p)) {
+
+    return false;
+  }
+  a->type = APRS_OBJECT;
+  return prvbPosition (a, p + TIMESTAMP_LEN, end);
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbItem (xAprs *a, const char *p, const char *end) {
+  const char *q = p;
+
+  // )NAME!position, the name has 3 to 9 characters
+  while ( (q < end) && (q - p <= OBJECT_NAME_LEN) && (*q != '!') && (*q != '_')) {
+    q++;
+  }
+  if ( (q == end) || (q - p < ITEM_NAME_MIN) || (q - p > OBJECT_NAME_LEN)) {
+
+    return false;
+  }
+  a->name = prvxStr (p, q);
+  a->killed = (*q == '_');
+  a->type = APRS_ITEM;
+  return prvbPosition (a, q + 1, end);
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbWeatherReport (xAprs *a, const char *p, const char *end) {
+  int v;
+
+  // _MMDDHHMMc...s...g...t...
+  if ( (p + 8 > end) || !prvbNum (p, 8, &v)) {
+
+    return false;
+  }
+  a->timestamp = prvxStr (p, p + 8);
+  a->flags |= APRS_HAS_TIMESTAMP;
+  p = prvpWeather (a, p + 8, end);
+  a->comment = prvxStr (p, end);
+  a->type = APRS_WEATHER;
+  return (a->flags & APRS_HAS_WEATHER) != 0;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbStatus (xAprs *a, const char *p, const char *end) {
+
+  // >DDHHMMztext, the timestamp is optional
+  if ( (p + TIMESTAMP_LEN <= end) && (p[6] == 'z') && prvbTimestamp (a, p)) {
+
+    p += TIMESTAMP_LEN;
+  }
+  a->comment = prvxStr (p, end);
+  a->type = APRS_STATUS;
+  return true;
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+int
+iAprsParse (xAprs *a, const char *dst, const void *info, size_t len) {
+  const char *p = (const char *) info;
+  const char *end = p + len;
+  bool ok = false;
+
+  if ( (!a) || (!info)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  memset (a, 0, sizeof (xAprs));
+  if (len == 0) {
+
+    return AX25_INVALID_FRAME;
+  }
+
+  a->dti = *p++;
+  switch (a->dti) {
+
+    case '=':
+    case '@':
+      a->flags |= APRS_HAS_MESSAGING;
+      // fall through
+    case '!':
+    case '/':
+      a->type = APRS_POSITION;
+      if ( (a->dti == '/') || (a->dti == '@')) {
+
+        if ( (p + TIMESTAMP_LEN > end) || !prvbTimestamp (a, p)) {
+          break;
+        }
+        p += TIMESTAMP_LEN;
+      }
+      ok = prvbPosition (a, p, end);
+      break;
+
+    case '`':
+    case '\'':
+    case 0x1C:
+    case 0x1D:
+      ok = prvbMicEReport (a, dst, p, end);
+      break;
+
+    case ';':
+      ok = prvbObject (a, p, end);
+      break;
+
+    case ')':
+      ok = prvbItem (a, p, end);
+      break;
+
+    case ':':
+      ok = prvbMessage (a, p, end);
+      break;
+
+    case 'T':
+      ok = prvbTelemetry (a, p, end);
+      break;
+
+    case '_':
+      ok = prvbWeatherReport (a, p, end);
+      break;
+
+    case '>':
+      ok = prvbStatus (a, p, end);
+      break;
+
+    default:
+      break;
+  }
+
+  if (!ok) {
+
+    a->type = APRS_UNKNOWN;
+    return AX25_INVALID_FRAME;
+  }
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAprsParseFrame (xAprs *a, const xAx25Frame *f) {
+
+  if ( (!a) || (!f)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  return iAprsParse (a, f->dst->callsign, f->info, f->info_len);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAprsParseView (xAprs *a, const xAx25View *v) {
+  char dst[AX25_CALL_LEN + 1];
+
+  if ( (!a) || (!v)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( ( (v->ctrl & ~0x10) != AX25_CTRL_UI) || (v->pid != AX25_PID_NOLAYER3)) {
+
+    memset (a, 0, sizeof (xAprs));
+    return AX25_INVALID_FRAME;
+  }
+
+  for (int i = 0; i < AX25_CALL_LEN; i++) {
+    char c = v->frame[i] >> 1;
+
+    dst[i] = (c == ' ') ? '\0' : c;
+  }
+  dst[AX25_CALL_LEN] = 0;
+  return iAprsParse (a, dst, v->info, v->info_len);
+}
+
+/* ========================================================================== */
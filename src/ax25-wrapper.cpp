@@ -7,6 +7,7 @@
  */
 #include <radio/ax25.hpp>
 #include <radio/ax25.h>
+#include <radio/filter.h>
 #include <stdlib.h>
 #include <stdexcept>
 
@@ -60,7 +61,7 @@ Ax25Node::getCallsign() const {
 void
 Ax25Node::setSsid (unsigned char ssid) {
 
-  p->ssid = ssid;
+  iAx25NodeSetSsid (p, ssid);
 }
 
 // -----------------------------------------------------------------------------
@@ -74,7 +75,7 @@ Ax25Node::getSsid() const {
 void
 Ax25Node::setFlag (bool flag) {
 
-  p->flag = flag;
+  iAx25NodeSetFlag (p, flag);
 }
 
 // -----------------------------------------------------------------------------
@@ -273,7 +274,7 @@ Ax25Frame::getReplen() const {
 /* public  ================================================================== */
 
 // -----------------------------------------------------------------------------
-Ax25::Ax25() : p(xAx25New()) {
+Ax25::Ax25() : p(xAx25New()), filter(0) {
 
   clear();
 }
@@ -282,6 +283,7 @@ Ax25::Ax25() : p(xAx25New()) {
 Ax25::~Ax25 () {
 
   vAx25Delete (p);
+  vAx25FilterDelete (filter);
 }
 
 // -----------------------------------------------------------------------------
@@ -289,6 +291,40 @@ void
 Ax25::clear () {
 
   iAx25Clear (p);
+  iAx25SetFilter (p, filter);
+}
+
+// -----------------------------------------------------------------------------
+int
+Ax25::setFilter (const char *expr) {
+  xAx25Filter *f = 0;
+
+  if (expr && *expr) {
+
+    f = xAx25FilterNew (expr);
+    if (!f) {
+
+      return ILLEGAL_FILTER;
+    }
+  }
+  iAx25SetFilter (p, f);
+  vAx25FilterDelete (filter);
+  filter = f;
+  return SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+Ax25::setPid (unsigned char pid, bool accept) {
+
+  return iAx25SetPid (p, pid, accept);
+}
+
+// -----------------------------------------------------------------------------
+int
+Ax25::setAllPid (bool accept) {
+
+  return iAx25SetAllPid (p, accept);
 }
 
 // -----------------------------------------------------------------------------
@@ -324,6 +360,13 @@ Ax25::poll() {
   return bAx25Poll (p);
 }
 
+// -----------------------------------------------------------------------------
+bool
+Ax25::pollTimeout (int timeoutMs) {
+
+  return bAx25PollTimeout (p, timeoutMs);
+}
+
 // -----------------------------------------------------------------------------
 void
 Ax25::send (const Ax25Frame &f) {
@@ -12,11 +12,22 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
+#include <time.h>
 
 #include <radio/ax25.h>
 #include <radio/crc.h>
+#include <radio/filter.h>
+#include <radio/capture.h>
+#include <radio/pcap.h>
 #include <sysio/log.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*
  * Enable access to the physical layer using streams
  * This option is not yet functional !
@@ -52,7 +63,10 @@ static const char * cErrorMsg[] = {
   "Object not found\n",   // AX25_OBJECT_NOT_FOUND         = -7
   "File not found\n",     // AX25_FILE_NOT_FOUND           = -8
   "Illegal repeater\n",   // AX25_ILLEGAL_REPEATER         = -9
-  "No frame received\n"   // AX25_NO_FRAME_RECEIVED        = -10
+  "No frame received\n",  // AX25_NO_FRAME_RECEIVED        = -10
+  "Illegal filter\n",     // AX25_ILLEGAL_FILTER           = -11
+  "Connection refused\n", // AX25_CONNECTION_REFUSED       = -12
+  "Connection lost\n"     // AX25_CONNECTION_LOST          = -13
 };
 
 // -----------------------------------------------------------------------------
@@ -85,6 +99,49 @@ prviError (int iError) {
 
 /* private ================================================================== */
 
+// -----------------------------------------------------------------------------
+static inline uint8_t
+prvucSsidByte (uint8_t ssid) {
+
+  /* Bits6:5 should be set to 1 for all SSIDs (0x60) */
+  return 0x60 | ( (ssid & 0x0F) << 1);
+}
+
+// -----------------------------------------------------------------------------
+// Encodes the node without the H bit, returns AX25_ILLEGAL_CALLSIGN without
+// any message if the callsign is illegal
+static int
+prviNodeEncode (const xAx25Node *n, uint8_t *addr) {
+  unsigned len = MIN (AX25_CALL_LEN, strlen (n->callsign));
+
+  for (unsigned i = 0; i < len; i++) {
+    uint8_t c = n->callsign[i];
+
+    if (! (isalnum (c) || c == ' ')) {
+
+      return AX25_ILLEGAL_CALLSIGN;
+    }
+    addr[i] = toupper (c) << 1;
+  }
+
+  /* Fill with spaces the rest of the CALL if it's shorter */
+  for (unsigned i = len; i < AX25_CALL_LEN; i++) {
+
+    addr[i] = ' ' << 1;
+  }
+  addr[AX25_CALL_LEN] = prvucSsidByte (n->ssid);
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvNodeCache (xAx25Node *n) {
+  int ret = prviNodeEncode (n, n->addr);
+
+  memcpy (n->addr_call, n->callsign, AX25_CALL_LEN);
+  n->addr_valid = (ret == AX25_SUCCESS) ? 1 : ret;
+}
+
 /* public  ================================================================== */
 
 // -----------------------------------------------------------------------------
@@ -115,6 +172,7 @@ iAx25NodeClear (xAx25Node *p) {
     return prviError (AX25_OBJECT_NOT_FOUND);
   }
   memset (p, 0, sizeof (xAx25Node));
+  prvvNodeCache (p);
   return AX25_SUCCESS;
 }
 
@@ -128,6 +186,68 @@ iAx25NodeSetCallsign (xAx25Node *p, const char * callsign) {
   }
   strncpy (p->callsign, callsign, AX25_CALL_LEN);
   p->callsign[AX25_CALL_LEN] = 0; // prevents core dump
+  prvvNodeCache (p);
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25NodeSetSsid (xAx25Node *p, uint8_t ssid) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  p->ssid = ssid;
+  p->addr[AX25_CALL_LEN] = prvucSsidByte (ssid);
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25NodeSetFlag (xAx25Node *p, bool flag) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  p->flag = flag;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25NodeEncode (const xAx25Node *n, uint8_t *addr) {
+
+  if (!n) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+
+  // The callsign field may have been written directly, or never cached
+  if ( (n->addr_valid != 0) &&
+       (strncmp (n->callsign, n->addr_call, AX25_CALL_LEN) == 0)) {
+
+    if (n->addr_valid < 0) {
+
+      return prviError (AX25_ILLEGAL_CALLSIGN);
+    }
+    memcpy (addr, n->addr, AX25_CALL_LEN + 1);
+    if ( ( (addr[AX25_CALL_LEN] >> 1) & 0x0F) != (n->ssid & 0x0F)) {
+
+      // The ssid field was written directly
+      addr[AX25_CALL_LEN] = prvucSsidByte (n->ssid);
+    }
+  }
+  else if (prviNodeEncode (n, addr) != AX25_SUCCESS) {
+
+    return prviError (AX25_ILLEGAL_CALLSIGN);
+  }
+
+  if (n->flag) {
+
+    addr[AX25_CALL_LEN] |= 0x80;
+  }
   return AX25_SUCCESS;
 }
 
@@ -245,7 +365,8 @@ iAx25FrameClear (xAx25Frame *p) {
   }
   p->ctrl = AX25_CTRL_UI;
   p->pid = AX25_PID_NOLAYER3;
-  memset (p->info, 0, AX25_FRAME_BUF_LEN);
+  // Only the terminator is cleared, the info field is written with its length
+  p->info[0] = 0;
   p->info_len = 0;
   iAx25NodeClear (p->src);
   iAx25NodeClear (p->dst);
@@ -268,7 +389,7 @@ iAx25FrameSetSrc (xAx25Frame *p, const char *callsign, uint8_t ssid) {
     return prviError (AX25_OBJECT_NOT_FOUND);
   }
   iAx25NodeSetCallsign (p->src, callsign);
-  p->src->ssid = ssid;
+  iAx25NodeSetSsid (p->src, ssid);
   return AX25_SUCCESS;
 }
 
@@ -281,7 +402,7 @@ iAx25FrameSetDst (xAx25Frame *p, const char *callsign, uint8_t ssid) {
     return prviError (AX25_OBJECT_NOT_FOUND);
   }
   iAx25NodeSetCallsign (p->dst, callsign);
-  p->dst->ssid = ssid;
+  iAx25NodeSetSsid (p->dst, ssid);
   return AX25_SUCCESS;
 }
 
@@ -301,7 +422,7 @@ iAx25FrameAddRepeater (xAx25Frame *p, const char *callsign, uint8_t ssid) {
 
   p->repeaters[index] = xAx25NodeNew();
   iAx25NodeSetCallsign (p->repeaters[index], callsign);
-  p->repeaters[index]->ssid = ssid;
+  iAx25NodeSetSsid (p->repeaters[index], ssid);
   return index;
 }
 
@@ -318,7 +439,7 @@ iAx25FrameSetRepeaterFlag (xAx25Frame *p, uint8_t index, bool flag) {
     return prviError (AX25_ILLEGAL_REPEATER);
   }
 
-  p->repeaters[index]->flag = flag;
+  iAx25NodeSetFlag (p->repeaters[index], flag);
   return AX25_SUCCESS;
 }
 
@@ -417,6 +538,87 @@ iAx25FramePrint (const xAx25Frame *p) {
   return iAx25FrameFilePrint (p, stdout);
 }
 
+//##############################################################################
+//#                                                                            #
+//#                           xAx25View Class                                  #
+//#                                                                            #
+//##############################################################################
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+int
+iAx25ViewInit (xAx25View *v, const uint8_t *frame, size_t len) {
+  const uint8_t *end = frame + len;
+  const uint8_t *buf = frame;
+
+  if ( (!v) || (!frame)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  memset (v, 0, sizeof (xAx25View));
+
+  // Walks the address field until the extension bit
+  do {
+
+    if ( (v->naddr >= AX25_MAX_RPT + 2) || (buf + AX25_CALL_LEN + 1 >= end)) {
+
+      return AX25_INVALID_FRAME;
+    }
+    buf += AX25_CALL_LEN + 1;
+    v->naddr++;
+  }
+  while (! (buf[-1] & 0x01));
+  if (v->naddr < 2) {
+
+    return AX25_INVALID_FRAME;
+  }
+
+  v->frame = frame;
+  v->len = len;
+  v->ctrl = *buf++;
+  // Only I and UI frames have a PID field
+  if ( ( (v->ctrl & 0x01) == 0) || ( (v->ctrl & ~0x10) == AX25_CTRL_UI)) {
+
+    if (buf >= end) {
+
+      return AX25_INVALID_FRAME;
+    }
+    v->pid = *buf++;
+  }
+  v->info = buf;
+  v->info_len = end - buf;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25ViewGetNode (const xAx25View *v, unsigned index, xAx25Node *n) {
+  const uint8_t *addr;
+
+  if ( (!v) || (!n)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (index >= v->naddr) {
+
+    return AX25_ILLEGAL_REPEATER;
+  }
+
+  addr = v->frame + index * (AX25_CALL_LEN + 1);
+  for (int i = 0; i < AX25_CALL_LEN; i++) {
+    char c = addr[i] >> 1;
+
+    n->callsign[i] = (c == ' ') ? '\x0' : c;
+  }
+  n->callsign[AX25_CALL_LEN] = 0;
+  n->addr_valid = 0;
+  n->ssid = (addr[AX25_CALL_LEN] >> 1) & 0x0F;
+  // The H bit only has a meaning for the repeaters
+  n->flag = (index >= 2) && (addr[AX25_CALL_LEN] & 0x80);
+  return AX25_SUCCESS;
+}
+
 //##############################################################################
 //#                                                                            #
 //#                             xAx25 Class                                    #
@@ -452,21 +654,22 @@ prvxOpenFile (int fd, int mode, int unused) {
 
 // -----------------------------------------------------------------------------
 static int
-prviGetc (int fd) {
-  uint8_t c;
-
-  if (read (fd, &c, 1) <= 0) {
+prviWrite (const uint8_t *buf, size_t len, int fd) {
 
-    return EOF;
-  }
-  return (unsigned) c;
-}
+  while (len) {
+    ssize_t n = write (fd, buf, len);
 
-// -----------------------------------------------------------------------------
-static int
-prviPutc (uint8_t c, int fd) {
+    if (n < 0) {
 
-  return write (fd, &c, 1);
+      if (errno == EINTR) {
+        continue;
+      }
+      return EOF;
+    }
+    buf += n;
+    len -= n;
+  }
+  return 0;
 }
 
 #else
@@ -542,13 +745,26 @@ prviGetc (FILE *f) {
 
 // -----------------------------------------------------------------------------
 static int
-prviPutc (uint8_t c, FILE *f) {
+prviWrite (const uint8_t *buf, size_t len, FILE *f) {
 
-  return fputc (c, f);
+  return (fwrite (buf, 1, len, f) == len) ? 0 : EOF;
 }
 
 #endif
 
+// -----------------------------------------------------------------------------
+// Stores c in out at index n, escaped if needed, returns the next index
+static size_t
+prvuPutEscaped (uint8_t *out, size_t n, uint8_t c) {
+
+  if (c == HDLC_FLAG || c == HDLC_RESET || c == AX25_ESC) {
+
+    out[n++] = AX25_ESC;
+  }
+  out[n++] = c;
+  return n;
+}
+
 /* public  ================================================================== */
 
 // -----------------------------------------------------------------------------
@@ -578,8 +794,8 @@ int iAx25Clear (xAx25 *p) {
     return prviError (AX25_OBJECT_NOT_FOUND);
   }
   memset (p, 0, sizeof (xAx25));
-  p->crc_in  = CRC_CCITT_INIT_VAL;
-  p->crc_out = CRC_CCITT_INIT_VAL;
+  iAx25DecoderClear (&p->dec);
+  p->pid[AX25_PID_NOLAYER3 / 8] = 1 << (AX25_PID_NOLAYER3 % 8);
 
   return AX25_SUCCESS;
 }
@@ -622,6 +838,94 @@ iAx25SetFdout (xAx25 *p, int fd) {
   return prviSetError (p, AX25_SUCCESS);
 }
 
+// -----------------------------------------------------------------------------
+int
+iAx25SetFilter (xAx25 *p, const xAx25Filter *filter) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  p->filter = filter;
+
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25SetCapture (xAx25 *p, xCapture *capture, uint16_t port) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  p->capture = capture;
+  p->port = port;
+
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25SetPcap (xAx25 *p, xPcap *pcap, uint16_t port) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  p->pcap = pcap;
+  p->port = port;
+
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25SetRxHandler (xAx25 *p, vAx25RxHandler handler, void *ctx) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  p->rx_handler = handler;
+  p->rx_ctx = ctx;
+
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25SetPid (xAx25 *p, uint8_t pid, bool accept) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (accept) {
+
+    p->pid[pid / 8] |= 1 << (pid % 8);
+  }
+  else {
+
+    p->pid[pid / 8] &= ~ (1 << (pid % 8));
+  }
+
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25SetAllPid (xAx25 *p, bool accept) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  memset (p->pid, accept ? 0xFF : 0, sizeof (p->pid));
+
+  return prviSetError (p, AX25_SUCCESS);
+}
+
 /*
  * ====================== Start of bertos code =================================
  * Bertos is free software; you can redistribute it and/or modify
@@ -653,9 +957,10 @@ iAx25SetFdout (xAx25 *p, int fd) {
  */
 /* constants ================================================================ */
 /*
- * Minimum size of a AX25 frame.
+ * Minimum size of a AX25 frame: two addresses, the control field and the FCS
+ * (S and U frames have no PID field).
  */
-#define AX25_MIN_FRAME_LEN 18
+#define AX25_MIN_FRAME_LEN 17
 
 /*
  * CRC computation on correct AX25 packets should
@@ -663,81 +968,534 @@ iAx25SetFdout (xAx25 *p, int fd) {
  */
 #define AX25_CRC_CORRECT  0xF0B8
 
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Decoder Class                               #
+//#                                                                            #
+//##############################################################################
+
 /* private ================================================================== */
+
 // -----------------------------------------------------------------------------
-static void
-prvvPutChar (xAx25 *p, uint8_t c) {
+// Index of the first HDLC_FLAG, HDLC_RESET or AX25_ESC byte of b, len if none
+static size_t
+prvuScanScalar (const uint8_t *b, size_t len) {
+  size_t i;
 
-  if (c == HDLC_FLAG || c == HDLC_RESET || c == AX25_ESC) {
+  for (i = 0; i < len; i++) {
 
-    prviPutc (AX25_ESC, p->fout);
+    if ( (b[i] == HDLC_FLAG) || (b[i] == HDLC_RESET) || (b[i] == AX25_ESC)) {
+      break;
+    }
   }
-  p->crc_out = usCrcCcittUpdate (c, p->crc_out);
-  prviPutc (c, p->fout);
+  return i;
 }
 
+#if defined(__SSE2__)
 // -----------------------------------------------------------------------------
-static int
-prviSendCall (xAx25 *p, const xAx25Node *n, bool last) {
-  unsigned len;
-
-  len = MIN (AX25_CALL_LEN, strlen (n->callsign));
-
-  for (unsigned i = 0; i < len; i++) {
-
-    uint8_t c = n->callsign[i];
-    if (! (isalnum (c) || c == ' ')) {
-
-      return prviSetError (p, AX25_ILLEGAL_CALLSIGN);
+static size_t
+prvuScanSse2 (const uint8_t *b, size_t len) {
+  const __m128i flag = _mm_set1_epi8 (HDLC_FLAG);
+  const __m128i reset = _mm_set1_epi8 (HDLC_RESET);
+  const __m128i esc = _mm_set1_epi8 (AX25_ESC);
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128 ( (const __m128i *) &b[i]);
+    __m128i m = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v, flag),
+                                            _mm_cmpeq_epi8 (v, reset)),
+                              _mm_cmpeq_epi8 (v, esc));
+    unsigned mask = _mm_movemask_epi8 (m);
+
+    if (mask) {
+
+      return i + __builtin_ctz (mask);
     }
-    c = toupper (c);
-    prvvPutChar (p, c << 1);
-    PINFO ("%02X", c << 1);
   }
+  return i + prvuScanScalar (&b[i], len - i);
+}
+#endif
 
-  /* Fill with spaces the rest of the CALL if it's shorter */
-  if (len < AX25_CALL_LEN) {
-    uint8_t space = ' ' << 1;
-
-    for (unsigned i = 0; i < (AX25_CALL_LEN - len); i++) {
-
-      prvvPutChar (p, space);
-      PINFO ("%02X", space);
+#if defined(__x86_64__) || defined(__i386__)
+// -----------------------------------------------------------------------------
+// Compiled for AVX2 whatever the flags of the library, only called if the
+// processor supports it
+__attribute__ ( (target ("avx2"))) static size_t
+prvuScanAvx2 (const uint8_t *b, size_t len) {
+  const __m256i flag = _mm256_set1_epi8 (HDLC_FLAG);
+  const __m256i reset = _mm256_set1_epi8 (HDLC_RESET);
+  const __m256i esc = _mm256_set1_epi8 (AX25_ESC);
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256 ( (const __m256i *) &b[i]);
+    __m256i m = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, flag),
+                                 _mm256_cmpeq_epi8 (v, reset)),
+                                 _mm256_cmpeq_epi8 (v, esc));
+    unsigned mask = _mm256_movemask_epi8 (m);
+
+    if (mask) {
+
+      return i + __builtin_ctz (mask);
     }
   }
+  return i + prvuScanScalar (&b[i], len - i);
+}
+#endif
 
-  /* Bits6:5 should be set to 1 for all SSIDs (0x60) */
-  /* The bit0 of last call SSID should be set to 1 */
-  uint8_t ssid = 0x60 | (n->flag ? 0x80 : 0) | (n->ssid << 1) | (last ? 0x01 : 0);
-  prvvPutChar (p, ssid);
-  PINFO ("-%02X ", ssid);
-  return prviSetError (p, AX25_SUCCESS);
+#if defined(__aarch64__) && defined(__ARM_NEON)
+// -----------------------------------------------------------------------------
+static size_t
+prvuScanNeon (const uint8_t *b, size_t len) {
+  const uint8x16_t flag = vdupq_n_u8 (HDLC_FLAG);
+  const uint8x16_t reset = vdupq_n_u8 (HDLC_RESET);
+  const uint8x16_t esc = vdupq_n_u8 (AX25_ESC);
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8 (&b[i]);
+    uint8x16_t m = vorrq_u8 (vorrq_u8 (vceqq_u8 (v, flag), vceqq_u8 (v, reset)),
+                             vceqq_u8 (v, esc));
+
+    if (vmaxvq_u8 (m)) {
+      // 4 bits per byte, the first special byte is the lowest nibble set
+      uint64_t nibbles = vget_lane_u64 (vreinterpret_u64_u8 (
+                                          vshrn_n_u16 (vreinterpretq_u16_u8 (m), 4)), 0);
+
+      return i + (__builtin_ctzll (nibbles) >> 2);
+    }
+  }
+  return i + prvuScanScalar (&b[i], len - i);
 }
+#endif
+
+static size_t prvuScanInit (const uint8_t *b, size_t len);
+
+// Kernel chosen for the processor at the first call
+static size_t (*prvuScan) (const uint8_t *b, size_t len) = prvuScanInit;
 
 // -----------------------------------------------------------------------------
-uint8_t *
-prvxExtractCallsign (uint8_t * buf, char * callsign) {
+static size_t
+prvuScanInit (const uint8_t *b, size_t len) {
 
-  for (uint8_t i = 0; i < AX25_CALL_LEN; i++) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports ("avx2")) {
 
-    char c = ( (*buf) >> 1);
-    callsign[i] = (c == ' ') ? '\x0' : c;
-    buf++;
+    prvuScan = prvuScanAvx2;
   }
-  return buf;
+  else
+#endif
+  {
+#if defined(__SSE2__)
+    prvuScan = prvuScanSse2;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    prvuScan = prvuScanNeon;
+#else
+    prvuScan = prvuScanScalar;
+#endif
+  }
+  return prvuScan (b, len);
 }
 
+/* public  ================================================================== */
+
 // -----------------------------------------------------------------------------
-static int
-prviDecode (xAx25 *p, xAx25Frame *f) {
-  char cs[AX25_CALL_LEN];
-  uint8_t *buf;
+xAx25Decoder *
+xAx25DecoderNew (void) {
+  xAx25Decoder *d;
 
-  buf = p->buf;
-  iAx25FrameClear (f);
+  d = malloc (sizeof (xAx25Decoder));
+  if (d) {
+    iAx25DecoderClear (d);
+  }
+  return d;
+}
 
-  buf = prvxExtractCallsign (buf, cs);
-  PDEBUG ("Dst: %c%c%c%c%c%c\n", cs[0], cs[1], cs[2], cs[3], cs[4], cs[5]);
+// -----------------------------------------------------------------------------
+void
+vAx25DecoderDelete (xAx25Decoder *d) {
+
+  free (d);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DecoderClear (xAx25Decoder *d) {
+
+  if (!d) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  d->len = 0;
+  d->crc = CRC_CCITT_INIT_VAL;
+  d->sync = false;
+  d->escape = false;
+  d->ready = false;
+
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+bool
+bAx25DecoderFeed (xAx25Decoder *d, const void *buf, size_t len, size_t *used) {
+  const uint8_t *b = (const uint8_t *) buf;
+  size_t i = 0;
+
+  if ( (d) && (b)) {
+
+    while ( (d->ready == false) && (i < len)) {
+      uint8_t c;
+
+      if (!d->escape) {
+        size_t n;
+
+        // The ordinary bytes up to the next special byte are processed at once
+        if (!d->sync) {
+
+          i += prvuScan (&b[i], len - i);
+        }
+        else if ( (n = prvuScan (&b[i], MIN (len - i, AX25_FRAME_BUF_LEN - d->len))) > 0) {
+
+          memcpy (&d->buf[d->len], &b[i], n);
+          d->crc = usCrcCcitt (d->crc, &b[i], n);
+          d->len += n;
+          i += n;
+        }
+        if (i == len) {
+          break;
+        }
+      }
+
+      c = b[i++];
+
+      if (!d->escape && c == HDLC_FLAG) {
+
+        if (d->len >= AX25_MIN_FRAME_LEN) {
+
+          if (d->crc == AX25_CRC_CORRECT) {
+
+            // The frame stays in buf until it is discarded
+            d->ready = true;
+            break;
+          }
+          PINFO ("CRC error, computed [%04X]\n", d->crc);
+        }
+        d->sync = true;
+        d->crc = CRC_CCITT_INIT_VAL;
+        d->len = 0;
+        continue;
+      }
+
+      if (!d->escape && c == HDLC_RESET) {
+
+        PINFO ("HDLC reset\n");
+        d->sync = false;
+        continue;
+      }
+
+      if (!d->escape && c == AX25_ESC) {
+
+        d->escape = true;
+        continue;
+      }
+
+      if (d->sync) {
+
+        if (d->len < AX25_FRAME_BUF_LEN) {
+
+          d->buf[d->len++] = c;
+          d->crc = usCrcCcittUpdate (c, d->crc);
+        }
+        else {
+
+          PINFO ("Buffer overrun");
+          d->sync = false;
+        }
+      }
+      d->escape = false;
+    }
+  }
+  if (used) {
+
+    *used = i;
+  }
+  return (d) ? d->ready : false;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DecoderView (const xAx25Decoder *d, xAx25View *v) {
+
+  if ( (!d) || (!v)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (!d->ready) {
+
+    return AX25_NO_FRAME_RECEIVED;
+  }
+  return iAx25ViewInit (v, d->buf, d->len - 2);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DecoderDiscard (xAx25Decoder *d) {
+
+  if (!d) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (!d->ready) {
+
+    return AX25_NO_FRAME_RECEIVED;
+  }
+  // The flag which ends the frame starts the next one
+  d->ready = false;
+  d->sync = true;
+  d->crc = CRC_CCITT_INIT_VAL;
+  d->len = 0;
+
+  return AX25_SUCCESS;
+}
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Encoder Class                               #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+static int
+prviEncoderStart (xAx25Encoder *e, size_t len) {
+  size_t size = len + 2;
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t c = e->frame[i];
+
+    if (c == HDLC_FLAG || c == HDLC_RESET || c == AX25_ESC) {
+      size++;
+    }
+  }
+  e->len = len;
+  e->pos = 0;
+  e->size = size;
+  e->flag = false;
+  e->escape = false;
+
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+static uint8_t *
+prvxEncodeCall (uint8_t *buf, const xAx25Node *n, bool last, int *iError) {
+
+  *iError = iAx25NodeEncode (n, buf);
+
+  /* The bit0 of last call SSID should be set to 1 */
+  if (last) {
+
+    buf[AX25_CALL_LEN] |= 0x01;
+  }
+  return buf + AX25_CALL_LEN + 1;
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xAx25Encoder *
+xAx25EncoderNew (void) {
+  xAx25Encoder *e;
+
+  e = malloc (sizeof (xAx25Encoder));
+  if (e) {
+    iAx25EncoderClear (e);
+  }
+  return e;
+}
+
+// -----------------------------------------------------------------------------
+void
+vAx25EncoderDelete (xAx25Encoder *e) {
+
+  free (e);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25EncoderClear (xAx25Encoder *e) {
+
+  if (!e) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  e->len = 0;
+  e->pos = 0;
+  e->size = 0;
+  e->flag = false;
+  e->escape = false;
+
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25EncoderSetFrame (xAx25Encoder *e, const xAx25Frame *f) {
+  uint8_t *buf;
+  uint16_t fcs;
+  int iError;
+
+  if ( (!e) || (!f)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  e->size = 0;
+  if ( (f->repeaters_len > AX25_MAX_RPT) ||
+       ( (2 + f->repeaters_len) * (AX25_CALL_LEN + 1) + 2 + f->info_len + 2 >
+         AX25_FRAME_BUF_LEN)) {
+
+    return prviError (AX25_INVALID_FRAME);
+  }
+
+  /* Path */
+  buf = prvxEncodeCall (e->frame, f->dst, false, &iError);
+  if (iError == AX25_SUCCESS) {
+
+    buf = prvxEncodeCall (buf, f->src, (f->repeaters_len ? false : true), &iError);
+  }
+  for (uint8_t i = 0; (iError == AX25_SUCCESS) && (i < f->repeaters_len); i++) {
+
+    buf = prvxEncodeCall (buf, f->repeaters[i], (i == f->repeaters_len - 1), &iError);
+  }
+  if (iError) {
+
+    return iError;
+  }
+
+  *buf++ = f->ctrl;
+  *buf++ = f->pid;
+  memcpy (buf, f->info, f->info_len);
+  buf += f->info_len;
+
+  /*
+   * According to AX25 protocol,
+   * CRC is sent in reverse order!
+   */
+  fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, e->frame, buf - e->frame) ^ 0xFFFF;
+  *buf++ = fcs & 0xFF;
+  *buf++ = fcs >> 8;
+
+  return prviEncoderStart (e, buf - e->frame);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25EncoderSetRaw (xAx25Encoder *e, const uint8_t *frame, size_t len) {
+
+  if ( (!e) || (!frame)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  e->size = 0;
+  if ( (len < AX25_MIN_FRAME_LEN) || (len > AX25_FRAME_BUF_LEN)) {
+
+    return prviError (AX25_INVALID_FRAME);
+  }
+  memcpy (e->frame, frame, len);
+
+  return prviEncoderStart (e, len);
+}
+
+// -----------------------------------------------------------------------------
+size_t
+uAx25EncoderSize (const xAx25Encoder *e) {
+
+  return (e) ? e->size : 0;
+}
+
+// -----------------------------------------------------------------------------
+size_t
+uAx25EncoderRead (xAx25Encoder *e, void *out, size_t size) {
+  uint8_t *o = (uint8_t *) out;
+  size_t n = 0;
+
+  if ( (!e) || (!o)) {
+
+    return 0;
+  }
+  while ( (n < size) && (e->size > 0)) {
+
+    if (!e->flag) {
+
+      o[n++] = HDLC_FLAG;
+      e->flag = true;
+    }
+    else if (e->pos < e->len) {
+      uint8_t c = e->frame[e->pos];
+
+      if (!e->escape && (c == HDLC_FLAG || c == HDLC_RESET || c == AX25_ESC)) {
+
+        o[n++] = AX25_ESC;
+        e->escape = true;
+      }
+      else {
+
+        o[n++] = c;
+        e->escape = false;
+        e->pos++;
+      }
+    }
+    else {
+
+      o[n++] = HDLC_FLAG;
+    }
+    e->size--;
+  }
+  return n;
+}
+
+//##############################################################################
+//#                                                                            #
+//#                             xAx25 Class                                    #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+// -----------------------------------------------------------------------------
+// Ready for the next frame
+static void
+prvvRxReset (xAx25 *p) {
+
+  (void) iAx25DecoderDiscard (&p->dec);
+  p->frm_recv = false;
+}
+
+// -----------------------------------------------------------------------------
+uint8_t *
+prvxExtractCallsign (uint8_t * buf, char * callsign) {
+
+  for (uint8_t i = 0; i < AX25_CALL_LEN; i++) {
+
+    char c = ( (*buf) >> 1);
+    callsign[i] = (c == ' ') ? '\x0' : c;
+    buf++;
+  }
+  return buf;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviDecode (xAx25 *p, xAx25Frame *f) {
+  char cs[AX25_CALL_LEN];
+  uint8_t *buf;
+
+  buf = p->dec.buf;
+  iAx25FrameClear (f);
+
+  buf = prvxExtractCallsign (buf, cs);
+  PDEBUG ("Dst: %c%c%c%c%c%c\n", cs[0], cs[1], cs[2], cs[3], cs[4], cs[5]);
   iAx25FrameSetDst (f, cs, (*buf++ >> 1) & 0x0F);
 
   buf = prvxExtractCallsign (buf, cs);
@@ -768,96 +1526,153 @@ prviDecode (xAx25 *p, xAx25Frame *f) {
   f->ctrl = *buf++;
   if (f->ctrl != AX25_CTRL_UI) {
 
+    // The frame can not be read, it is released for the next one
     PWARNING ("Only UI frames are handled, got [%02X]\n", f->ctrl);
+    prvvRxReset (p);
     return AX25_INVALID_FRAME;
   }
 
+  if (buf + 2 >= p->dec.buf + p->dec.len) {
+
+    PWARNING ("UI frame without PID field\n");
+    prvvRxReset (p);
+    return AX25_INVALID_FRAME;
+  }
   f->pid = *buf++;
-  if (f->pid != AX25_PID_NOLAYER3) {
+  if (! (p->pid[f->pid / 8] & (1 << (f->pid % 8)))) {
 
-    PWARNING ("Only frames without layer3 protocol are handled, got [%02X]\n", f->pid);
+    PWARNING ("Frames of PID [%02X] are not accepted\n", f->pid);
+    prvvRxReset (p);
     return AX25_INVALID_FRAME;
   }
 
-  f->info_len = p->len - 2 - (buf - p->buf);
+  f->info_len = p->dec.len - 2 - (buf - p->dec.buf);
   memcpy (f->info, buf, f->info_len);
+  f->info[f->info_len] = 0;
   PINFO ("DATA: %.*s\n", (int) f->info_len, f->info);
 
-  // Ready for the next frame
-  p->sync = false;
-  p->crc_in = CRC_CCITT_INIT_VAL;
-  p->len = 0;
-  p->escape = false;
-  p->frm_recv = false;
-
+  prvvRxReset (p);
   return AX25_SUCCESS;
 }
 
-/* public  ================================================================== */
-
 // -----------------------------------------------------------------------------
-bool
-bAx25Poll (xAx25 *p) {
-  int c;
+// Decodes the bytes of buf until a frame is received, returns the number of
+// bytes used. With a handler, the frames are given to it and all the bytes
+// are decoded
+static size_t
+prvuDecodeBuf (xAx25 *p, const uint8_t *buf, size_t len) {
+  size_t i = 0;
+
+  while ( (p->frm_recv == false) && (i < len)) {
+    const uint8_t *frame = p->dec.buf;
+    size_t used, flen;
+    bool found;
+
+    found = bAx25DecoderFeed (&p->dec, &buf[i], len - i, &used);
+    i += used;
+    if (!found) {
+
+      break;
+    }
+    flen = p->dec.len - 2;
 
-  if (!p->fin) {
+    if (p->capture) {
 
-    return false;
-  }
+      (void) iCaptureWrite (p->capture, p->port, frame, flen);
+    }
+    if (p->pcap) {
 
-  while ( (p->frm_recv == false) && ( (c = prviGetc (p->fin)) != EOF)) {
+      (void) iPcapWrite (p->pcap, p->port, frame, flen);
+    }
 
-    if (!p->escape && c == HDLC_FLAG) {
+    // The filter runs on the raw frame, without the FCS
+    if ( (p->filter == NULL) || bAx25FilterMatch (p->filter, frame, flen)) {
 
-      if (p->len >= AX25_MIN_FRAME_LEN) {
+      PINFO ("Frame found!\n");
+      if (p->rx_handler) {
+        xAx25View v;
 
-        if (p->crc_in == AX25_CRC_CORRECT) {
+        // The frame is given in place, the decoding goes on
+        if (iAx25ViewInit (&v, frame, flen) == AX25_SUCCESS) {
 
-          PINFO ("Frame found!\n");
-          p->frm_recv = true;
-          break;  // TODO: sortie à éclaircir !!!
+          p->rx_frames++;
+          p->rx_handler (p, &v, p->rx_ctx);
         }
-        else {
+      }
+      else {
 
-          PINFO ("CRC error, computed [%04X]\n", p->crc_in);
-        }
+        p->frm_recv = true;
+        break;
       }
-      p->sync = true;
-      p->crc_in = CRC_CCITT_INIT_VAL;
-      p->len = 0;
-      continue;
     }
+    else {
 
+      PINFO ("Frame rejected by filter\n");
+    }
+    (void) iAx25DecoderDiscard (&p->dec);
+  }
 
-    if (!p->escape && c == HDLC_RESET) {
+  return i;
+}
 
-      PINFO ("HDLC reset\n");
-      p->sync = false;
-      continue;
-    }
+// -----------------------------------------------------------------------------
+// Decodes the staged bytes, then the bytes read from the input by chunks if
+// fill is true, returns true if a frame is received or given to the handler
+static bool
+prvbDecode (xAx25 *p, bool fill) {
+  unsigned long frames = p->rx_frames;
+
+  while (p->frm_recv == false) {
 
-    if (!p->escape && c == AX25_ESC) {
+    if (p->stage_pos < p->stage_len) {
 
-      p->escape = true;
+      p->stage_pos += prvuDecodeBuf (p, &p->stage[p->stage_pos],
+                                     p->stage_len - p->stage_pos);
       continue;
     }
+    // The chunk which delivered frames to the handler is entirely decoded
+    if ( (!fill) || (p->rx_frames != frames)) {
 
-    if (p->sync) {
+      break;
+    }
+#if AX25_CFG_USE_STREAM == 0
+    ssize_t n = read (p->fin, p->stage, sizeof (p->stage));
 
-      if (p->len < AX25_FRAME_BUF_LEN) {
+    if (n <= 0) {
 
-        p->buf[p->len++] = c;
-        p->crc_in = usCrcCcittUpdate (c, p->crc_in);
-      }
-      else {
+      break;
+    }
+    p->stage_len = n;
+#else
+    int c = prviGetc (p->fin);
 
-        PINFO ("Buffer overrun");
-        p->sync = false;
-      }
+    if (c == EOF) {
+
+      break;
     }
-    p->escape = false;
+    p->stage[0] = c;
+    p->stage_len = 1;
+#endif
+    p->stage_pos = 0;
   }
 
+  return (p->frm_recv) || (p->rx_frames != frames);
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+bool
+bAx25Poll (xAx25 *p) {
+  bool ret;
+
+  if (!p->fin) {
+
+    return false;
+  }
+
+  ret = prvbDecode (p, true);
+
 #if AX25_CFG_USE_STREAM
   if (ferror (p->fin)) {
 
@@ -866,15 +1681,118 @@ bAx25Poll (xAx25 *p) {
   }
 #endif
 
-  return p->frm_recv;
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+bool
+bAx25PollTimeout (xAx25 *p, int timeout_ms) {
+  struct timespec deadline;
+  struct pollfd pfd;
+  unsigned long frames;
+
+  if ( (!p) || (!p->fin)) {
+
+    return false;
+  }
+  frames = p->rx_frames;
+
+  clock_gettime (CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+#if AX25_CFG_USE_STREAM == 0
+  pfd.fd = p->fin;
+#else
+  pfd.fd = fileno (p->fin);
+#endif
+  pfd.events = POLLIN;
+
+  // The input is read only when poll() says it is readable, so that a blocking
+  // file descriptor never blocks past the deadline
+  while ( (!prvbDecode (p, false)) || (!p->frm_recv)) {
+    struct timespec now;
+    int wait = -1;
+    ssize_t n;
+
+    if (p->rx_frames != frames) {
+
+      // Frames are given to the handler, the input is only drained
+      wait = 0;
+    }
+    else if (timeout_ms >= 0) {
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      wait = (deadline.tv_sec - now.tv_sec) * 1000 +
+             (deadline.tv_nsec - now.tv_nsec) / 1000000L;
+      if (wait < 0) {
+
+        wait = 0;
+      }
+    }
+
+    n = poll (&pfd, 1, wait);
+    if (n < 0) {
+
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (n == 0) {
+
+      // Timeout
+      break;
+    }
+
+#if AX25_CFG_USE_STREAM == 0
+    n = read (p->fin, p->stage, sizeof (p->stage));
+#else
+    n = read (fileno (p->fin), p->stage, sizeof (p->stage));
+#endif
+    if (n <= 0) {
+
+      if ( (n < 0) && ( (errno == EINTR) || (errno == EAGAIN))) {
+        continue;
+      }
+      // End of file or error
+      break;
+    }
+    p->stage_len = n;
+    p->stage_pos = 0;
+  }
+  return (p->frm_recv) || (p->rx_frames != frames);
+}
+
+// -----------------------------------------------------------------------------
+bool
+bAx25Feed (xAx25 *p, const void *buf, size_t len, size_t *used) {
+  size_t n = 0;
+  unsigned long frames = 0;
+
+  if ( (p) && (buf) && (!p->frm_recv)) {
+
+    frames = p->rx_frames;
+    n = prvuDecodeBuf (p, (const uint8_t *) buf, len);
+  }
+  if (used) {
+
+    *used = n;
+  }
+  return (p) ? (p->frm_recv) || (p->rx_frames != frames) : false;
 }
 
 // -----------------------------------------------------------------------------
 int
 iAx25Send (xAx25 *p, const xAx25Frame *f) {
+  xAx25Encoder e;
+  uint8_t out[AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)];
+  size_t n;
   int iError;
-  const uint8_t *buf = (const uint8_t *) f->info;
-  size_t len;
 
   if (!p) {
 
@@ -889,82 +1807,262 @@ iAx25Send (xAx25 *p, const xAx25Frame *f) {
     return prviSetError (p, AX25_INVALID_FRAME);
   }
 
-  p->crc_out = CRC_CCITT_INIT_VAL;
-  prviPutc (HDLC_FLAG, p->fout);
-  PINFO (">%02X ", HDLC_FLAG);
-
-  /* Send path */
-  iError = prviSendCall (p, f->dst, false);
+  // The whole escaped frame is built before being written at once
+  iAx25EncoderClear (&e);
+  iError = iAx25EncoderSetFrame (&e, f);
   if (iError) {
-    return iError;
+
+    return prviSetError (p, iError);
   }
-  iError = prviSendCall (p, f->src, (f->repeaters_len ? false : true));
-  if (iError) {
-    return iError;
+  n = uAx25EncoderRead (&e, out, sizeof (out));
+
+  if (prviWrite (out, n, p->fout) != 0) {
+
+    return prviSetError (p, AX25_FILE_ACCESS_ERROR);
   }
+  return prviSetError (p, AX25_SUCCESS);
+}
+/*
+ * ======================= End of bertos code =================================
+ */
 
-  for (uint8_t i = 0; i < f->repeaters_len; i++) {
+// -----------------------------------------------------------------------------
+int
+iAx25Read (xAx25 *p, xAx25Frame *f) {
 
-    iError = prviSendCall (p, f->repeaters[i], (i == f->repeaters_len - 1));
-    if (iError) {
-      return iError;
-    }
+  if ( (!p) || (!f)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+
+  if (!p->frm_recv) {
+
+    return AX25_NO_FRAME_RECEIVED;
+  }
+
+  p->error = AX25_SUCCESS;
+  return prviDecode (p, f);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25ReadView (xAx25 *p, xAx25View *v) {
+
+  if ( (!p) || (!v)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
   }
 
-  prvvPutChar (p, f->ctrl);
-  PINFO ("%02X ", f->ctrl);
+  if (!p->frm_recv) {
 
-  prvvPutChar (p, f->pid);
-  PINFO ("%02X ", f->pid);
+    return AX25_NO_FRAME_RECEIVED;
+  }
 
-  len = f->info_len;
+  return prviSetError (p, iAx25DecoderView (&p->dec, v));
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25Discard (xAx25 *p) {
+
+  if (!p) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+
+  if (!p->frm_recv) {
+
+    return AX25_NO_FRAME_RECEIVED;
+  }
+
+  prvvRxReset (p);
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+size_t
+uAx25Encode (uint8_t *out, const uint8_t *frame, size_t len) {
+  size_t n = 0;
+
+  out[n++] = HDLC_FLAG;
   while (len--) {
 
-    prvvPutChar (p, *buf);
-    PINFO ("%c", *buf);
-    buf++;
+    n = prvuPutEscaped (out, n, *frame++);
   }
+  out[n++] = HDLC_FLAG;
+  return n;
+}
 
-  /*
-   * According to AX25 protocol,
-   * CRC is sent in reverse order!
-   */
-  uint8_t crcl = (p->crc_out & 0xff) ^ 0xff;
-  uint8_t crch = (p->crc_out >> 8) ^ 0xff;
-  prvvPutChar (p, crcl);
-  PINFO (" %02X", crcl);
-  prvvPutChar (p, crch);
-  PINFO ("%02X ", crch);
+// -----------------------------------------------------------------------------
+int
+iAx25SendRaw (xAx25 *p, const uint8_t *frame, size_t len) {
+  uint8_t out[AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)];
+  size_t n = 0;
 
-  if (p->crc_out != AX25_CRC_CORRECT) {
+  if (!p) {
 
-    return prviSetError (p, AX25_CRC_ERROR);
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (!p->fout) {
+
+    return AX25_FILE_NOT_FOUND;
   }
+  if ( (!frame) || (len < AX25_MIN_FRAME_LEN) || (len > AX25_FRAME_BUF_LEN)) {
 
-  prviPutc (HDLC_FLAG, p->fout);
-  PINFO ("%02X\n", HDLC_FLAG);
+    return prviSetError (p, AX25_INVALID_FRAME);
+  }
+
+  // The whole escaped frame is built before being written at once
+  n = uAx25Encode (out, frame, len);
+
+  if (prviWrite (out, n, p->fout) != 0) {
+
+    return prviSetError (p, AX25_FILE_ACCESS_ERROR);
+  }
   return prviSetError (p, AX25_SUCCESS);
 }
-/*
- * ======================= End of bertos code =================================
- */
 
 // -----------------------------------------------------------------------------
 int
-iAx25Read (xAx25 *p, xAx25Frame *f) {
+iAx25SendEncoded (xAx25 *p, const void *buf, size_t len) {
 
-  if ( (!p) || (!f)) {
+  if (!p) {
 
     return prviError (AX25_OBJECT_NOT_FOUND);
   }
+  if (!p->fout) {
 
-  if (!p->frm_recv) {
+    return AX25_FILE_NOT_FOUND;
+  }
+  if ( (!buf) && (len)) {
 
-    return AX25_NO_FRAME_RECEIVED;
+    return prviSetError (p, AX25_INVALID_FRAME);
   }
 
-  p->error = AX25_SUCCESS;
-  return prviDecode (p, f);
+  if (prviWrite (buf, len, p->fout) != 0) {
+
+    return prviSetError (p, AX25_FILE_ACCESS_ERROR);
+  }
+  return prviSetError (p, AX25_SUCCESS);
+}
+
+//##############################################################################
+//#                                                                            #
+//#                          xAx25Template Class                               #
+//#                                                                            #
+//##############################################################################
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xAx25Template *
+xAx25TemplateNew (const xAx25Frame *frame) {
+  xAx25Template *t;
+
+  t = malloc (sizeof (xAx25Template));
+  if (t) {
+
+    if (iAx25TemplateSet (t, frame) != AX25_SUCCESS) {
+
+      free (t);
+      return NULL;
+    }
+  }
+  return t;
+}
+
+// -----------------------------------------------------------------------------
+void
+vAx25TemplateDelete (xAx25Template *t) {
+
+  free (t);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TemplateSet (xAx25Template *t, const xAx25Frame *f) {
+  uint8_t raw[(AX25_CALL_LEN + 1) * (2 + AX25_MAX_RPT) + 2];
+  const xAx25Node *n;
+  size_t len = 0;
+  int iError;
+
+  if ( (!t) || (!f)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (f->repeaters_len > AX25_MAX_RPT) {
+
+    return prviError (AX25_ILLEGAL_REPEATER);
+  }
+
+  for (int i = -2; i < f->repeaters_len; i++) {
+
+    n = (i == -2) ? f->dst : ( (i == -1) ? f->src : f->repeaters[i]);
+    iError = iAx25NodeEncode (n, &raw[len]);
+    if (iError) {
+
+      return iError;
+    }
+    len += AX25_CALL_LEN + 1;
+  }
+  /* The bit0 of last call SSID should be set to 1 */
+  raw[len - 1] |= 0x01;
+  raw[len++] = f->ctrl;
+  raw[len++] = f->pid;
+
+  t->crc = usCrcCcitt (CRC_CCITT_INIT_VAL, raw, len);
+  t->hdr_len = 0;
+  t->hdr[t->hdr_len++] = HDLC_FLAG;
+  for (size_t i = 0; i < len; i++) {
+
+    t->hdr_len = prvuPutEscaped (t->hdr, t->hdr_len, raw[i]);
+  }
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TemplateSend (xAx25 *p, const xAx25Template *t,
+                   const void *info, size_t info_len) {
+  uint8_t out[AX25_TEMPLATE_HDR_LEN + (AX25_INFO_LEN + 2) * 2 + 1];
+  const uint8_t *buf = (const uint8_t *) info;
+  uint16_t crc;
+  size_t n;
+
+  if ( (!p) || (!t)) {
+
+    return prviError (AX25_OBJECT_NOT_FOUND);
+  }
+  if (!p->fout) {
+
+    return AX25_FILE_NOT_FOUND;
+  }
+  if ( ( (!info) && (info_len)) || (info_len > AX25_INFO_LEN)) {
+
+    return prviSetError (p, AX25_INVALID_FRAME);
+  }
+
+  // Only the info field and the FCS have to be escaped
+  memcpy (out, t->hdr, t->hdr_len);
+  n = t->hdr_len;
+  crc = t->crc;
+  while (info_len--) {
+    uint8_t c = *buf++;
+
+    crc = usCrcCcittUpdate (c, crc);
+    n = prvuPutEscaped (out, n, c);
+  }
+
+  /* According to AX25 protocol, CRC is sent in reverse order! */
+  n = prvuPutEscaped (out, n, (crc & 0xff) ^ 0xff);
+  n = prvuPutEscaped (out, n, (crc >> 8) ^ 0xff);
+  out[n++] = HDLC_FLAG;
+
+  if (prviWrite (out, n, p->fout) != 0) {
+
+    return prviSetError (p, AX25_FILE_ACCESS_ERROR);
+  }
+  return prviSetError (p, AX25_SUCCESS);
 }
 
 /* ========================================================================== */
@@ -0,0 +1,322 @@
+/**
+ * @file src/capture.c
+ * @brief Journal de capture des trames reçues (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <radio/capture.h>
+
+/* constants ================================================================ */
+#define ALIGN8(n) (((n) + 7) & ~((size_t) 7))
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+static inline uint64_t
+prvullNow (clockid_t id) {
+  struct timespec ts;
+
+  clock_gettime (id, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Synchronizes the pages written since the last call
+static void
+prvvSync (xCapture *c, int flags) {
+  size_t page = sysconf (_SC_PAGESIZE);
+  size_t start = c->synced & ~ (page - 1);
+
+  if (c->pos > start) {
+
+    msync (c->map + start, c->pos - start, flags);
+  }
+  c->synced = c->pos;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvClose (xCapture *c) {
+
+  if (c->map) {
+
+    prvvSync (c, MS_SYNC);
+    munmap (c->map, c->seg_size);
+    c->map = NULL;
+  }
+  if (c->fd >= 0) {
+    size_t page = sysconf (_SC_PAGESIZE);
+    size_t keep = (c->pos + sizeof (xCaptureRecordHdr) + page - 1) & ~ (page - 1);
+
+    // The unused preallocated space is released, the page of the null record
+    // which ends the data is kept for the readers which follow the segment
+    if (ftruncate (c->fd, MIN (keep, c->seg_size)) < 0) {
+
+      perror ("ftruncate");
+    }
+    close (c->fd);
+    c->fd = -1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviOpen (xCapture *c, unsigned segment) {
+  xCaptureFileHdr *h;
+  char *name;
+  int err;
+
+  if (asprintf (&name, "%s.%04u", c->path, segment) < 0) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  c->fd = open (name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  free (name);
+  if (c->fd < 0) {
+
+    return AX25_FILE_ACCESS_ERROR;
+  }
+
+  // The whole segment is allocated now, no page fault can fail on writing
+  err = posix_fallocate (c->fd, 0, c->seg_size);
+  if ( (err == EOPNOTSUPP) || (err == EINVAL)) {
+
+    err = (ftruncate (c->fd, c->seg_size) < 0) ? errno : 0;
+  }
+  if (err == 0) {
+
+    c->map = mmap (NULL, c->seg_size, PROT_READ | PROT_WRITE, MAP_SHARED, c->fd, 0);
+    if (c->map == MAP_FAILED) {
+
+      c->map = NULL;
+    }
+  }
+  if (!c->map) {
+
+    close (c->fd);
+    c->fd = -1;
+    return AX25_FILE_ACCESS_ERROR;
+  }
+
+  h = (xCaptureFileHdr *) c->map;
+  memcpy (h->magic, AX25_CAPTURE_MAGIC, sizeof (h->magic));
+  h->hdr_size = sizeof (xCaptureFileHdr);
+  h->segment = segment;
+  h->created = prvullNow (CLOCK_REALTIME);
+  c->segment = segment;
+  c->pos = sizeof (xCaptureFileHdr);
+  c->synced = 0;
+  return AX25_SUCCESS;
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xCapture *
+xCaptureNew (const char *path, size_t seg_size) {
+  xCapture *c;
+
+  if (!path) {
+
+    return NULL;
+  }
+  if (seg_size == 0) {
+
+    seg_size = AX25_CAPTURE_SEGMENT_SIZE;
+  }
+  if (seg_size < sizeof (xCaptureFileHdr) + 2 * sizeof (xCaptureRecordHdr)) {
+
+    return NULL;
+  }
+
+  c = calloc (1, sizeof (xCapture));
+  if (c) {
+
+    c->fd = -1;
+    c->seg_size = ALIGN8 (seg_size);
+    c->path = strdup (path);
+    if ( (!c->path) || (prviOpen (c, 0) != AX25_SUCCESS)) {
+
+      free (c->path);
+      free (c);
+      return NULL;
+    }
+  }
+  return c;
+}
+
+// -----------------------------------------------------------------------------
+void
+vCaptureDelete (xCapture *c) {
+
+  if (c) {
+
+    prvvClose (c);
+    free (c->path);
+    free (c);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iCaptureWrite (xCapture *c, uint16_t port, const void *frame, size_t len) {
+  xCaptureRecordHdr *r;
+  size_t size = ALIGN8 (sizeof (xCaptureRecordHdr) + len);
+
+  if ( (!c) || (!frame)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  // The record and the null record which ends the data must fit in a segment
+  if ( (len == 0) || (sizeof (xCaptureFileHdr) + size +
+                      sizeof (xCaptureRecordHdr) > c->seg_size)) {
+
+    return AX25_INVALID_FRAME;
+  }
+
+  if ( (!c->map) || (c->pos + size + sizeof (xCaptureRecordHdr) > c->seg_size)) {
+    int ret;
+
+    // Segment rollover, tried again on each frame after a failure
+    prvvClose (c);
+    if ( (ret = prviOpen (c, c->segment + 1)) != AX25_SUCCESS) {
+
+      return ret;
+    }
+  }
+
+  r = (xCaptureRecordHdr *) (c->map + c->pos);
+  memcpy (r + 1, frame, len);
+  r->port = port;
+  r->mono = prvullNow (CLOCK_MONOTONIC);
+  r->wall = prvullNow (CLOCK_REALTIME);
+  // The length is published last, a reader never sees a partial record
+  __atomic_store_n (&r->len, (uint32_t) len, __ATOMIC_RELEASE);
+
+  c->pos += size;
+  c->frames++;
+  if (c->pos - c->synced >= AX25_CAPTURE_SYNC_SIZE) {
+
+    prvvSync (c, MS_ASYNC);
+  }
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iCaptureSync (xCapture *c) {
+
+  if ( (!c) || (!c->map)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  c->synced = 0;
+  prvvSync (c, MS_SYNC);
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+xCaptureReader *
+xCaptureReaderNew (const char *file) {
+  xCaptureReader *r;
+  struct stat st;
+  void *map;
+
+  r = calloc (1, sizeof (xCaptureReader));
+  if (!r) {
+
+    return NULL;
+  }
+
+  r->fd = open (file, O_RDONLY);
+  if (r->fd < 0) {
+
+    free (r);
+    return NULL;
+  }
+
+  if ( (fstat (r->fd, &st) == 0) && (st.st_size >= (off_t) sizeof (xCaptureFileHdr))) {
+
+    map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, r->fd, 0);
+    if (map != MAP_FAILED) {
+      const xCaptureFileHdr *h = (const xCaptureFileHdr *) map;
+
+      r->map = map;
+      r->size = st.st_size;
+      if ( (memcmp (h->magic, AX25_CAPTURE_MAGIC, sizeof (h->magic)) == 0) &&
+           (h->hdr_size >= sizeof (xCaptureFileHdr)) && (h->hdr_size <= r->size)) {
+
+        r->pos = ALIGN8 (h->hdr_size);
+        r->segment = h->segment;
+        return r;
+      }
+    }
+  }
+
+  vCaptureReaderDelete (r);
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+void
+vCaptureReaderDelete (xCaptureReader *r) {
+
+  if (r) {
+
+    if (r->map) {
+
+      munmap ( (void *) r->map, r->size);
+    }
+    close (r->fd);
+    free (r);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iCaptureRead (xCaptureReader *r, xCaptureRecord *rec) {
+  const xCaptureRecordHdr *h;
+  uint32_t len;
+
+  if ( (!r) || (!rec)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (r->pos + sizeof (xCaptureRecordHdr) > r->size) {
+
+    return 0;
+  }
+
+  h = (const xCaptureRecordHdr *) (r->map + r->pos);
+  len = __atomic_load_n (&h->len, __ATOMIC_ACQUIRE);
+  if (len == 0) {
+
+    return 0;
+  }
+  if (r->pos + sizeof (xCaptureRecordHdr) + len > r->size) {
+
+    return AX25_INVALID_FRAME;
+  }
+
+  rec->mono = h->mono;
+  rec->wall = h->wall;
+  rec->port = h->port;
+  rec->len = len;
+  rec->frame = (const uint8_t *) (h + 1);
+  r->pos += ALIGN8 (sizeof (xCaptureRecordHdr) + len);
+  return 1;
+}
+
+/* ========================================================================== */
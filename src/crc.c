@@ -70,8 +70,201 @@ const uint16_t usCrcCcittTab[256] = {
   0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
 };
 
+/* private variables ======================================================== */
+/*
+ * GF(2) matrices of the CRC-CCITT register transformation for 2^k zero bytes.
+ * Column j of the matrix k is the register obtained by feeding 2^k zero bytes
+ * to a register equal to (1 << j).
+ */
+static const uint16_t usCrcCcittShiftTab[32][16] = {
+  { /* 2^0 */
+    0x1189, 0x2312, 0x4624, 0x8c48, 0x1081, 0x2102, 0x4204, 0x8408,
+    0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080
+  },
+  { /* 2^1 */
+    0x19d8, 0x33b0, 0x6760, 0xcec0, 0x9591, 0x2333, 0x4666, 0x8ccc,
+    0x1189, 0x2312, 0x4624, 0x8c48, 0x1081, 0x2102, 0x4204, 0x8408
+  },
+  { /* 2^2 */
+    0x1cbb, 0x3976, 0x72ec, 0xe5d8, 0xc3a1, 0x8f53, 0x16b7, 0x2d6e,
+    0x5adc, 0xb5b8, 0x6361, 0xc6c2, 0x8595, 0x033b, 0x0676, 0x0cec
+  },
+  { /* 2^3 */
+    0x81bf, 0x0b6f, 0x16de, 0x2dbc, 0x5b78, 0xb6f0, 0x65f1, 0xcbe2,
+    0x9fd5, 0x37bb, 0x6f76, 0xdeec, 0xb5c9, 0x6383, 0xc706, 0x861d
+  },
+  { /* 2^4 */
+    0x8e10, 0x1431, 0x2862, 0x50c4, 0xa188, 0x4b01, 0x9602, 0x2415,
+    0x482a, 0x9054, 0x28b9, 0x5172, 0xa2e4, 0x4dd9, 0x9bb2, 0x3f75
+  },
+  { /* 2^5 */
+    0x7762, 0xeec4, 0xd599, 0xa323, 0x4e57, 0x9cae, 0x314d, 0x629a,
+    0xc534, 0x8279, 0x0ce3, 0x19c6, 0x338c, 0x6718, 0xce30, 0x9471
+  },
+  { /* 2^6 */
+    0x922d, 0x2c4b, 0x5896, 0xb12c, 0x6a49, 0xd492, 0xa135, 0x4a7b,
+    0x94f6, 0x21fd, 0x43fa, 0x87f4, 0x07f9, 0x0ff2, 0x1fe4, 0x3fc8
+  },
+  { /* 2^7 */
+    0xb6c9, 0x6583, 0xcb06, 0x9e1d, 0x342b, 0x6856, 0xd0ac, 0xa949,
+    0x5a83, 0xb506, 0x621d, 0xc43a, 0x8065, 0x08db, 0x11b6, 0x236c
+  },
+  { /* 2^8 */
+    0x2df8, 0x5bf0, 0xb7e0, 0x67d1, 0xcfa2, 0x9755, 0x26bb, 0x4d76,
+    0x9aec, 0x3dc9, 0x7b92, 0xf724, 0xe659, 0xc4a3, 0x8157, 0x0abf
+  },
+  { /* 2^9 */
+    0x8612, 0x0435, 0x086a, 0x10d4, 0x21a8, 0x4350, 0x86a0, 0x0551,
+    0x0aa2, 0x1544, 0x2a88, 0x5510, 0xaa20, 0x5c51, 0xb8a2, 0x7955
+  },
+  { /* 2^10 */
+    0x6304, 0xc608, 0x8401, 0x0013, 0x0026, 0x004c, 0x0098, 0x0130,
+    0x0260, 0x04c0, 0x0980, 0x1300, 0x2600, 0x4c00, 0x9800, 0x3811
+  },
+  { /* 2^11 */
+    0x56a1, 0xad42, 0x5295, 0xa52a, 0x4245, 0x848a, 0x0105, 0x020a,
+    0x0414, 0x0828, 0x1050, 0x20a0, 0x4140, 0x8280, 0x0d11, 0x1a22
+  },
+  { /* 2^12 */
+    0x8408, 0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040,
+    0x0080, 0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000
+  },
+  { /* 2^13 */
+    0x4204, 0x8408, 0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020,
+    0x0040, 0x0080, 0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000
+  },
+  { /* 2^14 */
+    0x1081, 0x2102, 0x4204, 0x8408, 0x0001, 0x0002, 0x0004, 0x0008,
+    0x0010, 0x0020, 0x0040, 0x0080, 0x0100, 0x0200, 0x0400, 0x0800
+  },
+  { /* 2^15 */
+    0x1189, 0x2312, 0x4624, 0x8c48, 0x1081, 0x2102, 0x4204, 0x8408,
+    0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080
+  },
+  { /* 2^16 */
+    0x19d8, 0x33b0, 0x6760, 0xcec0, 0x9591, 0x2333, 0x4666, 0x8ccc,
+    0x1189, 0x2312, 0x4624, 0x8c48, 0x1081, 0x2102, 0x4204, 0x8408
+  },
+  { /* 2^17 */
+    0x1cbb, 0x3976, 0x72ec, 0xe5d8, 0xc3a1, 0x8f53, 0x16b7, 0x2d6e,
+    0x5adc, 0xb5b8, 0x6361, 0xc6c2, 0x8595, 0x033b, 0x0676, 0x0cec
+  },
+  { /* 2^18 */
+    0x81bf, 0x0b6f, 0x16de, 0x2dbc, 0x5b78, 0xb6f0, 0x65f1, 0xcbe2,
+    0x9fd5, 0x37bb, 0x6f76, 0xdeec, 0xb5c9, 0x6383, 0xc706, 0x861d
+  },
+  { /* 2^19 */
+    0x8e10, 0x1431, 0x2862, 0x50c4, 0xa188, 0x4b01, 0x9602, 0x2415,
+    0x482a, 0x9054, 0x28b9, 0x5172, 0xa2e4, 0x4dd9, 0x9bb2, 0x3f75
+  },
+  { /* 2^20 */
+    0x7762, 0xeec4, 0xd599, 0xa323, 0x4e57, 0x9cae, 0x314d, 0x629a,
+    0xc534, 0x8279, 0x0ce3, 0x19c6, 0x338c, 0x6718, 0xce30, 0x9471
+  },
+  { /* 2^21 */
+    0x922d, 0x2c4b, 0x5896, 0xb12c, 0x6a49, 0xd492, 0xa135, 0x4a7b,
+    0x94f6, 0x21fd, 0x43fa, 0x87f4, 0x07f9, 0x0ff2, 0x1fe4, 0x3fc8
+  },
+  { /* 2^22 */
+    0xb6c9, 0x6583, 0xcb06, 0x9e1d, 0x342b, 0x6856, 0xd0ac, 0xa949,
+    0x5a83, 0xb506, 0x621d, 0xc43a, 0x8065, 0x08db, 0x11b6, 0x236c
+  },
+  { /* 2^23 */
+    0x2df8, 0x5bf0, 0xb7e0, 0x67d1, 0xcfa2, 0x9755, 0x26bb, 0x4d76,
+    0x9aec, 0x3dc9, 0x7b92, 0xf724, 0xe659, 0xc4a3, 0x8157, 0x0abf
+  },
+  { /* 2^24 */
+    0x8612, 0x0435, 0x086a, 0x10d4, 0x21a8, 0x4350, 0x86a0, 0x0551,
+    0x0aa2, 0x1544, 0x2a88, 0x5510, 0xaa20, 0x5c51, 0xb8a2, 0x7955
+  },
+  { /* 2^25 */
+    0x6304, 0xc608, 0x8401, 0x0013, 0x0026, 0x004c, 0x0098, 0x0130,
+    0x0260, 0x04c0, 0x0980, 0x1300, 0x2600, 0x4c00, 0x9800, 0x3811
+  },
+  { /* 2^26 */
+    0x56a1, 0xad42, 0x5295, 0xa52a, 0x4245, 0x848a, 0x0105, 0x020a,
+    0x0414, 0x0828, 0x1050, 0x20a0, 0x4140, 0x8280, 0x0d11, 0x1a22
+  },
+  { /* 2^27 */
+    0x8408, 0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040,
+    0x0080, 0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000
+  },
+  { /* 2^28 */
+    0x4204, 0x8408, 0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020,
+    0x0040, 0x0080, 0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000
+  },
+  { /* 2^29 */
+    0x1081, 0x2102, 0x4204, 0x8408, 0x0001, 0x0002, 0x0004, 0x0008,
+    0x0010, 0x0020, 0x0040, 0x0080, 0x0100, 0x0200, 0x0400, 0x0800
+  },
+  { /* 2^30 */
+    0x1189, 0x2312, 0x4624, 0x8c48, 0x1081, 0x2102, 0x4204, 0x8408,
+    0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080
+  },
+  { /* 2^31 */
+    0x19d8, 0x33b0, 0x6760, 0xcec0, 0x9591, 0x2333, 0x4666, 0x8ccc,
+    0x1189, 0x2312, 0x4624, 0x8c48, 0x1081, 0x2102, 0x4204, 0x8408
+  }
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// Multiplication of a 16x16 GF(2) matrix by a vector
+static uint16_t
+prvusMatrixMul (const uint16_t *m, uint16_t v) {
+  uint16_t r = 0;
+
+  while (v) {
+
+    if (v & 1) {
+
+      r ^= *m;
+    }
+    v >>= 1;
+    m++;
+  }
+  return r;
+}
+
 /* internal public functions ================================================ */
 
+// -----------------------------------------------------------------------------
+uint16_t
+usCrcCcittShift (uint16_t usCrc, size_t uLen) {
+
+  for (int k = 0; (k < 32) && uLen && usCrc; k++, uLen >>= 1) {
+
+    if (uLen & 1) {
+
+      usCrc = prvusMatrixMul (usCrcCcittShiftTab[k], usCrc);
+    }
+  }
+  return usCrc;
+}
+
+// -----------------------------------------------------------------------------
+uint16_t
+usCrcCcittCombine (uint16_t usCrc1, uint16_t usCrc2, size_t uLen2) {
+
+  return usCrc2 ^ usCrcCcittShift (usCrc1 ^ CRC_CCITT_INIT_VAL, uLen2);
+}
+
+// -----------------------------------------------------------------------------
+uint16_t
+usCrcCcittPatch (uint16_t usCrc, size_t uLen, size_t uOffset,
+                 const void *pvOld, const void *pvNew, size_t uCount) {
+  const uint8_t *o = (const uint8_t *) pvOld;
+  const uint8_t *n = (const uint8_t *) pvNew;
+  uint16_t usDelta = 0;
+
+  for (size_t i = 0; i < uCount; i++) {
+
+    usDelta = usCrcCcittUpdate (o[i] ^ n[i], usDelta);
+  }
+  return usCrc ^ usCrcCcittShift (usDelta, uLen - uOffset - uCount);
+}
+
 // -----------------------------------------------------------------------------
 uint16_t 
 usCrcCcitt (uint16_t usCrc, const void *pvBuf, size_t uLen) {
@@ -0,0 +1,400 @@
+/**
+ * @file src/digi.c
+ * @brief Digipeater AX.25 (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <radio/digi.h>
+#include <radio/crc.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+#define ADDR_LEN (AX25_CALL_LEN + 1)
+#define MAX_ADDR (AX25_MAX_RPT + 2)
+#define MIN_FRAME_LEN 17
+
+// SSID byte bits
+#define SSID_H     0x80
+#define SSID_MASK  0x1E
+#define SSID_LAST  0x01
+
+// Actions on the first unused repeater
+#define ACT_NONE   0
+#define ACT_MYCALL 1
+#define ACT_ALIAS  2
+#define ACT_WIDE   3
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+static bool
+prvbSameAddr (const uint8_t *a, const uint8_t *b) {
+
+  return (memcmp (a, b, AX25_CALL_LEN) == 0) &&
+         ( ( (a[AX25_CALL_LEN] ^ b[AX25_CALL_LEN]) & SSID_MASK) == 0);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviEncode (uint8_t *addr, const char *callsign, uint8_t ssid) {
+  xAx25Node n;
+
+  iAx25NodeClear (&n);
+  iAx25NodeSetCallsign (&n, callsign);
+  iAx25NodeSetSsid (&n, ssid);
+  return iAx25NodeEncode (&n, addr);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the WIDEn-N entry matching addr, NULL if none, n is stored in hops
+static const xAx25DigiWide *
+prvxMatchWide (const xAx25Digi *d, const uint8_t *addr, uint8_t *hops) {
+
+  for (int i = 0; i < d->wide_len; i++) {
+    const xAx25DigiWide *w = &d->wide[i];
+    uint8_t c;
+
+    if (memcmp (addr, w->call, w->len) != 0) {
+      continue;
+    }
+    c = addr[w->len] >> 1;
+    if ( (c < '1') || (c > '7')) {
+      continue;
+    }
+    for (int j = w->len + 1; j < AX25_CALL_LEN; j++) {
+
+      if (addr[j] != (' ' << 1)) {
+        c = 0;
+        break;
+      }
+    }
+    if (c) {
+
+      *hops = c - '0';
+      return w;
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static long
+prvlNow (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+// -----------------------------------------------------------------------------
+// Hash of the frame without its path: dst, src and everything after the
+// address field (FCS excluded)
+static uint16_t
+prvusHash (const uint8_t *frame, size_t len, unsigned naddr) {
+  uint16_t crc = CRC_CCITT_INIT_VAL;
+
+  crc = usCrcCcitt (crc, frame, AX25_CALL_LEN);
+  crc = usCrcCcittUpdate (frame[AX25_CALL_LEN] & SSID_MASK, crc);
+  crc = usCrcCcitt (crc, frame + ADDR_LEN, AX25_CALL_LEN);
+  crc = usCrcCcittUpdate (frame[ADDR_LEN + AX25_CALL_LEN] & SSID_MASK, crc);
+  return usCrcCcitt (crc, frame + naddr * ADDR_LEN, len - 2 - naddr * ADDR_LEN);
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbIsDupe (xAx25Digi *d, uint16_t hash, long now) {
+
+  for (int i = 0; i < AX25_DIGI_DUPE_LEN; i++) {
+
+    if ( (d->dupe[i].hash == hash) && (d->dupe[i].time != 0) &&
+         ( (now - d->dupe[i].time) < (long) d->dupe_time)) {
+
+      return true;
+    }
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the FCS after the old_len bytes at pos have been replaced by the
+// new_len bytes now at pos, tail being the number of unchanged bytes between
+// the modified bytes and the FCS.
+static void
+prvvPatchFcs (uint8_t *frame, size_t pos, const uint8_t *old, size_t old_len,
+              size_t new_len, size_t tail) {
+  uint8_t *fcs = frame + pos + new_len + tail;
+  uint16_t crc = fcs[0] | (fcs[1] << 8);
+
+  if (old_len == new_len) {
+
+    crc = usCrcCcittPatch (crc, pos + new_len + tail, pos, old, frame + pos, new_len);
+  }
+  else {
+    uint16_t s;
+
+    // The CRC registers of the old and new frames only differ by the CRC of
+    // the modified bytes, this difference is then shifted through the tail.
+    s = usCrcCcitt (CRC_CCITT_INIT_VAL, frame, pos);
+    s = usCrcCcitt (s, old, old_len) ^ usCrcCcitt (s, frame + pos, new_len);
+    crc ^= usCrcCcittShift (s, tail);
+  }
+  fcs[0] = crc & 0xff;
+  fcs[1] = crc >> 8;
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xAx25Digi *
+xAx25DigiNew (const char *callsign, uint8_t ssid) {
+  xAx25Digi *d;
+
+  d = calloc (1, sizeof (xAx25Digi));
+  if (d) {
+
+    if (prviEncode (d->mycall, callsign, ssid) != AX25_SUCCESS) {
+
+      free (d);
+      return NULL;
+    }
+    d->dupe_time = AX25_DIGI_DUPE_TIME;
+  }
+  return d;
+}
+
+// -----------------------------------------------------------------------------
+void
+vAx25DigiDelete (xAx25Digi *d) {
+
+  free (d);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DigiAddAlias (xAx25Digi *d, const char *callsign, uint8_t ssid) {
+
+  if (!d) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (d->alias_len >= AX25_DIGI_MAX_ALIAS) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  if (prviEncode (d->alias[d->alias_len], callsign, ssid) != AX25_SUCCESS) {
+
+    return AX25_ILLEGAL_CALLSIGN;
+  }
+  d->alias_len++;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DigiAddWide (xAx25Digi *d, const char *prefix, uint8_t max_hops, bool trace) {
+  uint8_t addr[ADDR_LEN];
+  xAx25DigiWide *w;
+  size_t len;
+
+  if (!d) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (d->wide_len >= AX25_DIGI_MAX_WIDE) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  // One character is needed for n
+  len = strlen (prefix);
+  if ( (len == 0) || (len >= AX25_CALL_LEN) || (prviEncode (addr, prefix, 0) != AX25_SUCCESS)) {
+
+    return AX25_ILLEGAL_CALLSIGN;
+  }
+
+  w = &d->wide[d->wide_len++];
+  memcpy (w->call, addr, len);
+  w->len = len;
+  w->max_hops = MIN (max_hops, 7);
+  w->trace = trace;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DigiSetDupeTime (xAx25Digi *d, unsigned seconds) {
+
+  if (!d) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  d->dupe_time = seconds;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DigiProcess (xAx25Digi *d, uint8_t *frame, size_t *len, size_t size) {
+  const xAx25DigiWide *w = NULL;
+  uint8_t old[ADDR_LEN];
+  uint8_t *addr = NULL;
+  uint8_t hops = 0, ssid;
+  unsigned naddr = 0, rpt;
+  int action = ACT_NONE;
+  size_t n;
+
+  if ( (!d) || (!frame) || (!len)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  n = *len;
+  if (n < MIN_FRAME_LEN) {
+
+    return 0;
+  }
+
+  // Walks the address field
+  while (naddr < MAX_ADDR) {
+    size_t pos = naddr * ADDR_LEN + AX25_CALL_LEN;
+
+    if (pos >= n - 2) {
+
+      return 0;
+    }
+    naddr++;
+    if (frame[pos] & SSID_LAST) {
+      break;
+    }
+  }
+  if (! (frame[naddr * ADDR_LEN - 1] & SSID_LAST)) {
+
+    return 0;
+  }
+
+  // First repeater which has not been used
+  for (rpt = 2; rpt < naddr; rpt++) {
+
+    if (! (frame[rpt * ADDR_LEN + AX25_CALL_LEN] & SSID_H)) {
+
+      addr = frame + rpt * ADDR_LEN;
+      break;
+    }
+  }
+  if (!addr) {
+
+    return 0;
+  }
+
+  ssid = (addr[AX25_CALL_LEN] & SSID_MASK) >> 1;
+  if (prvbSameAddr (addr, d->mycall)) {
+
+    action = ACT_MYCALL;
+  }
+  else {
+
+    for (int i = 0; i < d->alias_len; i++) {
+
+      if (prvbSameAddr (addr, d->alias[i])) {
+
+        action = ACT_ALIAS;
+        break;
+      }
+    }
+    if (action == ACT_NONE) {
+
+      w = prvxMatchWide (d, addr, &hops);
+      // WIDEn-N with N greater than n or n too large are not repeated
+      if (w && (ssid > 0) && (ssid <= hops) && (hops <= w->max_hops)) {
+
+        action = ACT_WIDE;
+      }
+    }
+  }
+  if (action == ACT_NONE) {
+
+    return 0;
+  }
+
+  if (d->dupe_time) {
+    uint16_t hash = prvusHash (frame, n, naddr);
+    long now = prvlNow();
+
+    if (prvbIsDupe (d, hash, now)) {
+
+      d->duplicated++;
+      return 0;
+    }
+    d->dupe[d->dupe_idx].hash = hash;
+    d->dupe[d->dupe_idx].time = now;
+    d->dupe_idx = (d->dupe_idx + 1) % AX25_DIGI_DUPE_LEN;
+  }
+
+  memcpy (old, addr, ADDR_LEN);
+  if (action == ACT_WIDE) {
+
+    ssid--;
+    addr[AX25_CALL_LEN] = (addr[AX25_CALL_LEN] & ~SSID_MASK) | (ssid << 1);
+    if (ssid == 0) {
+
+      addr[AX25_CALL_LEN] |= SSID_H;
+    }
+
+    if (w->trace && (naddr < MAX_ADDR) && (n + ADDR_LEN <= size)) {
+
+      // MYCALL* is inserted in front of the WIDEn-N entry
+      memmove (addr + ADDR_LEN, addr, frame + n - addr);
+      memcpy (addr, d->mycall, ADDR_LEN);
+      addr[AX25_CALL_LEN] = (addr[AX25_CALL_LEN] | SSID_H) & ~SSID_LAST;
+      *len = n + ADDR_LEN;
+      prvvPatchFcs (frame, addr - frame, old, ADDR_LEN, 2 * ADDR_LEN,
+                    n - 2 - (addr - frame) - ADDR_LEN);
+      d->repeated++;
+      return 1;
+    }
+  }
+  else {
+
+    // Alias substitution keeps the address extension bit
+    memcpy (addr, d->mycall, AX25_CALL_LEN);
+    addr[AX25_CALL_LEN] = (d->mycall[AX25_CALL_LEN] & ~SSID_LAST) |
+                          (old[AX25_CALL_LEN] & SSID_LAST) | SSID_H;
+  }
+  prvvPatchFcs (frame, addr - frame, old, ADDR_LEN, ADDR_LEN,
+                n - 2 - (addr - frame) - ADDR_LEN);
+  d->repeated++;
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25DigiPoll (xAx25Digi *d, xAx25 *rx, xAx25 *tx) {
+  int ret;
+
+  if ( (!d) || (!rx)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (!bAx25Poll (rx)) {
+
+    return 0;
+  }
+
+  ret = iAx25DigiProcess (d, rx->dec.buf, &rx->dec.len, AX25_FRAME_BUF_LEN);
+  if (ret > 0) {
+    int iError = iAx25SendRaw (tx ? tx : rx, rx->dec.buf, rx->dec.len);
+
+    if (iError) {
+
+      ret = iError;
+    }
+  }
+  iAx25Discard (rx);
+  return ret;
+}
+
+/* ========================================================================== */
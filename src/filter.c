@@ -0,0 +1,527 @@
+/**
+ * @file src/filter.c
+ * @brief Filtre de trames AX.25 compilé (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#define _GNU_SOURCE
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <radio/filter.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+// Instruction codes
+#define OP_DST  1
+#define OP_SRC  2
+#define OP_VIA  3
+#define OP_TYPE 4
+#define OP_INFO 5
+
+// H-bit requirement of OP_VIA
+#define H_CLEAR 0
+#define H_SET   1
+#define H_ANY   2
+
+// Syntax tree nodes
+#define NODE_TERM 0
+#define NODE_NOT  1
+#define NODE_AND  2
+#define NODE_OR   3
+#define MAX_NODES (AX25_FILTER_MAX_TERMS * 4)
+
+// Maximum number of addresses in a frame (dst, src and repeaters)
+#define MAX_ADDR (AX25_MAX_RPT + 2)
+
+/* private ================================================================== */
+typedef struct xNode {
+  uint8_t kind;
+  uint8_t left;   // child of NOT, left operand of AND/OR, term index for TERM
+  uint8_t right;
+} xNode;
+
+typedef struct xParser {
+  const char *expr; // start of the expression, for error messages
+  const char *s;    // current position
+  xNode node[MAX_NODES];
+  int nodes;
+  xAx25FilterInsn term[AX25_FILTER_MAX_TERMS];
+  int terms;
+  bool error;
+} xParser;
+
+static int prviParseOr (xParser *p);
+
+// -----------------------------------------------------------------------------
+static int
+prviSyntaxError (xParser *p, const char *msg) {
+
+  if (!p->error) {
+
+    PERROR ("Filter error at column %d: %s\n", (int) (p->s - p->expr) + 1, msg);
+    p->error = true;
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvSkipSpaces (xParser *p) {
+
+  while (isspace ( (unsigned char) *p->s)) {
+    p->s++;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the next token is the keyword kw (word or symbol)
+static bool
+prvbAccept (xParser *p, const char *sym, const char *kw) {
+  size_t len;
+
+  prvvSkipSpaces (p);
+  if (*p->s == *sym) {
+
+    p->s++;
+    return true;
+  }
+  len = strlen (kw);
+  if ( (strncasecmp (p->s, kw, len) == 0) && !isalnum ( (unsigned char) p->s[len])) {
+
+    p->s += len;
+    return true;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviNewNode (xParser *p, uint8_t kind, int left, int right) {
+
+  if ( (left < 0) || (right < 0)) {
+
+    return -1;
+  }
+  if (p->nodes >= MAX_NODES) {
+
+    return prviSyntaxError (p, "expression too complex");
+  }
+  p->node[p->nodes].kind = kind;
+  p->node[p->nodes].left = left;
+  p->node[p->nodes].right = right;
+  return p->nodes++;
+}
+
+// -----------------------------------------------------------------------------
+// Reads a term value, quoted or not, returns its length
+static int
+prviParseValue (xParser *p, char *value) {
+  int len = 0;
+
+  if (*p->s == '"') {
+
+    p->s++;
+    while (*p->s && (*p->s != '"')) {
+
+      if (len >= AX25_FILTER_STR_LEN) {
+
+        return prviSyntaxError (p, "value too long");
+      }
+      value[len++] = *p->s++;
+    }
+    if (*p->s != '"') {
+
+      return prviSyntaxError (p, "missing closing quote");
+    }
+    p->s++;
+  }
+  else {
+
+    while (*p->s && !isspace ( (unsigned char) *p->s) && !strchr (")&|", *p->s)) {
+
+      if (len >= AX25_FILTER_STR_LEN) {
+
+        return prviSyntaxError (p, "value too long");
+      }
+      value[len++] = *p->s++;
+    }
+  }
+  value[len] = 0;
+  if (len == 0) {
+
+    return prviSyntaxError (p, "empty value");
+  }
+  return len;
+}
+
+// -----------------------------------------------------------------------------
+// CALL, CALL-SSID, CALL-*, PREFIX*, *
+static int
+prviParseCall (xParser *p, xAx25FilterInsn *t, const char *value) {
+  const char *dash = strchr (value, '-');
+  size_t len = dash ? (size_t) (dash - value) : strlen (value);
+  bool prefix = false;
+
+  if ( (len > 0) && (value[len - 1] == '*')) {
+
+    prefix = true;
+    len--;
+  }
+  if (len > AX25_CALL_LEN) {
+
+    return prviSyntaxError (p, "callsign too long");
+  }
+  for (size_t i = 0; i < AX25_CALL_LEN; i++) {
+    uint8_t c = ' ';
+
+    if (i < len) {
+
+      c = toupper ( (unsigned char) value[i]);
+      if (!isalnum (c)) {
+
+        return prviSyntaxError (p, "illegal callsign");
+      }
+    }
+    t->call[i] = c << 1;
+  }
+  t->call_len = prefix ? len : AX25_CALL_LEN;
+  t->ssid = prefix ? -1 : 0;
+
+  if (dash) {
+    char *end;
+    long ssid;
+
+    if (strcmp (dash + 1, "*") == 0) {
+
+      t->ssid = -1;
+    }
+    else {
+
+      ssid = strtol (dash + 1, &end, 10);
+      if ( (end == dash + 1) || *end || (ssid < 0) || (ssid > 15)) {
+
+        return prviSyntaxError (p, "illegal ssid");
+      }
+      t->ssid = ssid;
+    }
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviParseTerm (xParser *p) {
+  static const struct {
+    const char *key;
+    uint8_t op;
+    uint8_t h;
+  } keys[] = {
+    { "dst", OP_DST, H_ANY },
+    { "src", OP_SRC, H_ANY },
+    { "via", OP_VIA, H_ANY },
+    { "used", OP_VIA, H_SET },
+    { "unused", OP_VIA, H_CLEAR },
+    { "type", OP_TYPE, H_ANY },
+    { "info", OP_INFO, H_ANY }
+  };
+  char value[AX25_FILTER_STR_LEN + 1];
+  xAx25FilterInsn *t;
+  int len;
+
+  if (p->terms >= AX25_FILTER_MAX_TERMS) {
+
+    return prviSyntaxError (p, "too many terms");
+  }
+  t = &p->term[p->terms];
+  memset (t, 0, sizeof (xAx25FilterInsn));
+
+  for (int i = 0; i < COUNTOF (keys); i++) {
+    size_t klen = strlen (keys[i].key);
+
+    if ( (strncasecmp (p->s, keys[i].key, klen) == 0) && (p->s[klen] == ':')) {
+
+      t->op = keys[i].op;
+      t->h = keys[i].h;
+      p->s += klen + 1;
+      break;
+    }
+  }
+  if (t->op == 0) {
+
+    return prviSyntaxError (p, "unknown term");
+  }
+
+  if ( (len = prviParseValue (p, value)) < 0) {
+
+    return -1;
+  }
+
+  if ( (t->op == OP_TYPE) || (t->op == OP_INFO)) {
+
+    memcpy (t->str, value, len + 1);
+    t->str_len = len;
+  }
+  else if (prviParseCall (p, t, value) < 0) {
+
+    return -1;
+  }
+
+  return prviNewNode (p, NODE_TERM, p->terms++, 0);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviParseUnary (xParser *p) {
+  int n;
+
+  if (prvbAccept (p, "!", "not")) {
+
+    return prviNewNode (p, NODE_NOT, prviParseUnary (p), 0);
+  }
+  if (prvbAccept (p, "(", "(")) {
+
+    n = prviParseOr (p);
+    if ( (n >= 0) && !prvbAccept (p, ")", ")")) {
+
+      return prviSyntaxError (p, "missing closing parenthesis");
+    }
+    return n;
+  }
+  if (*p->s == 0) {
+
+    return prviSyntaxError (p, "unexpected end of expression");
+  }
+  return prviParseTerm (p);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviParseAnd (xParser *p) {
+  int n = prviParseUnary (p);
+
+  while (n >= 0) {
+
+    if (!prvbAccept (p, "&", "and")) {
+
+      // Juxtaposition is an implicit and
+      prvvSkipSpaces (p);
+      if ( (*p->s == 0) || (*p->s == ')') || (*p->s == '|') ||
+           ( (strncasecmp (p->s, "or", 2) == 0) && !isalnum ( (unsigned char) p->s[2]))) {
+
+        return n;
+      }
+    }
+    n = prviNewNode (p, NODE_AND, n, prviParseUnary (p));
+  }
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviParseOr (xParser *p) {
+  int n = prviParseAnd (p);
+
+  while ( (n >= 0) && prvbAccept (p, "|", "or")) {
+
+    n = prviNewNode (p, NODE_OR, n, prviParseAnd (p));
+  }
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+// Emits the code of the node n so that it branches on t if true, on f if
+// false, the right operand is emitted first so that the entry of the left
+// operand knows where to jump. Returns the entry point of the node.
+static uint8_t
+prvucEmit (const xParser *p, xAx25Filter *f, int n, uint8_t t, uint8_t fl) {
+  const xNode *node = &p->node[n];
+  uint8_t r;
+
+  switch (node->kind) {
+
+    case NODE_NOT:
+      return prvucEmit (p, f, node->left, fl, t);
+
+    case NODE_AND:
+      r = prvucEmit (p, f, node->right, t, fl);
+      return prvucEmit (p, f, node->left, r, fl);
+
+    case NODE_OR:
+      r = prvucEmit (p, f, node->right, t, fl);
+      return prvucEmit (p, f, node->left, t, r);
+
+    default:
+      r = f->len++;
+      f->insn[r] = p->term[node->left];
+      f->insn[r].jt = t;
+      f->insn[r].jf = fl;
+      if (f->insn[r].op >= OP_VIA) {
+
+        f->need_path = true;
+      }
+      return r;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbMatchCall (const xAx25FilterInsn *t, const uint8_t *addr) {
+
+  if (memcmp (addr, t->call, t->call_len) != 0) {
+
+    return false;
+  }
+  return (t->ssid < 0) || ( ( (addr[AX25_CALL_LEN] >> 1) & 0x0F) == t->ssid);
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xAx25Filter *
+xAx25FilterNew (const char * expr) {
+  xAx25Filter *f;
+
+  f = malloc (sizeof (xAx25Filter));
+  if (f) {
+
+    if (iAx25FilterCompile (f, expr) != AX25_SUCCESS) {
+
+      free (f);
+      f = NULL;
+    }
+  }
+  return f;
+}
+
+// -----------------------------------------------------------------------------
+void
+vAx25FilterDelete (xAx25Filter *f) {
+
+  free (f);
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25FilterCompile (xAx25Filter *f, const char * expr) {
+  xParser *p;
+  int root;
+
+  if (!f) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  f->len = 0;
+  f->entry = AX25_FILTER_ACCEPT;
+  f->need_path = false;
+
+  if ( (expr == NULL) || (*expr == 0)) {
+
+    return AX25_SUCCESS;
+  }
+
+  p = calloc (1, sizeof (xParser));
+  if (!p) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  p->expr = p->s = expr;
+
+  root = prviParseOr (p);
+  if ( (root >= 0) && (prvvSkipSpaces (p), *p->s != 0)) {
+
+    root = prviSyntaxError (p, "unexpected character");
+  }
+  if (root >= 0) {
+
+    f->entry = prvucEmit (p, f, root, AX25_FILTER_ACCEPT, AX25_FILTER_REJECT);
+  }
+  free (p);
+
+  return (root >= 0) ? AX25_SUCCESS : AX25_ILLEGAL_FILTER;
+}
+
+// -----------------------------------------------------------------------------
+bool
+bAx25FilterMatch (const xAx25Filter *f, const uint8_t *frame, size_t len) {
+  unsigned naddr = 0;
+  const uint8_t *info = NULL;
+  size_t info_len = 0;
+  uint8_t pc;
+
+  if (!f) {
+
+    return true;
+  }
+  if (len < (AX25_CALL_LEN + 1) * 2) {
+
+    return false;
+  }
+
+  if (f->need_path) {
+
+    // Walks the address extension bits to find repeaters and info field
+    while (naddr < MAX_ADDR) {
+      size_t ssid = naddr * (AX25_CALL_LEN + 1) + AX25_CALL_LEN;
+
+      if (ssid >= len) {
+
+        return false;
+      }
+      naddr++;
+      if (frame[ssid] & 0x01) {
+
+        break;
+      }
+    }
+    info = frame + naddr * (AX25_CALL_LEN + 1) + 2; // skip ctrl and pid
+    if (info > frame + len) {
+
+      return false;
+    }
+    info_len = frame + len - info;
+  }
+
+  pc = f->entry;
+  while (pc < f->len) {
+    const xAx25FilterInsn *t = &f->insn[pc];
+    bool match = false;
+
+    switch (t->op) {
+
+      case OP_DST:
+        match = prvbMatchCall (t, frame);
+        break;
+
+      case OP_SRC:
+        match = prvbMatchCall (t, frame + AX25_CALL_LEN + 1);
+        break;
+
+      case OP_VIA:
+        for (unsigned i = 2; (i < naddr) && !match; i++) {
+          const uint8_t *addr = frame + i * (AX25_CALL_LEN + 1);
+
+          match = prvbMatchCall (t, addr) &&
+                  ( (t->h == H_ANY) || ( (addr[AX25_CALL_LEN] >> 7) == t->h));
+        }
+        break;
+
+      case OP_TYPE:
+        match = (info_len > 0) && (memchr (t->str, info[0], t->str_len) != NULL);
+        break;
+
+      case OP_INFO:
+        match = memmem (info, info_len, t->str, t->str_len) != NULL;
+        break;
+
+      default:
+        break;
+    }
+    pc = match ? t->jt : t->jf;
+  }
+  return pc == AX25_FILTER_ACCEPT;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,1333 @@
+/**
+ * @file src/link.c
+ * @brief Liaison AX.25 en mode connecté (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <radio/link.h>
+#include <radio/crc.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+#define ADDR_LEN (AX25_CALL_LEN + 1)
+
+// SSID byte bits, SSID_C is the C bit of dst and src, the H bit of repeaters
+#define SSID_C     0x80
+#define SSID_MASK  0x1E
+#define SSID_LAST  0x01
+
+// Limits of T1 in ms
+#define T1_MIN 20
+#define T1_MAX 60000
+
+/* private ================================================================== */
+
+// I frame info field, queued or waiting for its acknowledgement
+typedef struct xAx25LinkBuf {
+
+  struct xAx25LinkBuf *next;
+  size_t len;
+  uint8_t data[];
+} xAx25LinkBuf;
+
+// -----------------------------------------------------------------------------
+static long long
+prvllNow (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000L;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+prvbSameAddr (const uint8_t *a, const uint8_t *b) {
+
+  return (memcmp (a, b, AX25_CALL_LEN) == 0) &&
+         ( ( (a[AX25_CALL_LEN] ^ b[AX25_CALL_LEN]) & SSID_MASK) == 0);
+}
+
+// -----------------------------------------------------------------------------
+// Number of steps from the sequence number from to the sequence number to
+static unsigned
+prvuSeq (const xAx25Conn *c, unsigned from, unsigned to) {
+
+  return (to + c->modulo - from) % c->modulo;
+}
+
+// -----------------------------------------------------------------------------
+static unsigned
+prvuNext (const xAx25Conn *c, unsigned seq) {
+
+  return (seq + 1) % c->modulo;
+}
+
+// -----------------------------------------------------------------------------
+// An acknowledged N(R) is between V(A) and V(S)
+static bool
+prvbValidNr (const xAx25Conn *c, unsigned nr) {
+
+  return prvuSeq (c, c->va, nr) <= prvuSeq (c, c->va, c->vs);
+}
+
+// -----------------------------------------------------------------------------
+static long
+prvlClampT1 (long t1) {
+
+  return (t1 < T1_MIN) ? T1_MIN : ( (t1 > T1_MAX) ? T1_MAX : t1);
+}
+
+// -----------------------------------------------------------------------------
+// SRTT = 7/8 SRTT + 1/8 RTT, T1 = 2 SRTT
+static void
+prvvRtt (xAx25Conn *c, long rtt) {
+
+  c->srtt = (7 * c->srtt + rtt) / 8;
+  c->t1v = prvlClampT1 (2 * c->srtt);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvStartT1 (xAx25Conn *c) {
+
+  c->t1 = prvllNow() + c->t1v;
+  c->t3 = 0;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvStartT3 (xAx25Conn *c) {
+
+  c->t1 = 0;
+  c->t3 = prvllNow() + c->link->t3;
+}
+
+// -----------------------------------------------------------------------------
+// Address field of a frame sent to dst by src, command or response
+static size_t
+prvuHeader (uint8_t *buf, const uint8_t *dst, const uint8_t *src,
+            const uint8_t (*path) [ADDR_LEN], unsigned path_len, bool cmd) {
+  uint8_t *p = buf;
+
+  memcpy (p, dst, ADDR_LEN);
+  p[AX25_CALL_LEN] |= cmd ? SSID_C : 0;
+  p += ADDR_LEN;
+  memcpy (p, src, ADDR_LEN);
+  p[AX25_CALL_LEN] |= cmd ? 0 : SSID_C;
+  p += ADDR_LEN;
+  for (unsigned i = 0; i < path_len; i++) {
+
+    memcpy (p, path[i], ADDR_LEN);
+    p += ADDR_LEN;
+  }
+  p[-1] |= SSID_LAST;
+  return p - buf;
+}
+
+// -----------------------------------------------------------------------------
+// Remote address and path to the remote station of a received frame
+static void
+prvvReturnPath (const xAx25View *v, uint8_t *remote,
+                uint8_t (*path) [ADDR_LEN], uint8_t *path_len) {
+
+  memcpy (remote, v->frame + ADDR_LEN, ADDR_LEN);
+  remote[AX25_CALL_LEN] &= ~ (SSID_C | SSID_LAST);
+  *path_len = v->naddr - 2;
+  for (unsigned i = 0; i < *path_len; i++) {
+
+    memcpy (path[i], v->frame + (v->naddr - 1 - i) * ADDR_LEN, ADDR_LEN);
+    path[i][AX25_CALL_LEN] &= ~ (SSID_C | SSID_LAST);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Appends the FCS and sends the frame of len bytes
+static int
+prviSendFrame (xAx25Link *l, uint8_t *buf, size_t len) {
+  uint16_t fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, buf, len) ^ 0xFFFF;
+
+  buf[len++] = fcs & 0xFF;
+  buf[len++] = fcs >> 8;
+  l->frames_sent++;
+  return iAx25SendRaw (l->port, buf, len);
+}
+
+// -----------------------------------------------------------------------------
+// Control field of the I and S frames
+static size_t
+prvuCtrl (const xAx25Conn *c, uint8_t *buf, uint8_t c0, unsigned nr, bool pf) {
+
+  if (c->modulo == 128) {
+
+    buf[0] = c0;
+    buf[1] = (nr << 1) | (pf ? 0x01 : 0);
+    return 2;
+  }
+  buf[0] = c0 | (nr << 5) | (pf ? AX25_CTRL_PF : 0);
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviSendU (xAx25Conn *c, uint8_t ctrl, bool cmd, bool pf) {
+  uint8_t buf[AX25_FRAME_BUF_LEN];
+  size_t n;
+
+  n = prvuHeader (buf, c->remote, c->link->mycall, c->path, c->path_len, cmd);
+  buf[n++] = ctrl | (pf ? AX25_CTRL_PF : 0);
+  return prviSendFrame (c->link, buf, n);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviSendS (xAx25Conn *c, uint8_t type, unsigned nr, bool cmd, bool pf) {
+  uint8_t buf[AX25_FRAME_BUF_LEN];
+  size_t n;
+
+  n = prvuHeader (buf, c->remote, c->link->mycall, c->path, c->path_len, cmd);
+  n += prvuCtrl (c, &buf[n], type, nr, pf);
+  if (type != AX25_CTRL_SREJ) {
+
+    // N(R) acknowledges all the frames received
+    c->ack_pending = false;
+    c->t2 = 0;
+  }
+  return prviSendFrame (c->link, buf, n);
+}
+
+// -----------------------------------------------------------------------------
+// RR or RNR depending on the busy condition
+static int
+prviSendAck (xAx25Conn *c, bool cmd, bool pf) {
+
+  return prviSendS (c, c->own_busy ? AX25_CTRL_RNR : AX25_CTRL_RR, c->vr, cmd, pf);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviSendI (xAx25Conn *c, unsigned ns) {
+  uint8_t buf[AX25_FRAME_BUF_LEN];
+  const xAx25LinkBuf *b = c->tx[ns];
+  size_t n;
+
+  n = prvuHeader (buf, c->remote, c->link->mycall, c->path, c->path_len, true);
+  n += prvuCtrl (c, &buf[n], ns << 1, c->vr, false);
+  buf[n++] = AX25_PID_NOLAYER3;
+  memcpy (&buf[n], b->data, b->len);
+  // The acknowledgement is piggybacked
+  c->ack_pending = false;
+  c->t2 = 0;
+  return prviSendFrame (c->link, buf, n + b->len);
+}
+
+// -----------------------------------------------------------------------------
+// Sends a DM response to a station without connection
+static int
+prviSendDm (xAx25Link *l, const xAx25View *v, bool pf) {
+  uint8_t buf[AX25_FRAME_BUF_LEN];
+  uint8_t remote[ADDR_LEN], path[AX25_MAX_RPT][ADDR_LEN], path_len;
+  size_t n;
+
+  prvvReturnPath (v, remote, path, &path_len);
+  n = prvuHeader (buf, remote, l->mycall, (const uint8_t (*) [ADDR_LEN]) path,
+                  path_len, false);
+  buf[n++] = AX25_CTRL_DM | (pf ? AX25_CTRL_PF : 0);
+  return prviSendFrame (l, buf, n);
+}
+
+// -----------------------------------------------------------------------------
+// Sends the queued frames allowed by the window
+static void
+prvvPush (xAx25Conn *c) {
+
+  while ( (c->state == AX25_LINK_CONNECTED) && (!c->peer_busy) && (c->txq) &&
+          (prvuSeq (c, c->va, c->vs) < c->k)) {
+    xAx25LinkBuf *b = c->txq;
+
+    c->txq = b->next;
+    if (!c->txq) {
+      c->txq_tail = NULL;
+    }
+    b->next = NULL;
+    c->tx[c->vs] = b;
+    (void) prviSendI (c, c->vs);
+    if (!c->rtt_valid) {
+
+      c->rtt_seq = c->vs;
+      c->rtt_time = prvllNow();
+      c->rtt_valid = true;
+    }
+    if (!c->t1) {
+
+      prvvStartT1 (c);
+    }
+    c->vs = prvuNext (c, c->vs);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Sends again the frames from V(A) to V(S)
+static void
+prvvResend (xAx25Conn *c) {
+
+  for (unsigned s = c->va; s != c->vs; s = prvuNext (c, s)) {
+
+    (void) prviSendI (c, s);
+    c->link->frames_resent++;
+  }
+  c->rtt_valid = false;
+  if (c->va != c->vs) {
+
+    prvvStartT1 (c);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Frees the frames acknowledged by N(R)
+static void
+prvvAck (xAx25Conn *c, unsigned nr) {
+  bool acked = (nr != c->va);
+
+  while (c->va != nr) {
+
+    if (c->rtt_valid && (c->va == c->rtt_seq)) {
+
+      prvvRtt (c, prvllNow() - c->rtt_time);
+      c->rtt_valid = false;
+    }
+    free (c->tx[c->va]);
+    c->tx[c->va] = NULL;
+    c->va = prvuNext (c, c->va);
+  }
+
+  // In timer recovery, T1 is used to poll the remote station
+  if (c->state == AX25_LINK_CONNECTED) {
+
+    if (c->va == c->vs) {
+
+      prvvStartT3 (c);
+    }
+    else if (acked) {
+
+      prvvStartT1 (c);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Delayed acknowledgement
+static void
+prvvAckLater (xAx25Conn *c) {
+
+  c->ack_pending = true;
+  if (c->link->t2 <= 0) {
+
+    (void) prviSendAck (c, false, false);
+  }
+  else if (!c->t2) {
+
+    c->t2 = prvllNow() + c->link->t2;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvFreeFrames (xAx25Conn *c) {
+
+  for (unsigned i = 0; i < 128; i++) {
+
+    free (c->tx[i]);
+    free (c->rx[i]);
+    c->tx[i] = c->rx[i] = NULL;
+    c->srej_sent[i] = false;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Initializes the state variables, the queued frames are kept
+static void
+prvvReset (xAx25Conn *c, bool extended) {
+  const xAx25Link *l = c->link;
+
+  prvvFreeFrames (c);
+  c->modulo = extended ? 128 : 8;
+  c->k = extended ? l->k_ext : l->k;
+  c->srej = extended && l->srej;
+  c->vs = c->va = c->vr = 0;
+  c->rc = 0;
+  c->peer_busy = c->rej_sent = c->ack_pending = c->rtt_valid = false;
+  c->t1 = c->t2 = c->t3 = 0;
+}
+
+// -----------------------------------------------------------------------------
+static xAx25Conn *
+prvxFind (xAx25Link *l, const uint8_t *remote) {
+
+  for (xAx25Conn *c = l->conn; c; c = c->next) {
+
+    if (prvbSameAddr (c->remote, remote)) {
+
+      return c;
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static xAx25Conn *
+prvxNew (xAx25Link *l, const uint8_t *remote, const uint8_t (*path) [ADDR_LEN],
+         unsigned path_len, bool extended) {
+  xAx25Conn *c = calloc (1, sizeof (xAx25Conn));
+
+  if (c) {
+
+    c->link = l;
+    memcpy (c->remote, remote, ADDR_LEN);
+    memcpy (c->path, path, path_len * ADDR_LEN);
+    c->path_len = path_len;
+    c->n1 = l->n1;
+    c->n2 = l->n2;
+    c->srtt = l->t1 / 2;
+    c->t1v = prvlClampT1 (l->t1);
+    c->state = AX25_LINK_DISCONNECTED;
+    prvvReset (c, extended);
+    c->next = l->conn;
+    l->conn = c;
+  }
+  return c;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvDelete (xAx25Conn *c) {
+
+  prvvFreeFrames (c);
+  while (c->txq) {
+    xAx25LinkBuf *b = c->txq;
+
+    c->txq = b->next;
+    free (b);
+  }
+  free (c);
+}
+
+// -----------------------------------------------------------------------------
+// The connection is deleted after the event
+static void
+prvvRelease (xAx25Conn *c, int reason) {
+  xAx25Link *l = c->link;
+
+  c->state = AX25_LINK_DISCONNECTED;
+  c->reason = reason;
+  c->t1 = c->t2 = c->t3 = 0;
+  if (l->handler) {
+
+    l->handler (c, AX25_LINK_EV_DISCONNECTED, NULL, 0, l->ctx);
+  }
+  for (xAx25Conn **p = &l->conn; *p; p = & (*p)->next) {
+
+    if (*p == c) {
+
+      *p = c->next;
+      break;
+    }
+  }
+  prvvDelete (c);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvEstablished (xAx25Conn *c) {
+  xAx25Link *l = c->link;
+
+  c->state = AX25_LINK_CONNECTED;
+  c->reason = AX25_SUCCESS;
+  c->rc = 0;
+  prvvStartT3 (c);
+  if (l->handler) {
+
+    l->handler (c, AX25_LINK_EV_CONNECTED, NULL, 0, l->ctx);
+  }
+  prvvPush (c);
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvDeliver (xAx25Conn *c, const uint8_t *data, size_t len) {
+  xAx25Link *l = c->link;
+
+  if (l->handler) {
+
+    l->handler (c, AX25_LINK_EV_DATA, data, len, l->ctx);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Sends an enquiry and enters the timer recovery
+static void
+prvvEnquiry (xAx25Conn *c) {
+
+  c->state = AX25_LINK_TIMER_RECOVERY;
+  c->rtt_valid = false;
+  (void) prviSendAck (c, true, true);
+  prvvStartT1 (c);
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if the connection is released
+static bool
+prvbT1Expiry (xAx25Conn *c) {
+
+  // Exponential backoff
+  c->t1v = prvlClampT1 (c->srtt << MIN (c->rc + 2, 12));
+
+  switch (c->state) {
+
+    case AX25_LINK_AWAITING_CONNECTION:
+      if (++c->rc > c->n2) {
+
+        prvvRelease (c, AX25_CONNECTION_LOST);
+        return true;
+      }
+      (void) prviSendU (c, (c->modulo == 128) ? AX25_CTRL_SABME : AX25_CTRL_SABM, true, true);
+      prvvStartT1 (c);
+      break;
+
+    case AX25_LINK_AWAITING_RELEASE:
+      if (++c->rc > c->n2) {
+
+        prvvRelease (c, AX25_CONNECTION_LOST);
+        return true;
+      }
+      (void) prviSendU (c, AX25_CTRL_DISC, true, true);
+      prvvStartT1 (c);
+      break;
+
+    case AX25_LINK_CONNECTED:
+      c->rc = 1;
+      prvvEnquiry (c);
+      break;
+
+    case AX25_LINK_TIMER_RECOVERY:
+      if (++c->rc > c->n2) {
+
+        (void) prviSendU (c, AX25_CTRL_DM, false, false);
+        prvvRelease (c, AX25_CONNECTION_LOST);
+        return true;
+      }
+      prvvEnquiry (c);
+      break;
+
+    default:
+      break;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviInputU (xAx25Link *l, xAx25Conn *c, const xAx25View *v, uint8_t type,
+            bool cmd, bool pf) {
+
+  switch (type) {
+
+    case AX25_CTRL_SABM:
+    case AX25_CTRL_SABME:
+      if (!cmd) {
+        break;
+      }
+      if (!c) {
+        uint8_t remote[ADDR_LEN], path[AX25_MAX_RPT][ADDR_LEN], path_len;
+
+        if (!l->listen) {
+
+          (void) prviSendDm (l, v, pf);
+          break;
+        }
+        prvvReturnPath (v, remote, path, &path_len);
+        c = prvxNew (l, remote, (const uint8_t (*) [ADDR_LEN]) path, path_len,
+                     type == AX25_CTRL_SABME);
+        if (!c) {
+
+          return AX25_NOT_ENOUGH_MEMORY;
+        }
+        (void) prviSendU (c, AX25_CTRL_UA, false, pf);
+        prvvEstablished (c);
+        break;
+      }
+      if (c->state == AX25_LINK_AWAITING_RELEASE) {
+
+        (void) prviSendU (c, AX25_CTRL_DM, false, pf);
+        break;
+      }
+      // Connection reset, the frames not acknowledged are lost
+      prvvReset (c, type == AX25_CTRL_SABME);
+      (void) prviSendU (c, AX25_CTRL_UA, false, pf);
+      if (c->state == AX25_LINK_AWAITING_CONNECTION) {
+
+        prvvEstablished (c);
+      }
+      else {
+
+        c->state = AX25_LINK_CONNECTED;
+        prvvStartT3 (c);
+        prvvPush (c);
+      }
+      break;
+
+    case AX25_CTRL_DISC:
+      if (!cmd) {
+        break;
+      }
+      if ( (!c) || (c->state == AX25_LINK_AWAITING_CONNECTION)) {
+
+        (void) prviSendDm (l, v, pf);
+        break;
+      }
+      (void) prviSendU (c, AX25_CTRL_UA, false, pf);
+      prvvRelease (c, AX25_SUCCESS);
+      break;
+
+    case AX25_CTRL_UA:
+      if ( (cmd) || (!c)) {
+        break;
+      }
+      if (c->state == AX25_LINK_AWAITING_CONNECTION) {
+
+        if (c->rc == 0) {
+
+          prvvRtt (c, prvllNow() - c->rtt_time);
+        }
+        else {
+
+          c->t1v = prvlClampT1 (2 * c->srtt);
+        }
+        prvvReset (c, c->modulo == 128);
+        prvvEstablished (c);
+      }
+      else if (c->state == AX25_LINK_AWAITING_RELEASE) {
+
+        prvvRelease (c, AX25_SUCCESS);
+      }
+      break;
+
+    case AX25_CTRL_DM:
+      if ( (cmd) || (!c)) {
+        break;
+      }
+      if (c->state == AX25_LINK_AWAITING_CONNECTION) {
+
+        prvvRelease (c, AX25_CONNECTION_REFUSED);
+      }
+      else if (c->state == AX25_LINK_AWAITING_RELEASE) {
+
+        prvvRelease (c, AX25_SUCCESS);
+      }
+      else {
+
+        prvvRelease (c, AX25_CONNECTION_LOST);
+      }
+      break;
+
+    case AX25_CTRL_FRMR:
+      if (c) {
+
+        (void) prviSendU (c, AX25_CTRL_DM, false, false);
+        prvvRelease (c, AX25_CONNECTION_LOST);
+      }
+      break;
+
+    default:
+      PINFO ("U frame [%02X] not handled\n", type);
+      break;
+  }
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviInputS (xAx25Conn *c, uint8_t type, unsigned nr, bool cmd, bool pf) {
+
+  if (!prvbValidNr (c, nr)) {
+
+    PWARNING ("N(R) error: %u not in [%u,%u]\n", nr, c->va, c->vs);
+    return 1;
+  }
+
+  switch (type) {
+
+    case AX25_CTRL_RR:
+    case AX25_CTRL_REJ:
+      c->peer_busy = false;
+      prvvAck (c, nr);
+      break;
+
+    case AX25_CTRL_RNR:
+      c->peer_busy = true;
+      prvvAck (c, nr);
+      if (!c->t1) {
+
+        // The remote station is polled until it is no longer busy
+        prvvStartT1 (c);
+      }
+      break;
+
+    case AX25_CTRL_SREJ:
+      // Does not acknowledge, only the frame N(R) is sent again
+      c->peer_busy = false;
+      if ( (nr != c->vs) && (c->tx[nr])) {
+
+        (void) prviSendI (c, nr);
+        c->link->frames_resent++;
+        if (c->rtt_seq == nr) {
+          c->rtt_valid = false;
+        }
+        if (c->state == AX25_LINK_CONNECTED) {
+          prvvStartT1 (c);
+        }
+      }
+      break;
+
+    default:
+      PINFO ("S frame [%02X] not handled\n", type);
+      return 1;
+  }
+
+  if (cmd && pf) {
+
+    (void) prviSendAck (c, false, true);
+  }
+  if ( (!cmd) && (pf) && (c->state == AX25_LINK_TIMER_RECOVERY)) {
+
+    // Answer to the enquiry
+    c->state = AX25_LINK_CONNECTED;
+    c->rc = 0;
+    c->t1v = prvlClampT1 (2 * c->srtt);
+    c->t1 = 0;
+    if (c->va == c->vs) {
+
+      prvvStartT3 (c);
+    }
+    else if (c->peer_busy) {
+
+      prvvStartT1 (c);
+    }
+    else {
+
+      prvvResend (c);
+    }
+  }
+  else if ( (type == AX25_CTRL_REJ) && (c->state == AX25_LINK_CONNECTED)) {
+
+    prvvResend (c);
+  }
+  prvvPush (c);
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviInputI (xAx25Conn *c, unsigned ns, unsigned nr, bool pf,
+            const uint8_t *data, size_t len) {
+  unsigned gap;
+
+  if (!prvbValidNr (c, nr)) {
+
+    PWARNING ("N(R) error: %u not in [%u,%u]\n", nr, c->va, c->vs);
+    return 1;
+  }
+  prvvAck (c, nr);
+
+  if (c->own_busy) {
+
+    // Dropped, it will be sent again
+    if (pf) {
+
+      (void) prviSendAck (c, false, true);
+    }
+    else {
+
+      prvvAckLater (c);
+    }
+    prvvPush (c);
+    return 1;
+  }
+
+  gap = prvuSeq (c, c->vr, ns);
+  if (gap == 0) {
+
+    c->rej_sent = false;
+    c->srej_sent[ns] = false;
+    c->vr = prvuNext (c, c->vr);
+    prvvDeliver (c, data, len);
+    // Frames received out of sequence
+    while ( (c->rx[c->vr]) && (c->state != AX25_LINK_AWAITING_RELEASE)) {
+      xAx25LinkBuf *b = c->rx[c->vr];
+
+      c->rx[c->vr] = NULL;
+      c->srej_sent[c->vr] = false;
+      c->vr = prvuNext (c, c->vr);
+      prvvDeliver (c, b->data, b->len);
+      free (b);
+    }
+    if (c->state == AX25_LINK_AWAITING_RELEASE) {
+
+      // Released by the handler
+      return 1;
+    }
+    if (pf) {
+
+      (void) prviSendAck (c, false, true);
+    }
+    else {
+
+      prvvAckLater (c);
+    }
+  }
+  else if ( (c->srej) && (gap < c->modulo / 2)) {
+
+    // Kept until the missing frames are received
+    if ( (!c->rx[ns]) && (len <= AX25_INFO_LEN)) {
+      xAx25LinkBuf *b = malloc (sizeof (xAx25LinkBuf) + len);
+
+      if (b) {
+
+        b->next = NULL;
+        b->len = len;
+        memcpy (b->data, data, len);
+        c->rx[ns] = b;
+      }
+    }
+    for (unsigned s = c->vr; s != ns; s = prvuNext (c, s)) {
+
+      if ( (!c->rx[s]) && (!c->srej_sent[s])) {
+
+        (void) prviSendS (c, AX25_CTRL_SREJ, s, false, false);
+        c->srej_sent[s] = true;
+      }
+    }
+    if (pf) {
+
+      (void) prviSendAck (c, false, true);
+    }
+  }
+  else if ( (!c->srej) && (!c->rej_sent) &&
+            ( (c->modulo == 8) || (gap < c->modulo / 2))) {
+
+    c->rej_sent = true;
+    (void) prviSendS (c, AX25_CTRL_REJ, c->vr, false, pf);
+  }
+  else {
+
+    // Frame already received, or reject already sent
+    if (pf) {
+
+      (void) prviSendAck (c, false, true);
+    }
+    else {
+
+      prvvAckLater (c);
+    }
+  }
+  prvvPush (c);
+  return 1;
+}
+
+/* public =================================================================== */
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Link Class                                  #
+//#                                                                            #
+//##############################################################################
+
+// -----------------------------------------------------------------------------
+xAx25Link *
+xAx25LinkNew (xAx25 *port, const char *callsign, uint8_t ssid,
+              vAx25LinkHandler handler, void *ctx) {
+  xAx25Link *l;
+  xAx25Node n;
+
+  l = calloc (1, sizeof (xAx25Link));
+  if (l) {
+
+    iAx25NodeClear (&n);
+    iAx25NodeSetCallsign (&n, callsign);
+    iAx25NodeSetSsid (&n, ssid);
+    if ( (!port) || (iAx25NodeEncode (&n, l->mycall) != AX25_SUCCESS)) {
+
+      free (l);
+      return NULL;
+    }
+    l->mycall[AX25_CALL_LEN] &= ~ (SSID_C | SSID_LAST);
+    l->port = port;
+    l->handler = handler;
+    l->ctx = ctx;
+    l->srej = true;
+    l->k = AX25_LINK_K;
+    l->k_ext = AX25_LINK_K_EXT;
+    l->n1 = AX25_LINK_N1;
+    l->n2 = AX25_LINK_N2;
+    l->t1 = AX25_LINK_T1;
+    l->t2 = AX25_LINK_T2;
+    l->t3 = AX25_LINK_T3;
+  }
+  return l;
+}
+
+// -----------------------------------------------------------------------------
+void
+vAx25LinkDelete (xAx25Link *l) {
+
+  if (l) {
+
+    while (l->conn) {
+      xAx25Conn *c = l->conn;
+
+      l->conn = c->next;
+      prvvDelete (c);
+    }
+    free (l);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkListen (xAx25Link *l, bool listen) {
+
+  if (!l) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  l->listen = listen;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkSetWindow (xAx25Link *l, unsigned k, unsigned k_ext) {
+
+  if (!l) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (k < 1) || (k > 7) || (k_ext < 1) || (k_ext > 127)) {
+
+    return AX25_INVALID_FRAME;
+  }
+  l->k = k;
+  l->k_ext = k_ext;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkSetLimits (xAx25Link *l, size_t n1, unsigned n2) {
+
+  if (!l) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (n1 < 1) || (n1 > AX25_INFO_LEN) || (n2 < 1)) {
+
+    return AX25_INVALID_FRAME;
+  }
+  l->n1 = n1;
+  l->n2 = n2;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkSetTimers (xAx25Link *l, long t1, long t2, long t3) {
+
+  if (!l) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (t1 < T1_MIN) || (t2 < 0) || (t2 >= t1) || (t3 <= 0)) {
+
+    return AX25_INVALID_FRAME;
+  }
+  l->t1 = t1;
+  l->t2 = t2;
+  l->t3 = t3;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkSetSrej (xAx25Link *l, bool srej) {
+
+  if (!l) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  l->srej = srej;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkInput (xAx25Link *l, const xAx25View *v) {
+  uint8_t remote[ADDR_LEN], path[AX25_MAX_RPT][ADDR_LEN], path_len;
+  const uint8_t *f, *ctrl, *info, *end;
+  unsigned nr, ns;
+  xAx25Conn *c;
+  bool cmd, pf;
+
+  if ( (!l) || (!v) || (!v->frame)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  f = v->frame;
+  if (!prvbSameAddr (f, l->mycall)) {
+
+    return 0;
+  }
+  // A frame sent through repeaters is processed once repeated by the last one
+  if ( (v->naddr > 2) && (! (f[v->naddr * ADDR_LEN - 1] & SSID_C))) {
+
+    return 0;
+  }
+  ctrl = f + v->naddr * ADDR_LEN;
+  end = f + v->len;
+  if ( (ctrl[0] & ~AX25_CTRL_PF) == AX25_CTRL_UI) {
+
+    return 0;
+  }
+
+  // The frames of the version 2.0 have the same C bits and are commands
+  cmd = (f[AX25_CALL_LEN] & SSID_C) || (! (f[ADDR_LEN + AX25_CALL_LEN] & SSID_C));
+  prvvReturnPath (v, remote, path, &path_len);
+  c = prvxFind (l, remote);
+
+  if ( (ctrl[0] & 0x03) == 0x03) {
+
+    return prviInputU (l, c, v, ctrl[0] & ~AX25_CTRL_PF, cmd,
+                       (ctrl[0] & AX25_CTRL_PF) != 0);
+  }
+
+  if ( (!c) || (c->state == AX25_LINK_AWAITING_CONNECTION) ||
+       (c->state == AX25_LINK_AWAITING_RELEASE)) {
+
+    if ( (!c) && (cmd)) {
+
+      // I and S frames of an unknown connection
+      (void) prviSendDm (l, v, (ctrl[0] & AX25_CTRL_PF) != 0);
+    }
+    return 1;
+  }
+
+  if (c->modulo == 128) {
+
+    if (ctrl + 2 > end) {
+
+      return AX25_INVALID_FRAME;
+    }
+    nr = ctrl[1] >> 1;
+    pf = ctrl[1] & 0x01;
+    ns = ctrl[0] >> 1;
+    info = ctrl + 2;
+  }
+  else {
+
+    nr = ctrl[0] >> 5;
+    pf = (ctrl[0] & AX25_CTRL_PF) != 0;
+    ns = (ctrl[0] >> 1) & 0x07;
+    info = ctrl + 1;
+  }
+
+  if ( (ctrl[0] & 0x01) == 0) {
+
+    // I frames are commands, the info field follows the PID field
+    if ( (!cmd) || (info >= end)) {
+
+      return AX25_INVALID_FRAME;
+    }
+    return prviInputI (c, ns, nr, pf, info + 1, end - info - 1);
+  }
+  return prviInputS (c, ctrl[0] & 0x0F, nr, cmd, pf);
+}
+
+// -----------------------------------------------------------------------------
+long
+lAx25LinkTimer (xAx25Link *l) {
+  long long now = prvllNow();
+  long next = -1;
+  xAx25Conn *c, *n;
+
+  if (!l) {
+
+    return -1;
+  }
+
+  for (c = l->conn; c; c = n) {
+
+    n = c->next;
+    if ( (c->t1) && (now >= c->t1)) {
+
+      c->t1 = 0;
+      if (prvbT1Expiry (c)) {
+        continue;
+      }
+    }
+    if ( (c->t2) && (now >= c->t2)) {
+
+      c->t2 = 0;
+      if (c->ack_pending) {
+
+        (void) prviSendAck (c, false, false);
+      }
+    }
+    if ( (c->t3) && (now >= c->t3)) {
+
+      c->t3 = 0;
+      if (c->state == AX25_LINK_CONNECTED) {
+
+        c->rc = 0;
+        prvvEnquiry (c);
+      }
+    }
+  }
+
+  for (c = l->conn; c; c = c->next) {
+    long long t[3] = { c->t1, c->t2, c->t3 };
+
+    for (int i = 0; i < 3; i++) {
+
+      if (t[i]) {
+        long d = (t[i] > now) ? t[i] - now : 0;
+
+        if ( (next < 0) || (d < next)) {
+          next = d;
+        }
+      }
+    }
+  }
+  return next;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25LinkPoll (xAx25Link *l, int timeout_ms) {
+  long long deadline;
+  int count = 0;
+
+  if (!l) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+
+  deadline = prvllNow() + timeout_ms;
+  for (;;) {
+    long next = lAx25LinkTimer (l);
+    int wait = timeout_ms;
+    xAx25View v;
+
+    if (timeout_ms >= 0) {
+      long long left = deadline - prvllNow();
+
+      wait = (left > 0) ? left : 0;
+    }
+    if ( (next >= 0) && ( (wait < 0) || (next < wait))) {
+
+      wait = next;
+    }
+
+    // The frames already received are all processed
+    while (bAx25PollTimeout (l->port, wait)) {
+
+      if (iAx25ReadView (l->port, &v) == AX25_SUCCESS) {
+        int ret = iAx25LinkInput (l, &v);
+
+        if (ret < 0) {
+
+          PWARNING ("Frame not processed: %d\n", ret);
+        }
+        count++;
+        (void) iAx25Discard (l->port);
+      }
+      wait = 0;
+    }
+
+    if ( (count > 0) || ( (timeout_ms >= 0) && (prvllNow() >= deadline))) {
+
+      (void) lAx25LinkTimer (l);
+      return count;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+xAx25Conn *
+xAx25LinkConnect (xAx25Link *l, const xAx25Node *remote, const xAx25Node *path,
+                  unsigned path_len, bool extended) {
+  uint8_t addr[ADDR_LEN], rpt[AX25_MAX_RPT][ADDR_LEN];
+  xAx25Conn *c;
+
+  if ( (!l) || (!remote) || (path_len > AX25_MAX_RPT) || ( (path_len) && (!path))) {
+
+    return NULL;
+  }
+  if (iAx25NodeEncode (remote, addr) != AX25_SUCCESS) {
+
+    return NULL;
+  }
+  addr[AX25_CALL_LEN] &= ~ (SSID_C | SSID_LAST);
+  for (unsigned i = 0; i < path_len; i++) {
+
+    if (iAx25NodeEncode (&path[i], rpt[i]) != AX25_SUCCESS) {
+
+      return NULL;
+    }
+    rpt[i][AX25_CALL_LEN] &= ~ (SSID_C | SSID_LAST);
+  }
+  if (prvxFind (l, addr)) {
+
+    return NULL;
+  }
+
+  c = prvxNew (l, addr, (const uint8_t (*) [ADDR_LEN]) rpt, path_len, extended);
+  if (c) {
+
+    c->state = AX25_LINK_AWAITING_CONNECTION;
+    c->rtt_time = prvllNow();
+    (void) prviSendU (c, extended ? AX25_CTRL_SABME : AX25_CTRL_SABM, true, true);
+    prvvStartT1 (c);
+  }
+  return c;
+}
+
+// -----------------------------------------------------------------------------
+xAx25Conn *
+xAx25LinkFind (xAx25Link *l, const xAx25Node *remote) {
+  uint8_t addr[ADDR_LEN];
+
+  if ( (!l) || (!remote) || (iAx25NodeEncode (remote, addr) != AX25_SUCCESS)) {
+
+    return NULL;
+  }
+  return prvxFind (l, addr);
+}
+
+//##############################################################################
+//#                                                                            #
+//#                           xAx25Conn Class                                  #
+//#                                                                            #
+//##############################################################################
+
+// -----------------------------------------------------------------------------
+ssize_t
+iAx25ConnSend (xAx25Conn *c, const void *data, size_t len) {
+  const uint8_t *p = data;
+  size_t done = 0, max;
+
+  if ( (!c) || ( (!data) && (len))) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (c->state == AX25_LINK_DISCONNECTED) ||
+       (c->state == AX25_LINK_AWAITING_RELEASE)) {
+
+    return AX25_CONNECTION_LOST;
+  }
+
+  // With 2 control bytes and a full path, the frame buffer limits the info field
+  max = AX25_FRAME_BUF_LEN - (2 + c->path_len) * ADDR_LEN -
+        ( (c->modulo == 128) ? 2 : 1) - 3;
+  while (done < len) {
+    size_t n = MIN (len - done, MIN (c->n1, max));
+    xAx25LinkBuf *b = malloc (sizeof (xAx25LinkBuf) + n);
+
+    if (!b) {
+
+      break;
+    }
+    b->next = NULL;
+    b->len = n;
+    memcpy (b->data, &p[done], n);
+    if (c->txq_tail) {
+
+      c->txq_tail->next = b;
+    }
+    else {
+
+      c->txq = b;
+    }
+    c->txq_tail = b;
+    done += n;
+  }
+  prvvPush (c);
+  return ( (done == 0) && (len > 0)) ? AX25_NOT_ENOUGH_MEMORY : (ssize_t) done;
+}
+
+// -----------------------------------------------------------------------------
+unsigned
+uAx25ConnPending (const xAx25Conn *c) {
+  unsigned n = 0;
+
+  if (c) {
+
+    n = prvuSeq (c, c->va, c->vs);
+    for (const xAx25LinkBuf *b = c->txq; b; b = b->next) {
+
+      n++;
+    }
+  }
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25ConnSetBusy (xAx25Conn *c, bool busy) {
+
+  if (!c) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (busy != c->own_busy) {
+
+    c->own_busy = busy;
+    if ( (c->state == AX25_LINK_CONNECTED) || (c->state == AX25_LINK_TIMER_RECOVERY)) {
+
+      (void) prviSendAck (c, false, false);
+    }
+  }
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25ConnDisconnect (xAx25Conn *c) {
+
+  if (!c) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (c->state == AX25_LINK_DISCONNECTED) ||
+       (c->state == AX25_LINK_AWAITING_RELEASE)) {
+
+    return AX25_SUCCESS;
+  }
+
+  prvvReset (c, c->modulo == 128);
+  while (c->txq) {
+    xAx25LinkBuf *b = c->txq;
+
+    c->txq = b->next;
+    free (b);
+  }
+  c->txq_tail = NULL;
+  c->state = AX25_LINK_AWAITING_RELEASE;
+  (void) prviSendU (c, AX25_CTRL_DISC, true, true);
+  prvvStartT1 (c);
+  return AX25_SUCCESS;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,203 @@
+/**
+ * @file src/loop.cpp
+ * @brief Boucle d'événements et opérations asynchrones (Implémentation C++)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <radio/loop.hpp>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <stdexcept>
+
+/* constants ================================================================ */
+// Maximum number of events returned by epoll_wait()
+#define EPOLL_EVENTS 64
+
+//##############################################################################
+//#                                                                            #
+//#                           EventLoop:: Class                                #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+static thread_local EventLoop *xCurrentLoop;
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+EventLoop *
+EventLoop::current() {
+
+  return xCurrentLoop;
+}
+
+// -----------------------------------------------------------------------------
+void
+EventLoop::setCurrent (EventLoop *loop) {
+
+  xCurrentLoop = loop;
+}
+
+//##############################################################################
+//#                                                                            #
+//#                           EpollLoop:: Class                                #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+int
+EpollLoop::update (int fd, const Watch &w, bool added) {
+  struct epoll_event ev;
+
+  ev.events = (w.reader ? (uint32_t) EPOLLIN : 0u) | (w.writer ? (uint32_t) EPOLLOUT : 0u);
+  ev.data.fd = fd;
+  if (ev.events == 0) {
+
+    fds.erase (fd);
+    return epoll_ctl (epfd, EPOLL_CTL_DEL, fd, &ev);
+  }
+  return epoll_ctl (epfd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev);
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+EpollLoop::EpollLoop() : epfd (epoll_create1 (EPOLL_CLOEXEC)), stopped (false),
+  count (0) {
+
+  if (epfd < 0) {
+
+    throw std::runtime_error ("EpollLoop::EpollLoop");
+  }
+}
+
+// -----------------------------------------------------------------------------
+EpollLoop::~EpollLoop() {
+
+  if (current() == this) {
+
+    setCurrent (nullptr);
+  }
+  close (epfd);
+}
+
+// -----------------------------------------------------------------------------
+int
+EpollLoop::watch (int fd, unsigned event, Waiter *w) {
+  auto it = fds.find (fd);
+  bool added = (it == fds.end());
+  Watch watch = added ? Watch { nullptr, nullptr } : it->second;
+  Waiter *&slot = (event == READ) ? watch.reader : watch.writer;
+
+  if ( (!w) || ( (event != READ) && (event != WRITE)) || (slot)) {
+
+    return -1;
+  }
+  slot = w;
+  if (update (fd, watch, added) != 0) {
+
+    return -1;
+  }
+  fds[fd] = watch;
+  count++;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+void
+EpollLoop::unwatch (int fd, unsigned event) {
+  auto it = fds.find (fd);
+
+  if (it != fds.end()) {
+    Watch watch = it->second;
+    Waiter *&slot = (event == READ) ? watch.reader : watch.writer;
+
+    if (slot) {
+
+      slot = nullptr;
+      count--;
+      if ( (watch.reader) || (watch.writer)) {
+
+        it->second = watch;
+      }
+      update (fd, watch, false);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+EpollLoop::runOnce (int timeoutMs) {
+  struct epoll_event ev[EPOLL_EVENTS];
+  int n, called = 0;
+
+  n = epoll_wait (epfd, ev, EPOLL_EVENTS, timeoutMs);
+  if (n < 0) {
+
+    return (errno == EINTR) ? 0 : -1;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int fd = ev[i].data.fd;
+    unsigned hup = (ev[i].events & (EPOLLHUP | EPOLLERR)) ? HANGUP : 0;
+
+    // The waiters may change the watches, they are looked for each time
+    if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      auto it = fds.find (fd);
+
+      if ( (it != fds.end()) && (it->second.reader)) {
+        Waiter *w = it->second.reader;
+
+        w->ready (w, READ | hup);
+        called++;
+      }
+    }
+    if (ev[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+      auto it = fds.find (fd);
+
+      if ( (it != fds.end()) && (it->second.writer)) {
+        Waiter *w = it->second.writer;
+
+        w->ready (w, WRITE | hup);
+        called++;
+      }
+    }
+  }
+  return called;
+}
+
+// -----------------------------------------------------------------------------
+int
+EpollLoop::run() {
+  EventLoop *previous = current();
+  int ret = 0;
+
+  setCurrent (this);
+  stopped = false;
+  while ( (!stopped) && (count > 0) && (ret >= 0)) {
+
+    ret = runOnce (-1);
+  }
+  setCurrent (previous);
+  return (ret < 0) ? ret : 0;
+}
+
+// -----------------------------------------------------------------------------
+void
+EpollLoop::stop() {
+
+  stopped = true;
+}
+
+// -----------------------------------------------------------------------------
+unsigned
+EpollLoop::waiters() const {
+
+  return count;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,944 @@
+/**
+ * @file src/mux.c
+ * @brief Multiplexeur d'entrées-sorties de plusieurs ports (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <radio/mux.h>
+
+/* constants ================================================================ */
+// Multishot read, Linux 6.7, not defined by older headers
+#define OP_READ_MULTISHOT 49
+
+// Number of entries of the submission queue
+#define SQ_ENTRIES 256
+
+// Maximum number of writes in a chain
+#define CHAIN_MAX 32
+
+// Buffer group of the receive buffers
+#define BGID 0
+
+// Maximum number of events returned by epoll_wait()
+#define EPOLL_EVENTS 64
+
+// The low bit of user_data is set for a read, cleared for a write (pointer)
+#define UD_READ(port) ( ( (uint64_t) (port) << 1) | 1)
+
+/* private ================================================================== */
+/*
+ * Frame queued for sending
+ */
+typedef struct xMuxTx {
+  struct xMuxTx *next;
+  int port;
+  size_t len;
+  size_t off;           // number of bytes already written
+  bool inflight;        // write submitted, not yet completed
+  bool done;
+  uint8_t buf[];
+} xMuxTx;
+
+/*
+ * Port
+ */
+typedef struct xMuxPort {
+  xAx25 *ax25;
+  xTnc *tnc;
+  int fin;
+  int fout;
+  vMuxHandler handler;
+  void *udata;
+  bool open;            // input not closed
+  xMuxTx *head;         // send queue
+  xMuxTx *tail;
+  unsigned inflight;    // number of writes submitted
+  size_t pending;       // number of bytes queued
+} xMuxPort;
+
+/*
+ * io_uring rings
+ */
+typedef struct xUring {
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_array;
+  unsigned sq_mask;
+  unsigned sq_entries;
+  unsigned sq_local;    // tail not yet published
+  unsigned to_submit;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned cq_mask;
+  struct io_uring_cqe *cqes;
+  struct io_uring_buf_ring *br;
+  size_t br_size;
+  unsigned br_mask;
+  uint16_t br_tail;
+  bool multishot;
+} xUring;
+
+// -----------------------------------------------------------------------------
+// Decodes the received bytes and calls the handler for each frame
+static int
+prviDeliver (xMux *m, int port, const uint8_t *buf, size_t len) {
+  int frames = 0;
+
+  while (len) {
+    xMuxPort *p = &m->port[port];
+    size_t used;
+
+    if (p->ax25) {
+      unsigned long delivered = p->ax25->rx_frames;
+
+      // The frames given to the receive handler of the port are only counted
+      if ( (bAx25Feed (p->ax25, buf, len, &used)) && (p->ax25->frm_recv)) {
+
+        frames++;
+        if (p->handler) {
+
+          p->handler (m, port, p->udata);
+        }
+        p = &m->port[port];
+        if (p->ax25->frm_recv) {
+
+          iAx25Discard (p->ax25);
+        }
+      }
+      frames += p->ax25->rx_frames - delivered;
+    }
+    else {
+      unsigned long delivered = p->tnc->rx_msgs;
+      int ret = iTncFeed (p->tnc, buf, len, &used);
+
+      if (p->tnc->rx_msgs != delivered) {
+
+        frames += p->tnc->rx_msgs - delivered;
+      }
+      else if (ret == TNC_EOT) {
+
+        frames++;
+        if (p->handler) {
+
+          p->handler (m, port, p->udata);
+        }
+      }
+      else if (ret == TNC_CRC_ERROR) {
+
+        m->errors++;
+      }
+    }
+    buf += used;
+    len -= used;
+  }
+  m->frames += frames;
+  return frames;
+}
+
+// -----------------------------------------------------------------------------
+// Frees the frames written at the head of the queue
+static void
+prvvTxRelease (xMuxPort *p) {
+
+  while ( (p->head) && (p->head->done)) {
+    xMuxTx *t = p->head;
+
+    p->head = t->next;
+    p->pending -= t->len - t->off;
+    free (t);
+  }
+  if (!p->head) {
+
+    p->tail = NULL;
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvClosePort (xMux *m, xMuxPort *p) {
+
+  if (p->open) {
+
+    p->open = false;
+    m->nopen--;
+  }
+}
+
+//------------------------------------------------------------------------------
+//                               io_uring
+//------------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+static int
+prviUringEnter (xMux *m, unsigned wait, int timeout_ms) {
+  xUring *u = (xUring *) m->uring;
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec ts;
+  unsigned flags = 0;
+  int ret;
+
+  __atomic_store_n (u->sq_tail, u->sq_local, __ATOMIC_RELEASE);
+  memset (&arg, 0, sizeof (arg));
+  if (wait) {
+
+    flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    if (timeout_ms >= 0) {
+
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+      arg.ts = (uint64_t) (uintptr_t) &ts;
+    }
+  }
+
+  ret = syscall (__NR_io_uring_enter, m->fd, u->to_submit, wait, flags,
+                 wait ? &arg : NULL, wait ? sizeof (arg) : 0);
+  m->syscalls++;
+  if (ret < 0) {
+
+    if ( (errno == ETIME) || (errno == EINTR) || (errno == EBUSY)) {
+
+      return 0;
+    }
+    return AX25_FILE_ACCESS_ERROR;
+  }
+  u->to_submit -= ret;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Free entries of the submission queue
+static unsigned
+prvuUringSpace (xUring *u) {
+
+  return u->sq_entries - (u->sq_local - __atomic_load_n (u->sq_head, __ATOMIC_ACQUIRE));
+}
+
+// -----------------------------------------------------------------------------
+static struct io_uring_sqe *
+prvxUringSqe (xMux *m) {
+  xUring *u = (xUring *) m->uring;
+  struct io_uring_sqe *sqe;
+  unsigned i;
+
+  if ( (prvuUringSpace (u) == 0) && ( (prviUringEnter (m, 0, 0) != AX25_SUCCESS) ||
+                                      (prvuUringSpace (u) == 0))) {
+
+    return NULL;
+  }
+  i = u->sq_local++ & u->sq_mask;
+  sqe = &u->sqes[i];
+  memset (sqe, 0, sizeof (*sqe));
+  u->sq_array[i] = i;
+  u->to_submit++;
+  return sqe;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviUringArm (xMux *m, int port) {
+  xUring *u = (xUring *) m->uring;
+  struct io_uring_sqe *sqe = prvxUringSqe (m);
+
+  if (!sqe) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  sqe->opcode = u->multishot ? OP_READ_MULTISHOT : IORING_OP_READ;
+  sqe->fd = m->port[port].fin;
+  sqe->off = (uint64_t) -1;
+  sqe->len = u->multishot ? 0 : AX25_MUX_BUFFER_SIZE;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BGID;
+  sqe->user_data = UD_READ (port);
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Gives the buffer back to the kernel, published by prviUringReap()
+static void
+prvvUringRecycle (xMux *m, uint16_t bid) {
+  xUring *u = (xUring *) m->uring;
+  struct io_uring_buf *b = &u->br->bufs[u->br_tail++ & u->br_mask];
+
+  // The resv field of the first entry is the tail of the ring, it is not written
+  b->addr = (uint64_t) (uintptr_t) &m->bufs[bid * AX25_MUX_BUFFER_SIZE];
+  b->len = AX25_MUX_BUFFER_SIZE;
+  b->bid = bid;
+}
+
+// -----------------------------------------------------------------------------
+// Submits a chain of writes for each port which has no write in progress
+static void
+prvvUringFlush (xMux *m) {
+  xUring *u = (xUring *) m->uring;
+
+  for (int i = 0; i < m->nports; i++) {
+    xMuxPort *p = &m->port[i];
+    struct io_uring_sqe *sqe = NULL;
+    unsigned n = 0;
+
+    if ( (p->inflight) || (!p->head)) {
+      continue;
+    }
+
+    // A chain is never split between two submissions
+    if ( (prvuUringSpace (u) < CHAIN_MAX) && (prviUringEnter (m, 0, 0) != AX25_SUCCESS)) {
+      return;
+    }
+    for (xMuxTx *t = p->head; (t) && (n < CHAIN_MAX) && (prvuUringSpace (u) > 0);
+         t = t->next, n++) {
+
+      sqe = prvxUringSqe (m);
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->fd = p->fout;
+      sqe->off = (uint64_t) -1;
+      sqe->addr = (uint64_t) (uintptr_t) &t->buf[t->off];
+      sqe->len = t->len - t->off;
+      sqe->flags = IOSQE_IO_LINK;
+      sqe->user_data = (uint64_t) (uintptr_t) t;
+      t->inflight = true;
+      p->inflight++;
+    }
+    if (sqe) {
+
+      // End of the chain
+      sqe->flags = 0;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvUringWritten (xMux *m, xMuxTx *t, int res) {
+  xMuxPort *p = &m->port[t->port];
+
+  t->inflight = false;
+  p->inflight--;
+  if (res >= 0) {
+
+    // A short write cancels the end of the chain, the rest is written later
+    t->off += res;
+    p->pending -= res;
+    t->done = (t->off >= t->len);
+  }
+  else if ( (res != -ECANCELED) && (res != -EAGAIN) && (res != -EINTR)) {
+
+    // Write error, the frame is lost
+    t->done = true;
+  }
+  prvvTxRelease (p);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviUringRead (xMux *m, int port, const struct io_uring_cqe *cqe) {
+  xMuxPort *p = &m->port[port];
+  int frames = 0;
+
+  if (cqe->flags & IORING_CQE_F_BUFFER) {
+    uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+    if (cqe->res > 0) {
+
+      frames = prviDeliver (m, port, &m->bufs[bid * AX25_MUX_BUFFER_SIZE], cqe->res);
+      p = &m->port[port];
+    }
+    prvvUringRecycle (m, bid);
+  }
+
+  if (! (cqe->flags & IORING_CQE_F_MORE)) {
+
+    // The read is no longer armed
+    if ( (cqe->res > 0) || (cqe->res == -ENOBUFS) || (cqe->res == -EINTR) ||
+         (cqe->res == -EAGAIN)) {
+
+      if (prviUringArm (m, port) != AX25_SUCCESS) {
+
+        prvvClosePort (m, p);
+      }
+    }
+    else {
+
+      // End of file or error
+      prvvClosePort (m, p);
+    }
+  }
+  return frames;
+}
+
+// -----------------------------------------------------------------------------
+// Processes all the completions available
+static int
+prviUringReap (xMux *m) {
+  xUring *u = (xUring *) m->uring;
+  unsigned head = *u->cq_head;
+  unsigned tail = __atomic_load_n (u->cq_tail, __ATOMIC_ACQUIRE);
+  uint16_t br_tail = u->br_tail;
+  int frames = 0;
+
+  while (head != tail) {
+    const struct io_uring_cqe *cqe = &u->cqes[head & u->cq_mask];
+
+    if (cqe->user_data & 1) {
+
+      frames += prviUringRead (m, cqe->user_data >> 1, cqe);
+    }
+    else {
+
+      prvvUringWritten (m, (xMuxTx *) (uintptr_t) cqe->user_data, cqe->res);
+    }
+    head++;
+  }
+  __atomic_store_n (u->cq_head, head, __ATOMIC_RELEASE);
+  if (br_tail != u->br_tail) {
+
+    __atomic_store_n (&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+  }
+  return frames;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvUringDelete (xMux *m) {
+  xUring *u = (xUring *) m->uring;
+
+  if (m->fd >= 0) {
+
+    close (m->fd);
+  }
+  if (u) {
+
+    if (u->br) {
+
+      munmap (u->br, u->br_size);
+    }
+    if (u->sqes) {
+
+      munmap (u->sqes, u->sqes_size);
+    }
+    if ( (u->cq_ring) && (u->cq_ring != u->sq_ring)) {
+
+      munmap (u->cq_ring, u->cq_ring_size);
+    }
+    if (u->sq_ring) {
+
+      munmap (u->sq_ring, u->sq_ring_size);
+    }
+    free (u);
+  }
+  m->uring = NULL;
+  m->fd = -1;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviUringNew (xMux *m) {
+  struct io_uring_params par;
+  struct io_uring_buf_reg reg;
+  struct io_uring_probe *probe;
+  xUring *u;
+  uint8_t *sq, *cq;
+
+  u = calloc (1, sizeof (xUring));
+  if (!u) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  m->uring = u;
+
+  memset (&par, 0, sizeof (par));
+  par.flags = IORING_SETUP_COOP_TASKRUN;
+  m->fd = syscall (__NR_io_uring_setup, SQ_ENTRIES, &par);
+  if ( (m->fd < 0) && (errno == EINVAL)) {
+
+    // Kernel older than 5.19
+    memset (&par, 0, sizeof (par));
+    m->fd = syscall (__NR_io_uring_setup, SQ_ENTRIES, &par);
+  }
+  if ( (m->fd < 0) || (! (par.features & IORING_FEAT_EXT_ARG))) {
+
+    goto error;
+  }
+
+  // Rings
+  u->sq_ring_size = par.sq_off.array + par.sq_entries * sizeof (unsigned);
+  u->cq_ring_size = par.cq_off.cqes + par.cq_entries * sizeof (struct io_uring_cqe);
+  if (par.features & IORING_FEAT_SINGLE_MMAP) {
+
+    if (u->cq_ring_size > u->sq_ring_size) {
+
+      u->sq_ring_size = u->cq_ring_size;
+    }
+    u->cq_ring_size = u->sq_ring_size;
+  }
+  u->sq_ring = mmap (NULL, u->sq_ring_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, m->fd, IORING_OFF_SQ_RING);
+  if (u->sq_ring == MAP_FAILED) {
+
+    u->sq_ring = NULL;
+    goto error;
+  }
+  if (par.features & IORING_FEAT_SINGLE_MMAP) {
+
+    u->cq_ring = u->sq_ring;
+  }
+  else {
+
+    u->cq_ring = mmap (NULL, u->cq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, m->fd, IORING_OFF_CQ_RING);
+    if (u->cq_ring == MAP_FAILED) {
+
+      u->cq_ring = NULL;
+      goto error;
+    }
+  }
+  u->sqes_size = par.sq_entries * sizeof (struct io_uring_sqe);
+  u->sqes = mmap (NULL, u->sqes_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, m->fd, IORING_OFF_SQES);
+  if (u->sqes == MAP_FAILED) {
+
+    u->sqes = NULL;
+    goto error;
+  }
+
+  sq = (uint8_t *) u->sq_ring;
+  cq = (uint8_t *) u->cq_ring;
+  u->sq_head = (unsigned *) (sq + par.sq_off.head);
+  u->sq_tail = (unsigned *) (sq + par.sq_off.tail);
+  u->sq_array = (unsigned *) (sq + par.sq_off.array);
+  u->sq_mask = * (unsigned *) (sq + par.sq_off.ring_mask);
+  u->sq_entries = par.sq_entries;
+  u->sq_local = *u->sq_tail;
+  u->cq_head = (unsigned *) (cq + par.cq_off.head);
+  u->cq_tail = (unsigned *) (cq + par.cq_off.tail);
+  u->cq_mask = * (unsigned *) (cq + par.cq_off.ring_mask);
+  u->cqes = (struct io_uring_cqe *) (cq + par.cq_off.cqes);
+
+  // Is the multishot read supported ?
+  probe = calloc (1, sizeof (struct io_uring_probe) + 256 * sizeof (struct io_uring_probe_op));
+  if (probe) {
+
+    if ( (syscall (__NR_io_uring_register, m->fd, IORING_REGISTER_PROBE, probe, 256) == 0) &&
+         (probe->last_op >= OP_READ_MULTISHOT) &&
+         (probe->ops[OP_READ_MULTISHOT].flags & IO_URING_OP_SUPPORTED)) {
+
+      u->multishot = true;
+    }
+    free (probe);
+  }
+
+  // Ring of the receive buffers, Linux 5.19
+  u->br_size = m->nbufs * sizeof (struct io_uring_buf);
+  u->br = mmap (NULL, u->br_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (u->br == MAP_FAILED) {
+
+    u->br = NULL;
+    goto error;
+  }
+  memset (&reg, 0, sizeof (reg));
+  reg.ring_addr = (uint64_t) (uintptr_t) u->br;
+  reg.ring_entries = m->nbufs;
+  reg.bgid = BGID;
+  if (syscall (__NR_io_uring_register, m->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+
+    goto error;
+  }
+  u->br_mask = m->nbufs - 1;
+  for (unsigned i = 0; i < m->nbufs; i++) {
+
+    prvvUringRecycle (m, i);
+  }
+  __atomic_store_n (&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+
+  m->backend = AX25_MUX_URING;
+  return AX25_SUCCESS;
+
+error:
+  prvvUringDelete (m);
+  return AX25_FILE_ACCESS_ERROR;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviUringPoll (xMux *m, int timeout_ms) {
+  xUring *u = (xUring *) m->uring;
+  int frames;
+  bool busy = (m->nopen > 0);
+
+  prvvUringFlush (m);
+  for (int i = 0; (i < m->nports) && (!busy); i++) {
+
+    busy = (m->port[i].inflight > 0);
+  }
+
+  // The completions already there are processed without waiting
+  frames = prviUringReap (m);
+  if ( (u->to_submit) || ( (frames == 0) && (timeout_ms != 0) && (busy))) {
+    int ret = prviUringEnter (m, ( (frames == 0) && (timeout_ms != 0) && (busy)) ? 1 : 0,
+                              timeout_ms);
+
+    if (ret < 0) {
+
+      return ret;
+    }
+    frames += prviUringReap (m);
+  }
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+//                                 epoll
+//------------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// Writes the queued frames until the output would block
+static void
+prvvEpollFlush (xMux *m) {
+
+  for (int i = 0; i < m->nports; i++) {
+    xMuxPort *p = &m->port[i];
+
+    while (p->head) {
+      xMuxTx *t = p->head;
+      ssize_t n = write (p->fout, &t->buf[t->off], t->len - t->off);
+
+      m->syscalls++;
+      if (n < 0) {
+
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN) {
+          break;
+        }
+        // Write error, the frame is lost
+        n = 0;
+        t->done = true;
+      }
+      t->off += n;
+      p->pending -= n;
+      t->done |= (t->off >= t->len);
+      prvvTxRelease (p);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviEpollPoll (xMux *m, int timeout_ms) {
+  struct epoll_event ev[EPOLL_EVENTS];
+  bool pending = false;
+  int n, frames = 0;
+
+  prvvEpollFlush (m);
+  for (int i = 0; (i < m->nports) && (!pending); i++) {
+
+    pending = (m->port[i].head != NULL);
+  }
+  if (m->nopen == 0) {
+
+    return 0;
+  }
+  if ( (pending) && ( (timeout_ms < 0) || (timeout_ms > 1))) {
+
+    // The output is retried soon
+    timeout_ms = 1;
+  }
+
+  n = epoll_wait (m->fd, ev, EPOLL_EVENTS, timeout_ms);
+  m->syscalls++;
+  if (n < 0) {
+
+    return (errno == EINTR) ? 0 : AX25_FILE_ACCESS_ERROR;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int port = ev[i].data.u32;
+    xMuxPort *p = &m->port[port];
+    ssize_t len = read (p->fin, m->bufs, AX25_MUX_BUFFER_SIZE);
+
+    m->syscalls++;
+    if (len > 0) {
+
+      frames += prviDeliver (m, port, m->bufs, len);
+    }
+    else if ( (len == 0) || ( (errno != EAGAIN) && (errno != EINTR))) {
+
+      // End of file or error
+      epoll_ctl (m->fd, EPOLL_CTL_DEL, p->fin, NULL);
+      prvvClosePort (m, p);
+    }
+  }
+  return frames;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviAddPort (xMux *m, xAx25 *ax25, xTnc *tnc, int fin, int fout,
+             vMuxHandler handler, void *udata) {
+  xMuxPort *p;
+  int port = m->nports;
+
+  p = realloc (m->port, (m->nports + 1) * sizeof (xMuxPort));
+  if (!p) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  m->port = p;
+  p = &m->port[port];
+  memset (p, 0, sizeof (xMuxPort));
+  p->ax25 = ax25;
+  p->tnc = tnc;
+  p->fin = fin;
+  p->fout = fout;
+  p->handler = handler;
+  p->udata = udata;
+
+  if (m->backend == AX25_MUX_URING) {
+
+    if (prviUringArm (m, port) != AX25_SUCCESS) {
+
+      return AX25_NOT_ENOUGH_MEMORY;
+    }
+  }
+  else {
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = port;
+    if (epoll_ctl (m->fd, EPOLL_CTL_ADD, fin, &ev) != 0) {
+
+      return AX25_FILE_ACCESS_ERROR;
+    }
+  }
+  p->open = true;
+  m->nports++;
+  m->nopen++;
+  return port;
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xMux *
+xMuxNew (int backend, unsigned nbufs) {
+  xMux *m;
+  unsigned n = 1;
+
+  if (nbufs == 0) {
+
+    nbufs = AX25_MUX_BUFFERS;
+  }
+  // The ring of buffers has a power of 2 size
+  while ( (n < nbufs) && (n < 32768)) {
+
+    n <<= 1;
+  }
+
+  m = calloc (1, sizeof (xMux));
+  if (!m) {
+
+    return NULL;
+  }
+  m->fd = -1;
+  m->nbufs = n;
+  m->bufs = malloc (n * AX25_MUX_BUFFER_SIZE);
+  if (!m->bufs) {
+
+    goto error;
+  }
+
+  if ( (backend == AX25_MUX_AUTO) || (backend == AX25_MUX_URING)) {
+
+    if (prviUringNew (m) == AX25_SUCCESS) {
+
+      return m;
+    }
+    if (backend == AX25_MUX_URING) {
+
+      goto error;
+    }
+  }
+  else if (backend != AX25_MUX_EPOLL) {
+
+    goto error;
+  }
+
+  m->fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (m->fd >= 0) {
+
+    m->backend = AX25_MUX_EPOLL;
+    return m;
+  }
+
+error:
+  free (m->bufs);
+  free (m);
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+void
+vMuxDelete (xMux *m) {
+
+  if (m) {
+
+    if (m->backend == AX25_MUX_URING) {
+
+      prvvUringDelete (m);
+    }
+    else {
+
+      close (m->fd);
+    }
+    for (int i = 0; i < m->nports; i++) {
+      xMuxTx *t = m->port[i].head;
+
+      while (t) {
+        xMuxTx *next = t->next;
+
+        free (t);
+        t = next;
+      }
+    }
+    free (m->port);
+    free (m->bufs);
+    free (m);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iMuxAddAx25 (xMux *m, xAx25 *ax25, vMuxHandler handler, void *udata) {
+
+  if ( (!m) || (!ax25)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (!ax25->fin) {
+
+    return AX25_FILE_NOT_FOUND;
+  }
+  return prviAddPort (m, ax25, NULL, ax25->fin, ax25->fout ? ax25->fout : -1,
+                      handler, udata);
+}
+
+// -----------------------------------------------------------------------------
+int
+iMuxAddTnc (xMux *m, xTnc *tnc, vMuxHandler handler, void *udata) {
+
+  if ( (!m) || (!tnc)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (tnc->fin < 0) {
+
+    return AX25_FILE_NOT_FOUND;
+  }
+  return prviAddPort (m, NULL, tnc, tnc->fin, tnc->fout, handler, udata);
+}
+
+// -----------------------------------------------------------------------------
+int
+iMuxSend (xMux *m, int port, const void *frame, size_t len) {
+  xMuxPort *p;
+  xMuxTx *t;
+
+  if ( (!m) || (!frame) || (port < 0) || (port >= m->nports)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  p = &m->port[port];
+  if (p->fout < 0) {
+
+    return AX25_FILE_NOT_FOUND;
+  }
+  if ( (len == 0) || ( (p->ax25) && (len > AX25_FRAME_BUF_LEN))) {
+
+    return AX25_INVALID_FRAME;
+  }
+
+  t = malloc (sizeof (xMuxTx) + (p->ax25 ? AX25_RAW_SIZE (len) : TNC_MSG_SIZE (len)));
+  if (!t) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  t->next = NULL;
+  t->port = port;
+  t->off = 0;
+  t->inflight = false;
+  t->done = false;
+  t->len = p->ax25 ? uAx25Encode (t->buf, (const uint8_t *) frame, len) :
+           uTncEncode (t->buf, frame, len);
+
+  if (p->tail) {
+
+    p->tail->next = t;
+  }
+  else {
+
+    p->head = t;
+  }
+  p->tail = t;
+  p->pending += t->len;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iMuxPoll (xMux *m, int timeout_ms) {
+
+  if (!m) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (m->backend == AX25_MUX_URING) {
+
+    return prviUringPoll (m, timeout_ms);
+  }
+  return prviEpollPoll (m, timeout_ms);
+}
+
+// -----------------------------------------------------------------------------
+int
+iMuxOpenPorts (const xMux *m) {
+
+  if (!m) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  return m->nopen;
+}
+
+// -----------------------------------------------------------------------------
+ssize_t
+iMuxPending (const xMux *m, int port) {
+
+  if ( (!m) || (port < 0) || (port >= m->nports)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  return m->port[port].pending;
+}
+
+/* ========================================================================== */
@@ -0,0 +1,375 @@
+/**
+ * @file src/pcap.c
+ * @brief Export de trames au format pcap/pcapng (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <radio/pcap.h>
+
+/* constants ================================================================ */
+#define ALIGN8(n) (((n) + 7) & ~((size_t) 7))
+#define PAD4(n) (((n) + 3) & ~((size_t) 3))
+
+// Record length of the padding which ends the ring buffer before a wrap
+#define REC_WRAP 0xFFFFFFFF
+
+// Sleep of the writer thread when the ring buffer is empty
+#define IDLE_NS 2000000
+
+// pcap
+#define PCAP_MAGIC_NS 0xA1B23C4D
+
+// pcapng
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_BOM 0x1A2B3C4D
+#define OPT_ENDOFOPT 0
+#define OPT_IF_NAME 2
+#define OPT_IF_TSRESOL 9
+
+#define SNAPLEN 65535
+
+/* private ================================================================== */
+/*
+ * Record of the ring buffer, followed by the frame
+ */
+typedef struct xRecord {
+  uint32_t len;
+  uint16_t port;
+  uint16_t reserved;
+  uint64_t ts;
+} xRecord;
+
+// -----------------------------------------------------------------------------
+static void
+prvvPut (xPcap *p, const void *data, size_t len) {
+
+  fwrite (data, 1, len, p->file);
+  p->file_len += len;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvPut32 (xPcap *p, uint32_t v) {
+
+  prvvPut (p, &v, sizeof (v));
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvPut16 (xPcap *p, uint16_t v) {
+
+  prvvPut (p, &v, sizeof (v));
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvPad (xPcap *p, size_t len) {
+  static const uint8_t zero[4];
+
+  prvvPut (p, zero, PAD4 (len) - len);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviOpen (xPcap *p) {
+  char *name = NULL;
+
+  if (p->rotate) {
+
+    if (asprintf (&name, "%s.%04u", p->path, p->index) < 0) {
+
+      return AX25_NOT_ENOUGH_MEMORY;
+    }
+  }
+  p->file = fopen (name ? name : p->path, "wb");
+  free (name);
+  if (!p->file) {
+
+    return AX25_FILE_ACCESS_ERROR;
+  }
+  setvbuf (p->file, NULL, _IOFBF, 64 * 1024);
+  p->file_len = 0;
+  p->nif = 0;
+  for (int i = 0; i < AX25_PCAP_MAX_PORTS; i++) {
+
+    p->ifid[i] = -1;
+  }
+
+  if (p->format == AX25_PCAPNG) {
+
+    // Section Header Block
+    prvvPut32 (p, PCAPNG_SHB);
+    prvvPut32 (p, 28);
+    prvvPut32 (p, PCAPNG_BOM);
+    prvvPut16 (p, 1);
+    prvvPut16 (p, 0);
+    prvvPut32 (p, 0xFFFFFFFF); // section length unknown
+    prvvPut32 (p, 0xFFFFFFFF);
+    prvvPut32 (p, 28);
+  }
+  else {
+
+    prvvPut32 (p, PCAP_MAGIC_NS);
+    prvvPut16 (p, 2);
+    prvvPut16 (p, 4);
+    prvvPut32 (p, 0); // thiszone
+    prvvPut32 (p, 0); // sigfigs
+    prvvPut32 (p, SNAPLEN);
+    prvvPut32 (p, p->linktype);
+  }
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Interface Description Block written the first time a port is seen
+static int
+prviInterface (xPcap *p, uint16_t port) {
+
+  if (p->ifid[port] < 0) {
+    static const uint8_t tsresol[4] = { 9 }; // nanoseconds, 3 padding bytes
+    char name[8];
+    size_t nlen = snprintf (name, sizeof (name), "port%u", port);
+
+    prvvPut32 (p, PCAPNG_IDB);
+    prvvPut32 (p, 20 + 4 + PAD4 (nlen) + 8 + 4);
+    prvvPut16 (p, p->linktype);
+    prvvPut16 (p, 0);
+    prvvPut32 (p, SNAPLEN);
+    prvvPut16 (p, OPT_IF_NAME);
+    prvvPut16 (p, nlen);
+    prvvPut (p, name, nlen);
+    prvvPad (p, nlen);
+    prvvPut16 (p, OPT_IF_TSRESOL);
+    prvvPut16 (p, 1);
+    prvvPut (p, tsresol, sizeof (tsresol));
+    prvvPut32 (p, OPT_ENDOFOPT);
+    prvvPut32 (p, 20 + 4 + PAD4 (nlen) + 8 + 4);
+    p->ifid[port] = p->nif++;
+  }
+  return p->ifid[port];
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvRecord (xPcap *p, const xRecord *r, const uint8_t *frame) {
+  uint8_t kiss = (r->port & 0x0F) << 4;
+  size_t caplen = r->len + (p->linktype == AX25_LINKTYPE_AX25_KISS ? 1 : 0);
+
+  if ( (p->rotate) && (p->file_len + caplen + 32 > p->rotate) &&
+       (p->file_len > 64)) {
+
+    fclose (p->file);
+    p->index++;
+    if (prviOpen (p) != AX25_SUCCESS) {
+
+      p->file = NULL;
+      return;
+    }
+  }
+
+  if (p->format == AX25_PCAPNG) {
+    int ifid = prviInterface (p, r->port);
+
+    prvvPut32 (p, PCAPNG_EPB);
+    prvvPut32 (p, 32 + PAD4 (caplen));
+    prvvPut32 (p, ifid);
+    prvvPut32 (p, r->ts >> 32);
+    prvvPut32 (p, r->ts & 0xFFFFFFFF);
+    prvvPut32 (p, caplen);
+    prvvPut32 (p, caplen);
+  }
+  else {
+
+    prvvPut32 (p, r->ts / 1000000000ULL);
+    prvvPut32 (p, r->ts % 1000000000ULL);
+    prvvPut32 (p, caplen);
+    prvvPut32 (p, caplen);
+  }
+
+  if (p->linktype == AX25_LINKTYPE_AX25_KISS) {
+
+    prvvPut (p, &kiss, 1);
+  }
+  prvvPut (p, frame, r->len);
+
+  if (p->format == AX25_PCAPNG) {
+
+    prvvPad (p, caplen);
+    prvvPut32 (p, 32 + PAD4 (caplen));
+  }
+  p->frames++;
+}
+
+// -----------------------------------------------------------------------------
+static void *
+prvvThread (void *arg) {
+  xPcap *p = (xPcap *) arg;
+
+  for (;;) {
+    size_t head = __atomic_load_n (&p->head, __ATOMIC_ACQUIRE);
+    size_t tail = p->tail;
+
+    if (head == tail) {
+
+      if (__atomic_load_n (&p->stop, __ATOMIC_ACQUIRE)) {
+
+        // The producer has stopped, the last records were read
+        if (__atomic_load_n (&p->head, __ATOMIC_ACQUIRE) == tail) {
+          break;
+        }
+        continue;
+      }
+      if (p->file) {
+
+        fflush (p->file);
+      }
+      struct timespec ts = { 0, IDLE_NS };
+      nanosleep (&ts, NULL);
+      continue;
+    }
+
+    while (tail != head) {
+      const xRecord *r = (const xRecord *) &p->ring[tail & (p->size - 1)];
+
+      if (r->len == REC_WRAP) {
+
+        tail += p->size - (tail & (p->size - 1));
+        continue;
+      }
+      if (p->file) {
+
+        prvvRecord (p, r, (const uint8_t *) (r + 1));
+      }
+      tail += ALIGN8 (sizeof (xRecord) + r->len);
+    }
+    __atomic_store_n (&p->tail, tail, __ATOMIC_RELEASE);
+  }
+
+  if (p->file) {
+
+    fclose (p->file);
+    p->file = NULL;
+  }
+  return NULL;
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xPcap *
+xPcapNew (const char *path, int format, bool kiss, size_t ring_size,
+          size_t rotate) {
+  xPcap *p;
+  size_t size = 1024;
+
+  if ( (!path) || ( (format != AX25_PCAP) && (format != AX25_PCAPNG))) {
+
+    return NULL;
+  }
+  if (ring_size == 0) {
+
+    ring_size = AX25_PCAP_RING_SIZE;
+  }
+  while (size < ring_size) {
+
+    size <<= 1;
+  }
+
+  p = calloc (1, sizeof (xPcap));
+  if (p) {
+
+    p->size = size;
+    p->format = format;
+    p->linktype = kiss ? AX25_LINKTYPE_AX25_KISS : AX25_LINKTYPE_AX25;
+    p->rotate = rotate;
+    p->ring = malloc (size);
+    p->path = strdup (path);
+    if ( (!p->ring) || (!p->path) || (prviOpen (p) != AX25_SUCCESS)) {
+
+      goto error;
+    }
+    if (pthread_create (&p->thread, NULL, prvvThread, p) != 0) {
+
+      fclose (p->file);
+      goto error;
+    }
+  }
+  return p;
+
+error:
+  free (p->ring);
+  free (p->path);
+  free (p);
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+void
+vPcapDelete (xPcap *p) {
+
+  if (p) {
+
+    __atomic_store_n (&p->stop, true, __ATOMIC_RELEASE);
+    pthread_join (p->thread, NULL);
+    free (p->ring);
+    free (p->path);
+    free (p);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iPcapWrite (xPcap *p, uint16_t port, const void *frame, size_t len) {
+  struct timespec ts;
+  size_t head, tail, size, off;
+  xRecord *r;
+
+  if ( (!p) || (!frame)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  size = ALIGN8 (sizeof (xRecord) + len);
+  if ( (port >= AX25_PCAP_MAX_PORTS) || (len > SNAPLEN) || (size > p->size / 2)) {
+
+    return AX25_INVALID_FRAME;
+  }
+
+  head = p->head;
+  tail = __atomic_load_n (&p->tail, __ATOMIC_ACQUIRE);
+  off = head & (p->size - 1);
+
+  // A record is never split, the end of the buffer is skipped if needed
+  if ( (off + size > p->size) && (head + (p->size - off) - tail <= p->size)) {
+
+    ( (xRecord *) &p->ring[off])->len = REC_WRAP;
+    head += p->size - off;
+    off = 0;
+  }
+  if (head + size - tail > p->size) {
+
+    // The consumer is late, the frame is lost
+    p->dropped++;
+    __atomic_store_n (&p->head, head, __ATOMIC_RELEASE);
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  r = (xRecord *) &p->ring[off];
+  r->len = len;
+  r->port = port;
+  r->ts = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  memcpy (r + 1, frame, len);
+  __atomic_store_n (&p->head, head + size, __ATOMIC_RELEASE);
+  return AX25_SUCCESS;
+}
+
+/* ========================================================================== */
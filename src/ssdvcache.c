@@ -0,0 +1,333 @@
+/**
+ * @file src/ssdvcache.c
+ * @brief Réassemblage d'images SSDV (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <string.h>
+#include <stdlib.h>
+
+#include <radio/ssdvcache.h>
+
+/* constants ================================================================ */
+#define LAST_ID_UNKNOWN 0xFFFF
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+static inline bool
+prvbHasPacket (const xSsdvSlot *s, unsigned id) {
+
+  return (s->bitmap[id / 32] & (1UL << (id % 32))) != 0;
+}
+
+// -----------------------------------------------------------------------------
+static inline uint8_t *
+prvpPacket (const xSsdvSlot *s, unsigned id) {
+
+  return s->packets + id * SSDV_PKT_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// Base 40 callsign used in the SSDV header
+static void
+prvvDecodeCallsign (char *call, uint32_t code) {
+  char *p = call;
+
+  if (code > 0xF423FFFF) {
+
+    // Invalid callsign
+    *p = 0;
+    return;
+  }
+  while ( (code) && (p < call + SSDV_CALL_LEN - 1)) {
+    uint8_t s = code % 40;
+
+    if (s == 0) {
+      *p++ = '-';
+    }
+    else if (s < 11) {
+      *p++ = '0' + s - 1;
+    }
+    else if (s < 14) {
+      *p++ = '-';
+    }
+    else {
+      *p++ = 'A' + s - 14;
+    }
+    code /= 40;
+  }
+  *p = 0;
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviFind (const xSsdvCache *c, uint32_t callsign, uint8_t image_id) {
+
+  for (unsigned i = 0; i < c->slots; i++) {
+    const xSsdvSlot *s = &c->slot[i];
+
+    if ( (s->used) && (s->callsign == callsign) && (s->image_id == image_id)) {
+
+      return i;
+    }
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Returns a free slot, or the least recently updated one
+static xSsdvSlot *
+prvxAllocate (xSsdvCache *c) {
+  xSsdvSlot *lru = &c->slot[0];
+
+  for (unsigned i = 0; i < c->slots; i++) {
+    xSsdvSlot *s = &c->slot[i];
+
+    if (!s->used) {
+
+      return s;
+    }
+    if (s->tick < lru->tick) {
+
+      lru = s;
+    }
+  }
+  if (!lru->complete) {
+
+    c->evicted++;
+  }
+  return lru;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvSlotInit (xSsdvCache *c, xSsdvSlot *s, const ssdv_packet_info_t *info) {
+
+  s->used = true;
+  s->complete = false;
+  s->callsign = info->callsign;
+  prvvDecodeCallsign (s->call, info->callsign);
+  s->image_id = info->image_id;
+  s->width = info->width;
+  s->height = info->height;
+  s->received = 0;
+  s->last_id = LAST_ID_UNKNOWN;
+  s->next_id = 0;
+  s->jpeg_len = 0;
+  memset (s->bitmap, 0, ( (c->max_packets + 31) / 32) * sizeof (uint32_t));
+  ssdv_dec_init (&s->dec);
+  ssdv_dec_set_buffer (&s->dec, s->jpeg, c->jpeg_size);
+}
+
+// -----------------------------------------------------------------------------
+// Feeds the progressive decoder with the packets following the last decoded
+static void
+prvvDecode (xSsdvCache *c, xSsdvSlot *s) {
+
+  while ( (s->next_id < c->max_packets) && prvbHasPacket (s, s->next_id)) {
+
+    ssdv_dec_feed (&s->dec, prvpPacket (s, s->next_id));
+    if (s->next_id == s->last_id) {
+      uint8_t *jpeg;
+
+      if (ssdv_dec_get_jpeg (&s->dec, &jpeg, &s->jpeg_len) == SSDV_OK) {
+
+        s->complete = true;
+      }
+      s->next_id++;
+      break;
+    }
+    s->next_id++;
+  }
+}
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xSsdvCache *
+xSsdvCacheNew (unsigned slots, unsigned max_packets, size_t jpeg_size) {
+  xSsdvCache *c;
+
+  if ( (slots == 0) || (max_packets == 0) || (max_packets > LAST_ID_UNKNOWN)) {
+
+    return NULL;
+  }
+
+  c = calloc (1, sizeof (xSsdvCache));
+  if (c) {
+
+    c->slots = slots;
+    c->max_packets = max_packets;
+    c->jpeg_size = jpeg_size;
+    c->slot = calloc (slots, sizeof (xSsdvSlot));
+    if (!c->slot) {
+
+      free (c);
+      return NULL;
+    }
+
+    for (unsigned i = 0; i < slots; i++) {
+      xSsdvSlot *s = &c->slot[i];
+
+      s->bitmap = calloc ( (max_packets + 31) / 32, sizeof (uint32_t));
+      s->packets = malloc (max_packets * SSDV_PKT_SIZE);
+      s->jpeg = malloc (jpeg_size);
+      if ( (!s->bitmap) || (!s->packets) || (!s->jpeg)) {
+
+        vSsdvCacheDelete (c);
+        return NULL;
+      }
+    }
+  }
+  return c;
+}
+
+// -----------------------------------------------------------------------------
+void
+vSsdvCacheDelete (xSsdvCache *c) {
+
+  if (c) {
+
+    for (unsigned i = 0; i < c->slots; i++) {
+
+      free (c->slot[i].bitmap);
+      free (c->slot[i].packets);
+      free (c->slot[i].jpeg);
+    }
+    free (c->slot);
+    free (c);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iSsdvCacheFeed (xSsdvCache *c, const uint8_t *packet) {
+  ssdv_packet_info_t info;
+  xSsdvSlot *s;
+  int i;
+
+  if ( (!c) || (!packet)) {
+
+    return TNC_OBJECT_NOT_FOUND;
+  }
+
+  ssdv_dec_header (&info, (uint8_t *) packet);
+  if (info.packet_id >= c->max_packets) {
+
+    return TNC_NOT_ENOUGH_MEMORY;
+  }
+
+  c->tick++;
+  i = prviFind (c, info.callsign, info.image_id);
+  if (i < 0) {
+
+    s = prvxAllocate (c);
+    prvvSlotInit (c, s, &info);
+  }
+  else {
+
+    s = &c->slot[i];
+  }
+  s->tick = c->tick;
+
+  if (prvbHasPacket (s, info.packet_id)) {
+
+    // Duplicate packet
+    return 0;
+  }
+  memcpy (prvpPacket (s, info.packet_id), packet, SSDV_PKT_SIZE);
+  s->bitmap[info.packet_id / 32] |= 1UL << (info.packet_id % 32);
+  s->received++;
+  if (info.eoi) {
+
+    s->last_id = info.packet_id;
+  }
+
+  prvvDecode (c, s);
+  return s->complete ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+const xSsdvSlot *
+xSsdvCacheFind (const xSsdvCache *c, uint32_t callsign, uint8_t image_id) {
+  int i;
+
+  if (!c) {
+
+    return NULL;
+  }
+  i = prviFind (c, callsign, image_id);
+  return (i < 0) ? NULL : &c->slot[i];
+}
+
+// -----------------------------------------------------------------------------
+int
+iSsdvCacheGetImage (xSsdvCache *c, uint32_t callsign, uint8_t image_id,
+                    uint8_t *buf, size_t size, size_t *len) {
+  const xSsdvSlot *s;
+  uint8_t *jpeg;
+  int i;
+
+  if ( (!c) || (!buf) || (!len)) {
+
+    return TNC_OBJECT_NOT_FOUND;
+  }
+  i = prviFind (c, callsign, image_id);
+  if (i < 0) {
+
+    return TNC_OBJECT_NOT_FOUND;
+  }
+  s = &c->slot[i];
+
+  if (s->complete) {
+
+    if (s->jpeg_len > size) {
+
+      return TNC_NOT_ENOUGH_MEMORY;
+    }
+    memcpy (buf, s->jpeg, s->jpeg_len);
+    *len = s->jpeg_len;
+    return 1;
+  }
+
+  // Partial image, decoded with the packets received so far
+  ssdv_dec_init (&c->scratch);
+  ssdv_dec_set_buffer (&c->scratch, buf, size);
+  for (unsigned id = 0; id < c->max_packets; id++) {
+
+    if (prvbHasPacket (s, id)) {
+
+      if (ssdv_dec_feed (&c->scratch, prvpPacket (s, id)) == SSDV_ERROR) {
+
+        return TNC_NOT_ENOUGH_MEMORY;
+      }
+    }
+  }
+  if (ssdv_dec_get_jpeg (&c->scratch, &jpeg, len) != SSDV_OK) {
+
+    return TNC_ILLEGAL_MSG;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+int
+iSsdvCacheRelease (xSsdvCache *c, uint32_t callsign, uint8_t image_id) {
+  int i;
+
+  if (!c) {
+
+    return TNC_OBJECT_NOT_FOUND;
+  }
+  i = prviFind (c, callsign, image_id);
+  if (i < 0) {
+
+    return TNC_OBJECT_NOT_FOUND;
+  }
+  c->slot[i].used = false;
+  return TNC_SUCCESS;
+}
+
+/* ========================================================================== */
@@ -7,11 +7,179 @@
  */
 #include <radio/tnc.hpp>
 #include <radio/tnc.h>
+#include <radio/aprs.h>
+#include <radio/ssdvcache.h>
 #include <ssdv/ssdv.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+
+//##############################################################################
+//#                                                                            #
+//#                           xTncWorkers Class                                #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+
+/*
+ * Message received by the poll thread, SSDV-length messages are checked and
+ * corrected by the workers, the others are ready as soon as they are queued.
+ */
+struct xTncJob {
+  std::vector<unsigned char> buf;
+  unsigned len;
+  bool done;
+  bool ssdv;
+  ssdv_packet_info_t info;
+};
+
+/*
+ * Ordered ring of messages: the poll thread queues at tail, the workers take
+ * the jobs at next and the results are delivered from head in arrival order.
+ */
+struct xTncWorkers {
+  std::vector<xTncJob> ring;
+  unsigned long head;
+  unsigned long next;
+  unsigned long tail;
+  bool stop;
+  std::mutex mutex;
+  std::condition_variable work;
+  std::condition_variable done;
+  std::vector<std::thread> threads;
+
+  xTncWorkers (unsigned depth, unsigned bufsize) :
+    ring (depth), head (0), next (0), tail (0), stop (false) {
+
+    for (unsigned i = 0; i < depth; i++) {
+      ring[i].buf.resize (bufsize);
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+static void
+prvvWorker (xTncWorkers *w) {
+  std::unique_lock<std::mutex> lock (w->mutex);
+
+  for (;;) {
+    w->work.wait (lock, [w] { return w->stop || (w->next != w->tail); });
+    if (w->stop) {
+      return;
+    }
+
+    xTncJob &job = w->ring[w->next++ % w->ring.size()];
+    if (job.done) {
+      continue;
+    }
+
+    // Reed-Solomon correction and header decoding out of the lock
+    lock.unlock();
+    int iError;
+    job.ssdv = (ssdv_dec_is_packet (job.buf.data(), &iError) == 0);
+    if (job.ssdv) {
+
+      ssdv_dec_header (&job.info, job.buf.data());
+    }
+    lock.lock();
+
+    job.done = true;
+    w->done.notify_all();
+  }
+}
+
+//##############################################################################
+//#                                                                            #
+//#                           xSsdvTx Class                                    #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+
+/*
+ * Packets encoded by the producer thread, consumed window by window by the
+ * transmitting thread. The store holds two windows so that the encoding of
+ * the next window overlaps the transmission of the current one.
+ */
+struct xSsdvTx {
+  std::vector<unsigned char> store;
+  unsigned window;
+  unsigned long produced;
+  unsigned long consumed;
+  bool done;
+  bool abort;
+  int error;
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  xSsdvTx (unsigned w) : store (2 * w * SSDV_PKT_SIZE), window (w),
+    produced (0), consumed (0), done (false), abort (false), error (0) {}
+
+  unsigned char * packet (unsigned long id) {
+    return &store[ (id % (2 * window)) * SSDV_PKT_SIZE];
+  }
+};
+
+// -----------------------------------------------------------------------------
+static void
+prvvSsdvEncoder (xSsdvTx *tx, const unsigned char *jpeg, unsigned len,
+                 const char *callsign, int imageId, int quality) {
+  ssdv_t ssdv;
+  char call[SSDV_CALL_LEN];
+  bool fed = false;
+  int error = 0;
+
+  strncpy (call, callsign, sizeof (call) - 1);
+  call[sizeof (call) - 1] = 0;
+  ssdv_enc_init (&ssdv, SSDV_TYPE_NORMAL, call, imageId, quality);
+
+  for (;;) {
+    unsigned char pkt[SSDV_PKT_SIZE];
+    char c;
+
+    ssdv_enc_set_buffer (&ssdv, pkt);
+    while ( (c = ssdv_enc_get_packet (&ssdv)) == SSDV_FEED_ME) {
+
+      if (fed) {
+        break;
+      }
+      // The whole image is in memory, it is given at once
+      ssdv_enc_feed (&ssdv, (unsigned char *) jpeg, len);
+      fed = true;
+    }
+
+    if (c != SSDV_OK) {
+
+      if (c != SSDV_EOI) {
+        error = Tnc::ILLEGAL_MSG;
+      }
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock (tx->mutex);
+    tx->cv.wait (lock, [tx] {
+      return tx->abort || (tx->produced - tx->consumed < 2 * tx->window);
+    });
+    if (tx->abort) {
+      return;
+    }
+    memcpy (tx->packet (tx->produced), pkt, SSDV_PKT_SIZE);
+    tx->produced++;
+    tx->cv.notify_all();
+  }
+
+  std::lock_guard<std::mutex> lock (tx->mutex);
+  tx->error = error;
+  tx->done = true;
+  tx->cv.notify_all();
+}
 
 //##############################################################################
 //#                                                                            #
@@ -22,16 +190,21 @@
 /* public  ================================================================== */
 
 // -----------------------------------------------------------------------------
-Tnc::Tnc (unsigned iRxBufferSize) : p (xTncNew (iRxBufferSize)), pkt_type (NO_PACKET) {
+Tnc::Tnc (unsigned iRxBufferSize) : p (xTncNew (iRxBufferSize)), pkt_type (NO_PACKET),
+  ssdv_callsign (0), ssdv_complete (false), ssdv_cache (0), workers (0) {
 
   rx_buf = new unsigned char[iRxBufferSize];
   rx_buf_size = iRxBufferSize;
+  aprs = new xAprs;
 }
 
 // -----------------------------------------------------------------------------
 Tnc::~Tnc () {
 
+  setSsdvWorkers (0);
   delete rx_buf;
+  delete aprs;
+  vSsdvCacheDelete (ssdv_cache);
   vTncDelete (p);
 }
 
@@ -63,46 +236,224 @@ Tnc::setFdin (int fd) {
 
 // -----------------------------------------------------------------------------
 int
-Tnc::poll() {
-  int state, rv = NO_PACKET;
+Tnc::setSsdvWorkers (unsigned count, unsigned depth) {
+
+  if (workers) {
 
-  state = iTncPoll (p);
-  if (state == TNC_EOT) {
+    // The messages queued and not yet delivered by poll() are lost
+    {
+      std::lock_guard<std::mutex> lock (workers->mutex);
+      workers->stop = true;
+    }
+    workers->work.notify_all();
+    for (auto &t : workers->threads) {
+      t.join();
+    }
+    delete workers;
+    workers = 0;
+  }
+
+  if (count) {
+
+    try {
+      workers = new xTncWorkers (depth ? depth : 1, rx_buf_size);
+      for (unsigned i = 0; i < count; i++) {
+
+        workers->threads.push_back (std::thread (prvvWorker, workers));
+      }
+    }
+    catch (std::exception &e) {
+
+      fprintf (stderr, "Unable to start the SSDV workers: %s\n", e.what());
+      setSsdvWorkers (0);
+      return NOT_ENOUGH_MEMORY;
+    }
+  }
+  return SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::pollWorkers (bool timed, int timeoutMs) {
+  xTncWorkers *w = workers;
+  std::unique_lock<std::mutex> lock (w->mutex);
+  auto ready = [w] {
+    return (w->head != w->tail) && w->ring[w->head % w->ring.size()].done;
+  };
+
+  if (ready()) {
+
+    // The oldest message is already checked, the input is not read
+  }
+  else if (w->tail - w->head == w->ring.size()) {
+
+    // The ring is full, waits for the oldest message
+    w->done.wait (lock, ready);
+  }
+  else {
+    bool pending = (w->head != w->tail);
+
+    // While a message is checked, only the bytes already available are
+    // decoded: no input event would signal the end of the check
+    lock.unlock();
+    int eot = (pending ? pollInput (true, 0) : pollInput (timed, timeoutMs)) == TNC_EOT;
+    lock.lock();
+
+    if (eot) {
+      xTncJob &job = w->ring[w->tail % w->ring.size()];
+
+      memcpy (job.buf.data(), p->rxbuf, p->len);
+      job.len = p->len;
+      job.ssdv = false;
+      job.done = (p->len != SSDV_PKT_SIZE);
+      memset (&job.info, 0, sizeof (job.info));
+      w->tail++;
+      w->work.notify_one();
+    }
+
+    if (pending) {
+
+      if ( (timed) && (timeoutMs >= 0)) {
+
+        w->done.wait_for (lock, std::chrono::milliseconds (timeoutMs), ready);
+      }
+      else {
+
+        w->done.wait (lock, ready);
+      }
+    }
+  }
+
+  // Messages already checked are delivered even if nothing was received
+
+  if ( (w->head == w->tail) || !w->ring[w->head % w->ring.size()].done) {
+
+    return NO_PACKET;
+  }
+
+  // The oldest message is delivered, its slot is only reused by this thread
+  xTncJob &job = w->ring[w->head++ % w->ring.size()];
+  lock.unlock();
+
+  memcpy (rx_buf, job.buf.data(), job.len);
+  rx_len = job.len;
+  return received (job.ssdv, job.info.image_id, job.info.packet_id, job.info.callsign);
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::pollInput (bool timed, int timeoutMs) {
+
+  return timed ? iTncPollTimeout (p, timeoutMs) : iTncPoll (p);
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::pollMessage (bool timed, int timeoutMs) {
+
+  if (workers) {
+
+    return pollWorkers (timed, timeoutMs);
+  }
+
+  if (pollInput (timed, timeoutMs) == TNC_EOT) {
+    ssdv_packet_info_t xPktInfo;
+    int iError;
 
     memcpy (rx_buf, p->rxbuf, p->len);
     rx_len = p->len;
 
-    if (rx_len == SSDV_PKT_SIZE) {
-      int iError;
+    // Le paquet a la longueur d'un paquet SSDV
+    if ( (rx_len == SSDV_PKT_SIZE) && (ssdv_dec_is_packet (rx_buf, &iError) == 0)) {
+
+      ssdv_dec_header (&xPktInfo, rx_buf);
+      return received (true, xPktInfo.image_id, xPktInfo.packet_id, xPktInfo.callsign);
+    }
+    return received (false, 0, 0, 0);
+  }
+  return NO_PACKET;
+}
+
+// -----------------------------------------------------------------------------
+// Message already received, without waiting for the input. The messages
+// rejected are skipped and the messages checked by the workers are waited,
+// since no input event will signal them.
+int
+Tnc::pollReady() {
+  int rv;
 
-      // Le paquet a la longueur d'un paquet SSDV
-      if (ssdv_dec_is_packet (rx_buf, &iError) == 0) {
-        ssdv_packet_info_t xPktInfo;
+  for (;;) {
+    bool pending;
 
-        // C'est un paquet SSDV
-        ssdv_dec_header (&xPktInfo, rx_buf);
-        ssdv_image_id = (unsigned int) xPktInfo.image_id;
-        ssdv_packet_id = (unsigned int) xPktInfo.packet_id;
-        rv = SSDV_PACKET;
-        pkt_type = (ePacketType) rv;
-      }
+    rv = pollMessage (true, 0);
+    if (rv != NO_PACKET) {
+      break;
     }
-    else {
+    pending = (p->stage_pos < p->stage_len);
+    if ( (!pending) && (workers)) {
+      std::lock_guard<std::mutex> lock (workers->mutex);
 
-      if ( (rx_buf[0] == '@') || (rx_buf[0] == '/')) {
+      pending = (workers->head != workers->tail);
+    }
+    if (!pending) {
+      break;
+    }
+  }
+  return rv;
+}
 
-        // C'est un paquet APRS
-        if (rx_len < rx_buf_size) {
+// -----------------------------------------------------------------------------
+int
+Tnc::poll() {
 
-          rv = APRS_PACKET;
-          pkt_type = (ePacketType) rv;
-          rx_buf[rx_len] = 0;
-          //printf("APRS Packet: %s\n", rx_buf);
-        }
-        else {
+  return pollMessage (false, 0);
+}
 
-          fprintf (stderr, "APRS packet too long, maximum length = %d\n", rx_buf_size - 1);
-        }
+// -----------------------------------------------------------------------------
+int
+Tnc::pollTimeout (int timeoutMs) {
+
+  return pollMessage (true, timeoutMs);
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::received (bool ssdv, int image_id, int packet_id, unsigned long callsign) {
+  int rv = NO_PACKET;
+
+  pkt_type = NO_PACKET;
+  if (ssdv) {
+
+    // C'est un paquet SSDV
+    ssdv_image_id = image_id;
+    ssdv_packet_id = packet_id;
+    ssdv_callsign = callsign;
+    if (ssdv_cache) {
+
+      // Le paquet est ajouté à l'image en cours de réassemblage
+      ssdv_complete = (iSsdvCacheFeed (ssdv_cache, rx_buf) > 0);
+    }
+    rv = SSDV_PACKET;
+    pkt_type = (ePacketType) rv;
+  }
+  else if (rx_len != SSDV_PKT_SIZE) {
+
+    if ( (rx_buf[0] == '@') || (rx_buf[0] == '/')) {
+
+      // C'est un paquet APRS
+      if (rx_len < rx_buf_size) {
+
+        rv = APRS_PACKET;
+        pkt_type = (ePacketType) rv;
+        // The destination address is not transmitted, Mic-E can not be
+        // decoded, aprs->type is APRS_UNKNOWN if the decoding fails
+        (void) iAprsParse (aprs, NULL, rx_buf, rx_len);
+        rx_buf[rx_len] = 0;
+        //printf("APRS Packet: %s\n", rx_buf);
+      }
+      else {
+
+        fprintf (stderr, "APRS packet too long, maximum length = %d\n", rx_buf_size - 1);
       }
     }
   }
@@ -116,6 +467,13 @@ Tnc::getPacketType() const {
   return (int) pkt_type;
 }
 
+// -----------------------------------------------------------------------------
+const struct xAprs *
+Tnc::getAprs() const {
+
+  return ( (pkt_type == APRS_PACKET) && (aprs->type != APRS_UNKNOWN)) ? aprs : 0;
+}
+
 // -----------------------------------------------------------------------------
 int
 Tnc::getSsdvImageId() const {
@@ -130,6 +488,146 @@ Tnc::getSsdvPacketId() const {
   return ssdv_packet_id;
 }
 
+// -----------------------------------------------------------------------------
+unsigned long
+Tnc::getSsdvCallsign() const {
+
+  return ssdv_callsign;
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::enableSsdvCache (unsigned slots, unsigned maxPackets, unsigned jpegSize) {
+
+  vSsdvCacheDelete (ssdv_cache);
+  ssdv_cache = xSsdvCacheNew (slots, maxPackets, jpegSize);
+  return ssdv_cache ? SUCCESS : NOT_ENOUGH_MEMORY;
+}
+
+// -----------------------------------------------------------------------------
+bool
+Tnc::isSsdvImageComplete() const {
+
+  return ssdv_complete;
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::getSsdvImage (void *buf, unsigned size) {
+
+  return getSsdvImage (ssdv_callsign, ssdv_image_id, buf, size);
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::getSsdvImage (unsigned long callsign, int imageId, void *buf, unsigned size) {
+  size_t len;
+  int ret;
+
+  if (!ssdv_cache) {
+
+    return OBJECT_NOT_FOUND;
+  }
+  ret = iSsdvCacheGetImage (ssdv_cache, callsign, imageId, (uint8_t *) buf, size, &len);
+  return (ret < 0) ? ret : (int) len;
+}
+
+// -----------------------------------------------------------------------------
+int
+Tnc::writeSsdvImage (const void *jpeg, unsigned len, const char *callsign,
+                     int imageId, int quality, unsigned interleave,
+                     unsigned headerRepeat, unsigned batch) {
+  std::vector<unsigned char> out;
+  unsigned char first[SSDV_PKT_SIZE];
+  unsigned long sent = 0;
+  int ret = SUCCESS;
+
+  if ( (!jpeg) || (!callsign)) {
+
+    return OBJECT_NOT_FOUND;
+  }
+  interleave = (interleave == 0) ? 1 : interleave;
+  batch = (batch == 0) ? 1 : batch;
+
+  try {
+    // A window is made of interleave batches, each batch takes one packet
+    // out of interleave in the window
+    xSsdvTx tx (interleave * batch);
+    out.resize (batch * SSDV_PKT_SIZE);
+    std::thread encoder (prvvSsdvEncoder, &tx, (const unsigned char *) jpeg,
+                         len, callsign, imageId, quality);
+
+    for (;;) {
+      unsigned long base;
+      unsigned n;
+
+      {
+        std::unique_lock<std::mutex> lock (tx.mutex);
+        tx.cv.wait (lock, [&tx] {
+          return tx.done || (tx.produced - tx.consumed >= tx.window);
+        });
+        base = tx.consumed;
+        n = std::min<unsigned long> (tx.produced - tx.consumed, tx.window);
+      }
+      if (n == 0) {
+        break;
+      }
+
+      if (base == 0) {
+        memcpy (first, tx.packet (0), SSDV_PKT_SIZE);
+      }
+
+      // The window is sent in stride order, consecutive packets are
+      // transmitted one batch apart
+      for (unsigned col = 0; (col < interleave) && (ret == SUCCESS); col++) {
+        unsigned count = 0;
+
+        for (unsigned i = col; i < n; i += interleave) {
+
+          memcpy (&out[count++ * SSDV_PKT_SIZE], tx.packet (base + i), SSDV_PKT_SIZE);
+        }
+        if ( (count) && (iTncWriteBatch (p, out.data(), SSDV_PKT_SIZE, count) < 0)) {
+
+          ret = IO_ERROR;
+        }
+        sent += count;
+      }
+
+      // One copy of the first packet is inserted after each window
+      if ( (ret == SUCCESS) && (headerRepeat)) {
+
+        if (iTncWriteBatch (p, first, SSDV_PKT_SIZE, 1) < 0) {
+
+          ret = IO_ERROR;
+        }
+        headerRepeat--;
+        sent++;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock (tx.mutex);
+        tx.consumed += n;
+        tx.abort = (ret != SUCCESS);
+        tx.cv.notify_all();
+      }
+      if (ret != SUCCESS) {
+        break;
+      }
+    }
+
+    encoder.join();
+    if ( (ret == SUCCESS) && (tx.error)) {
+      ret = tx.error;
+    }
+  }
+  catch (std::exception &e) {
+
+    ret = NOT_ENOUGH_MEMORY;
+  }
+
+  return (ret == SUCCESS) ? (int) sent : ret;
+}
+
 // -----------------------------------------------------------------------------
 int
 Tnc::getRxlen() {
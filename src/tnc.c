@@ -13,9 +13,18 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <termios.h>
+#include <poll.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include <radio/tnc.h>
 #include <radio/crc.h>
+#include <radio/capture.h>
 
 //##############################################################################
 //#                                                                            #
@@ -55,6 +64,600 @@ prviError (int iError) {
   return iError;
 }
 
+//##############################################################################
+//#                                                                            #
+//#                        Hexadecimal conversion                              #
+//#                                                                            #
+//##############################################################################
+
+/* private ================================================================== */
+static const char cHex[] = "0123456789ABCDEF";
+
+// -----------------------------------------------------------------------------
+static
+uint8_t
+htoi (uint8_t c) {
+
+  c = toupper (c);
+  if (!isdigit (c)) {
+    c -= 7;
+  }
+  return c - '0';
+}
+
+// -----------------------------------------------------------------------------
+// Encodes the n bytes of b in 2n uppercase hexadecimal characters
+static void
+prvvHexEncodeScalar (uint8_t *hex, const uint8_t *b, size_t n) {
+
+  for (size_t i = 0; i < n; i++) {
+
+    hex[2 * i] = cHex[b[i] >> 4];
+    hex[2 * i + 1] = cHex[b[i] & 0x0F];
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Decodes up to n pairs of hexadecimal characters of hex in b, returns the
+// number of pairs decoded before the first character which is not hexadecimal
+static size_t
+prvuHexDecodeScalar (uint8_t *b, const uint8_t *hex, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+
+    if ( (!isxdigit (hex[2 * i])) || (!isxdigit (hex[2 * i + 1]))) {
+      break;
+    }
+    b[i] = (htoi (hex[2 * i]) << 4) + htoi (hex[2 * i + 1]);
+  }
+  return i;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// -----------------------------------------------------------------------------
+// Values of the 16 characters of v, *valid is the mask of the characters
+// which are hexadecimal
+__attribute__ ( (target ("ssse3"))) static inline __m128i
+prvxHexValSsse3 (__m128i v, unsigned *valid) {
+  __m128i lower = _mm_or_si128 (v, _mm_set1_epi8 (0x20));
+  __m128i digit = _mm_and_si128 (_mm_cmpgt_epi8 (v, _mm_set1_epi8 ('0' - 1)),
+                                 _mm_cmpgt_epi8 (_mm_set1_epi8 ('9' + 1), v));
+  __m128i letter = _mm_and_si128 (_mm_cmpgt_epi8 (lower, _mm_set1_epi8 ('a' - 1)),
+                                  _mm_cmpgt_epi8 (_mm_set1_epi8 ('f' + 1), lower));
+
+  *valid = _mm_movemask_epi8 (_mm_or_si128 (digit, letter));
+  return _mm_or_si128 (_mm_and_si128 (digit, _mm_sub_epi8 (v, _mm_set1_epi8 ('0'))),
+                       _mm_and_si128 (letter, _mm_sub_epi8 (lower, _mm_set1_epi8 ('a' - 10))));
+}
+
+// -----------------------------------------------------------------------------
+__attribute__ ( (target ("ssse3"))) static void
+prvvHexEncodeSsse3 (uint8_t *hex, const uint8_t *b, size_t n) {
+  const __m128i lut = _mm_loadu_si128 ( (const __m128i *) cHex);
+  const __m128i low = _mm_set1_epi8 (0x0F);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128 ( (const __m128i *) &b[i]);
+    __m128i hi = _mm_and_si128 (_mm_srli_epi16 (v, 4), low);
+    __m128i lo = _mm_and_si128 (v, low);
+
+    _mm_storeu_si128 ( (__m128i *) &hex[2 * i],
+                       _mm_shuffle_epi8 (lut, _mm_unpacklo_epi8 (hi, lo)));
+    _mm_storeu_si128 ( (__m128i *) &hex[2 * i + 16],
+                       _mm_shuffle_epi8 (lut, _mm_unpackhi_epi8 (hi, lo)));
+  }
+  prvvHexEncodeScalar (&hex[2 * i], &b[i], n - i);
+}
+
+// -----------------------------------------------------------------------------
+__attribute__ ( (target ("ssse3"))) static size_t
+prvuHexDecodeSsse3 (uint8_t *b, const uint8_t *hex, size_t n) {
+  // Weights of the characters of a pair: 16 for the first, 1 for the second
+  const __m128i weight = _mm_set1_epi16 (0x0110);
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    unsigned valid;
+    __m128i v = prvxHexValSsse3 (_mm_loadu_si128 ( (const __m128i *) &hex[2 * i]), &valid);
+
+    if (valid != 0xFFFF) {
+      break;
+    }
+    v = _mm_maddubs_epi16 (v, weight);
+    _mm_storel_epi64 ( (__m128i *) &b[i], _mm_packus_epi16 (v, v));
+  }
+  return i + prvuHexDecodeScalar (&b[i], &hex[2 * i], n - i);
+}
+
+// -----------------------------------------------------------------------------
+__attribute__ ( (target ("avx2"))) static void
+prvvHexEncodeAvx2 (uint8_t *hex, const uint8_t *b, size_t n) {
+  const __m256i lut = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ( (const __m128i *) cHex));
+  const __m256i low = _mm256_set1_epi16 (0x0F);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    // One byte per 16-bit word, its high nibble is stored first
+    __m256i v = _mm256_cvtepu8_epi16 (_mm_loadu_si128 ( (const __m128i *) &b[i]));
+    __m256i nib = _mm256_or_si256 (_mm256_and_si256 (_mm256_srli_epi16 (v, 4), low),
+                                   _mm256_slli_epi16 (_mm256_and_si256 (v, low), 8));
+
+    _mm256_storeu_si256 ( (__m256i *) &hex[2 * i], _mm256_shuffle_epi8 (lut, nib));
+  }
+  prvvHexEncodeScalar (&hex[2 * i], &b[i], n - i);
+}
+
+// -----------------------------------------------------------------------------
+__attribute__ ( (target ("avx2"))) static size_t
+prvuHexDecodeAvx2 (uint8_t *b, const uint8_t *hex, size_t n) {
+  const __m256i weight = _mm256_set1_epi16 (0x0110);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256 ( (const __m256i *) &hex[2 * i]);
+    __m256i lower = _mm256_or_si256 (v, _mm256_set1_epi8 (0x20));
+    __m256i digit = _mm256_and_si256 (_mm256_cmpgt_epi8 (v, _mm256_set1_epi8 ('0' - 1)),
+                                      _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('9' + 1), v));
+    __m256i letter = _mm256_and_si256 (_mm256_cmpgt_epi8 (lower, _mm256_set1_epi8 ('a' - 1)),
+                                       _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('f' + 1), lower));
+
+    if ( (unsigned) _mm256_movemask_epi8 (_mm256_or_si256 (digit, letter)) != 0xFFFFFFFFU) {
+      break;
+    }
+    v = _mm256_or_si256 (_mm256_and_si256 (digit, _mm256_sub_epi8 (v, _mm256_set1_epi8 ('0'))),
+                         _mm256_and_si256 (letter, _mm256_sub_epi8 (lower, _mm256_set1_epi8 ('a' - 10))));
+    v = _mm256_maddubs_epi16 (v, weight);
+    // The packing is done in each 128-bit lane, the 2 lower quarters are kept
+    v = _mm256_permute4x64_epi64 (_mm256_packus_epi16 (v, v), 0xD8);
+    _mm_storeu_si128 ( (__m128i *) &b[i], _mm256_castsi256_si128 (v));
+  }
+  return i + prvuHexDecodeSsse3 (&b[i], &hex[2 * i], n - i);
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+// -----------------------------------------------------------------------------
+// Values of the 16 characters of v, *valid is true if all are hexadecimal
+static inline uint8x16_t
+prvxHexValNeon (uint8x16_t v, bool *valid) {
+  uint8x16_t lower = vorrq_u8 (v, vdupq_n_u8 (0x20));
+  uint8x16_t digit = vsubq_u8 (v, vdupq_n_u8 ('0'));
+  uint8x16_t letter = vsubq_u8 (lower, vdupq_n_u8 ('a'));
+  uint8x16_t isdigit = vcltq_u8 (digit, vdupq_n_u8 (10));
+  uint8x16_t isletter = vcltq_u8 (letter, vdupq_n_u8 (6));
+
+  *valid = (vminvq_u8 (vorrq_u8 (isdigit, isletter)) == 0xFF);
+  return vbslq_u8 (isdigit, digit, vaddq_u8 (letter, vdupq_n_u8 (10)));
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvHexEncodeNeon (uint8_t *hex, const uint8_t *b, size_t n) {
+  const uint8x16_t lut = vld1q_u8 ( (const uint8_t *) cHex);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t v = vld1q_u8 (&b[i]);
+    uint8x16x2_t out;
+
+    out.val[0] = vqtbl1q_u8 (lut, vshrq_n_u8 (v, 4));
+    out.val[1] = vqtbl1q_u8 (lut, vandq_u8 (v, vdupq_n_u8 (0x0F)));
+    // The high and low nibbles are interleaved by the store
+    vst2q_u8 (&hex[2 * i], out);
+  }
+  prvvHexEncodeScalar (&hex[2 * i], &b[i], n - i);
+}
+
+// -----------------------------------------------------------------------------
+static size_t
+prvuHexDecodeNeon (uint8_t *b, const uint8_t *hex, size_t n) {
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    // The first and second characters of the pairs are split by the load
+    uint8x16x2_t v = vld2q_u8 (&hex[2 * i]);
+    bool vhi, vlo;
+    uint8x16_t hi = prvxHexValNeon (v.val[0], &vhi);
+    uint8x16_t lo = prvxHexValNeon (v.val[1], &vlo);
+
+    if ( (!vhi) || (!vlo)) {
+      break;
+    }
+    vst1q_u8 (&b[i], vorrq_u8 (vshlq_n_u8 (hi, 4), lo));
+  }
+  return i + prvuHexDecodeScalar (&b[i], &hex[2 * i], n - i);
+}
+#endif
+
+static void prvvHexEncodeInit (uint8_t *hex, const uint8_t *b, size_t n);
+static size_t prvuHexDecodeInit (uint8_t *b, const uint8_t *hex, size_t n);
+
+// Kernels chosen for the processor at the first call
+static void (*prvvHexEncode) (uint8_t *hex, const uint8_t *b, size_t n) = prvvHexEncodeInit;
+static size_t (*prvuHexDecode) (uint8_t *b, const uint8_t *hex, size_t n) = prvuHexDecodeInit;
+
+// -----------------------------------------------------------------------------
+static void
+prvvHexInit (void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports ("avx2")) {
+
+    prvvHexEncode = prvvHexEncodeAvx2;
+    prvuHexDecode = prvuHexDecodeAvx2;
+    return;
+  }
+  if (__builtin_cpu_supports ("ssse3")) {
+
+    prvvHexEncode = prvvHexEncodeSsse3;
+    prvuHexDecode = prvuHexDecodeSsse3;
+    return;
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  prvvHexEncode = prvvHexEncodeNeon;
+  prvuHexDecode = prvuHexDecodeNeon;
+  return;
+#endif
+  prvvHexEncode = prvvHexEncodeScalar;
+  prvuHexDecode = prvuHexDecodeScalar;
+}
+
+// -----------------------------------------------------------------------------
+static void
+prvvHexEncodeInit (uint8_t *hex, const uint8_t *b, size_t n) {
+
+  prvvHexInit();
+  prvvHexEncode (hex, b, n);
+}
+
+// -----------------------------------------------------------------------------
+static size_t
+prvuHexDecodeInit (uint8_t *b, const uint8_t *hex, size_t n) {
+
+  prvvHexInit();
+  return prvuHexDecode (b, hex, n);
+}
+
+//##############################################################################
+//#                                                                            #
+//#                           xTncDecoder Class                                #
+//#                                                                            #
+//##############################################################################
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xTncDecoder *
+xTncDecoderNew (size_t iBufferSize) {
+  xTncDecoder *d = malloc (sizeof (xTncDecoder));
+
+  if (d) {
+    uint8_t *buf = malloc (iBufferSize);
+
+    if (!buf) {
+
+      free (d);
+      return NULL;
+    }
+    iTncDecoderInit (d, buf, iBufferSize);
+  }
+  return d;
+}
+
+// -----------------------------------------------------------------------------
+void
+vTncDecoderDelete (xTncDecoder *d) {
+
+  if (d) {
+
+    free (d->buf);
+    free (d);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncDecoderInit (xTncDecoder *d, uint8_t *buf, size_t size) {
+
+  if (!d) {
+
+    return prviError (TNC_OBJECT_NOT_FOUND);
+  }
+  d->buf = buf;
+  d->size = buf ? size : 0;
+  return iTncDecoderClear (d);
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncDecoderClear (xTncDecoder *d) {
+
+  if (!d) {
+
+    return prviError (TNC_OBJECT_NOT_FOUND);
+  }
+  d->len = 0;
+  d->crc_rx = CRC_CCITT_INIT_VAL;
+  d->crc_tx = 0;
+  d->state = 0;
+  d->cnt = 0;
+  d->msb = 0;
+  return TNC_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncDecoderFeed (xTncDecoder *d, const void *buffer, size_t len, size_t *used) {
+  const uint8_t *buf = (const uint8_t *) buffer;
+  size_t i = 0;
+
+  if ( (!d) || ( (!buf) && (len))) {
+
+    if (used) {
+
+      *used = 0;
+    }
+    return prviError (TNC_OBJECT_NOT_FOUND);
+  }
+
+  // The message received by the previous call is released
+  if (d->state == TNC_EOT) {
+    d->state = 0;
+  }
+
+  while ( (i < len) && (d->state != TNC_EOT)) {
+    uint8_t c;
+
+    if ( (d->state == TNC_STX) && ! (d->cnt & 1)) {
+      size_t n = MIN ( (len - i) / 2, d->size - d->len);
+
+      // The pairs of digits up to the next other character are decoded at once
+      if ( (n = prvuHexDecode (&d->buf[d->len], &buf[i], n)) > 0) {
+
+        d->crc_rx = usCrcCcitt (d->crc_rx, &buf[i], 2 * n);
+        d->len += n;
+        i += 2 * n;
+        if (i == len) {
+          break;
+        }
+      }
+    }
+
+    c = buf[i++];
+
+    switch (c) {
+
+      case TNC_SOH:
+        d->crc_rx = CRC_CCITT_INIT_VAL;
+        d->state = TNC_SOH;
+        d->len = 0;
+        break;
+
+      case TNC_STX:
+        if (d->state == TNC_SOH) {
+
+          d->cnt = 0;
+          d->state = TNC_STX;
+        }
+        else {
+          d->state = 0;
+        }
+        break;
+
+      case TNC_ETX:
+        if (d->state == TNC_STX) {
+
+          d->cnt = 0;
+          d->crc_tx = 0;
+          d->state = TNC_ETX;
+        }
+        else {
+          d->state = 0;
+        }
+        break;
+
+      case TNC_EOT:
+        if (d->state == TNC_ETX) {
+
+          d->state = TNC_EOT;
+        }
+        else {
+          d->state = 0;
+        }
+        break;
+
+      default:
+        if (isxdigit (c)) {
+
+          // Digit hexa
+          switch (d->state) {
+
+            case TNC_STX:
+              d->crc_rx = usCrcCcittUpdate (c, d->crc_rx);
+              if (d->cnt++ & 1) {
+                // LSB
+                d->buf[d->len++] = d->msb + htoi (c);
+              }
+              else if (d->len < d->size) {
+                // MSB
+                d->msb = htoi (c) << 4;
+              }
+              else {
+
+                // Message plus long que le buffer, on l'ignore
+                d->state = TNC_ILLEGAL_MSG;
+              }
+              break;
+
+            case TNC_ETX:
+              if (d->cnt <= 12) {
+
+                d->crc_tx += ( (uint16_t) htoi (c)) << (12 - d->cnt);
+                d->cnt += 4;
+              }
+              else {
+
+                // Plus de 4 octets de CRC reçu
+                d->state = TNC_ILLEGAL_MSG;
+              }
+              break;
+
+            default:
+              // Digit hexa en dehors d'une trame, on ignore
+              d->state = 0;
+              break;
+          }
+        }
+        break;
+
+    }
+  }
+  if (used) {
+
+    *used = i;
+  }
+  if ( (d->state == TNC_EOT) && (d->crc_rx != d->crc_tx)) {
+
+    return TNC_CRC_ERROR;
+  }
+  return d->state;
+}
+
+//##############################################################################
+//#                                                                            #
+//#                           xTncEncoder Class                                #
+//#                                                                            #
+//##############################################################################
+
+/* public  ================================================================== */
+
+// -----------------------------------------------------------------------------
+xTncEncoder *
+xTncEncoderNew (void) {
+  xTncEncoder *e = malloc (sizeof (xTncEncoder));
+
+  if (e) {
+
+    iTncEncoderClear (e);
+  }
+  return e;
+}
+
+// -----------------------------------------------------------------------------
+void
+vTncEncoderDelete (xTncEncoder *e) {
+
+  free (e);
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncEncoderClear (xTncEncoder *e) {
+
+  if (!e) {
+
+    return prviError (TNC_OBJECT_NOT_FOUND);
+  }
+  memset (e, 0, sizeof (xTncEncoder));
+  return TNC_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncEncoderSetMsg (xTncEncoder *e, const void *buf, size_t count) {
+
+  if ( (!e) || ( (!buf) && (count))) {
+
+    return prviError (TNC_OBJECT_NOT_FOUND);
+  }
+  e->msg = (const uint8_t *) buf;
+  e->count = count;
+  e->pos = 0;
+  e->size = TNC_MSG_SIZE (count);
+  e->crc = CRC_CCITT_INIT_VAL;
+  return TNC_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+size_t
+uTncEncoderSize (const xTncEncoder *e) {
+
+  return (e) ? e->size - e->pos : 0;
+}
+
+// -----------------------------------------------------------------------------
+size_t
+uTncEncoderRead (xTncEncoder *e, void *out, size_t size) {
+  uint8_t *o = (uint8_t *) out;
+  size_t n = 0, txt;
+
+  if ( (!e) || (!out)) {
+
+    return 0;
+  }
+  // Index of ETX in the encoded message
+  txt = 2 + 2 * e->count;
+
+  while ( (n < size) && (e->pos < e->size)) {
+    size_t pos = e->pos;
+
+    if ( (pos >= 2) && (pos < txt)) {
+
+      if (! (pos & 1)) {
+        size_t k = MIN ( (txt - pos) / 2, (size - n) / 2);
+
+        // Whole bytes are converted at once
+        if (k) {
+
+          prvvHexEncode (&o[n], &e->msg[ (pos - 2) >> 1], k);
+          e->crc = usCrcCcitt (e->crc, &o[n], 2 * k);
+          n += 2 * k;
+          pos += 2 * k;
+        }
+      }
+
+      // TXT: the CRC is computed on the characters as they are produced
+      while ( (n < size) && (pos < txt)) {
+        uint8_t b = e->msg[ (pos - 2) >> 1];
+        uint8_t c = cHex[ (pos & 1) ? b & 0x0F : b >> 4];
+
+        e->crc = usCrcCcittUpdate (c, e->crc);
+        o[n++] = c;
+        pos++;
+      }
+      e->pos = pos;
+      continue;
+    }
+
+    if (pos == 0) {
+
+      o[n] = TNC_SOH;
+    }
+    else if (pos == 1) {
+
+      o[n] = TNC_STX;
+    }
+    else if (pos == txt) {
+
+      o[n] = TNC_ETX;
+    }
+    else if (pos < txt + 5) {
+
+      o[n] = cHex[ (e->crc >> (12 - 4 * (pos - txt - 1))) & 0x0F];
+    }
+    else {
+
+      o[n] = TNC_EOT;
+    }
+    n++;
+    e->pos++;
+  }
+  return n;
+}
+
 //##############################################################################
 //#                                                                            #
 //#                             xTnc Class                                    #
@@ -91,20 +694,37 @@ prvxOpenFile (int fd, int mode) {
 }
 
 // -----------------------------------------------------------------------------
-static
-uint8_t
-htoi (uint8_t c) {
+static int
+prviWriteAll (xTnc *p, const uint8_t *buf, size_t len) {
 
-  c = toupper (c);
-  if (!isdigit (c)) {
-    c -= 7;
+  while (len) {
+    ssize_t i = write (p->fout, buf, len);
+
+    if (i < 0) {
+
+      perror ("write: ");
+      return prviSetError (p, TNC_IO_ERROR);
+    }
+    buf += i;
+    len -= i;
   }
-  return c - '0';
+  return TNC_SUCCESS;
 }
 
-
 /* public  ================================================================== */
 
+// -----------------------------------------------------------------------------
+size_t
+uTncEncode (uint8_t *msg, const void *buf, size_t count) {
+  xTncEncoder e;
+
+  if (iTncEncoderSetMsg (&e, buf, count) != TNC_SUCCESS) {
+
+    return 0;
+  }
+  return uTncEncoderRead (&e, msg, e.size);
+}
+
 // -----------------------------------------------------------------------------
 xTnc *
 xTncNew (size_t iRxBufferSize) {
@@ -120,6 +740,10 @@ xTncNew (size_t iRxBufferSize) {
       free (p);
       p = 0;
     }
+    else {
+
+      iTncDecoderInit (&p->dec, p->rxbuf, iRxBufferSize);
+    }
   }
   return p;
 }
@@ -140,7 +764,7 @@ int iTncClear (xTnc *p) {
     return prviError (TNC_OBJECT_NOT_FOUND);
   }
   memset (p, 0, sizeof (xTnc));
-  p->crc_rx  = CRC_CCITT_INIT_VAL;
+  iTncDecoderClear (&p->dec);
   p->fin = -1;
   p->fout = -1;
 
@@ -187,133 +811,268 @@ iTncSetFdout (xTnc *p, int fd) {
 
 // -----------------------------------------------------------------------------
 int
-iTncPoll (xTnc *p) {
+iTncSetCapture (xTnc *p, xCapture *capture, uint16_t port) {
 
   if (!p) {
 
     return prviSetError (p, TNC_OBJECT_NOT_FOUND);
   }
-  else {
+  p->capture = capture;
+  p->port = port;
+
+  return prviSetError (p, TNC_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncSetRxHandler (xTnc *p, vTncRxHandler handler, void *ctx) {
+
+  if (!p) {
+
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
+  p->rx_handler = handler;
+  p->rx_ctx = ctx;
+
+  return prviSetError (p, TNC_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the bytes of buf until a message is received, *used is set to the
+// number of bytes used. With a handler, the messages are given to it and all
+// the bytes are decoded
+static int
+prviDecodeBuf (xTnc *p, const uint8_t *buf, size_t len, size_t *used) {
+  size_t i = 0;
+  unsigned long msgs = p->rx_msgs;
+  int ret;
 
-    if (p->state == TNC_EOT) {
-      p->state = 0;
+  for (;;) {
+    size_t n;
+
+    ret = iTncDecoderFeed (&p->dec, &buf[i], len - i, &n);
+    i += n;
+    if ( (ret != TNC_EOT) && (ret != TNC_CRC_ERROR)) {
+
+      break;
+    }
+
+    p->len = p->dec.len;
+    if ( (p->capture) && (p->len) && (ret == TNC_EOT)) {
+
+      (void) iCaptureWrite (p->capture, p->port, p->rxbuf, p->len);
+    }
+    if (!p->rx_handler) {
+
+      break;
     }
 
-    if (p->fin < 0) {
+    // The message is given in place, the decoding goes on
+    if (ret == TNC_EOT) {
 
-      return prviSetError (p, TNC_FILE_NOT_FOUND);
+      p->rx_msgs++;
+      p->rx_handler (p, p->rxbuf, p->len, p->rx_ctx);
     }
     else {
-      ssize_t count;
 
-      do {
-        uint8_t c;
+      (void) prviError (TNC_CRC_ERROR);
+    }
+    ret = 0;
+    if (i == len) {
 
-        count = read (p->fin, &c, 1);
-        if (count < 0) {
+      break;
+    }
+  }
+  *used = i;
+  if (ret == TNC_CRC_ERROR) {
 
-          perror ("read: ");
-          return prviSetError (p, TNC_IO_ERROR);
-        }
-        if (count > 0) {
+    return prviSetError (p, TNC_CRC_ERROR);
+  }
+  p->state = ret;
+  return (p->rx_msgs != msgs) ? TNC_EOT : p->state;
+}
 
-          switch (c) {
+// -----------------------------------------------------------------------------
+// Decodes the staged bytes, then the bytes read from the input by chunks if
+// fill is true, returns TNC_EOT if a message is received or given to the
+// handler
+static int
+prviDecode (xTnc *p, bool fill) {
+  unsigned long msgs;
 
-            case TNC_SOH:
-              p->crc_rx = CRC_CCITT_INIT_VAL;
-              p->state = TNC_SOH;
-              p->len = 0;
-              break;
+  if (!p) {
 
-            case TNC_STX:
-              if (p->state == TNC_SOH) {
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
+  if (p->fin < 0) {
 
-                p->cnt = 0;
-                p->state = TNC_STX;
-              }
-              else {
-                p->state = 0;
-              }
-              break;
+    return prviSetError (p, TNC_FILE_NOT_FOUND);
+  }
 
-            case TNC_ETX:
-              if (p->state == TNC_STX) {
+  if (p->state == TNC_EOT) {
+    p->state = 0;
+  }
+  msgs = p->rx_msgs;
+  for (;;) {
 
-                p->cnt = 0;
-                p->crc_tx = 0;
-                p->state = TNC_ETX;
-              }
-              else {
-                p->state = 0;
-              }
-              break;
+    if (p->stage_pos < p->stage_len) {
+      size_t used;
+      int ret = prviDecodeBuf (p, &p->stage[p->stage_pos],
+                               p->stage_len - p->stage_pos, &used);
 
-            case TNC_EOT:
-              if (p->state == TNC_ETX) {
+      p->stage_pos += used;
+      if ( (ret < 0) || (p->state == TNC_EOT)) {
 
-                p->state = TNC_EOT;
-                if (p->crc_rx != p->crc_tx) {
-                  return prviSetError (p, TNC_CRC_ERROR);
-                }
-              }
-              else {
-                p->state = 0;
-              }
-              break;
+        // A CRC error is returned before the next message is decoded
+        return ret;
+      }
+      continue;
+    }
+    // The chunk which delivered messages to the handler is entirely decoded
+    if ( (!fill) || (p->rx_msgs != msgs)) {
 
-            default:
-              if (isxdigit (c)) {
-
-                // Digit hexa
-                switch (p->state) {
-
-                  case TNC_STX:
-                    p->crc_rx = usCrcCcittUpdate (c, p->crc_rx);
-                    if (p->cnt++ & 1) {
-                      // LSB
-                      p->rxbuf[p->len++] = p->msb + htoi (c);
-                    }
-                    else {
-                      // MSB
-                      p->msb = htoi (c) << 4;
-                    }
-                    break;
-
-                  case TNC_ETX:
-                    if (p->cnt <= 12) {
-
-                      p->crc_tx += ( (uint16_t) htoi (c)) << (12 - p->cnt);
-                      p->cnt += 4;
-                    }
-                    else {
-
-                      // Plus de 4 octets de CRC reçu
-                      p->state = TNC_ILLEGAL_MSG;
-                    }
-                    break;
-
-                  default:
-                    // Digit hexa en dehors d'une trame, on ignore
-                    p->state = 0;
-                    break;
-                }
-              }
-              break;
+      break;
+    }
 
-          }
-        }
+    ssize_t n = read (p->fin, p->stage, sizeof (p->stage));
+    if (n < 0) {
+
+      perror ("read: ");
+      return prviSetError (p, TNC_IO_ERROR);
+    }
+    if (n == 0) {
+
+      break;
+    }
+    p->stage_len = n;
+    p->stage_pos = 0;
+  }
+  return (p->rx_msgs != msgs) ? TNC_EOT : p->state;
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncPoll (xTnc *p) {
+
+  return prviDecode (p, true);
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncPollTimeout (xTnc *p, int timeout_ms) {
+  struct timespec deadline;
+  struct pollfd pfd;
+  unsigned long msgs;
+  int ret;
+
+  if (!p) {
+
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
+  if (p->fin < 0) {
+
+    return prviSetError (p, TNC_FILE_NOT_FOUND);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  pfd.fd = p->fin;
+  pfd.events = POLLIN;
+  msgs = p->rx_msgs;
+
+  // The input is read only when poll() says it is readable, so that a blocking
+  // file descriptor never blocks past the deadline
+  while ( ( (ret = prviDecode (p, false)) != TNC_EOT) || (p->state != TNC_EOT)) {
+    struct timespec now;
+    int wait = -1;
+    ssize_t n;
+
+    if (ret < 0) {
+
+      return ret;
+    }
+    if (p->rx_msgs != msgs) {
+
+      // Messages are given to the handler, the input is only drained
+      wait = 0;
+    }
+    else if (timeout_ms >= 0) {
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      wait = (deadline.tv_sec - now.tv_sec) * 1000 +
+             (deadline.tv_nsec - now.tv_nsec) / 1000000L;
+      if (wait < 0) {
+
+        wait = 0;
+      }
+    }
+
+    n = poll (&pfd, 1, wait);
+    if (n < 0) {
+
+      if (errno == EINTR) {
+        continue;
+      }
+      return prviSetError (p, TNC_IO_ERROR);
+    }
+    if (n == 0) {
+
+      // Timeout
+      break;
+    }
+
+    n = read (p->fin, p->stage, sizeof (p->stage));
+    if (n <= 0) {
+
+      if ( (n < 0) && ( (errno == EINTR) || (errno == EAGAIN))) {
+        continue;
       }
-      while ( (count > 0) && (p->state != TNC_EOT));
+      // End of file or error
+      if (n < 0) {
+
+        return prviSetError (p, TNC_IO_ERROR);
+      }
+      break;
     }
+    p->stage_len = n;
+    p->stage_pos = 0;
   }
-  return p->state;
+  return (p->rx_msgs != msgs) ? TNC_EOT : ret;
+}
+
+// -----------------------------------------------------------------------------
+int
+iTncFeed (xTnc *p, const void *buf, size_t len, size_t *used) {
+  size_t n = 0;
+  int ret;
+
+  if ( (!p) || (!buf)) {
+
+    ret = prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
+  else {
+
+    ret = prviDecodeBuf (p, (const uint8_t *) buf, len, &n);
+  }
+  if (used) {
+
+    *used = n;
+  }
+  return ret;
 }
 
 // -----------------------------------------------------------------------------
 ssize_t
 iTncWrite (xTnc *p, const void *buf, size_t count) {
-  ssize_t index = 0;
-
+  uint8_t msg[TNC_MSG_SIZE (TNC_STAGE_LEN)];
+  xTncEncoder e;
+  size_t len;
 
   if (!p) {
 
@@ -324,93 +1083,61 @@ iTncWrite (xTnc *p, const void *buf, size_t count) {
 
     return prviSetError (p, TNC_FILE_NOT_FOUND);
   }
-  else {
-    int state = TNC_SOH;
-    ssize_t i;
-    uint8_t cnt = 0;
-    char str[5];
-    const uint8_t *b = (uint8_t *) buf;
-    uint16_t crc = CRC_CCITT_INIT_VAL;
-
-    tcflush (p->fout, TCIOFLUSH);
 
-    while (state != TNC_EOT) {
-      uint8_t c;
+  if (iTncEncoderSetMsg (&e, buf, count) != TNC_SUCCESS) {
 
-      switch (state) {
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
 
-        case TNC_SOH:
-          c = state;
-          state = TNC_STX;
-          break;
+  // Only the input is flushed, the output not yet transmitted belongs to the
+  // previous messages
+  tcflush (p->fout, TCIFLUSH);
 
-        case TNC_STX:
-          c = state;
-          state = TNC_TXT;
-          break;
+  // A message of up to TNC_STAGE_LEN bytes is written in one go
+  while ( (len = uTncEncoderRead (&e, msg, sizeof (msg))) > 0) {
 
-        case TNC_TXT:
-          if (count) {
-            if (cnt++ & 1) {
+    int ret = prviWriteAll (p, msg, len);
 
-              // LSB
-              c = str[1];
-              if (++index >= count) {
-                state = TNC_ETX;
-              }
-            }
-            else {
-
-              // MSB
-              snprintf (str, 3, "%02X", b[index]);
-              c = str[0];
-            }
-            crc = usCrcCcittUpdate (c, crc);
-          }
-          else {
+    if (ret < 0) {
 
-            state = TNC_ETX;
-            continue;
-          }
+      return ret;
+    }
+  }
+  return count;
+}
 
-          break;
+// -----------------------------------------------------------------------------
+ssize_t
+iTncWriteBatch (xTnc *p, const void *buf, size_t size, unsigned count) {
+  const uint8_t *b = (const uint8_t *) buf;
+  uint8_t *msg;
+  size_t len = 0;
+  ssize_t ret;
 
-        case TNC_ETX:
-          c = state;
-          cnt = 0;
-          state = TNC_CRC;
-          snprintf (str, 5, "%04X", crc);
-          break;
+  if (!p) {
 
-        case TNC_CRC:
-          if (cnt < 4) {
+    return prviSetError (p, TNC_OBJECT_NOT_FOUND);
+  }
 
-            c = str[cnt++];
-          }
-          else {
+  if (p->fout < 0) {
 
-            c = TNC_EOT;
-            state = TNC_EOT;
-          }
-          break;
+    return prviSetError (p, TNC_FILE_NOT_FOUND);
+  }
 
-        default:
-          break;
+  msg = malloc (TNC_MSG_SIZE (size) * count);
+  if (!msg) {
 
-      }
-      do {
+    return prviSetError (p, TNC_NOT_ENOUGH_MEMORY);
+  }
 
-        i = write (p->fout, &c, 1);
-        if (i < 0) {
+  for (unsigned i = 0; i < count; i++) {
 
-          perror ("write: ");
-          return prviSetError (p, TNC_IO_ERROR);
-        }
-      }
-      while (i == 0);
-    }
+    len += uTncEncode (&msg[len], &b[i * size], size);
   }
-  return index;
+
+  ret = prviWriteAll (p, msg, len);
+  free (msg);
+  return (ret < 0) ? ret : (ssize_t) (size * count);
 }
 
 /* ========================================================================== */
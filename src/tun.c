@@ -0,0 +1,415 @@
+/**
+ * @file src/tun.c
+ * @brief Passerelle IPv4 sur AX.25 par interface TUN (Implémentation C)
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include <radio/tun.h>
+#include <radio/crc.h>
+#include <sysio/log.h>
+
+/* constants ================================================================ */
+#define ADDR_LEN (AX25_CALL_LEN + 1)
+#define IP_HDR_LEN 20
+
+// SSID byte bits
+#define SSID_H     0x80
+#define SSID_MASK  0x1E
+#define SSID_LAST  0x01
+
+/* private ================================================================== */
+
+// -----------------------------------------------------------------------------
+static bool
+prvbSameAddr (const uint8_t *a, const uint8_t *b) {
+
+  return (memcmp (a, b, AX25_CALL_LEN) == 0) &&
+         ( ( (a[AX25_CALL_LEN] ^ b[AX25_CALL_LEN]) & SSID_MASK) == 0);
+}
+
+// -----------------------------------------------------------------------------
+static int
+prviEncode (const xAx25Node *n, uint8_t *addr) {
+  int ret = iAx25NodeEncode (n, addr);
+
+  addr[AX25_CALL_LEN] &= ~ (SSID_H | SSID_LAST);
+  return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Route of the IPv4 destination address dst (host byte order), NULL if none
+static const xAx25TunRoute *
+prvxRoute (const xAx25Tun *t, uint32_t dst) {
+
+  // Longest prefix first
+  for (unsigned i = 0; i < t->route_len; i++) {
+
+    if ( (dst & t->route[i].mask) == t->route[i].net) {
+
+      return &t->route[i];
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Process the frames received on the port
+static int
+prviDrainPort (xAx25Tun *t) {
+  int count = 0;
+
+  while (bAx25PollTimeout (t->port, 0)) {
+    xAx25View v;
+
+    if (iAx25ReadView (t->port, &v) == AX25_SUCCESS) {
+
+      if (iAx25TunInput (t, &v) > 0) {
+
+        count++;
+      }
+      (void) iAx25Discard (t->port);
+    }
+  }
+  return count;
+}
+
+/* public =================================================================== */
+
+// -----------------------------------------------------------------------------
+xAx25Tun *
+xAx25TunNew (xAx25 *port, const char *callsign, uint8_t ssid) {
+  xAx25Tun *t;
+  xAx25Node n;
+
+  t = calloc (1, sizeof (xAx25Tun));
+  if (t) {
+
+    iAx25NodeClear (&n);
+    iAx25NodeSetCallsign (&n, callsign);
+    iAx25NodeSetSsid (&n, ssid);
+    if ( (!port) || (prviEncode (&n, t->mycall) != AX25_SUCCESS)) {
+
+      free (t);
+      return NULL;
+    }
+    t->port = port;
+    t->fd = -1;
+  }
+  return t;
+}
+
+// -----------------------------------------------------------------------------
+void
+vAx25TunDelete (xAx25Tun *t) {
+
+  if (t) {
+
+    if (t->own_fd) {
+
+      close (t->fd);
+    }
+    free (t);
+  }
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TunOpen (xAx25Tun *t, const char *ifname) {
+  struct ifreq ifr;
+  int fd, s;
+
+  if ( (!t) || (!ifname)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+
+  fd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+
+    PWARNING ("Unable to open /dev/net/tun: %s\n", strerror (errno));
+    return AX25_FILE_NOT_FOUND;
+  }
+  memset (&ifr, 0, sizeof (ifr));
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  strncpy (ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  if (ioctl (fd, TUNSETIFF, &ifr) < 0) {
+
+    PWARNING ("Unable to create %s: %s\n", ifname, strerror (errno));
+    close (fd);
+    return AX25_FILE_ACCESS_ERROR;
+  }
+
+  // The info field of a frame holds a whole packet
+  s = socket (AF_INET, SOCK_DGRAM, 0);
+  ifr.ifr_mtu = AX25_INFO_LEN;
+  if ( (s < 0) || (ioctl (s, SIOCSIFMTU, &ifr) < 0)) {
+
+    PWARNING ("Unable to set the MTU of %s: %s\n", ifr.ifr_name, strerror (errno));
+    if (s >= 0) {
+      close (s);
+    }
+    close (fd);
+    return AX25_FILE_ACCESS_ERROR;
+  }
+  close (s);
+
+  if (t->own_fd) {
+
+    close (t->fd);
+  }
+  t->fd = fd;
+  t->own_fd = true;
+  snprintf (t->ifname, sizeof (t->ifname), "%.*s", IFNAMSIZ, ifr.ifr_name);
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TunSetFd (xAx25Tun *t, int fd) {
+  int flags;
+
+  if (!t) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (fd < 0) || ( (flags = fcntl (fd, F_GETFL)) < 0) ||
+       (fcntl (fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+
+    return AX25_FILE_ACCESS_ERROR;
+  }
+  if (t->own_fd) {
+
+    close (t->fd);
+  }
+  t->fd = fd;
+  t->own_fd = false;
+  t->ifname[0] = 0;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TunAddRoute (xAx25Tun *t, uint32_t addr, unsigned prefix_len,
+                  const xAx25Node *dst, const xAx25Node *path,
+                  unsigned path_len) {
+  xAx25TunRoute r;
+  uint8_t *p = r.hdr;
+  unsigned i;
+
+  if ( (!t) || (!dst) || ( (path_len) && (!path))) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (t->route_len >= AX25_TUN_MAX_ROUTE) {
+
+    return AX25_NOT_ENOUGH_MEMORY;
+  }
+  if (prefix_len > 32) {
+
+    return AX25_INVALID_FRAME;
+  }
+  if (path_len > AX25_MAX_RPT) {
+
+    return AX25_NOT_ENOUGH_REPEATER;
+  }
+
+  r.prefix_len = prefix_len;
+  r.mask = prefix_len ? 0xFFFFFFFFUL << (32 - prefix_len) : 0;
+  r.net = ntohl (addr) & r.mask;
+
+  // The header is built once for all the packets of the route
+  if (prviEncode (dst, p) != AX25_SUCCESS) {
+
+    return AX25_ILLEGAL_CALLSIGN;
+  }
+  p += ADDR_LEN;
+  memcpy (p, t->mycall, ADDR_LEN);
+  p += ADDR_LEN;
+  for (i = 0; i < path_len; i++) {
+
+    if (prviEncode (&path[i], p) != AX25_SUCCESS) {
+
+      return AX25_ILLEGAL_CALLSIGN;
+    }
+    p += ADDR_LEN;
+  }
+  p[-1] |= SSID_LAST;
+  *p++ = AX25_CTRL_UI;
+  *p++ = AX25_PID_IP;
+  r.hdr_len = p - r.hdr;
+  r.crc = usCrcCcitt (CRC_CCITT_INIT_VAL, r.hdr, r.hdr_len);
+
+  for (i = t->route_len; (i > 0) && (t->route[i - 1].prefix_len < prefix_len); i--) {
+
+    t->route[i] = t->route[i - 1];
+  }
+  t->route[i] = r;
+  t->route_len++;
+  return AX25_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TunInput (xAx25Tun *t, const xAx25View *v) {
+  ssize_t n;
+
+  if ( (!t) || (!v) || (!v->frame)) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if ( (t->fd < 0) || ( (v->ctrl & ~0x10) != AX25_CTRL_UI) || (v->pid != AX25_PID_IP) ||
+       (!prvbSameAddr (v->frame, t->mycall))) {
+
+    return 0;
+  }
+  // A frame sent through repeaters is processed once repeated by the last one
+  if ( (v->naddr > 2) && (! (v->frame[v->naddr * ADDR_LEN - 1] & SSID_H))) {
+
+    return 0;
+  }
+  if ( (v->info_len < IP_HDR_LEN) || ( (v->info[0] >> 4) != 4)) {
+
+    t->dropped++;
+    return 0;
+  }
+
+  // Written from the buffer of the decoder
+  do {
+    n = write (t->fd, v->info, v->info_len);
+  }
+  while ( (n < 0) && (errno == EINTR));
+  if (n < 0) {
+
+    t->dropped++;
+    return (errno == EAGAIN) ? 0 : AX25_FILE_ACCESS_ERROR;
+  }
+  t->rx_packets++;
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TunRead (xAx25Tun *t) {
+  uint8_t *pkt;
+  size_t n = 0;
+  int count = 0;
+
+  if (!t) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (t->fd < 0) {
+
+    return AX25_FILE_NOT_FOUND;
+  }
+
+  pkt = &t->frame[AX25_TUN_HDR_LEN];
+  while (count < AX25_TUN_BATCH) {
+    const xAx25TunRoute *r;
+    uint8_t *frame;
+    uint16_t fcs;
+    ssize_t len;
+
+    // One more byte to detect the packets too long
+    len = read (t->fd, pkt, AX25_INFO_LEN + 1);
+    if (len < 0) {
+
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        break;
+      }
+      return AX25_FILE_ACCESS_ERROR;
+    }
+    if (len == 0) {
+      break;
+    }
+    if ( (len > AX25_INFO_LEN) || (len < IP_HDR_LEN) || ( (pkt[0] >> 4) != 4)) {
+
+      t->dropped++;
+      continue;
+    }
+    r = prvxRoute (t, ( (uint32_t) pkt[16] << 24) | (pkt[17] << 16) | (pkt[18] << 8) | pkt[19]);
+    if (!r) {
+
+      t->dropped++;
+      continue;
+    }
+
+    // The header is put in front of the packet, the CRC goes on from the
+    // one of the header
+    frame = pkt - r->hdr_len;
+    memcpy (frame, r->hdr, r->hdr_len);
+    fcs = usCrcCcitt (r->crc, pkt, len) ^ 0xFFFF;
+    pkt[len++] = fcs & 0xFF;
+    pkt[len++] = fcs >> 8;
+    n += uAx25Encode (&t->out[n], frame, r->hdr_len + len);
+    count++;
+  }
+
+  if (n) {
+    int ret = iAx25SendEncoded (t->port, t->out, n);
+
+    if (ret != AX25_SUCCESS) {
+
+      return ret;
+    }
+    t->tx_packets += count;
+  }
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+int
+iAx25TunPoll (xAx25Tun *t, int timeout_ms) {
+  struct pollfd pfd[2];
+  int count, ret;
+
+  if (!t) {
+
+    return AX25_OBJECT_NOT_FOUND;
+  }
+  if (t->fd < 0) {
+
+    return AX25_FILE_NOT_FOUND;
+  }
+
+  // The frames already decoded do not wait
+  count = prviDrainPort (t);
+  if (count == 0) {
+
+    pfd[0].fd = t->fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = t->port->fin;
+    pfd[1].events = POLLIN;
+    if ( (poll (pfd, t->port->fin ? 2 : 1, timeout_ms) < 0) && (errno != EINTR)) {
+
+      return AX25_FILE_ACCESS_ERROR;
+    }
+  }
+
+  ret = iAx25TunRead (t);
+  if (ret < 0) {
+
+    return ret;
+  }
+  return count + ret + prviDrainPort (t);
+}
+
+/* ========================================================================== */
@@ -0,0 +1,221 @@
+/**
+ * @file test_aprs.c
+ * @brief APRS decoder test and benchmark
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include <radio/aprs.h>
+
+/* constants ================================================================ */
+#define BENCH_LOOPS 200000
+
+/* private variables ======================================================== */
+static const struct {
+  const char *dst;
+  const char *info;
+} xPackets[] = {
+  { "APRS", "!4903.50N/07201.75W-Test 001234" },
+  { "APRS", "@092345z4903.50N/07201.75W>088/036/A=001234" },
+  { "APRS", "=/5L!!<*e7>7P[" },
+  { "APRS", "!/5L!!<*e7OS]S" },
+  { "S32U6T", "`(_fn\"Oj/]\"4T}Comment" },
+  { "APRS", ";LEADER   *092345z4903.50N/07201.75W>088/036" },
+  { "APRS", ")AID #2!4903.50N/07201.75WA" },
+  { "APRS", ":WU2Z     :Testing{003" },
+  { "APRS", ":KB2ICI-14:ack003" },
+  { "APRS", "T#005,199,000,255,073,123,01101001" },
+  { "APRS", "_10090556c220s004g005t077r000p000P000h50b09900wRSW" },
+  { "APRS", "@092345z4903.50N/07201.75W_220/004g005t-07r000p000P000h00b09900wRSW" },
+  { "APRS", ">092345zNet Control Center" },
+  { "APRS", "!49  .  N/072  .  W-" },
+  { "APRS", ":F4ABC    :acknowledged{12" },
+  { "APRS", ":F4ABC    :ack" },
+  { "APRS", ":F4ABC    :rejAB12}C3" },
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static bool
+bStrEq (xAprsStr s, const char *str) {
+
+  return (s.len == strlen (str)) && (memcmp (s.str, str, s.len) == 0);
+}
+
+// -----------------------------------------------------------------------------
+static bool
+bNear (double a, double b) {
+
+  return (a - b < 1e-4) && (b - a < 1e-4);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vParse (xAprs *a, int i) {
+
+  assert (iAprsParse (a, xPackets[i].dst, xPackets[i].info,
+                      strlen (xPackets[i].info)) == AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTestDecode (void) {
+  xAprs a;
+
+  vParse (&a, 0);
+  assert (a.type == APRS_POSITION);
+  assert (a.pos.format == APRS_POS_UNCOMPRESSED);
+  assert (bNear (a.pos.lat, 49.058333) && bNear (a.pos.lon, -72.029167));
+  assert ( (a.pos.symbol_table == '/') && (a.pos.symbol_code == '-'));
+  assert (bStrEq (a.comment, "Test 001234"));
+  assert (! (a.flags & (APRS_HAS_MESSAGING | APRS_HAS_TIMESTAMP)));
+
+  vParse (&a, 1);
+  assert (a.flags & APRS_HAS_MESSAGING);
+  assert (bStrEq (a.timestamp, "092345z"));
+  assert ( (a.flags & APRS_HAS_COURSE) && (a.pos.course == 88) && (a.pos.speed == 36));
+  assert ( (a.flags & APRS_HAS_ALTITUDE) && (a.pos.altitude == 1234));
+
+  vParse (&a, 2);
+  assert (a.pos.format == APRS_POS_COMPRESSED);
+  assert (bNear (a.pos.lat, 49.5) && bNear (a.pos.lon, -72.75));
+  assert ( (a.pos.course == 88) && (a.pos.speed == 36));
+
+  vParse (&a, 3);
+  assert ( (a.flags & APRS_HAS_ALTITUDE) && (a.pos.altitude == 10004));
+
+  vParse (&a, 4);
+  assert (a.pos.format == APRS_POS_MICE);
+  assert (bNear (a.pos.lat, 33.427333) && bNear (a.pos.lon, -12.129));
+  assert ( (a.pos.speed == 20) && (a.pos.course == 251));
+  assert ( (a.pos.symbol_table == '/') && (a.pos.symbol_code == 'j'));
+  assert (a.pos.mice_msg == 4);
+  assert ( (a.flags & APRS_HAS_ALTITUDE) && (a.pos.altitude == 200));
+  assert (bStrEq (a.comment, "Comment"));
+
+  vParse (&a, 5);
+  assert ( (a.type == APRS_OBJECT) && bStrEq (a.name, "LEADER") && !a.killed);
+  assert (a.pos.course == 88);
+
+  vParse (&a, 6);
+  assert ( (a.type == APRS_ITEM) && bStrEq (a.name, "AID #2"));
+  assert (a.pos.symbol_code == 'A');
+
+  vParse (&a, 7);
+  assert ( (a.type == APRS_MESSAGE) && (a.msg.kind == APRS_MSG_TEXT));
+  assert (bStrEq (a.msg.addressee, "WU2Z") && bStrEq (a.msg.text, "Testing"));
+  assert (bStrEq (a.msg.id, "003"));
+
+  vParse (&a, 8);
+  assert ( (a.msg.kind == APRS_MSG_ACK) && bStrEq (a.msg.addressee, "KB2ICI-14"));
+  assert (bStrEq (a.msg.id, "003"));
+
+  vParse (&a, 9);
+  assert ( (a.type == APRS_TELEMETRY) && (a.tlm.seq == 5) && (a.tlm.nvalues == 5));
+  assert ( (a.tlm.values[0] == 199) && (a.tlm.values[4] == 123));
+  assert (a.tlm.has_bits && (a.tlm.bits == 0x69));
+
+  vParse (&a, 10);
+  assert ( (a.type == APRS_WEATHER) && bStrEq (a.timestamp, "10090556"));
+  assert ( (a.wx.wind_dir == 220) && (a.wx.wind_speed == 4) && (a.wx.gust == 5));
+  assert ( (a.wx.temp == 77) && (a.wx.humidity == 50) && (a.wx.pressure == 9900));
+  assert (bStrEq (a.comment, "wRSW"));
+
+  vParse (&a, 11);
+  assert ( (a.type == APRS_POSITION) && (a.flags & APRS_HAS_WEATHER));
+  assert ( (a.wx.wind_dir == 220) && (a.wx.temp == -7) && (a.wx.humidity == 100));
+
+  vParse (&a, 12);
+  assert ( (a.type == APRS_STATUS) && bStrEq (a.comment, "Net Control Center"));
+
+  vParse (&a, 13);
+  assert ( (a.pos.ambiguity == 4) && bNear (a.pos.lat, 49.0));
+
+  // Only an id of 1 to 5 characters makes an ack or a reject
+  vParse (&a, 14);
+  assert ( (a.msg.kind == APRS_MSG_TEXT) && bStrEq (a.msg.text, "acknowledged"));
+  assert (bStrEq (a.msg.id, "12"));
+  vParse (&a, 15);
+  assert ( (a.msg.kind == APRS_MSG_TEXT) && bStrEq (a.msg.text, "ack") && (a.msg.id.len == 0));
+  vParse (&a, 16);
+  assert ( (a.msg.kind == APRS_MSG_REJ) && bStrEq (a.msg.id, "AB12"));
+
+  assert (iAprsParse (&a, "APRS", "Xjunk", 5) == AX25_INVALID_FRAME);
+  assert (a.type == APRS_UNKNOWN);
+  assert (iAprsParse (&a, "APRS", "!4903.50N", 9) == AX25_INVALID_FRAME);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTestView (void) {
+  uint8_t frame[64];
+  const char *info = "`(_fn\"Oj/";
+  xAx25Node n;
+  xAx25View v;
+  xAprs a;
+  size_t len;
+
+  iAx25NodeClear (&n);
+  iAx25NodeSetCallsign (&n, "S32U6T");
+  iAx25NodeEncode (&n, frame);
+  iAx25NodeSetCallsign (&n, "F4ABC");
+  iAx25NodeEncode (&n, frame + 7);
+  frame[13] |= 0x01;
+  frame[14] = AX25_CTRL_UI;
+  frame[15] = AX25_PID_NOLAYER3;
+  memcpy (frame + 16, info, strlen (info));
+  len = 16 + strlen (info);
+
+  assert (iAx25ViewInit (&v, frame, len) == AX25_SUCCESS);
+  assert ( (v.naddr == 2) && (v.info_len == strlen (info)));
+  assert (iAx25ViewGetNode (&v, 1, &n) == AX25_SUCCESS);
+  assert (strcmp (n.callsign, "F4ABC") == 0);
+  assert (iAprsParseView (&a, &v) == AX25_SUCCESS);
+  assert ( (a.pos.format == APRS_POS_MICE) && bNear (a.pos.lat, 33.427333));
+}
+
+// -----------------------------------------------------------------------------
+static void
+vBenchmark (void) {
+  struct timespec t0, t1;
+  unsigned long count = 0;
+  double s;
+  size_t len[COUNTOF (xPackets)];
+  xAprs a;
+
+  for (unsigned i = 0; i < COUNTOF (xPackets); i++) {
+
+    len[i] = strlen (xPackets[i].info);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &t0);
+  for (int l = 0; l < BENCH_LOOPS; l++) {
+
+    for (unsigned i = 0; i < COUNTOF (xPackets); i++) {
+
+      count += (iAprsParse (&a, xPackets[i].dst, xPackets[i].info, len[i]) == AX25_SUCCESS);
+    }
+  }
+  clock_gettime (CLOCK_MONOTONIC, &t1);
+  assert (count == BENCH_LOOPS * COUNTOF (xPackets));
+  s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  printf ("%lu packets decoded in %.3f s: %.2f Mpackets/s\n", count, s, count / s / 1e6);
+}
+
+/* internal public functions ================================================ */
+int
+main (void) {
+
+  printf ("Test APRS decoder\n");
+  vTestDecode();
+  vTestView();
+  vBenchmark();
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file test_ax25_capture.c
+ * @brief AX25 capture log test
+ *
+ * Frames received by bAx25Poll() are logged in small segments, then read
+ * back from all the segments and checked. A reader which follows a segment
+ * must reach the end of data after the segment is closed, and a failed
+ * rollover must be reported and tried again on the next frame.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <radio/capture.h>
+
+/* constants ================================================================ */
+#define INFO ">Test %05d"
+#define COUNT 500
+#define PATH "/tmp/radio_test_ax25_capture"
+#define PORT 3
+#define SEGMENT_SIZE 4096
+#define DIR "/tmp/radio_test_ax25_capture.d"
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2], flag, count = 0, segments = 0;
+  uint64_t last = 0;
+  xAx25 *xAx25;
+  xAx25Frame *xFrame;
+  xCapture *xCap;
+
+  assert (pipe (io) == 0);
+  flag = fcntl (io[0], F_GETFL);
+  fcntl (io[0], F_SETFL, flag | O_NONBLOCK);
+  xAx25 = xAx25New();
+  xFrame = xAx25FrameNew();
+  assert (xAx25 && xFrame);
+  iAx25SetFdout (xAx25, io[1]);
+  iAx25SetFdin (xAx25, io[0]);
+
+  xCap = xCaptureNew (PATH, SEGMENT_SIZE);
+  assert (xCap);
+  assert (iAx25SetCapture (xAx25, xCap, PORT) == AX25_SUCCESS);
+
+  iAx25FrameSetDst (xFrame, "APRS", 0);
+  iAx25FrameSetSrc (xFrame, "F4ABC", 1);
+  iAx25FrameAddRepeater (xFrame, "WIDE1", 1);
+  for (int i = 0; i < COUNT; i++) {
+    char cInfo[32];
+
+    iAx25FrameSetInfo (xFrame, cInfo, snprintf (cInfo, sizeof (cInfo), INFO, i));
+    assert (iAx25Send (xAx25, xFrame) == AX25_SUCCESS);
+    assert (bAx25Poll (xAx25));
+    iAx25Discard (xAx25);
+  }
+  printf ("%lu frames logged in %u segments\n", xCap->frames, xCap->segment + 1);
+  assert (xCap->frames == COUNT);
+  vCaptureDelete (xCap);
+
+  // Read back all the segments
+  for (;;) {
+    char cFile[64];
+    xCaptureReader *xReader;
+    xCaptureRecord xRec;
+    int ret;
+
+    snprintf (cFile, sizeof (cFile), "%s.%04u", PATH, segments);
+    xReader = xCaptureReaderNew (cFile);
+    if (!xReader) {
+      break;
+    }
+    assert (xReader->segment == segments);
+
+    while ( (ret = iCaptureRead (xReader, &xRec)) == 1) {
+      xAx25View xView;
+      char cInfo[32];
+
+      assert (xRec.port == PORT);
+      assert (xRec.mono >= last);
+      last = xRec.mono;
+
+      assert (iAx25ViewInit (&xView, xRec.frame, xRec.len) == AX25_SUCCESS);
+      snprintf (cInfo, sizeof (cInfo), INFO, count);
+      assert ( (xView.info_len == strlen (cInfo)) &&
+               (memcmp (xView.info, cInfo, xView.info_len) == 0));
+      count++;
+    }
+    assert (ret == 0);
+    vCaptureReaderDelete (xReader);
+    unlink (cFile);
+    segments++;
+  }
+
+  printf ("%d frames read from %d segments\n", count, segments);
+  assert (count == COUNT);
+  assert (segments > 1);
+
+  // Reader following a segment closed with the end of data on a page boundary
+  {
+    uint8_t frame[40] = { 0 };
+    xCaptureReader *xReader;
+    xCaptureRecord xRec;
+    int n = 0;
+
+    xCap = xCaptureNew (PATH, 2 * SEGMENT_SIZE);
+    assert (xCap);
+    xReader = xCaptureReaderNew (PATH ".0000");
+    assert (xReader && (xReader->size == 2 * SEGMENT_SIZE));
+    while (xCap->pos + 64 < SEGMENT_SIZE) {
+
+      assert (iCaptureWrite (xCap, PORT, frame, sizeof (frame)) == AX25_SUCCESS);
+    }
+    assert (iCaptureWrite (xCap, PORT, frame, SEGMENT_SIZE - xCap->pos - sizeof (xCaptureRecordHdr)) == AX25_SUCCESS);
+    assert (xCap->pos == SEGMENT_SIZE);
+    while (iCaptureRead (xReader, &xRec) == 1) {
+      n++;
+    }
+    vCaptureDelete (xCap);
+    assert (iCaptureRead (xReader, &xRec) == 0);
+    printf ("%d frames followed, end of data after close\n", n);
+    vCaptureReaderDelete (xReader);
+    unlink (PATH ".0000");
+  }
+
+  // Rollover in a removed directory
+  {
+    uint8_t frame[100] = { 0 };
+    int ret;
+
+    assert (mkdir (DIR, 0755) == 0);
+    xCap = xCaptureNew (DIR "/cap", SEGMENT_SIZE);
+    assert (xCap);
+    assert ( (unlink (DIR "/cap.0000") == 0) && (rmdir (DIR) == 0));
+    while ( (ret = iCaptureWrite (xCap, PORT, frame, sizeof (frame))) == AX25_SUCCESS);
+    assert ( (ret < 0) && (xCap->segment == 0));
+    assert (iCaptureWrite (xCap, PORT, frame, 20) < 0);
+    assert (mkdir (DIR, 0755) == 0);
+    assert (iCaptureWrite (xCap, PORT, frame, 20) == AX25_SUCCESS);
+    assert (xCap->segment == 1);
+    printf ("Failed rollover reported, then done\n");
+    vCaptureDelete (xCap);
+    assert ( (unlink (DIR "/cap.0001") == 0) && (rmdir (DIR) == 0));
+  }
+
+  vAx25FrameDelete (xFrame);
+  vAx25Delete (xAx25);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
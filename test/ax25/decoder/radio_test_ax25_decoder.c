@@ -0,0 +1,234 @@
+/**
+ * @file test_ax25_decoder.c
+ * @brief AX25 decoder and encoder test
+ *
+ * Frames are encoded by pieces of a few bytes with xAx25Encoder: the size
+ * known up front and the bytes must be the same as the ones sent by
+ * iAx25Send(). The frames are then decoded with xAx25Decoder from spans of
+ * random lengths, and from frames sharing their flags. Long frames whose
+ * special bytes are at every position are decoded among noise. A frame
+ * other than UI must be released by iAx25Read().
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <radio/ax25.h>
+#include <radio/link.h>
+#include <radio/crc.h>
+
+/* constants ================================================================ */
+#define FRAMES 200
+#define PIECE 7
+#define INFO ">Test decoder %03d \x7E\x7F\x1B"
+#define LONG 200
+#define NOISE 100
+
+/* private variables ======================================================== */
+static uint8_t ucStream[FRAMES * AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)];
+static const uint8_t ucSpecial[] = { HDLC_FLAG, HDLC_RESET, AX25_ESC };
+static size_t uStreamLen;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vCheck (const xAx25View *v, int i) {
+  char info[32];
+  xAx25Node n;
+
+  snprintf (info, sizeof (info), INFO, i);
+  assert ( (v->info_len == strlen (info)) && (memcmp (v->info, info, v->info_len) == 0));
+  assert ( (iAx25ViewGetNode (v, 1, &n) == AX25_SUCCESS) && (strcmp (n.callsign, "F4ABC") == 0));
+  assert ( (v->naddr == 3) && (iAx25ViewGetNode (v, 2, &n) == AX25_SUCCESS) && (n.flag));
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int raw[2];
+  uint8_t ref[AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)];
+  xAx25 *xAx25 = xAx25New();
+  xAx25Frame *xFrame = xAx25FrameNew();
+  xAx25Encoder *e = xAx25EncoderNew();
+  xAx25Decoder *d = xAx25DecoderNew();
+  xAx25View v;
+  size_t pos;
+  int n;
+
+  assert (xAx25 && xFrame && e && d);
+  assert (pipe (raw) == 0);
+  iAx25SetFdout (xAx25, raw[1]);
+  iAx25FrameSetDst (xFrame, "APRS", 0);
+  iAx25FrameSetSrc (xFrame, "F4ABC", 1);
+  iAx25FrameAddRepeater (xFrame, "WIDE1", 1);
+  iAx25FrameSetRepeaterFlag (xFrame, 0, true);
+
+  // Encoding by pieces
+  for (int i = 0; i < FRAMES; i++) {
+    char info[32];
+    size_t size, len = 0, got;
+    ssize_t reflen;
+
+    iAx25FrameSetInfo (xFrame, info, snprintf (info, sizeof (info), INFO, i));
+    assert (iAx25Send (xAx25, xFrame) == AX25_SUCCESS);
+    reflen = read (raw[0], ref, sizeof (ref));
+    assert (reflen > 0);
+
+    assert (iAx25EncoderSetFrame (e, xFrame) == AX25_SUCCESS);
+    size = uAx25EncoderSize (e);
+    assert (size == (size_t) reflen);
+    while ( (got = uAx25EncoderRead (e, &ucStream[uStreamLen + len], PIECE)) > 0) {
+
+      assert ( (got == PIECE) || (uAx25EncoderSize (e) == 0));
+      len += got;
+    }
+    assert ( (len == size) && (memcmp (&ucStream[uStreamLen], ref, len) == 0));
+    uStreamLen += len;
+  }
+  printf ("%d frames encoded, %zu bytes\n", FRAMES, uStreamLen);
+
+  // Decoding by spans of random lengths
+  pos = 0;
+  n = 0;
+  while (pos < uStreamLen) {
+    size_t len = 1 + rand() % 40, used;
+
+    if (len > uStreamLen - pos) {
+      len = uStreamLen - pos;
+    }
+    if (bAx25DecoderFeed (d, &ucStream[pos], len, &used)) {
+
+      assert (iAx25DecoderView (d, &v) == AX25_SUCCESS);
+      vCheck (&v, n++);
+      assert (iAx25DecoderDiscard (d) == AX25_SUCCESS);
+    }
+    pos += used;
+  }
+  printf ("%d frames decoded by spans\n", n);
+  assert ( (n == FRAMES) && (iAx25DecoderDiscard (d) == AX25_NO_FRAME_RECEIVED));
+
+  // Frames sharing their flags: the closing flag of a frame opens the next
+  iAx25DecoderClear (d);
+  pos = 0;
+  for (int i = 0; i < 2; i++) {
+    char info[32];
+
+    iAx25FrameSetInfo (xFrame, info, snprintf (info, sizeof (info), INFO, i));
+    iAx25EncoderSetFrame (e, xFrame);
+    pos += uAx25EncoderRead (e, &ucStream[pos], sizeof (ucStream) - pos) - 1;
+  }
+  pos++;
+  n = 0;
+  for (size_t i = 0, used; i < pos; i += used) {
+
+    if (bAx25DecoderFeed (d, &ucStream[i], pos - i, &used)) {
+
+      assert (iAx25DecoderView (d, &v) == AX25_SUCCESS);
+      vCheck (&v, n++);
+      iAx25DecoderDiscard (d);
+    }
+  }
+  printf ("%d frames with shared flags decoded\n", n);
+  assert (n == 2);
+
+  // Long frames among noise, a special byte at each position of the info
+  iAx25DecoderClear (d);
+  uStreamLen = 0;
+  for (int i = 0; i < LONG; i++) {
+    uint8_t info[LONG];
+
+    // The noise does not contain any flag and does not escape the next one
+    ucStream[uStreamLen++] = HDLC_RESET;
+    for (int j = 1; j < NOISE; j++) {
+      uint8_t c;
+
+      do {
+        c = rand();
+      }
+      while ( (c == HDLC_FLAG) || (c == AX25_ESC));
+      ucStream[uStreamLen++] = c;
+    }
+    for (int j = 0; j < LONG; j++) {
+
+      info[j] = 'A' + (i + j) % 26;
+    }
+    info[i] = ucSpecial[i % 3];
+    iAx25FrameSetInfo (xFrame, info, LONG);
+    iAx25EncoderSetFrame (e, xFrame);
+    uStreamLen += uAx25EncoderRead (e, &ucStream[uStreamLen], sizeof (ucStream) - uStreamLen);
+  }
+  n = 0;
+  for (size_t i = 0, used; i < uStreamLen; i += used) {
+
+    if (bAx25DecoderFeed (d, &ucStream[i], uStreamLen - i, &used)) {
+
+      assert (iAx25DecoderView (d, &v) == AX25_SUCCESS);
+      assert ( (v.info_len == LONG) && (v.info[n] == ucSpecial[n % 3]));
+      n++;
+      iAx25DecoderDiscard (d);
+    }
+  }
+  printf ("%d long frames decoded among noise\n", n);
+  assert (n == LONG);
+
+  // An RR frame followed by a UI frame: iAx25Read() releases the RR frame
+  {
+    xAx25Node node;
+    uint16_t fcs;
+    int got = 0, invalid = 0;
+
+    iAx25NodeClear (&node);
+    iAx25NodeSetCallsign (&node, "F4XYZ");
+    iAx25NodeEncode (&node, ref);
+    iAx25NodeSetCallsign (&node, "F4ABC");
+    iAx25NodeEncode (&node, &ref[AX25_CALL_LEN + 1]);
+    ref[2 * AX25_CALL_LEN + 1] |= 0x01;
+    ref[2 * AX25_CALL_LEN + 2] = AX25_CTRL_RR;
+    fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, ref, 2 * AX25_CALL_LEN + 3) ^ 0xFFFF;
+    ref[2 * AX25_CALL_LEN + 3] = fcs & 0xFF;
+    ref[2 * AX25_CALL_LEN + 4] = fcs >> 8;
+    assert (iAx25EncoderSetRaw (e, ref, 2 * AX25_CALL_LEN + 5) == AX25_SUCCESS);
+    uStreamLen = uAx25EncoderRead (e, ucStream, sizeof (ucStream));
+    iAx25FrameSetInfo (xFrame, "UI", 2);
+    assert (iAx25EncoderSetFrame (e, xFrame) == AX25_SUCCESS);
+    uStreamLen += uAx25EncoderRead (e, &ucStream[uStreamLen], sizeof (ucStream) - uStreamLen);
+
+    for (size_t i = 0, used; (i < uStreamLen) && (invalid < 2); i += used) {
+
+      if (bAx25Feed (xAx25, &ucStream[i], uStreamLen - i, &used)) {
+        int ret = iAx25Read (xAx25, xFrame);
+
+        if (ret == AX25_SUCCESS) {
+
+          assert ( (xFrame->info_len == 2) && (memcmp (xFrame->info, "UI", 2) == 0));
+          got++;
+        }
+        else {
+
+          assert (ret == AX25_INVALID_FRAME);
+          invalid++;
+        }
+      }
+    }
+    assert ( (got == 1) && (invalid == 1));
+    printf ("RR frame skipped by iAx25Read()\n");
+  }
+
+  // Frames which can not be encoded
+  assert (iAx25EncoderSetRaw (e, ref, 4) == AX25_INVALID_FRAME);
+  assert (uAx25EncoderSize (e) == 0);
+
+  vAx25DecoderDelete (d);
+  vAx25EncoderDelete (e);
+  vAx25FrameDelete (xFrame);
+  vAx25Delete (xAx25);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
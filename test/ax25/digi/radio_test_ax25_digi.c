@@ -0,0 +1,147 @@
+/**
+ * @file test_ax25_digi.c
+ * @brief AX25 digipeater test
+ *
+ * Frames are sent in a first pipe, repeated by the digipeater in a second
+ * pipe, then received and decoded to check their path and their FCS.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <radio/ax25.h>
+#include <radio/digi.h>
+
+/* constants ================================================================ */
+#define INFO ">Test 00001: SolarPi (\x7E) APRS http://www.btssn.net"
+
+/* private variables ======================================================== */
+static xAx25 *xTx, *xDigiPort, *xRx;
+static xAx25Frame *xFrame;
+
+// path sent, path expected after the digipeater ("" if not repeated)
+static const struct {
+  const char *path[3];
+  uint8_t ssid[3];
+  const char *expected;
+} xTests[] = {
+  { { "WIDE1", "WIDE2" }, { 1, 1 }, "APRS>F4ABC,F4DIG-1*,WIDE1*,WIDE2-1:" INFO },
+  { { "WIDE2" }, { 2 }, "APRS>F4ABC,F4DIG-1*,WIDE2-1:" INFO },
+  { { "TEST", "WIDE2" }, { 0, 2 }, "APRS>F4ABC,TEST*,F4DIG-1*,WIDE2-1:" INFO },
+  { { "RELAY" }, { 0 }, "APRS>F4ABC,F4DIG-1*:" INFO },
+  { { "F4DIG", "WIDE2" }, { 1, 1 }, "APRS>F4ABC,F4DIG-1*,WIDE2-1:" INFO },
+  { { "TRACE3" }, { 3 }, "APRS>F4ABC,TRACE3-2:" INFO },
+  { { "TRACE3" }, { 1 }, "APRS>F4ABC,TRACE3*:" INFO },
+  { { "WIDE7" }, { 7 }, "" },
+  { { "WIDE2" }, { 3 }, "" },
+  { { "OTHER" }, { 0 }, "" },
+  { { NULL }, { 0 }, "" },
+};
+#define NOF_TESTS (sizeof(xTests) / sizeof(xTests[0]))
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static xAx25 *
+xPort (int fdin, int fdout) {
+  xAx25 *p = xAx25New();
+
+  assert (p);
+  fcntl (fdin, F_SETFL, fcntl (fdin, F_GETFL) | O_NONBLOCK);
+  iAx25SetFdin (p, fdin);
+  iAx25SetFdout (p, fdout);
+  return p;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vSend (unsigned t, unsigned counter) {
+  char info[sizeof (INFO) + 8];
+
+  iAx25FrameClear (xFrame);
+  iAx25FrameSetDst (xFrame, "APRS", 0);
+  iAx25FrameSetSrc (xFrame, "F4ABC", 0);
+  for (int i = 0; (i < 3) && xTests[t].path[i]; i++) {
+
+    iAx25FrameAddRepeater (xFrame, xTests[t].path[i], xTests[t].ssid[i]);
+  }
+  if (xTests[t].path[0] && (strcmp (xTests[t].path[0], "TEST") == 0)) {
+
+    iAx25FrameSetRepeaterFlag (xFrame, 0, true);
+  }
+  strcpy (info, INFO);
+  if (counter) {
+
+    // makes the frame different for duplicate detection
+    sprintf (info + strlen (info), " %u", counter);
+  }
+  iAx25FrameSetInfo (xFrame, info, strlen (info));
+  assert (iAx25Send (xTx, xFrame) == AX25_SUCCESS);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io1[2], io2[2];
+  xAx25Digi *d;
+
+  assert ( (pipe (io1) == 0) && (pipe (io2) == 0));
+  xTx = xPort (io2[0], io1[1]);
+  xDigiPort = xPort (io1[0], io2[1]);
+  xRx = xPort (io2[0], io2[1]);
+  assert ( (xFrame = xAx25FrameNew()) != NULL);
+
+  assert ( (d = xAx25DigiNew ("F4DIG", 1)) != NULL);
+  assert (iAx25DigiAddAlias (d, "RELAY", 0) == AX25_SUCCESS);
+  assert (iAx25DigiAddWide (d, "WIDE", 2, true) == AX25_SUCCESS);
+  assert (iAx25DigiAddWide (d, "TRACE", 3, false) == AX25_SUCCESS);
+  assert (iAx25DigiAddWide (d, "TOOLONG", 3, false) != AX25_SUCCESS);
+
+  for (unsigned t = 0; t < NOF_TESTS; t++) {
+    char *str;
+    int ret;
+
+    vSend (t, t);
+    ret = iAx25DigiPoll (d, xDigiPort, NULL);
+    assert (ret >= 0);
+
+    if (bAx25Poll (xRx)) {
+
+      assert (iAx25Read (xRx, xFrame) == AX25_SUCCESS);
+      str = xAx25FrameToStr (xFrame);
+      printf ("%-60.60s\n", str); fflush (stdout);
+      assert (ret == 1);
+      assert (strncmp (str, xTests[t].expected, strlen (xTests[t].expected)) == 0);
+      free (str);
+    }
+    else {
+
+      printf ("not repeated\n");
+      assert (ret == 0);
+      assert (*xTests[t].expected == 0);
+    }
+  }
+
+  // The same frame is not repeated twice
+  vSend (0, 1000);
+  assert (iAx25DigiPoll (d, xDigiPort, NULL) == 1);
+  assert (bAx25Poll (xRx) && (iAx25Discard (xRx) == AX25_SUCCESS));
+  vSend (0, 1000);
+  assert (iAx25DigiPoll (d, xDigiPort, NULL) == 0);
+  assert (d->duplicated == 1);
+
+  vAx25DigiDelete (d);
+  vAx25FrameDelete (xFrame);
+  vAx25Delete (xTx);
+  vAx25Delete (xDigiPort);
+  vAx25Delete (xRx);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,156 @@
+/**
+ * @file test_ax25_filter.c
+ * @brief AX25 frame filter test
+ *
+ * Frames are sent through a pipe and received with a filter, the accepted
+ * frames are compared to the expected ones.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <radio/ax25.h>
+#include <radio/filter.h>
+
+/* private variables ======================================================== */
+static xAx25 *ax25;
+static xAx25Frame *xFrame;
+static int io[2];
+
+// Test frames: dst, src, repeater, repeater flag, info
+static const struct {
+  const char *dst;
+  uint8_t dst_ssid;
+  const char *src;
+  uint8_t src_ssid;
+  const char *rpt;
+  uint8_t rpt_ssid;
+  bool rpt_flag;
+  const char *info;
+} xFrames[] = {
+  { "APRS", 0, "F4ABC", 9, "WIDE2", 2, false, "!4903.50N/07201.75W-Test 001" },
+  { "APRS", 0, "F4XYZ", 0, "WIDE1", 0, true, "@092345z4903.50N/07201.75W>" },
+  { "TLM100", 0, "NOCALL", 0, "TEST", 0, true, ">Test 00001: SolarPi" },
+  { "APZ", 1, "F1ABC", 15, NULL, 0, false, ":F4ABC-9  :hello{1" },
+};
+#define NOF_FRAMES (sizeof(xFrames) / sizeof(xFrames[0]))
+
+// Filter expressions and the list of accepted frames (one bit per frame)
+static const struct {
+  const char *expr;
+  unsigned accepted;
+} xTests[] = {
+  { "", 0x0F },
+  { "dst:APRS", 0x03 },
+  { "dst:APRS-1", 0x00 },
+  { "dst:AP*", 0x0B },
+  { "src:F4ABC-*", 0x01 },
+  { "src:F4ABC", 0x00 },
+  { "src:F4*", 0x03 },
+  { "via:WIDE2-2", 0x01 },
+  { "used:*", 0x06 },
+  { "unused:WIDE*", 0x01 },
+  { "type:!=@/", 0x03 },
+  { "info:SolarPi", 0x04 },
+  { "info:\"Test 0\"", 0x05 },
+  { "dst:APRS & !src:F4XYZ", 0x01 },
+  { "dst:APRS and not src:F4XYZ", 0x01 },
+  { "dst:TLM100 | type::", 0x0C },
+  { "(dst:TLM100 | type::) src:F1ABC-15", 0x08 },
+  { "!(via:* | dst:APZ-1)", 0x00 },
+  { "!via:*", 0x08 },
+};
+#define NOF_TESTS (sizeof(xTests) / sizeof(xTests[0]))
+
+static const char *cBadExpr[] = {
+  "dst:", "foo:bar", "dst:TOOLONGCALL", "src:F4ABC-16", "(dst:APRS",
+  "dst:APRS |", "info:\"unterminated", "dst:F4-ABC"
+};
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vSend (unsigned i) {
+
+  iAx25FrameClear (xFrame);
+  iAx25FrameSetDst (xFrame, xFrames[i].dst, xFrames[i].dst_ssid);
+  iAx25FrameSetSrc (xFrame, xFrames[i].src, xFrames[i].src_ssid);
+  if (xFrames[i].rpt) {
+
+    iAx25FrameAddRepeater (xFrame, xFrames[i].rpt, xFrames[i].rpt_ssid);
+    iAx25FrameSetRepeaterFlag (xFrame, 0, xFrames[i].rpt_flag);
+  }
+  iAx25FrameSetInfo (xFrame, xFrames[i].info, strlen (xFrames[i].info));
+  assert (iAx25Send (ax25, xFrame) == AX25_SUCCESS);
+}
+
+// -----------------------------------------------------------------------------
+static unsigned
+uReceive (void) {
+  unsigned accepted = 0;
+
+  while (bAx25Poll (ax25)) {
+
+    assert (iAx25Read (ax25, xFrame) == AX25_SUCCESS);
+    for (unsigned i = 0; i < NOF_FRAMES; i++) {
+
+      if ( (strcmp (xFrame->src->callsign, xFrames[i].src) == 0) &&
+           (strncmp ( (const char *) xFrame->info, xFrames[i].info, xFrame->info_len) == 0)) {
+
+        accepted |= 1 << i;
+      }
+    }
+  }
+  return accepted;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  xAx25Filter *f;
+
+  assert (pipe (io) == 0);
+  fcntl (io[0], F_SETFL, fcntl (io[0], F_GETFL) | O_NONBLOCK);
+
+  assert ( (xFrame = xAx25FrameNew()) != NULL);
+  assert ( (ax25 = xAx25New()) != NULL);
+  iAx25SetFdout (ax25, io[1]);
+  iAx25SetFdin (ax25, io[0]);
+
+  for (unsigned t = 0; t < NOF_TESTS; t++) {
+    unsigned accepted;
+
+    f = xAx25FilterNew (xTests[t].expr);
+    assert (f != NULL);
+    iAx25SetFilter (ax25, f);
+
+    for (unsigned i = 0; i < NOF_FRAMES; i++) {
+
+      vSend (i);
+    }
+    accepted = uReceive();
+    printf ("%-40s %02X (expected %02X, %d instructions)\n", xTests[t].expr,
+            accepted, xTests[t].accepted, f->len);
+    assert (accepted == xTests[t].accepted);
+    iAx25SetFilter (ax25, NULL);
+    vAx25FilterDelete (f);
+  }
+
+  for (unsigned t = 0; t < sizeof (cBadExpr) / sizeof (cBadExpr[0]); t++) {
+
+    assert (xAx25FilterNew (cBadExpr[t]) == NULL);
+  }
+
+  vAx25FrameDelete (xFrame);
+  vAx25Delete (ax25);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,111 @@
+/**
+ * @file test_ax25_handler.c
+ * @brief AX25 receive handler test
+ *
+ * A receive handler is set with iAx25SetRxHandler(): all the frames written
+ * in a pipe must be given to the handler, in order, by a single call to
+ * bAx25PollTimeout(), then by a single call to bAx25Feed(). Without
+ * handler, the frames must be read with iAx25Read() again.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <radio/ax25.h>
+
+/* constants ================================================================ */
+#define FRAMES 100
+#define TIMEOUT 50
+#define INFO ">Test handler %03d"
+
+/* private variables ======================================================== */
+static int iReceived;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vHandler (xAx25 *ax25, const xAx25View *frame, void *ctx) {
+  char info[32];
+  xAx25Node src;
+
+  assert (ctx == &iReceived);
+  snprintf (info, sizeof (info), INFO, iReceived);
+  assert ( (frame->info_len == strlen (info)) &&
+           (memcmp (frame->info, info, frame->info_len) == 0));
+  assert (iAx25ViewGetNode (frame, 1, &src) == AX25_SUCCESS);
+  assert (strcmp (src.callsign, "F4ABC") == 0);
+  iReceived++;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2], raw[2];
+  static uint8_t buf[FRAMES * AX25_RAW_SIZE (64)];
+  size_t len = 0, used;
+  ssize_t n;
+  xAx25 *xAx25;
+  xAx25Frame *xFrame;
+
+  assert ( (pipe (io) == 0) && (pipe (raw) == 0));
+  xAx25 = xAx25New();
+  xFrame = xAx25FrameNew();
+  assert (xAx25 && xFrame);
+  iAx25SetFdin (xAx25, io[0]);
+
+  // The frames are built in the raw pipe
+  iAx25SetFdout (xAx25, raw[1]);
+  iAx25FrameSetDst (xFrame, "APRS", 0);
+  iAx25FrameSetSrc (xFrame, "F4ABC", 1);
+  for (int i = 0; i < FRAMES; i++) {
+    char info[32];
+
+    iAx25FrameSetInfo (xFrame, info, snprintf (info, sizeof (info), INFO, i));
+    assert (iAx25Send (xAx25, xFrame) == AX25_SUCCESS);
+    n = read (raw[0], &buf[len], sizeof (buf) - len);
+    assert (n > 0);
+    len += n;
+  }
+  assert (iAx25SetRxHandler (xAx25, vHandler, &iReceived) == AX25_SUCCESS);
+
+  // All the frames are given to the handler by one call
+  assert (write (io[1], buf, len) == (ssize_t) len);
+  assert (bAx25PollTimeout (xAx25, TIMEOUT));
+  printf ("bAx25PollTimeout: %d frames received\n", iReceived);
+  assert ( (iReceived == FRAMES) && (xAx25->rx_frames == FRAMES));
+  assert (iAx25Read (xAx25, xFrame) != AX25_SUCCESS);
+  assert (!bAx25PollTimeout (xAx25, 0));
+
+  // Same with bytes given by the caller
+  iReceived = 0;
+  assert (bAx25Feed (xAx25, buf, len, &used));
+  printf ("bAx25Feed: %d frames received\n", iReceived);
+  assert ( (iReceived == FRAMES) && (used == len));
+
+  // Without handler, one frame is received at once
+  iAx25SetRxHandler (xAx25, NULL, NULL);
+  assert (write (io[1], buf, len) == (ssize_t) len);
+  for (int i = 0; i < FRAMES; i++) {
+    char info[32];
+
+    snprintf (info, sizeof (info), INFO, i);
+    assert (bAx25PollTimeout (xAx25, TIMEOUT));
+    assert (iAx25Read (xAx25, xFrame) == AX25_SUCCESS);
+    assert ( (xFrame->info_len == strlen (info)) &&
+             (memcmp (xFrame->info, info, xFrame->info_len) == 0));
+  }
+  assert (!bAx25PollTimeout (xAx25, 0));
+  assert (iReceived == FRAMES);
+
+  vAx25FrameDelete (xFrame);
+  vAx25Delete (xAx25);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,276 @@
+/**
+ * @file test_ax25_link.c
+ * @brief AX25 connected mode link test
+ *
+ * Two stations are connected through a digipeater which drops some of the
+ * frames. A connection to a station which does not listen must be refused.
+ * Data are then exchanged in both directions in modulo 8, in modulo 128 with
+ * SREJ and in modulo 128 with REJ, before the connection is released. A
+ * connection whose frames are no longer repeated must be lost after N2
+ * retries.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <radio/link.h>
+#include <radio/digi.h>
+
+/* constants ================================================================ */
+#define DATA_LEN 20000
+#define TIMEOUT 30
+
+/* structures =============================================================== */
+typedef struct xStation {
+  xAx25 *port;
+  xAx25Link *link;
+  xAx25Conn *conn;
+  uint8_t rx[DATA_LEN];
+  size_t rx_len;
+  int connected;
+  int disconnected;
+  int reason;
+} xStation;
+
+/* private variables ======================================================== */
+static xStation xA, xB;
+static xAx25 *xRelayA, *xRelayB;
+static xAx25Digi *xDigi;
+static uint8_t ucDataA[DATA_LEN], ucDataB[DATA_LEN];
+static unsigned uDrop; // every uDrop frame is dropped, all if 1
+static unsigned uRelayed;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vHandler (xAx25Conn *c, int event, const uint8_t *data, size_t len, void *ctx) {
+  xStation *s = ctx;
+
+  switch (event) {
+
+    case AX25_LINK_EV_CONNECTED:
+      s->conn = c;
+      s->connected++;
+      break;
+
+    case AX25_LINK_EV_DISCONNECTED:
+      s->conn = NULL;
+      s->disconnected++;
+      s->reason = c->reason;
+      break;
+
+    case AX25_LINK_EV_DATA:
+      assert (s->rx_len + len <= DATA_LEN);
+      memcpy (&s->rx[s->rx_len], data, len);
+      s->rx_len += len;
+      break;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Repeats the frames received on in to out
+static void
+vRelay (xAx25 *in, xAx25 *out) {
+
+  while (bAx25PollTimeout (in, 0)) {
+
+    if ( (uDrop != 1) && ( (uDrop == 0) || (++uRelayed % uDrop))) {
+
+      assert (iAx25DigiProcess (xDigi, in->dec.buf, &in->dec.len, AX25_FRAME_BUF_LEN) == 1);
+      assert (iAx25SendRaw (out, in->dec.buf, in->dec.len) == AX25_SUCCESS);
+    }
+    iAx25Discard (in);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+vStep (void) {
+
+  assert (iAx25LinkPoll (xA.link, 1) >= 0);
+  vRelay (xRelayA, xRelayB);
+  assert (iAx25LinkPoll (xB.link, 0) >= 0);
+  vRelay (xRelayB, xRelayA);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vReset (xStation *s) {
+
+  s->rx_len = 0;
+  s->connected = s->disconnected = 0;
+  s->reason = 1;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vWait (bool (*done) (void)) {
+  time_t t = time (NULL);
+
+  while (!done()) {
+
+    assert (time (NULL) - t < TIMEOUT);
+    vStep();
+  }
+}
+
+// -----------------------------------------------------------------------------
+static bool
+bConnected (void) {
+
+  return xA.connected && xB.connected;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+bDisconnected (void) {
+
+  return xA.disconnected && xB.disconnected;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+bRefused (void) {
+
+  return xA.disconnected;
+}
+
+// -----------------------------------------------------------------------------
+static bool
+bReceived (void) {
+
+  return (xB.rx_len == DATA_LEN) && (xA.rx_len == DATA_LEN / 4) &&
+         (uAx25ConnPending (xA.conn) == 0) && (uAx25ConnPending (xB.conn) == 0);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vConnect (bool extended) {
+  xAx25Node b, relay;
+  xAx25Conn *c;
+
+  iAx25NodeClear (&b);
+  iAx25NodeSetCallsign (&b, "F4XYZ");
+  iAx25NodeSetSsid (&b, 2);
+  iAx25NodeClear (&relay);
+  iAx25NodeSetCallsign (&relay, "RELAY");
+
+  vReset (&xA);
+  vReset (&xB);
+  c = xAx25LinkConnect (xA.link, &b, &relay, 1, extended);
+  assert (c && (c->state == AX25_LINK_AWAITING_CONNECTION));
+  assert (xAx25LinkFind (xA.link, &b) == c);
+  assert (xAx25LinkConnect (xA.link, &b, &relay, 1, extended) == NULL);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTransfer (bool extended, bool srej, unsigned drop) {
+  unsigned long sent, resent;
+
+  iAx25LinkSetSrej (xA.link, srej);
+  iAx25LinkSetSrej (xB.link, srej);
+  uDrop = drop;
+  vConnect (extended);
+  vWait (bConnected);
+  assert ( (xA.conn->modulo == (extended ? 128 : 8)) && (xB.conn->modulo == xA.conn->modulo));
+  assert ( (xA.conn->state == AX25_LINK_CONNECTED) && (xB.conn->state == AX25_LINK_CONNECTED));
+
+  sent = xA.link->frames_sent;
+  resent = xA.link->frames_resent;
+  assert (iAx25ConnSend (xA.conn, ucDataA, DATA_LEN) == DATA_LEN);
+  assert (iAx25ConnSend (xB.conn, ucDataB, DATA_LEN / 4) == DATA_LEN / 4);
+  vWait (bReceived);
+  assert (memcmp (xB.rx, ucDataA, DATA_LEN) == 0);
+  assert (memcmp (xA.rx, ucDataB, DATA_LEN / 4) == 0);
+  printf ("Modulo %u, k=%u, %s, 1/%u dropped: %lu frames sent, %lu I frames resent, SRTT %ld ms\n",
+          xA.conn->modulo, xA.conn->k, xA.conn->srej ? "SREJ" : "REJ", drop,
+          xA.link->frames_sent - sent, xA.link->frames_resent - resent, xA.conn->srtt);
+
+  assert (iAx25ConnDisconnect (xA.conn) == AX25_SUCCESS);
+  assert (iAx25ConnSend (xA.conn, ucDataA, 1) == AX25_CONNECTION_LOST);
+  vWait (bDisconnected);
+  assert ( (xA.reason == AX25_SUCCESS) && (xB.reason == AX25_SUCCESS));
+  assert ( (xA.link->conn == NULL) && (xB.link->conn == NULL));
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int a2r[2], r2a[2], b2r[2], r2b[2];
+
+  assert ( (pipe (a2r) == 0) && (pipe (r2a) == 0) && (pipe (b2r) == 0) && (pipe (r2b) == 0));
+  xA.port = xAx25New();
+  xB.port = xAx25New();
+  xRelayA = xAx25New();
+  xRelayB = xAx25New();
+  assert (xA.port && xB.port && xRelayA && xRelayB);
+  iAx25SetFdout (xA.port, a2r[1]);
+  iAx25SetFdin (xA.port, r2a[0]);
+  iAx25SetFdout (xB.port, b2r[1]);
+  iAx25SetFdin (xB.port, r2b[0]);
+  iAx25SetFdin (xRelayA, a2r[0]);
+  iAx25SetFdout (xRelayA, r2a[1]);
+  iAx25SetFdin (xRelayB, b2r[0]);
+  iAx25SetFdout (xRelayB, r2b[1]);
+
+  xDigi = xAx25DigiNew ("RELAY", 0);
+  xA.link = xAx25LinkNew (xA.port, "F4ABC", 1, vHandler, &xA);
+  xB.link = xAx25LinkNew (xB.port, "F4XYZ", 2, vHandler, &xB);
+  assert (xDigi && xA.link && xB.link);
+  assert (xAx25LinkNew (xA.port, "F4-ABC", 1, vHandler, &xA) == NULL);
+  assert (iAx25DigiSetDupeTime (xDigi, 0) == AX25_SUCCESS);
+  assert (iAx25LinkSetWindow (xA.link, 8, 32) == AX25_INVALID_FRAME);
+  assert (iAx25LinkSetWindow (xA.link, 7, 32) == AX25_SUCCESS);
+  assert (iAx25LinkSetWindow (xB.link, 7, 32) == AX25_SUCCESS);
+  assert (iAx25LinkSetTimers (xA.link, 100, 10, 10000) == AX25_SUCCESS);
+  assert (iAx25LinkSetTimers (xB.link, 100, 10, 10000) == AX25_SUCCESS);
+  for (int i = 0; i < DATA_LEN; i++) {
+
+    ucDataA[i] = i * 7 + (i >> 8);
+    ucDataB[i] = i * 13 + (i >> 7);
+  }
+
+  // B does not listen
+  vConnect (false);
+  vWait (bRefused);
+  printf ("Connection refused\n");
+  assert ( (xA.reason == AX25_CONNECTION_REFUSED) && (xA.link->conn == NULL) && (xB.link->conn == NULL));
+  assert (iAx25LinkListen (xB.link, true) == AX25_SUCCESS);
+
+  vTransfer (false, false, 0);
+  vTransfer (false, false, 7);
+  vTransfer (true, true, 0);
+  vTransfer (true, true, 11);
+  vTransfer (true, false, 11);
+
+  // The frames are no longer repeated
+  assert (iAx25LinkSetLimits (xA.link, 128, 3) == AX25_SUCCESS);
+  uDrop = 0;
+  vConnect (false);
+  vWait (bConnected);
+  assert (xA.conn->n1 == 128);
+  uDrop = 1;
+  assert (iAx25ConnSend (xA.conn, ucDataA, 1000) == 1000);
+  vWait (bRefused);
+  printf ("Connection lost\n");
+  assert ( (xA.reason == AX25_CONNECTION_LOST) && (xA.link->conn == NULL));
+
+  vAx25LinkDelete (xA.link);
+  vAx25LinkDelete (xB.link);
+  vAx25DigiDelete (xDigi);
+  vAx25Delete (xA.port);
+  vAx25Delete (xB.port);
+  vAx25Delete (xRelayA);
+  vAx25Delete (xRelayB);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
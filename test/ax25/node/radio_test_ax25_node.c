@@ -0,0 +1,106 @@
+/**
+ * @file test_ax25_node.c
+ * @brief AX25 node encoding test
+ *
+ * The address encoded by iAx25NodeEncode() must follow the changes of the
+ * callsign, the SSID and the flag made with the setters, and the changes of
+ * the callsign, ssid and flag fields written directly, even in a node never
+ * cleared. A node read from a frame must be encoded as the address of the
+ * frame.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <radio/ax25.h>
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// Checks the encoded address of n, ssid byte without the last bit
+static void
+vCheck (const xAx25Node *n, const char *call, uint8_t ssid) {
+  uint8_t addr[AX25_CALL_LEN + 1];
+
+  assert (iAx25NodeEncode (n, addr) == AX25_SUCCESS);
+  for (int i = 0; i < AX25_CALL_LEN; i++) {
+
+    assert (addr[i] == call[i] << 1);
+  }
+  assert (addr[AX25_CALL_LEN] == ssid);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  xAx25Node *n = xAx25NodeNew();
+  xAx25Frame *f = xAx25FrameNew();
+  xAx25Encoder *e = xAx25EncoderNew();
+  uint8_t raw[AX25_CALL_LEN + 1];
+  xAx25View v;
+  xAx25Node r;
+
+  assert (n && f && e);
+  vCheck (n, "      ", 0x60);
+
+  // Setters
+  assert (iAx25NodeSetCallsign (n, "f4abc") == AX25_SUCCESS);
+  vCheck (n, "F4ABC ", 0x60);
+  assert (iAx25NodeSetSsid (n, 7) == AX25_SUCCESS);
+  vCheck (n, "F4ABC ", 0x60 | (7 << 1));
+  assert (iAx25NodeSetFlag (n, true) == AX25_SUCCESS);
+  vCheck (n, "F4ABC ", 0x80 | 0x60 | (7 << 1));
+  assert (iAx25NodeSetCallsign (n, "WIDE2") == AX25_SUCCESS);
+  vCheck (n, "WIDE2 ", 0x80 | 0x60 | (7 << 1));
+
+  // Fields written directly
+  n->ssid = 2;
+  n->flag = false;
+  vCheck (n, "WIDE2 ", 0x60 | (2 << 1));
+  strcpy (n->callsign, "RELAY");
+  vCheck (n, "RELAY ", 0x60 | (2 << 1));
+
+  // Node never cleared
+  memset (&r, 0x5A, sizeof (r));
+  strcpy (r.callsign, "F4XYZ");
+  r.ssid = 5;
+  r.flag = false;
+  vCheck (&r, "F4XYZ ", 0x60 | (5 << 1));
+
+  // Illegal callsign, until a legal one is set
+  assert (iAx25NodeSetCallsign (n, "F4-ABC") == AX25_SUCCESS);
+  assert (iAx25NodeEncode (n, raw) == AX25_ILLEGAL_CALLSIGN);
+  assert (iAx25NodeSetSsid (n, 3) == AX25_SUCCESS);
+  assert (iAx25NodeEncode (n, raw) == AX25_ILLEGAL_CALLSIGN);
+  assert (iAx25NodeSetCallsign (n, "F4ABCDEF") == AX25_SUCCESS);
+  vCheck (n, "F4ABCD", 0x60 | (3 << 1));
+
+  // Nodes read from a frame are encoded as in the frame
+  iAx25FrameSetDst (f, "APRS", 0);
+  iAx25FrameSetSrc (f, "F4ABC", 1);
+  iAx25FrameAddRepeater (f, "WIDE1", 1);
+  iAx25FrameSetRepeaterFlag (f, 0, true);
+  iAx25FrameAddRepeater (f, "WIDE2", 2);
+  assert (iAx25EncoderSetFrame (e, f) == AX25_SUCCESS);
+  assert (iAx25ViewInit (&v, e->frame, e->len - 2) == AX25_SUCCESS);
+  for (unsigned i = 0; i < v.naddr; i++) {
+    uint8_t addr[AX25_CALL_LEN + 1];
+
+    assert (iAx25ViewGetNode (&v, i, &r) == AX25_SUCCESS);
+    assert (iAx25NodeEncode (&r, addr) == AX25_SUCCESS);
+    addr[AX25_CALL_LEN] |= (i == v.naddr - 1);
+    assert (memcmp (addr, &e->frame[i * (AX25_CALL_LEN + 1)], AX25_CALL_LEN + 1) == 0);
+  }
+  printf ("%u addresses encoded as in the frame\n", v.naddr);
+
+  vAx25EncoderDelete (e);
+  vAx25FrameDelete (f);
+  vAx25NodeDelete (n);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,152 @@
+/**
+ * @file test_ax25_pcap.c
+ * @brief AX25 pcap/pcapng export test
+ *
+ * Frames of several ports are exported to a pcapng file and to rotated pcap
+ * files with a KISS header, the files are then parsed and checked.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <radio/pcap.h>
+
+/* constants ================================================================ */
+#define COUNT 1000
+#define PORTS 3
+#define PCAPNG_FILE "/tmp/radio_test_ax25_pcap.pcapng"
+#define PCAP_PATH "/tmp/radio_test_ax25_pcap.pcap"
+#define ROTATE_SIZE 8192
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static size_t
+prvuFrame (uint8_t *frame, int i) {
+  size_t len = 16 + (i % 64);
+
+  for (size_t j = 0; j < len; j++) {
+    frame[j] = i + j;
+  }
+  return len;
+}
+
+// -----------------------------------------------------------------------------
+static uint32_t
+prvulGet32 (const uint8_t *p) {
+  uint32_t v;
+
+  memcpy (&v, p, sizeof (v));
+  return v;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vWriteAll (xPcap *xPcap) {
+
+  for (int i = 0; i < COUNT; i++) {
+    uint8_t frame[128];
+    size_t len = prvuFrame (frame, i);
+
+    while (iPcapWrite (xPcap, i % PORTS, frame, len) == AX25_NOT_ENOUGH_MEMORY) {
+      usleep (1000);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+static uint8_t *
+pucLoad (const char *file, size_t *len) {
+  static uint8_t buf[1024 * 1024];
+  FILE *f = fopen (file, "rb");
+
+  if (!f) {
+    return NULL;
+  }
+  *len = fread (buf, 1, sizeof (buf), f);
+  fclose (f);
+  return buf;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  xPcap *xPcap;
+  uint8_t *b;
+  size_t len, pos;
+  int count = 0, nif = 0, files = 0;
+
+  // pcapng, one interface per port
+  xPcap = xPcapNew (PCAPNG_FILE, AX25_PCAPNG, false, 4096, 0);
+  assert (xPcap);
+  vWriteAll (xPcap);
+  vPcapDelete (xPcap);
+
+  b = pucLoad (PCAPNG_FILE, &len);
+  assert (b);
+  assert (prvulGet32 (b) == 0x0A0D0D0A);
+  for (pos = 0; pos < len; pos += prvulGet32 (&b[pos + 4])) {
+    uint32_t type = prvulGet32 (&b[pos]);
+    uint32_t blen = prvulGet32 (&b[pos + 4]);
+
+    assert (prvulGet32 (&b[pos + blen - 4]) == blen);
+    if (type == 1) {
+
+      assert ( (b[pos + 8] | (b[pos + 9] << 8)) == AX25_LINKTYPE_AX25);
+      nif++;
+    }
+    else if (type == 6) {
+      uint8_t frame[128];
+      size_t flen = prvuFrame (frame, count);
+
+      // Interfaces are created in the order the ports are seen
+      assert (prvulGet32 (&b[pos + 8]) == count % PORTS);
+      assert (prvulGet32 (&b[pos + 20]) == flen);
+      assert (memcmp (&b[pos + 28], frame, flen) == 0);
+      count++;
+    }
+  }
+  printf ("pcapng: %d frames, %d interfaces\n", count, nif);
+  assert ( (count == COUNT) && (nif == PORTS));
+  unlink (PCAPNG_FILE);
+
+  // Rotated pcap files, the port is in the KISS byte
+  xPcap = xPcapNew (PCAP_PATH, AX25_PCAP, true, 0, ROTATE_SIZE);
+  assert (xPcap);
+  vWriteAll (xPcap);
+  vPcapDelete (xPcap);
+
+  count = 0;
+  for (;;) {
+    char file[64];
+
+    snprintf (file, sizeof (file), "%s.%04u", PCAP_PATH, files);
+    if ( (b = pucLoad (file, &len)) == NULL) {
+      break;
+    }
+    assert (len <= ROTATE_SIZE);
+    assert (prvulGet32 (b) == 0xA1B23C4D);
+    assert (prvulGet32 (&b[20]) == AX25_LINKTYPE_AX25_KISS);
+    for (pos = 24; pos < len; pos += 16 + prvulGet32 (&b[pos + 8])) {
+      uint8_t frame[128];
+      size_t flen = prvuFrame (frame, count);
+
+      assert (prvulGet32 (&b[pos + 8]) == flen + 1);
+      assert (b[pos + 16] == (count % PORTS) << 4);
+      assert (memcmp (&b[pos + 17], frame, flen) == 0);
+      count++;
+    }
+    unlink (file);
+    files++;
+  }
+  printf ("pcap: %d frames in %d files\n", count, files);
+  assert ( (count == COUNT) && (files > 1));
+
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file test_ax25_template.c
+ * @brief AX25 frame template test
+ *
+ * The same frames are sent with iAx25Send() and with a template, the bytes
+ * written must be identical and the frames must be received correctly.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <radio/ax25.h>
+
+/* constants ================================================================ */
+#define INFO ">Test %05d: SolarPi (\x7E\x1B\x7F) APRS http://www.btssn.net"
+#define COUNT 100
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vOpenPipe (int *io) {
+  int flag;
+
+  assert (pipe (io) == 0);
+  flag = fcntl (io[0], F_GETFL);
+  fcntl (io[0], F_SETFL, flag | O_NONBLOCK);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int ref[2], tpl[2];
+  xAx25 *xRef, *xTpl;
+  xAx25Frame *xFrame, *xRxFrame;
+  xAx25Template *xTemplate;
+
+  vOpenPipe (ref);
+  vOpenPipe (tpl);
+  xRef = xAx25New();
+  xTpl = xAx25New();
+  assert (xRef && xTpl);
+  iAx25SetFdout (xRef, ref[1]);
+  iAx25SetFdout (xTpl, tpl[1]);
+  iAx25SetFdin (xTpl, tpl[0]);
+
+  xFrame = xAx25FrameNew();
+  xRxFrame = xAx25FrameNew();
+  iAx25FrameSetDst (xFrame, "APRS", 0);
+  iAx25FrameSetSrc (xFrame, "F4ABC", 15); // 0x7E SSID byte is escaped
+  iAx25FrameAddRepeater (xFrame, "WIDE1", 1);
+  iAx25FrameAddRepeater (xFrame, "WIDE2", 2);
+  iAx25FrameSetRepeaterFlag (xFrame, 0, true);
+
+  xTemplate = xAx25TemplateNew (xFrame);
+  assert (xTemplate);
+
+  for (int i = 0; i < COUNT; i++) {
+    char cInfo[80];
+    uint8_t a[AX25_FRAME_BUF_LEN * 2], b[AX25_FRAME_BUF_LEN * 2];
+    ssize_t alen, blen;
+    int len;
+
+    len = snprintf (cInfo, sizeof (cInfo), INFO, i);
+    iAx25FrameSetInfo (xFrame, cInfo, len);
+    assert (iAx25Send (xRef, xFrame) == AX25_SUCCESS);
+    assert (iAx25TemplateSend (xTpl, xTemplate, cInfo, len) == AX25_SUCCESS);
+
+    alen = read (ref[0], a, sizeof (a));
+    blen = read (tpl[0], b, sizeof (b));
+    assert ( (alen > 0) && (alen == blen));
+    assert (memcmp (a, b, alen) == 0);
+  }
+
+  // The frame built from the template is received correctly
+  assert (iAx25TemplateSend (xTpl, xTemplate, "!", 1) == AX25_SUCCESS);
+  assert (bAx25Poll (xTpl));
+  assert (iAx25Read (xTpl, xRxFrame) == AX25_SUCCESS);
+  printf ("%s\n", xAx25FrameToStr (xRxFrame));
+  assert (strcmp (xAx25FrameToStr (xRxFrame), "APRS>F4ABC-15,WIDE1-1*,WIDE2-2:!") == 0);
+
+  vAx25TemplateDelete (xTemplate);
+  vAx25FrameDelete (xFrame);
+  vAx25FrameDelete (xRxFrame);
+  vAx25Delete (xRef);
+  vAx25Delete (xTpl);
+  printf ("%d frames checked\nSuccess ! Have a nice day !\n", COUNT);
+  return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file test_ax25_timeout.c
+ * @brief AX25 receive with deadline test
+ *
+ * bAx25PollTimeout() is used on a blocking pipe: it must return on timeout
+ * when nothing is received or when only a part of a frame is received, and
+ * return true as soon as a frame is complete.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <radio/ax25.h>
+
+/* constants ================================================================ */
+#define TIMEOUT 50
+#define INFO ">Test timeout"
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static long
+lNowMs (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2], raw[2];
+  uint8_t buf[AX25_FRAME_BUF_LEN * 2];
+  ssize_t len;
+  long t;
+  xAx25 *xAx25;
+  xAx25Frame *xFrame;
+
+  // Both pipes are blocking
+  assert ( (pipe (io) == 0) && (pipe (raw) == 0));
+  xAx25 = xAx25New();
+  xFrame = xAx25FrameNew();
+  assert (xAx25 && xFrame);
+  iAx25SetFdin (xAx25, io[0]);
+
+  // The frame is built in the raw pipe, then sent by pieces
+  iAx25SetFdout (xAx25, raw[1]);
+  iAx25FrameSetDst (xFrame, "APRS", 0);
+  iAx25FrameSetSrc (xFrame, "F4ABC", 1);
+  iAx25FrameSetInfo (xFrame, INFO, strlen (INFO));
+  assert (iAx25Send (xAx25, xFrame) == AX25_SUCCESS);
+  len = read (raw[0], buf, sizeof (buf));
+  assert (len > 10);
+
+  // Nothing received
+  t = lNowMs();
+  assert (!bAx25PollTimeout (xAx25, TIMEOUT));
+  t = lNowMs() - t;
+  printf ("No data: timeout after %ld ms\n", t);
+  assert ( (t >= TIMEOUT - 1) && (t < TIMEOUT * 4));
+
+  // Part of a frame received
+  assert (write (io[1], buf, len / 2) == len / 2);
+  t = lNowMs();
+  assert (!bAx25PollTimeout (xAx25, TIMEOUT));
+  t = lNowMs() - t;
+  printf ("Partial frame: timeout after %ld ms\n", t);
+  assert ( (t >= TIMEOUT - 1) && (t < TIMEOUT * 4));
+
+  // End of the frame received
+  assert (write (io[1], &buf[len / 2], len - len / 2) == len - len / 2);
+  t = lNowMs();
+  assert (bAx25PollTimeout (xAx25, TIMEOUT));
+  t = lNowMs() - t;
+  printf ("Complete frame: received after %ld ms\n", t);
+  assert (t < TIMEOUT);
+  assert (iAx25Read (xAx25, xFrame) == AX25_SUCCESS);
+  printf ("%s\n", xAx25FrameToStr (xFrame));
+  assert ( (xFrame->info_len == strlen (INFO)) &&
+           (memcmp (xFrame->info, INFO, xFrame->info_len) == 0));
+
+  // Two frames written at once are both received
+  assert (write (io[1], buf, len) == len);
+  assert (write (io[1], buf, len) == len);
+  assert (bAx25PollTimeout (xAx25, TIMEOUT));
+  iAx25Discard (xAx25);
+  assert (bAx25PollTimeout (xAx25, 0));
+  iAx25Discard (xAx25);
+  assert (!bAx25PollTimeout (xAx25, 0));
+
+  vAx25FrameDelete (xFrame);
+  vAx25Delete (xAx25);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file test_ax25_tun.c
+ * @brief AX25 PID handling and IPv4 bridge test
+ *
+ * A frame whose PID is not accepted must be rejected and released by
+ * iAx25Read() until its PID is accepted. Two bridges are then connected by pipes, the TUN
+ * interfaces being replaced by packet sockets: the packets written on the
+ * interface of the first bridge must be read unchanged on the interface of
+ * the second, through the route of the longest prefix, and the packets
+ * without route, too long or which are not IPv4 must be dropped. The TUN
+ * interface is opened when the system allows it.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include <radio/tun.h>
+
+/* constants ================================================================ */
+#define PACKETS 100
+#define IP_HDR 20
+
+/* private variables ======================================================== */
+static uint8_t ucPacket[PACKETS][AX25_INFO_LEN + 1];
+static size_t uPacketLen[PACKETS];
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// IPv4 packet of len bytes to dst
+static size_t
+uPacket (uint8_t *pkt, size_t len, const char *dst, int seed) {
+
+  for (size_t i = 0; i < len; i++) {
+
+    pkt[i] = seed + i * 31;
+  }
+  pkt[0] = 0x45;
+  inet_pton (AF_INET, "10.0.0.1", &pkt[12]);
+  inet_pton (AF_INET, dst, &pkt[16]);
+  return len;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vNode (xAx25Node *n, const char *callsign, uint8_t ssid) {
+
+  iAx25NodeClear (n);
+  iAx25NodeSetCallsign (n, callsign);
+  iAx25NodeSetSsid (n, ssid);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int a2b[2], b2a[2], ifa[2], ifb[2];
+  xAx25 *xPortA = xAx25New(), *xPortB = xAx25New();
+  xAx25Frame *f = xAx25FrameNew();
+  xAx25Tun *a, *b;
+  xAx25Node dst;
+  xAx25View v;
+  uint32_t net;
+  uint8_t buf[AX25_INFO_LEN + 2];
+  int n, got;
+
+  assert (xPortA && xPortB && f);
+  assert ( (pipe (a2b) == 0) && (pipe (b2a) == 0));
+  iAx25SetFdout (xPortA, a2b[1]);
+  iAx25SetFdin (xPortB, a2b[0]);
+  iAx25SetFdout (xPortB, b2a[1]);
+  iAx25SetFdin (xPortA, b2a[0]);
+
+  // PID handling
+  iAx25FrameSetDst (f, "F4XYZ", 2);
+  iAx25FrameSetSrc (f, "F4ABC", 1);
+  f->pid = AX25_PID_IP;
+  iAx25FrameSetInfo (f, ucPacket[0], uPacket (ucPacket[0], 40, "10.0.0.2", 0));
+  for (int i = 0; i < 4; i++) {
+
+    assert (iAx25Send (xPortA, f) == AX25_SUCCESS);
+  }
+  assert (bAx25Poll (xPortB));
+  assert (iAx25Read (xPortB, f) == AX25_INVALID_FRAME);
+  assert (iAx25Discard (xPortB) == AX25_NO_FRAME_RECEIVED);
+  assert (iAx25SetPid (xPortB, AX25_PID_IP, true) == AX25_SUCCESS);
+  assert (bAx25Poll (xPortB));
+  assert ( (iAx25Read (xPortB, f) == AX25_SUCCESS) && (f->pid == AX25_PID_IP));
+  assert ( (f->info_len == 40) && (memcmp (f->info, ucPacket[0], 40) == 0));
+  assert (iAx25SetAllPid (xPortB, false) == AX25_SUCCESS);
+  assert (bAx25Poll (xPortB));
+  assert (iAx25ReadView (xPortB, &v) == AX25_SUCCESS);
+  assert (iAx25Read (xPortB, f) == AX25_INVALID_FRAME);
+  assert (iAx25ReadView (xPortB, &v) == AX25_NO_FRAME_RECEIVED);
+  assert (iAx25SetAllPid (xPortB, true) == AX25_SUCCESS);
+  assert (bAx25Poll (xPortB));
+  assert (iAx25Read (xPortB, f) == AX25_SUCCESS);
+  iAx25Clear (xPortB);
+  iAx25SetFdin (xPortB, a2b[0]);
+  iAx25SetFdout (xPortB, b2a[1]);
+  printf ("PID handling checked\n");
+
+  // Bridges
+  assert ( (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, ifa) == 0) &&
+           (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, ifb) == 0));
+  a = xAx25TunNew (xPortA, "F4ABC", 1);
+  b = xAx25TunNew (xPortB, "F4XYZ", 2);
+  assert (a && b);
+  assert (xAx25TunNew (xPortA, "F4-ABC", 1) == NULL);
+  assert ( (iAx25TunSetFd (a, ifa[0]) == AX25_SUCCESS) && (iAx25TunSetFd (b, ifb[0]) == AX25_SUCCESS));
+
+  // 10.0.0.2 is F4XYZ-2, the rest of 10.0.0.0/8 is F4OTH
+  inet_pton (AF_INET, "10.0.0.0", &net);
+  vNode (&dst, "F4OTH", 0);
+  assert (iAx25TunAddRoute (a, net, 8, &dst, NULL, 0) == AX25_SUCCESS);
+  inet_pton (AF_INET, "10.0.0.2", &net);
+  vNode (&dst, "F4XYZ", 2);
+  assert (iAx25TunAddRoute (a, net, 32, &dst, NULL, 0) == AX25_SUCCESS);
+  inet_pton (AF_INET, "0.0.0.0", &net);
+  vNode (&dst, "F4ABC", 1);
+  assert (iAx25TunAddRoute (b, net, 0, &dst, NULL, 0) == AX25_SUCCESS);
+  assert (iAx25TunAddRoute (b, net, 33, &dst, NULL, 0) == AX25_INVALID_FRAME);
+
+  for (int i = 0; i < PACKETS; i++) {
+
+    uPacketLen[i] = uPacket (ucPacket[i], IP_HDR + (i * 37) % (AX25_INFO_LEN - IP_HDR + 1),
+                             "10.0.0.2", i);
+    assert (write (ifa[1], ucPacket[i], uPacketLen[i]) == uPacketLen[i]);
+    if ( (i % 10) == 0) {
+
+      // Not for F4XYZ-2, without route, too long, not IPv4
+      assert (write (ifa[1], buf, uPacket (buf, 60, "10.1.2.3", i)) == 60);
+      assert (write (ifa[1], buf, uPacket (buf, 60, "192.168.1.1", i)) == 60);
+      assert (write (ifa[1], buf, uPacket (buf, AX25_INFO_LEN + 1, "10.0.0.2", i)) == AX25_INFO_LEN + 1);
+      buf[0] = 0x60;
+      assert (write (ifa[1], buf, 60) == 60);
+    }
+  }
+
+  // Packets sent by batches
+  n = 0;
+  while ( (got = iAx25TunRead (a)) > 0) {
+
+    assert (got <= AX25_TUN_BATCH);
+    n += got;
+  }
+  printf ("%d packets sent, %lu dropped\n", n, a->dropped);
+  assert ( (got == 0) && (n == PACKETS + PACKETS / 10) && (a->dropped == 3 * PACKETS / 10));
+
+  n = 0;
+  while ( (got = iAx25TunPoll (b, 100)) > 0) {
+
+    n += got;
+  }
+  printf ("%d packets received\n", n);
+  assert ( (got == 0) && (n == PACKETS) && (b->rx_packets == PACKETS));
+  for (int i = 0; i < PACKETS; i++) {
+
+    assert (read (ifb[1], buf, sizeof (buf)) == uPacketLen[i]);
+    assert (memcmp (buf, ucPacket[i], uPacketLen[i]) == 0);
+  }
+
+  // Backward, through iAx25TunPoll() on both sides
+  assert (write (ifb[1], ucPacket[1], uPacketLen[1]) == uPacketLen[1]);
+  assert (iAx25TunPoll (b, 0) == 1);
+  assert (iAx25TunPoll (a, 100) == 1);
+  assert ( (read (ifa[1], buf, sizeof (buf)) == uPacketLen[1]) && (memcmp (buf, ucPacket[1], uPacketLen[1]) == 0));
+  printf ("Backward packet received\n");
+
+  // TUN interface
+  if (iAx25TunOpen (a, "tun%d") == AX25_SUCCESS) {
+
+    printf ("Interface %s opened\n", a->ifname);
+    assert ( (a->own_fd) && (strncmp (a->ifname, "tun", 3) == 0));
+    assert (iAx25TunRead (a) == 0);
+  }
+  else {
+
+    printf ("TUN interface not available, skipped\n");
+  }
+
+  vAx25TunDelete (a);
+  vAx25TunDelete (b);
+  vAx25FrameDelete (f);
+  vAx25Delete (xPortA);
+  vAx25Delete (xPortB);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,353 @@
+/**
+ * @file test_codec_cpp.cpp
+ * @brief Policy-based codec test
+ *
+ * The Hdlc and Tnc framings are checked bit for bit against the C
+ * implementation: the frames must be encoded in the same bytes, and a random
+ * stream of frames, S frames of the minimum length included, corrupted frames
+ * and noise must be decoded in the same frames. The Kiss framing is checked
+ * on a known frame and by a round trip. The fd and ring transports are checked by a round trip, then the decoding
+ * speed of the codec is compared with the C implementation.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include <radio/codec.hpp>
+
+using namespace radio;
+
+/* constants ================================================================ */
+#define FRAMES 2000
+#define BENCH_LOOPS 20
+
+/* private variables ======================================================== */
+typedef std::vector<std::string> tFrames;
+typedef std::vector<uint8_t> tBytes;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static double
+dNow (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// -----------------------------------------------------------------------------
+// Random AX25 frame without FCS, with special bytes in the info field, or
+// S frame without PID and info fields
+static tBytes
+xAx25Random (void) {
+  static const uint8_t special[] = { HDLC_FLAG, HDLC_RESET, AX25_ESC, 0xC0, 0xDB };
+  unsigned naddr = 2 + rand() % 3;
+  tBytes f;
+
+  for (unsigned a = 0; a < naddr; a++) {
+
+    for (int i = 0; i < AX25_CALL_LEN; i++) {
+      f.push_back ( ('A' + rand() % 26) << 1);
+    }
+    f.push_back (0x60 | ( (rand() % 16) << 1) | (a == naddr - 1));
+  }
+  if ( (rand() % 8) == 0) {
+
+    // RR, RNR or REJ with N(R) and P/F bits
+    f.push_back ( ( (rand() % 3) << 2) | 0x01 | ( (rand() % 16) << 4));
+    return f;
+  }
+  f.push_back (AX25_CTRL_UI);
+  f.push_back (AX25_PID_NOLAYER3);
+  for (int i = rand() % 200; i > 0; i--) {
+    f.push_back ( (rand() % 4) ? rand() % 256 : special[rand() % sizeof (special)]);
+  }
+  return f;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vAppend (tBytes &s, const uint8_t *b, size_t len) {
+
+  s.insert (s.end(), b, b + len);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vNoise (tBytes &s) {
+
+  for (int i = rand() % 64; i > 0; i--) {
+    s.push_back (rand() % 256);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+vAx25Handler (xAx25 *ax25, const xAx25View *frame, void *ctx) {
+
+  ( (tFrames *) ctx)->push_back (std::string ( (const char *) frame->frame, frame->len));
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTncHandler (xTnc *tnc, const uint8_t *msg, size_t len, void *ctx) {
+
+  ( (tFrames *) ctx)->push_back (std::string ( (const char *) msg, len));
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTestHdlc (void) {
+  typedef Codec<Hdlc, MemoryTransport, Fcs16> tCodec;
+  static uint8_t ref[AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)], out[sizeof (ref)];
+  tBytes stream;
+  tFrames c, cpp;
+  xAx25 *ax25 = xAx25New();
+  tCodec codec;
+
+  assert (ax25);
+  for (int n = 0; n < FRAMES; n++) {
+    tBytes f = xAx25Random();
+    size_t len = f.size();
+    uint16_t fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, f.data(), len) ^ 0xFFFF;
+    size_t reflen, outlen;
+
+    // Same encoding as the C implementation
+    outlen = tCodec::encode (out, f.data(), len);
+    f.push_back (fcs & 0xFF);
+    f.push_back (fcs >> 8);
+    reflen = uAx25Encode (ref, f.data(), f.size());
+    assert ( (outlen == reflen) && (memcmp (out, ref, reflen) == 0));
+    assert (outlen <= tCodec::encodedSize (len));
+
+    switch (rand() % 8) {
+      case 0:
+        // Corrupted frame
+        out[1 + rand() % (outlen - 2)] ^= 1 << (rand() % 8);
+        break;
+      case 1:
+        // Truncated frame
+        outlen = 1 + rand() % (outlen - 1);
+        break;
+      case 2:
+        // Reset in the frame
+        out[1 + rand() % (outlen - 2)] = HDLC_RESET;
+        break;
+      case 3:
+        vNoise (stream);
+        break;
+      default:
+        break;
+    }
+    vAppend (stream, out, outlen);
+  }
+
+  iAx25SetRxHandler (ax25, vAx25Handler, &c);
+  assert (bAx25Feed (ax25, stream.data(), stream.size(), NULL));
+  codec.transport().setInput (stream.data(), stream.size());
+  codec.receive ([&cpp] (const uint8_t *frame, size_t len) {
+    cpp.push_back (std::string ( (const char *) frame, len));
+  });
+  printf ("Hdlc: %zu bytes, %zu frames in C, %zu frames in C++\n",
+          stream.size(), c.size(), cpp.size());
+  assert ( (c.size() > FRAMES / 2) && (c == cpp));
+
+  // Speed of the decoding
+  double t0 = dNow();
+  for (int i = 0; i < BENCH_LOOPS; i++) {
+    c.clear();
+    bAx25Feed (ax25, stream.data(), stream.size(), NULL);
+  }
+  double t1 = dNow();
+  unsigned frames = 0;
+  for (int i = 0; i < BENCH_LOOPS; i++) {
+    codec.transport().setInput (stream.data(), stream.size());
+    frames += codec.receive ([] (const uint8_t *, size_t) {});
+  }
+  double t2 = dNow();
+  assert (frames == cpp.size() * BENCH_LOOPS);
+  printf ("Hdlc decoding: C %.0f MB/s, C++ %.0f MB/s\n",
+          stream.size() * BENCH_LOOPS / (t1 - t0) / 1e6,
+          stream.size() * BENCH_LOOPS / (t2 - t1) / 1e6);
+
+  vAx25Delete (ax25);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTestTnc (void) {
+  typedef Codec<Tnc, MemoryTransport, Crc16> tCodec;
+  static uint8_t ref[TNC_MSG_SIZE (256)], out[sizeof (ref)];
+  tBytes stream;
+  tFrames c, cpp;
+  xTnc *tnc = xTncNew (1024);
+  tCodec codec;
+
+  assert (tnc);
+  for (int n = 0; n < FRAMES; n++) {
+    uint8_t msg[256];
+    size_t len = rand() % sizeof (msg), reflen, outlen;
+
+    for (size_t i = 0; i < len; i++) {
+      msg[i] = rand() % 256;
+    }
+    outlen = tCodec::encode (out, msg, len);
+    reflen = uTncEncode (ref, msg, len);
+    assert ( (outlen == reflen) && (memcmp (out, ref, reflen) == 0));
+    assert (outlen <= tCodec::encodedSize (len));
+
+    switch (rand() % 8) {
+      case 0:
+        // Corrupted message
+        out[2 + rand() % (outlen - 3)] ^= 1 << (rand() % 8);
+        break;
+      case 1:
+        // Lower case digit, which changes the CRC
+        out[2 + rand() % (outlen - 3)] |= 0x20;
+        break;
+      case 2:
+        // Truncated message
+        outlen = 1 + rand() % (outlen - 1);
+        break;
+      case 3:
+        vNoise (stream);
+        break;
+      case 4: {
+        // CRC with an extra digit
+        tBytes extra (out, out + outlen - 1);
+
+        extra.push_back ('0');
+        extra.push_back (TNC_EOT);
+        vAppend (stream, extra.data(), extra.size());
+        continue;
+      }
+      default:
+        break;
+    }
+    vAppend (stream, out, outlen);
+  }
+
+  iTncSetRxHandler (tnc, vTncHandler, &c);
+  assert (iTncFeed (tnc, stream.data(), stream.size(), NULL) == TNC_EOT);
+  codec.transport().setInput (stream.data(), stream.size());
+  codec.receive ([&cpp] (const uint8_t *frame, size_t len) {
+    cpp.push_back (std::string ( (const char *) frame, len));
+  });
+  printf ("Tnc: %zu bytes, %zu messages in C, %zu messages in C++\n",
+          stream.size(), c.size(), cpp.size());
+  assert ( (c.size() > FRAMES / 2) && (c == cpp));
+
+  vTncDelete (tnc);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTestKiss (void) {
+  typedef Codec<Kiss, MemoryTransport, NoChecksum> tCodec;
+  typedef Codec<Kiss, MemoryTransport, Fcs16> tCodecFcs;
+  static const uint8_t frame[] = { 0xC0, 0xDB, 0x01 };
+  static const uint8_t kiss[] = { 0xC0, 0x00, 0xDB, 0xDC, 0xDB, 0xDD, 0x01, 0xC0 };
+  // Command frame (TX delay), ignored
+  static const uint8_t cmd[] = { 0xC0, 0x01, 0x32, 0xC0 };
+  uint8_t out[tCodec::encodedSize (sizeof (frame))];
+  static uint8_t buf[FRAMES * tCodecFcs::encodedSize (256)];
+  tCodec codec;
+  tCodecFcs fcs (nullptr, 0, buf, sizeof (buf));
+  tBytes stream;
+  std::vector<tBytes> sent;
+  unsigned n = 0;
+
+  assert ( (tCodec::encode (out, frame, sizeof (frame)) == sizeof (kiss)) &&
+           (memcmp (out, kiss, sizeof (kiss)) == 0));
+  vAppend (stream, cmd, sizeof (cmd));
+  vAppend (stream, kiss, sizeof (kiss));
+  codec.transport().setInput (stream.data(), stream.size());
+  assert ( (codec.poll()) && (codec.length() == sizeof (frame)) &&
+           (memcmp (codec.frame(), frame, sizeof (frame)) == 0));
+  assert (!codec.poll());
+
+  // Round trip with a checksum
+  for (int i = 0; i < FRAMES; i++) {
+    tBytes f = xAx25Random();
+
+    assert (fcs.send (f.data(), f.size()) == tCodecFcs::SUCCESS);
+    sent.push_back (f);
+  }
+  fcs.transport().setInput (buf, fcs.transport().written());
+  while (fcs.poll()) {
+    assert ( (fcs.length() == sent[n].size()) &&
+             (memcmp (fcs.frame(), sent[n].data(), fcs.length()) == 0));
+    n++;
+  }
+  printf ("Kiss: %u frames\n", n);
+  assert (n == FRAMES);
+}
+
+// -----------------------------------------------------------------------------
+static void
+vTestTransports (void) {
+  static Ring<4096> a, b;
+  Codec<Hdlc, RingTransport<4096>, Fcs16> ra (&a, &b), rb (&b, &a);
+  int io[2];
+  unsigned n = 0;
+
+  // Fd transport through a pipe
+  assert (pipe (io) == 0);
+  {
+    Codec<Tnc, FdTransport, Crc16> c (io[0], io[1]);
+
+    for (int i = 0; i < 100; i++) {
+      char msg[32];
+
+      assert (c.send (msg, snprintf (msg, sizeof (msg), ">Test %d", i)) == 0);
+    }
+    close (io[1]);
+    n = c.receive ([&n] (const uint8_t *frame, size_t len) {
+      char msg[32];
+
+      assert ( (len == (size_t) snprintf (msg, sizeof (msg), ">Test %d", n)) &&
+               (memcmp (frame, msg, len) == 0));
+      n++;
+    });
+    close (io[0]);
+  }
+  printf ("FdTransport: %u messages\n", n);
+  assert (n == 100);
+
+  // Ring transport between two codecs
+  for (int i = 0; i < 100; i++) {
+    tBytes f = xAx25Random();
+
+    assert (ra.send (f.data(), f.size()) == 0);
+    assert ( (rb.poll()) && (rb.length() == f.size()) &&
+             (memcmp (rb.frame(), f.data(), f.size()) == 0));
+    assert (rb.send (f.data(), f.size()) == 0);
+    assert ( (ra.poll()) && (ra.length() == f.size()));
+  }
+  assert ( (!ra.poll()) && (!rb.poll()));
+  assert ( (a.size() == 0) && (b.size() == 0));
+  printf ("RingTransport: 100 frames each way\n");
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+
+  srand (1);
+  vTestHdlc();
+  vTestTnc();
+  vTestKiss();
+  vTestTransports();
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
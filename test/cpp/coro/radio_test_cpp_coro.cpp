@@ -0,0 +1,154 @@
+/**
+ * @file test_coro_cpp.cpp
+ * @brief C++20 coroutines test
+ *
+ * Many AX25 and TNC ports are served by coroutines running in a single
+ * thread on an EpollLoop: each AX25 port has a sender and a receiver
+ * coroutine, each TNC port a receiver coroutine. The frames must be received
+ * in order, and the receivers must end at the end of file.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+
+#include <radio/ax25.hpp>
+#include <radio/tnc.hpp>
+
+#if !defined(__cpp_impl_coroutine)
+#error "This test must be compiled with -std=c++20"
+#endif
+
+/* constants ================================================================ */
+#define PORTS 128
+#define FRAMES 50
+#define APRS_MSG "@Test %05d: port %d"
+
+/* private variables ======================================================== */
+static int iAx25Done, iTncDone, iSent;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static Task
+xAx25Sender (Ax25 &ax25, int port) {
+  Ax25Frame f ("APRS", "F4ABC");
+
+  for (int i = 0; i < FRAMES; i++) {
+    char msg[32];
+
+    f.setInfo (msg, snprintf (msg, sizeof (msg), APRS_MSG, i, port));
+    assert (co_await ax25.asyncSend (f) == Ax25::SUCCESS);
+    iSent++;
+  }
+  // End of file for the receiver
+  close (ax25.getFdout());
+}
+
+// -----------------------------------------------------------------------------
+static Task
+xAx25Receiver (Ax25 &ax25, int port) {
+  Ax25Frame f;
+  int count = 0;
+
+  while (co_await ax25.asyncReceive (f)) {
+    char msg[32];
+
+    snprintf (msg, sizeof (msg), APRS_MSG, count, port);
+    assert ( (f.getInfolen() == strlen (msg)) && (memcmp (f.getInfo(), msg, f.getInfolen()) == 0));
+    count++;
+  }
+  assert (count == FRAMES);
+  iAx25Done++;
+}
+
+// -----------------------------------------------------------------------------
+static Task
+xTncReceiver (Tnc &tnc, int port) {
+  int count = 0, type;
+
+  while ( (type = co_await tnc.asyncReceive()) != Tnc::NO_PACKET) {
+    char msg[32];
+
+    assert (type > 0);
+    snprintf (msg, sizeof (msg), APRS_MSG, count, port);
+    assert (strcmp (tnc.read(), msg) == 0);
+    count++;
+  }
+  assert (count == FRAMES);
+  iTncDone++;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  std::vector<std::unique_ptr<Ax25>> ax25;
+  std::vector<std::unique_ptr<Tnc>> tnc;
+  EpollLoop loop;
+
+  for (int i = 0; i < PORTS; i++) {
+    Ax25 *tx = new Ax25, *rx = new Ax25;
+    Tnc *t = new Tnc (64);
+    int io[2];
+
+    // AX25: the frames are sent by a coroutine
+    assert (pipe (io) == 0);
+    tx->setFdout (io[1]);
+    rx->setFdin (io[0]);
+    ax25.emplace_back (tx);
+    ax25.emplace_back (rx);
+
+    // TNC: the messages are in the pipe before the loop starts
+    assert (pipe (io) == 0);
+    t->setFdout (io[1]);
+    t->setFdin (io[0]);
+    for (int j = 0; j < FRAMES; j++) {
+      char msg[32];
+
+      snprintf (msg, sizeof (msg), APRS_MSG, j, i);
+      assert (t->write (msg) > 0);
+    }
+    close (io[1]);
+    tnc.emplace_back (t);
+  }
+
+  // Without loop, the operations fail at once
+  {
+    Ax25Frame f;
+    bool got = true;
+
+    [&]() -> Task {
+      got = co_await ax25[1]->asyncReceive (f);
+    }();
+    assert (!got);
+  }
+
+  EventLoop::setCurrent (&loop);
+  for (int i = 0; i < PORTS; i++) {
+
+    xAx25Receiver (*ax25[2 * i + 1], i);
+    xAx25Sender (*ax25[2 * i], i);
+    xTncReceiver (*tnc[i], i);
+  }
+  printf ("%d ports, %u waiters\n", PORTS * 2, loop.waiters());
+  assert (loop.run() == 0);
+
+  printf ("%d frames sent, %d AX25 and %d TNC receivers ended\n", iSent, iAx25Done, iTncDone);
+  assert ( (iSent == PORTS * FRAMES) && (iAx25Done == PORTS) && (iTncDone == PORTS));
+  assert (loop.waiters() == 0);
+
+  for (int i = 0; i < PORTS; i++) {
+
+    close (ax25[2 * i + 1]->getFdin());
+    close (tnc[i]->getFdin());
+  }
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
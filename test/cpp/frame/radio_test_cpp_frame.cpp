@@ -0,0 +1,123 @@
+/**
+ * @file test_frame_cpp.cpp
+ * @brief Fixed capacity frames test
+ *
+ * A small frame for a telemetry node and a full size frame for a gateway
+ * are sent through a pipe: the bytes sent must be the same as the ones sent
+ * by iAx25Send() for the same frame, and the frames must be read back
+ * without loss. A frame which exceeds the capacity of the reader must be
+ * rejected and discarded.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <radio/ax25frame.hpp>
+
+/* constants ================================================================ */
+#define TELEMETRY "T#001,123,045"
+#define GATEWAY ">Test gateway, a longer info field for a full size frame"
+
+typedef Ax25FrameT<16, 0> TelemetryFrame;
+typedef Ax25FrameT<> GatewayFrame;
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2];
+  uint8_t ref[AX25_RAW_SIZE (AX25_FRAME_BUF_LEN)], buf[sizeof (ref)];
+  ssize_t reflen, len;
+  Ax25 ax25;
+  TelemetryFrame t ("APRS", "F4ABC");
+  GatewayFrame g ("APRS", "F4ABC"), r;
+  xAx25Frame *f = xAx25FrameNew();
+
+  printf ("sizeof: xAx25Frame %zu, TelemetryFrame %zu, GatewayFrame %zu\n",
+          sizeof (xAx25Frame), sizeof (TelemetryFrame), sizeof (GatewayFrame));
+  assert (sizeof (TelemetryFrame) < sizeof (xAx25Frame) / 4);
+
+  assert (pipe (io) == 0);
+  ax25.setFdin (io[0]);
+  ax25.setFdout (io[1]);
+
+  // Bytes sent by the C API for the gateway frame
+  g.getSrc().ssid = 1;
+  assert (g.addRepeater ("WIDE1", 1) == AX25_SUCCESS);
+  assert (g.addRepeater ("WIDE2", 2) == AX25_SUCCESS);
+  g.repeater (0).flag = true;
+  g.setInfo (GATEWAY, strlen (GATEWAY));
+  assert (f);
+  iAx25FrameSetDst (f, "APRS", 0);
+  iAx25FrameSetSrc (f, "F4ABC", 1);
+  iAx25FrameAddRepeater (f, "WIDE1", 1);
+  iAx25FrameAddRepeater (f, "WIDE2", 2);
+  iAx25FrameSetRepeaterFlag (f, 0, true);
+  iAx25FrameSetInfo (f, GATEWAY, strlen (GATEWAY));
+  {
+    xAx25 *c = xAx25New();
+
+    assert (c);
+    iAx25SetFdout (c, io[1]);
+    assert (iAx25Send (c, f) == AX25_SUCCESS);
+    vAx25Delete (c);
+  }
+  reflen = read (io[0], ref, sizeof (ref));
+  assert (reflen > 0);
+
+  // Same bytes from the template frame
+  assert (ax25.send (g) == Ax25::SUCCESS);
+  len = read (io[0], buf, sizeof (buf));
+  printf ("Gateway frame: %zd bytes on air\n", len);
+  assert ( (len == reflen) && (memcmp (buf, ref, len) == 0));
+
+  // Read back in a frame of the same capacity
+  assert (write (io[1], buf, len) == len);
+  assert (ax25.poll());
+  assert (ax25.read (r) == Ax25::SUCCESS);
+  assert ( (strcmp (r.getDst().callsign, "APRS") == 0) && (strcmp (r.getSrc().callsign, "F4ABC") == 0));
+  assert ( (r.getSrc().ssid == 1) && (r.getReplen() == 2));
+  assert ( (strcmp (r.repeater (1).callsign, "WIDE2") == 0) && (r.repeater (1).ssid == 2));
+  assert ( (r.repeater (0).flag) && (!r.repeater (1).flag));
+  assert ( (r.getCtrl() == AX25_CTRL_UI) && (r.getPid() == AX25_PID_NOLAYER3));
+  assert ( (r.getInfolen() == strlen (GATEWAY)) && (strcmp (r.getInfo(), GATEWAY) == 0));
+
+  // The telemetry frame is read by the gateway
+  t.setInfo (TELEMETRY, strlen (TELEMETRY));
+  assert (ax25.send (t) == Ax25::SUCCESS);
+  assert (ax25.poll());
+  assert (ax25.read (r) == Ax25::SUCCESS);
+  printf ("Telemetry frame: %zu bytes of info\n", r.getInfolen());
+  assert ( (r.getReplen() == 0) && (strcmp (r.getInfo(), TELEMETRY) == 0));
+
+  // The gateway frame exceeds the capacity of the telemetry frame
+  assert (ax25.send (g) == Ax25::SUCCESS);
+  assert (ax25.send (t) == Ax25::SUCCESS);
+  assert (ax25.poll());
+  assert (ax25.read (t) == Ax25::NOT_ENOUGH_REPEATER);
+  assert (ax25.read (t) == Ax25::NO_FRAME_RECEIVED);
+  assert (ax25.poll());
+  assert (ax25.read (t) == Ax25::SUCCESS);
+  assert (strcmp (t.getInfo(), TELEMETRY) == 0);
+
+  // The info field is truncated to the capacity
+  t.setInfo (GATEWAY, strlen (GATEWAY));
+  assert ( (t.getInfolen() == TelemetryFrame::maxInfo) && (strlen (t.getInfo()) == t.getInfolen()));
+  t.clear();
+  assert ( (t.getInfolen() == 0) && (t.getInfo()[0] == 0));
+
+  // The C frame is still terminated after a clear
+  iAx25FrameClear (f);
+  assert ( (f->info_len == 0) && (f->info[0] == 0));
+
+  vAx25FrameDelete (f);
+  close (io[0]);
+  close (io[1]);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,204 @@
+/**
+ * @file jpeg.h
+ * @brief Test image, 64x64 pixels JPEG
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#ifndef _RADIO_TEST_JPEG_H_
+#define _RADIO_TEST_JPEG_H_
+
+static const unsigned char ucJpeg[] = {
+  0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01,
+  0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43,
+  0x00, 0x08, 0x06, 0x06, 0x07, 0x06, 0x05, 0x08, 0x07, 0x07, 0x07, 0x09,
+  0x09, 0x08, 0x0A, 0x0C, 0x14, 0x0D, 0x0C, 0x0B, 0x0B, 0x0C, 0x19, 0x12,
+  0x13, 0x0F, 0x14, 0x1D, 0x1A, 0x1F, 0x1E, 0x1D, 0x1A, 0x1C, 0x1C, 0x20,
+  0x24, 0x2E, 0x27, 0x20, 0x22, 0x2C, 0x23, 0x1C, 0x1C, 0x28, 0x37, 0x29,
+  0x2C, 0x30, 0x31, 0x34, 0x34, 0x34, 0x1F, 0x27, 0x39, 0x3D, 0x38, 0x32,
+  0x3C, 0x2E, 0x33, 0x34, 0x32, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x09, 0x09,
+  0x09, 0x0C, 0x0B, 0x0C, 0x18, 0x0D, 0x0D, 0x18, 0x32, 0x21, 0x1C, 0x21,
+  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+  0x32, 0x32, 0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0x40, 0x00, 0x40, 0x03,
+  0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xFF, 0xC4, 0x00,
+  0x1F, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+  0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x10, 0x00,
+  0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00,
+  0x00, 0x01, 0x7D, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+  0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81,
+  0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24,
+  0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25,
+  0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A,
+  0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56,
+  0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A,
+  0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86,
+  0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+  0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3,
+  0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6,
+  0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9,
+  0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1,
+  0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xC4, 0x00,
+  0x1F, 0x01, 0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+  0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x11, 0x00,
+  0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00,
+  0x01, 0x02, 0x77, 0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31,
+  0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08,
+  0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15,
+  0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18,
+  0x19, 0x1A, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39,
+  0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55,
+  0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+  0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84,
+  0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+  0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA,
+  0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4,
+  0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7,
+  0xD8, 0xD9, 0xDA, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA,
+  0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xDA, 0x00,
+  0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0xF2,
+  0xD8, 0x20, 0x70, 0xC1, 0x4B, 0x63, 0x1C, 0x6D, 0x03, 0xFA, 0x7A, 0xF2,
+  0x2A, 0xD4, 0x70, 0x33, 0x36, 0xED, 0xA3, 0x0F, 0xFE, 0xD0, 0xC0, 0xE3,
+  0xFF, 0x00, 0xD5, 0xFE, 0x4D, 0x58, 0x86, 0x06, 0x60, 0x54, 0x04, 0x55,
+  0xE4, 0x6D, 0xEA, 0x40, 0x18, 0xCF, 0x51, 0xCF, 0xD2, 0xAF, 0x1B, 0x7D,
+  0x8A, 0xA1, 0x91, 0x80, 0x5C, 0x0C, 0xA7, 0x00, 0xF5, 0xE9, 0xEF, 0xD7,
+  0xE9, 0x4D, 0x3B, 0x06, 0x1A, 0xBD, 0xDD, 0x8A, 0xD1, 0x5B, 0x85, 0x74,
+  0x19, 0x39, 0x61, 0x96, 0xDB, 0x9C, 0xFD, 0x7A, 0x75, 0xFF, 0x00, 0xEB,
+  0xD5, 0xC8, 0x2D, 0x24, 0xDA, 0x8B, 0x80, 0x01, 0xCE, 0x70, 0x4E, 0x3A,
+  0xFD, 0x79, 0xAB, 0x51, 0x5B, 0x79, 0x8C, 0x51, 0xB6, 0x94, 0x38, 0xE7,
+  0xA8, 0x27, 0x8F, 0xD4, 0xD5, 0xA8, 0xE3, 0xDA, 0xAC, 0x8D, 0x86, 0x39,
+  0x39, 0xFD, 0x7F, 0x9D, 0x5A, 0x97, 0x44, 0x7B, 0x78, 0x7C, 0x46, 0x88,
+  0xAE, 0x96, 0xCD, 0xFC, 0x3B, 0xB0, 0x3E, 0x50, 0x7B, 0x63, 0x9F, 0xF0,
+  0x07, 0xF1, 0xF7, 0xAB, 0x11, 0xDB, 0xB9, 0x65, 0x0D, 0xCF, 0x3F, 0x70,
+  0x8F, 0x6E, 0xBE, 0xD5, 0x69, 0x6D, 0xDA, 0x22, 0x43, 0xBB, 0x03, 0xD7,
+  0x00, 0x0C, 0x82, 0x7E, 0x9E, 0xF5, 0x6E, 0x3B, 0x46, 0x9B, 0xCB, 0x3B,
+  0x02, 0x8D, 0xB8, 0xDC, 0x79, 0x23, 0x9C, 0x74, 0xEF, 0xFF, 0x00, 0xD6,
+  0xEB, 0x5B, 0x29, 0x75, 0x3D, 0xAC, 0x3D, 0x76, 0xB4, 0x66, 0x45, 0xCA,
+  0xAC, 0x6A, 0xCE, 0xD2, 0x34, 0x33, 0xA0, 0x25, 0x50, 0x72, 0x18, 0x63,
+  0x71, 0xCA, 0x83, 0xCE, 0x42, 0x91, 0xCE, 0x31, 0x83, 0x8E, 0x71, 0x59,
+  0x1F, 0x62, 0x68, 0xC4, 0x56, 0xC9, 0x1C, 0xA8, 0x01, 0x70, 0x54, 0xC6,
+  0x58, 0x17, 0x2A, 0x31, 0xB4, 0x63, 0x76, 0xED, 0xBC, 0xF2, 0x02, 0xE4,
+  0x64, 0x77, 0xAE, 0xB2, 0xEE, 0xCD, 0x22, 0xB7, 0x69, 0x52, 0x24, 0x13,
+  0x3E, 0xFF, 0x00, 0x2F, 0x90, 0x98, 0x38, 0x27, 0x9D, 0xC4, 0x73, 0xF7,
+  0x8E, 0x40, 0x04, 0x06, 0x3E, 0xF5, 0x87, 0xA9, 0x5B, 0xB6, 0x19, 0xD1,
+  0x62, 0x92, 0x01, 0xB4, 0x87, 0x5E, 0x8C, 0x7A, 0x6E, 0x50, 0x38, 0x18,
+  0xC6, 0xD2, 0x33, 0xD3, 0x6F, 0x19, 0xE6, 0xBD, 0x4C, 0x1B, 0x5A, 0x25,
+  0xFD, 0x7F, 0x5F, 0xE6, 0x79, 0x39, 0xB5, 0x79, 0x3B, 0xCA, 0x4A, 0xF6,
+  0xE9, 0xAE, 0xDB, 0xEF, 0xF2, 0x49, 0xBE, 0xD6, 0x4D, 0xEC, 0x86, 0xC1,
+  0x6E, 0x23, 0x43, 0x84, 0x6C, 0x03, 0x91, 0x86, 0x3F, 0x97, 0xA6, 0x3F,
+  0xFA, 0xF9, 0xA9, 0xE3, 0x42, 0x8C, 0x4E, 0x3A, 0x8C, 0x10, 0x07, 0x03,
+  0x8F, 0x52, 0x47, 0x3C, 0x7F, 0x9C, 0xD5, 0xC4, 0xB7, 0xDC, 0x9C, 0x21,
+  0xF3, 0x39, 0xC1, 0x1C, 0x85, 0x27, 0xAE, 0x79, 0xE7, 0xEB, 0x56, 0xC5,
+  0xB1, 0x51, 0x8C, 0x63, 0x8E, 0x0E, 0xDD, 0xC0, 0xF6, 0x3F, 0x4E, 0xF5,
+  0xF3, 0xB1, 0x7D, 0xCF, 0x86, 0xA1, 0x88, 0x57, 0x2A, 0xC7, 0x08, 0xF9,
+  0x9C, 0x23, 0x46, 0x58, 0x06, 0x04, 0x2E, 0x4F, 0xFF, 0x00, 0x5C, 0x74,
+  0x3E, 0xF5, 0x69, 0x60, 0xFD, 0xD9, 0x0E, 0x14, 0xB6, 0x49, 0xCF, 0x51,
+  0xF4, 0xAB, 0x70, 0x5B, 0x3A, 0xC7, 0xC2, 0xB1, 0x61, 0x90, 0x0E, 0x76,
+  0xE3, 0x3F, 0xE2, 0x7F, 0xC6, 0xA6, 0xB5, 0xB7, 0x3C, 0xB9, 0xF9, 0xFD,
+  0x41, 0x3C, 0xF2, 0x3B, 0xF1, 0xED, 0x5A, 0x46, 0x57, 0x3D, 0xBC, 0x3E,
+  0x23, 0x4B, 0xA2, 0x25, 0xB7, 0x6D, 0x80, 0x36, 0x32, 0xA4, 0x02, 0x37,
+  0x60, 0xE7, 0x1C, 0x76, 0xFA, 0x9A, 0xB7, 0x14, 0x39, 0x0A, 0x40, 0x05,
+  0x4F, 0x20, 0x2F, 0x1C, 0x8E, 0x3A, 0xE3, 0xE9, 0xFC, 0xF3, 0x57, 0x22,
+  0x82, 0x45, 0x94, 0xA1, 0x00, 0xA9, 0x3C, 0x12, 0x30, 0x40, 0xE3, 0xFF,
+  0x00, 0xAC, 0x3D, 0xAA, 0xDC, 0x16, 0xCC, 0xC3, 0xA0, 0x24, 0x03, 0x9F,
+  0x9B, 0xAF, 0x1D, 0xB1, 0xFE, 0x1E, 0x95, 0xAA, 0x95, 0x8F, 0x66, 0x86,
+  0x27, 0xBB, 0x32, 0xFE, 0xCD, 0x27, 0x98, 0x08, 0x76, 0x26, 0x36, 0x04,
+  0x43, 0x13, 0x64, 0xBA, 0x9C, 0x81, 0x9D, 0xC4, 0x63, 0x92, 0x4F, 0x5F,
+  0xE1, 0xF5, 0xAE, 0x76, 0x75, 0x30, 0xD9, 0x0B, 0x5B, 0x95, 0x54, 0x70,
+  0xFB, 0x14, 0x39, 0x2F, 0x22, 0x27, 0xCD, 0x9E, 0xF8, 0x18, 0x1B, 0x40,
+  0xC6, 0x3B, 0x1C, 0x74, 0x35, 0xD7, 0x5D, 0x85, 0x40, 0x98, 0x13, 0x45,
+  0x22, 0xB7, 0xCB, 0x28, 0x8D, 0x42, 0xA8, 0xC8, 0xEA, 0x4E, 0x46, 0x08,
+  0x04, 0xF7, 0xC0, 0x1B, 0xB1, 0xC5, 0x61, 0xDE, 0x44, 0xD0, 0x5C, 0x0F,
+  0xB3, 0xC6, 0xEC, 0xA1, 0x4B, 0x2C, 0xB2, 0xA6, 0x0C, 0x80, 0xB6, 0x09,
+  0x6C, 0x81, 0xB8, 0x12, 0x4F, 0x5F, 0xEF, 0x63, 0xBD, 0x7A, 0xD8, 0x34,
+  0xEE, 0x78, 0xB9, 0xD6, 0x39, 0x45, 0xFB, 0xAE, 0xED, 0x5F, 0xF1, 0xB7,
+  0x47, 0xAD, 0xD2, 0x5D, 0xEC, 0xB4, 0xEA, 0xDD, 0x99, 0x1C, 0x21, 0x9D,
+  0x4E, 0xE5, 0x6C, 0x0E, 0x5B, 0x23, 0x91, 0xEF, 0xEF, 0xD6, 0xAE, 0x45,
+  0x6E, 0x4E, 0xD2, 0xC4, 0x02, 0x9C, 0xF7, 0xE0, 0xFA, 0xF3, 0xC7, 0xFF,
+  0x00, 0xAE, 0xAC, 0xC5, 0x6E, 0xBE, 0x59, 0x09, 0x11, 0x0D, 0x9C, 0xA8,
+  0x27, 0xBE, 0x73, 0xF5, 0xE8, 0x3A, 0xFB, 0x76, 0xAB, 0xB1, 0xDB, 0x90,
+  0xDC, 0x31, 0x52, 0xC3, 0x82, 0x9C, 0xFA, 0xFD, 0x79, 0xC0, 0xAF, 0x9C,
+  0x4C, 0xF8, 0xAA, 0x18, 0x8D, 0x6C, 0x54, 0x8A, 0xDA, 0x38, 0xBE, 0x65,
+  0x05, 0x89, 0x5C, 0x1E, 0x3E, 0xF6, 0x6A, 0xDD, 0xBD, 0xBE, 0x02, 0x6E,
+  0xF3, 0x30, 0x1B, 0x07, 0x07, 0x18, 0xF6, 0xFF, 0x00, 0x3F, 0xD6, 0xAE,
+  0x41, 0x14, 0x61, 0x70, 0x4E, 0x76, 0x9C, 0x29, 0x52, 0x33, 0xFE, 0x1E,
+  0x83, 0xA7, 0x6A, 0xB3, 0x1C, 0x48, 0x78, 0x70, 0xE0, 0xF5, 0x24, 0x91,
+  0xC1, 0x1D, 0x87, 0xE3, 0x57, 0x19, 0xF4, 0x3D, 0xBA, 0x15, 0x99, 0x54,
+  0x59, 0xE1, 0x5C, 0x27, 0xCA, 0x99, 0xC0, 0xC8, 0x20, 0x1F, 0x6C, 0xFE,
+  0x43, 0xF1, 0xAB, 0x76, 0xB0, 0x71, 0xB4, 0xA9, 0x74, 0x6E, 0x46, 0x3F,
+  0xCF, 0x3D, 0xFF, 0x00, 0x2E, 0xF5, 0x72, 0x38, 0x42, 0x3B, 0x23, 0xA1,
+  0xCB, 0xE0, 0x14, 0x3C, 0xF1, 0xCF, 0x5F, 0x5A, 0x9E, 0xDE, 0x02, 0xAA,
+  0x76, 0xBE, 0xD5, 0x39, 0xE0, 0x0F, 0x4F, 0x5C, 0x7E, 0x5F, 0x81, 0xAD,
+  0x62, 0xEE, 0x8F, 0x6A, 0x86, 0x22, 0xFD, 0x4C, 0xB9, 0xE0, 0x56, 0x33,
+  0x16, 0x4C, 0x22, 0xC4, 0xD9, 0x1B, 0x89, 0xEF, 0xF2, 0xE5, 0x47, 0x51,
+  0x9C, 0xE4, 0xFA, 0x64, 0x72, 0x33, 0x58, 0xDA, 0x8C, 0xB1, 0xBC, 0x8C,
+  0x64, 0x92, 0x00, 0xEE, 0xA5, 0xC3, 0xC4, 0xC0, 0xB2, 0x1C, 0x01, 0xB1,
+  0x88, 0x6E, 0x7A, 0xB7, 0x6F, 0xA6, 0x41, 0x22, 0xBB, 0x19, 0x2D, 0xC4,
+  0x52, 0xB6, 0xF8, 0xDE, 0x58, 0xE4, 0x4C, 0x1D, 0xA8, 0x64, 0xDB, 0xC6,
+  0x06, 0x40, 0xC9, 0xE7, 0x27, 0x38, 0xC8, 0xE3, 0xA6, 0x4D, 0x72, 0xCD,
+  0x04, 0x71, 0xBD, 0xE5, 0xA9, 0x8A, 0x44, 0x96, 0x39, 0x59, 0xB7, 0xA6,
+  0xD3, 0x1F, 0x1F, 0x78, 0x37, 0x03, 0x80, 0xA4, 0xF6, 0x00, 0x76, 0xC7,
+  0x39, 0xEE, 0xA1, 0x5E, 0x34, 0xD5, 0xD7, 0xA7, 0xDF, 0xFD, 0x6F, 0xA9,
+  0xE4, 0x67, 0x38, 0xBE, 0x5F, 0x76, 0xEB, 0x5E, 0x9E, 0x6B, 0x5D, 0x7B,
+  0xDD, 0x3D, 0x3C, 0xFF, 0x00, 0x0C, 0x0B, 0x3D, 0x4F, 0x52, 0xB8, 0xD4,
+  0x1A, 0xC7, 0xEC, 0x52, 0xC5, 0x70, 0x92, 0x3B, 0x87, 0xB8, 0x42, 0x52,
+  0x44, 0x5C, 0x6E, 0xC1, 0xC2, 0xFC, 0xBB, 0x99, 0x55, 0x58, 0x06, 0x38,
+  0xE4, 0xAF, 0xAD, 0xBD, 0x3B, 0x57, 0x46, 0xBA, 0x36, 0xA9, 0x23, 0x5C,
+  0xBC, 0x08, 0x65, 0x95, 0x40, 0xDD, 0x31, 0x50, 0xEA, 0x14, 0xE1, 0x55,
+  0x42, 0x90, 0x0B, 0x6E, 0x42, 0xA1, 0xC1, 0x00, 0x00, 0x7A, 0x9E, 0x37,
+  0x4F, 0xF1, 0x32, 0xE9, 0x43, 0xCB, 0x12, 0x5C, 0x1C, 0xAC, 0x5E, 0x5D,
+  0xCB, 0xA2, 0x3B, 0x36, 0x58, 0xC9, 0x21, 0x91, 0x43, 0xE1, 0x8B, 0x33,
+  0x63, 0x05, 0xB2, 0xA0, 0x9E, 0x43, 0x6E, 0xDD, 0x9E, 0x2F, 0x66, 0x86,
+  0xE9, 0xE7, 0x44, 0x8A, 0xCA, 0xEA, 0x09, 0xBC, 0xD7, 0x89, 0x11, 0x61,
+  0xE7, 0x25, 0x59, 0x41, 0x5D, 0xAE, 0xA0, 0x02, 0x06, 0xC0, 0x49, 0x3F,
+  0x33, 0x12, 0x0E, 0x6B, 0xA6, 0x39, 0x5F, 0x3D, 0xD5, 0x92, 0x5D, 0x3F,
+  0xAF, 0x9F, 0xC8, 0xE6, 0xC3, 0x65, 0x9E, 0xD1, 0xB4, 0xD2, 0x4A, 0xCA,
+  0xDE, 0x6F, 0xBF, 0xFC, 0x0B, 0xE8, 0xFE, 0x47, 0xA3, 0xCD, 0xAE, 0xDB,
+  0xE9, 0x72, 0xDE, 0x5B, 0x4D, 0x77, 0xE5, 0xC7, 0x1A, 0x98, 0xE0, 0x9D,
+  0x4E, 0x70, 0xE0, 0x7C, 0xCA, 0x5C, 0x17, 0x62, 0xC0, 0xE3, 0x39, 0x4E,
+  0x38, 0xDD, 0x9D, 0xC3, 0x3B, 0x56, 0x9A, 0xC6, 0x9C, 0xC6, 0x34, 0x45,
+  0x92, 0x19, 0x64, 0x4F, 0x3B, 0x6C, 0xD3, 0x22, 0x90, 0x80, 0x95, 0xC8,
+  0xCB, 0x6D, 0xDB, 0x84, 0x67, 0xF9, 0x72, 0x08, 0x1B, 0xBA, 0x91, 0x9F,
+  0x37, 0xB4, 0xD4, 0xD2, 0x5B, 0x72, 0x67, 0xFB, 0x3B, 0x5C, 0xC9, 0x09,
+  0x64, 0x96, 0x22, 0xB6, 0xFB, 0x0A, 0x2B, 0x6C, 0x52, 0xD1, 0x9E, 0x80,
+  0xAA, 0x10, 0xA5, 0x41, 0x2D, 0xB3, 0x90, 0x15, 0x72, 0xF8, 0x6F, 0xE2,
+  0x16, 0xD6, 0x73, 0x1F, 0x2E, 0xEA, 0x7B, 0x38, 0xD6, 0x28, 0x83, 0x89,
+  0x83, 0xA8, 0xCB, 0xB1, 0xCB, 0x07, 0x00, 0x14, 0x20, 0x01, 0x8E, 0xCE,
+  0x38, 0x04, 0x61, 0x76, 0xFE, 0xCB, 0x8B, 0x56, 0xB6, 0xBD, 0x6D, 0xFD,
+  0x77, 0xFF, 0x00, 0x3E, 0xE7, 0xB9, 0x43, 0x2A, 0x8B, 0xF7, 0x5D, 0xEF,
+  0xD6, 0xDD, 0x74, 0xB7, 0x97, 0x55, 0xAF, 0x9E, 0xBD, 0xCF, 0x47, 0xD4,
+  0xF5, 0x3F, 0x22, 0x24, 0x9D, 0xFC, 0xE5, 0x8A, 0x41, 0x24, 0x5E, 0x46,
+  0xD0, 0xC6, 0x69, 0x88, 0x1B, 0x50, 0x3C, 0x6C, 0x59, 0x18, 0x30, 0x65,
+  0xCE, 0x08, 0xE1, 0xBD, 0x14, 0x9D, 0x4B, 0x4D, 0x66, 0x1B, 0xB1, 0x23,
+  0x5A, 0xBA, 0x49, 0x97, 0x09, 0x04, 0x51, 0xEE, 0x91, 0xBC, 0xCD, 0xA0,
+  0xB6, 0xE6, 0x5D, 0xC0, 0x00, 0x5D, 0x41, 0x61, 0xB8, 0x0C, 0x9C, 0x9E,
+  0x70, 0x3C, 0xEA, 0x0D, 0x65, 0x0D, 0xBD, 0xCD, 0x86, 0xDB, 0xBB, 0x8B,
+  0x8B, 0xA1, 0x24, 0x4B, 0x30, 0xB9, 0xC9, 0x94, 0x1D, 0xC1, 0x01, 0xC4,
+  0x61, 0xDF, 0xAA, 0x63, 0x77, 0xA6, 0x3E, 0x55, 0x66, 0x06, 0x0B, 0xCD,
+  0x62, 0xD2, 0x72, 0x49, 0xB6, 0xB8, 0x76, 0x2E, 0x89, 0x25, 0xBC, 0x93,
+  0xAE, 0xCF, 0x25, 0x54, 0x11, 0x1E, 0x42, 0x82, 0x32, 0xDB, 0x8E, 0xD1,
+  0x85, 0x1F, 0x2E, 0x17, 0x81, 0x8C, 0xE7, 0x97, 0xA8, 0x53, 0x7C, 0xEA,
+  0xD6, 0xFE, 0x96, 0xFF, 0x00, 0xD7, 0x9A, 0xD0, 0xF6, 0x30, 0xB9, 0x43,
+  0x9D, 0xA1, 0x25, 0xF3, 0xD3, 0x6D, 0x3C, 0xF7, 0xDF, 0xCF, 0x4E, 0x9D,
+  0x3D, 0x2A, 0x2D, 0x49, 0x6E, 0xEE, 0x67, 0x88, 0xAD, 0xC0, 0x64, 0xE3,
+  0x7B, 0xB2, 0x24, 0x92, 0x17, 0x67, 0xDB, 0x13, 0x26, 0x14, 0x81, 0xB5,
+  0x95, 0x94, 0x91, 0xFE, 0xF1, 0x05, 0x5B, 0x3C, 0x56, 0xA7, 0xAD, 0xCD,
+  0x7F, 0x6E, 0xB3, 0x48, 0xAA, 0xA2, 0xD2, 0x1F, 0x2D, 0xCD, 0xA2, 0x6D,
+  0xDA, 0x1F, 0xCB, 0xD8, 0x98, 0x3B, 0x92, 0x49, 0x08, 0x2C, 0xCA, 0xA3,
+  0x72, 0xAE, 0xE5, 0x42, 0xCC, 0x5B, 0x75, 0x62, 0xCB, 0xAE, 0x5F, 0xDA,
+  0x5E, 0x98, 0x74, 0xB6, 0x76, 0x36, 0x32, 0x29, 0x2B, 0x0A, 0x38, 0x32,
+  0x45, 0x1E, 0x59, 0xC6, 0xE5, 0x7D, 0x98, 0x62, 0xDB, 0xB3, 0x96, 0x19,
+  0x07, 0x07, 0x00, 0xD6, 0x55, 0xC6, 0xAB, 0x15, 0x84, 0x30, 0x7D, 0x96,
+  0x6B, 0x4F, 0x2A, 0x5B, 0xD5, 0xB8, 0xB4, 0xB7, 0xBE, 0xF9, 0xBC, 0xA8,
+  0xC8, 0x75, 0x4F, 0x30, 0x6E, 0xF9, 0x70, 0xAE, 0x1C, 0xB6, 0x73, 0xBC,
+  0xE4, 0x0C, 0x7C, 0xEF, 0xE3, 0xD6, 0x9D, 0x18, 0xCA, 0x72, 0x4A, 0xF7,
+  0x56, 0x4A, 0xEA, 0xCB, 0xE2, 0x57, 0x7D, 0x96, 0xBA, 0xDB, 0xF1, 0x4B,
+  0x5F, 0x33, 0x39, 0xC9, 0xE7, 0x4D, 0xF2, 0x45, 0xAE, 0x57, 0x67, 0xB6,
+  0xFB, 0x5E, 0xFA, 0xE9, 0xF9, 0x2B, 0xEF, 0xDF, 0xFF, 0xD9,
+};
+
+#endif /* _RADIO_TEST_JPEG_H_ */
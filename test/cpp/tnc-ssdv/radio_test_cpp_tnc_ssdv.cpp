@@ -0,0 +1,136 @@
+/**
+ * @file test_tnc_ssdv_cpp.cpp
+ * @brief TNC SSDV image transmission test
+ *
+ * An image is sent in a pipe by writeSsdvImage(), the SSDV packets received
+ * must be in stride order window by window, consecutive packets of a full
+ * window being one batch apart, with a copy of the first packet after each
+ * of the first headerRepeat windows. Without interleaving, the packets must
+ * be received in order.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+#include <radio/tnc.hpp>
+#include <ssdv/ssdv.h>
+#include "jpeg.h"
+
+/* constants ================================================================ */
+#define CALL "F4ABC"
+#define IMAGE_ID 7
+#define QUALITY 7
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// Packet ids in the order writeSsdvImage() must send the n packets of an image
+static std::vector<int>
+xExpected (unsigned n, unsigned interleave, unsigned headerRepeat, unsigned batch) {
+  std::vector<int> ids;
+  unsigned window = interleave * batch;
+
+  for (unsigned base = 0; base < n; base += window) {
+    unsigned m = std::min (window, n - base);
+
+    for (unsigned col = 0; col < interleave; col++) {
+      for (unsigned i = col; i < m; i += interleave) {
+        ids.push_back (base + i);
+      }
+    }
+    if (headerRepeat) {
+      ids.push_back (0);
+      headerRepeat--;
+    }
+  }
+  return ids;
+}
+
+// -----------------------------------------------------------------------------
+// Sends the image and returns the packet ids received
+static std::vector<int>
+xSend (Tnc &tnc, unsigned interleave, unsigned headerRepeat, unsigned batch) {
+  std::vector<int> ids;
+  int sent, idle = 0;
+
+  sent = tnc.writeSsdvImage (ucJpeg, sizeof (ucJpeg), CALL, IMAGE_ID, QUALITY,
+                             interleave, headerRepeat, batch);
+  assert (sent > 0);
+
+  while ( ( (int) ids.size() < sent) && (idle < 1000000)) {
+
+    if (tnc.poll() == Tnc::SSDV_PACKET) {
+
+      assert (tnc.getSsdvImageId() == IMAGE_ID);
+      ids.push_back (tnc.getSsdvPacketId());
+      idle = 0;
+    }
+    else {
+      idle++;
+    }
+  }
+  assert ( (int) ids.size() == sent);
+  return ids;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  Tnc tnc (SSDV_PKT_SIZE);
+  std::vector<int> ids;
+  unsigned n;
+  int io[2];
+
+  assert (pipe (io) == 0);
+  tnc.setFdout (io[1]);
+  tnc.setFdin (io[0]);
+
+  // In order, without copy of the first packet
+  ids = xSend (tnc, 1, 0, 8);
+  n = ids.size();
+  for (unsigned i = 0; i < n; i++) {
+    assert (ids[i] == (int) i);
+  }
+  printf ("%u packets received in order\n", n);
+
+  // Interleaved by windows of 3 batches of 2 packets, 2 copies of the first
+  // packet, the image must span more windows than copies
+  {
+    const unsigned interleave = 3, batch = 2, repeat = 2;
+    const unsigned window = interleave * batch;
+
+    assert (n > repeat * window);
+    ids = xSend (tnc, interleave, repeat, batch);
+    assert (ids == xExpected (n, interleave, repeat, batch));
+    assert (std::count (ids.begin(), ids.end(), 0) == 1 + repeat);
+
+    // Consecutive packets of the first window are one batch apart
+    for (unsigned i = 0; i + 1 < window; i++) {
+
+      if ( (i + 1) % interleave) {
+        unsigned a = std::find (ids.begin(), ids.end(), i) - ids.begin();
+        unsigned b = std::find (ids.begin(), ids.end(), i + 1) - ids.begin();
+
+        assert (b - a == batch);
+      }
+    }
+    for (unsigned i = 0; i < ids.size(); i++) {
+      printf ("%d%c", ids[i], (i + 1 < ids.size()) ? ' ' : '\n');
+    }
+    printf ("%zu packets received interleaved, %u copies of the first\n",
+            ids.size(), repeat);
+  }
+
+  close (io[1]);
+  close (io[0]);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
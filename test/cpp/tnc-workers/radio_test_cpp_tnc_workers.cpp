@@ -0,0 +1,87 @@
+/**
+ * @file test_tnc_workers_cpp.cpp
+ * @brief TNC SSDV workers test
+ *
+ * APRS messages interleaved with SSDV-length messages are sent in a pipe,
+ * they must be received in the order they were sent while the SSDV-length
+ * messages are checked by the workers. A message ready must be delivered
+ * without reading the input again.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <radio/tnc.hpp>
+#include <radio/aprs.h>
+
+/* constants ================================================================ */
+#define TNC_BUFFER_SIZE 256
+#define MESSAGES 32
+#define APRS_MSG "@092345z4903.50N/07201.75W>Test %05d"
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  Tnc tnc (TNC_BUFFER_SIZE);
+  uint8_t block[TNC_BUFFER_SIZE];
+  char msg[64];
+  int io[2], count = 0, idle = 0;
+
+  assert (pipe (io) == 0);
+  tnc.setFdout (io[1]);
+  tnc.setFdin (io[0]);
+  assert (tnc.setSsdvWorkers (4, 8) == Tnc::SUCCESS);
+
+  memset (block, 0xAA, sizeof (block));
+
+  // A message queued behind a message being checked is delivered while the
+  // pipe stays open, without waiting for another message
+  alarm (5);
+  snprintf (msg, sizeof (msg), APRS_MSG, 99999);
+  assert (tnc.write (block, sizeof (block)) > 0);
+  assert (tnc.write (msg) > 0);
+  for (int i = 0; (i < 4) && (count == 0); i++) {
+
+    count = (tnc.poll() == Tnc::APRS_PACKET);
+  }
+  assert ( (count == 1) && (strcmp (tnc.read(), msg) == 0));
+  alarm (0);
+  count = 0;
+
+  for (int i = 0; i < MESSAGES; i++) {
+
+    snprintf (msg, sizeof (msg), APRS_MSG, i);
+    assert (tnc.write (msg) > 0);
+    // Not a valid SSDV packet, checked by a worker and dropped
+    assert (tnc.write (block, sizeof (block)) > 0);
+  }
+  // End of file for the reader, all messages are in the pipe
+  close (io[1]);
+
+  while ( (count < MESSAGES) && (idle < 1000000)) {
+
+    if (tnc.poll() == Tnc::APRS_PACKET) {
+
+      snprintf (msg, sizeof (msg), APRS_MSG, count);
+      printf ("%s\n", tnc.read());
+      assert (strcmp (tnc.read(), msg) == 0);
+      assert (tnc.getAprs() && (tnc.getAprs()->type == APRS_POSITION));
+      count++;
+      idle = 0;
+    }
+    else {
+      idle++;
+    }
+  }
+  assert (count == MESSAGES);
+  assert (tnc.setSsdvWorkers (0) == Tnc::SUCCESS);
+
+  printf ("%d messages received in order\nSuccess ! Have a nice day !\n", count);
+  return 0;
+}
+/* ========================================================================== */
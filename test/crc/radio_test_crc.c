@@ -23,6 +23,31 @@ main (void) {
   usCrc = usCrcCcitt (CRC_CCITT_INIT_VAL, TEST_STR, strlen (TEST_STR));
   printf ("Calculated result: 0x%04X\n", usCrc);
   assert (usCrc == TEST_CRC);
+
+  printf ("Test CRC CCITT combine\n");
+  for (size_t i = 0; i <= strlen (TEST_STR); i++) {
+    uint16_t usCrc1 = usCrcCcitt (CRC_CCITT_INIT_VAL, TEST_STR, i);
+    uint16_t usCrc2 = usCrcCcitt (CRC_CCITT_INIT_VAL, TEST_STR + i, strlen (TEST_STR) - i);
+
+    assert (usCrcCcittCombine (usCrc1, usCrc2, strlen (TEST_STR) - i) == TEST_CRC);
+  }
+
+  printf ("Test CRC CCITT patch\n");
+  for (size_t i = 0; i < strlen (TEST_STR) - 3; i++) {
+    char cMsg[] = TEST_STR;
+
+    memcpy (cMsg + i, "abc", 3);
+    usCrc = usCrcCcittPatch (TEST_CRC, strlen (TEST_STR), i, TEST_STR + i, "abc", 3);
+    assert (usCrc == usCrcCcitt (CRC_CCITT_INIT_VAL, cMsg, strlen (cMsg)));
+  }
+
+  printf ("Test CRC CCITT shift\n");
+  {
+    static uint8_t ucZero[70000];
+
+    usCrc = usCrcCcitt (TEST_CRC, ucZero, sizeof (ucZero));
+    assert (usCrcCcittShift (TEST_CRC, sizeof (ucZero)) == usCrc);
+  }
   printf ("Success ! Have a nice day !\n");
 
   return 0;
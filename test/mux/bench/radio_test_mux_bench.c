@@ -0,0 +1,247 @@
+/**
+ * @file test_mux_bench.c
+ * @brief Multiplexer test and benchmark, io_uring versus epoll
+ *
+ * Each port is a pipe looped back on itself: the frames queued with iMuxSend()
+ * are received by the same port. A window of frames is kept in flight on each
+ * port, a new frame being queued by the handler each time one is received.
+ * The even ports are AX25 ports, the odd ones TNC ports. For each backend,
+ * the order and the content of the frames are checked, then the throughput,
+ * the CPU time and the number of system calls per frame are displayed.
+ *
+ * usage: radio_test_mux_bench [ports [frames]]
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <radio/mux.h>
+#include <radio/crc.h>
+
+/* constants ================================================================ */
+#define PORTS 16
+#define FRAMES 2000
+#define WINDOW 8
+#define INFO_LEN 64
+
+/* private variables ======================================================== */
+static int iPorts = PORTS;
+static int iFrames = FRAMES;
+
+typedef struct xPort {
+  xAx25 *ax25;
+  xTnc *tnc;
+  xAx25Frame *frame;
+  int io[2];
+  int port;
+  int sent;
+  int received;
+} xPort;
+
+static xPort *xPorts;
+static unsigned long ulReceived;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static uint64_t
+ullNow (clockid_t id) {
+  struct timespec ts;
+
+  clock_gettime (id, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+// Payload of the frame seq of a port
+static void
+vPayload (uint8_t *info, int port, int seq) {
+
+  for (int i = 0; i < INFO_LEN; i++) {
+
+    info[i] = port + seq + i;
+  }
+  memcpy (info, &seq, sizeof (seq));
+}
+
+// -----------------------------------------------------------------------------
+static void
+vSend (xMux *mux, xPort *p) {
+  uint8_t info[INFO_LEN];
+
+  vPayload (info, p->port, p->sent);
+  if (p->ax25) {
+    static const uint8_t hdr[] = {
+      'A' << 1, 'P' << 1, 'R' << 1, 'S' << 1, ' ' << 1, ' ' << 1, 0x60,
+      'F' << 1, '4' << 1, 'A' << 1, 'B' << 1, 'C' << 1, ' ' << 1, 0x61,
+      AX25_CTRL_UI, AX25_PID_NOLAYER3
+    };
+    uint8_t raw[sizeof (hdr) + INFO_LEN + 2];
+    uint16_t fcs;
+
+    memcpy (raw, hdr, sizeof (hdr));
+    memcpy (&raw[sizeof (hdr)], info, INFO_LEN);
+    fcs = usCrcCcitt (CRC_CCITT_INIT_VAL, raw, sizeof (raw) - 2) ^ 0xFFFF;
+    raw[sizeof (raw) - 2] = fcs & 0xFF;
+    raw[sizeof (raw) - 1] = fcs >> 8;
+    assert (iMuxSend (mux, p->port, raw, sizeof (raw)) == AX25_SUCCESS);
+  }
+  else {
+
+    assert (iMuxSend (mux, p->port, info, INFO_LEN) == AX25_SUCCESS);
+  }
+  p->sent++;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vHandler (xMux *mux, int port, void *udata) {
+  xPort *p = (xPort *) udata;
+  uint8_t info[INFO_LEN];
+
+  assert (p->port == port);
+  vPayload (info, port, p->received);
+  if (p->ax25) {
+
+    assert (iAx25Read (p->ax25, p->frame) == AX25_SUCCESS);
+    assert ( (p->frame->info_len == INFO_LEN) &&
+             (memcmp (p->frame->info, info, INFO_LEN) == 0));
+  }
+  else {
+
+    assert ( (p->tnc->len == INFO_LEN) && (memcmp (p->tnc->rxbuf, info, INFO_LEN) == 0));
+  }
+  p->received++;
+  ulReceived++;
+  if (p->sent < iFrames) {
+
+    vSend (mux, p);
+  }
+}
+
+// -----------------------------------------------------------------------------
+static void
+vRun (int backend) {
+  struct rusage r0, r1;
+  uint64_t t0, t1;
+  double cpu;
+  unsigned long total = (unsigned long) iPorts * iFrames;
+  xMux *mux;
+
+  mux = xMuxNew (backend, 0);
+  if (!mux) {
+
+    printf ("%s not available\n", backend == AX25_MUX_URING ? "io_uring" : "epoll");
+    assert (backend == AX25_MUX_URING);
+    return;
+  }
+  printf ("%s: %d ports, %d frames per port\n",
+          mux->backend == AX25_MUX_URING ? "io_uring" : "epoll", iPorts, iFrames);
+
+  ulReceived = 0;
+  for (int i = 0; i < iPorts; i++) {
+    xPort *p = &xPorts[i];
+
+    memset (p, 0, sizeof (xPort));
+    assert (pipe (p->io) == 0);
+    if (i & 1) {
+
+      p->tnc = xTncNew (INFO_LEN);
+      assert (p->tnc);
+      iTncSetFdin (p->tnc, p->io[0]);
+      iTncSetFdout (p->tnc, p->io[1]);
+      p->port = iMuxAddTnc (mux, p->tnc, vHandler, p);
+    }
+    else {
+
+      p->ax25 = xAx25New();
+      p->frame = xAx25FrameNew();
+      assert (p->ax25 && p->frame);
+      iAx25SetFdin (p->ax25, p->io[0]);
+      iAx25SetFdout (p->ax25, p->io[1]);
+      p->port = iMuxAddAx25 (mux, p->ax25, vHandler, p);
+    }
+    assert (p->port == i);
+  }
+
+  getrusage (RUSAGE_SELF, &r0);
+  t0 = ullNow (CLOCK_MONOTONIC);
+  for (int i = 0; i < iPorts; i++) {
+
+    for (int j = 0; (j < WINDOW) && (j < iFrames); j++) {
+
+      vSend (mux, &xPorts[i]);
+    }
+  }
+  while (ulReceived < total) {
+
+    assert (iMuxPoll (mux, 1000) > 0);
+  }
+  t1 = ullNow (CLOCK_MONOTONIC);
+  getrusage (RUSAGE_SELF, &r1);
+
+  cpu = (r1.ru_utime.tv_sec - r0.ru_utime.tv_sec) + (r1.ru_stime.tv_sec - r0.ru_stime.tv_sec) +
+        ( (r1.ru_utime.tv_usec - r0.ru_utime.tv_usec) +
+          (r1.ru_stime.tv_usec - r0.ru_stime.tv_usec)) / 1e6;
+  printf ("  %lu frames in %.3f s, %.0f frames/s, cpu %.3f s, %.2f syscalls/frame\n",
+          total, (t1 - t0) / 1e9, total / ( (t1 - t0) / 1e9), cpu,
+          (double) mux->syscalls / total);
+  assert ( (mux->frames == total) && (mux->errors == 0));
+
+  // The ports are closed when the end of file is read
+  for (int i = 0; i < iPorts; i++) {
+
+    assert (iMuxPending (mux, i) == 0);
+    close (xPorts[i].io[1]);
+  }
+  while (iMuxOpenPorts (mux) > 0) {
+
+    assert (iMuxPoll (mux, 1000) == 0);
+  }
+
+  vMuxDelete (mux);
+  for (int i = 0; i < iPorts; i++) {
+    xPort *p = &xPorts[i];
+
+    close (p->io[0]);
+    if (p->ax25) {
+
+      vAx25FrameDelete (p->frame);
+      vAx25Delete (p->ax25);
+    }
+    else {
+
+      vTncDelete (p->tnc);
+    }
+  }
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+
+  if (argc > 1) {
+    iPorts = atoi (argv[1]);
+  }
+  if (argc > 2) {
+    iFrames = atoi (argv[2]);
+  }
+  assert ( (iPorts > 0) && (iFrames > 0));
+  xPorts = calloc (iPorts, sizeof (xPort));
+  assert (xPorts);
+
+  vRun (AX25_MUX_EPOLL);
+  vRun (AX25_MUX_URING);
+
+  free (xPorts);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
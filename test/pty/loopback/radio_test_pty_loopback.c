@@ -0,0 +1,310 @@
+/**
+ * @file test_pty_loopback.c
+ * @brief Serial loopback test and benchmark on pseudo-terminals
+ *
+ * Two pty pairs replace a serial link: the transmitter writes on the first
+ * slave, a modem thread reads the first master and writes the bytes on the
+ * second master at the simulated baud rate, the receiver reads the second
+ * slave. The slaves are configured as serial ports (raw mode, VMIN/VTIME),
+ * so that the whole tty path of the AX25 and TNC transports is exercised
+ * without any device.
+ * For each transport, the latency is measured by sending the frames one at
+ * a time, then the throughput by sending them back to back.
+ *
+ * usage: radio_test_pty_loopback [baudrate [frames]]
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <termios.h>
+#include <pty.h>
+#include <time.h>
+
+#include <radio/ax25.h>
+#include <radio/tnc.h>
+
+/* constants ================================================================ */
+#define BAUDRATE 115200
+#define FRAMES 200
+#define PINGS 20
+
+// Bits per byte on the line (start, 8 data, stop)
+#define BITS_PER_BYTE 10
+
+// VTIME of the receiver, in 1/10 s
+#define RX_VTIME 1
+
+// The receiver gives up after this idle time once the transmitter is done
+#define RX_IDLE_NS 1000000000ULL
+
+#define APRS_MSG ">Test %05d: SolarPi (\x7E\x1B\x7F) APRS http://www.btssn.net"
+#define TNC_MSG_LEN 64
+
+/* private variables ======================================================== */
+static int iBaudrate = BAUDRATE;
+static int iFrames = FRAMES;
+
+// Link
+static int iTxMaster, iTxSlave, iRxMaster, iRxSlave;
+static unsigned long ulLineBytes;
+
+// Transport under test
+static bool bTnc;
+static xAx25 *xTx, *xRx;
+static xAx25Frame *xTxFrame, *xRxFrame;
+static xTnc *xTncTx, *xTncRx;
+
+// Time at which each frame was sent, 0 if not sent
+static uint64_t *ullSent;
+static volatile bool bTxDone;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static uint64_t
+ullNow (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vSleepUntil (uint64_t t) {
+  uint64_t now = ullNow();
+
+  if (t > now) {
+    struct timespec ts = { (t - now) / 1000000000ULL, (t - now) % 1000000000ULL };
+
+    nanosleep (&ts, NULL);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Serial port settings of a slave
+static void
+vSetSerial (int fd, int vmin, int vtime) {
+  struct termios tios;
+
+  assert (tcgetattr (fd, &tios) == 0);
+  cfmakeraw (&tios);
+  cfsetspeed (&tios, B38400);
+  tios.c_cflag |= CLOCAL | CREAD;
+  tios.c_cc[VMIN] = vmin;
+  tios.c_cc[VTIME] = vtime;
+  assert (tcsetattr (fd, TCSANOW, &tios) == 0);
+}
+
+// -----------------------------------------------------------------------------
+// Carries the bytes from the transmitter to the receiver at the baud rate
+static void *
+pvModem (void *arg) {
+  uint8_t buf[256];
+  uint64_t t = 0;
+  ssize_t n;
+
+  while ( (n = read (iTxMaster, buf, sizeof (buf))) > 0) {
+    uint64_t now = ullNow();
+
+    if (t < now) {
+      // Idle line, the transmission starts now
+      t = now;
+    }
+    for (ssize_t i = 0; i < n; ) {
+      // Bytes are sent by chunks of about 1 ms
+      ssize_t len = iBaudrate / BITS_PER_BYTE / 1000 + 1;
+
+      len = (len > n - i) ? n - i : len;
+      t += len * BITS_PER_BYTE * 1000000000ULL / iBaudrate;
+      vSleepUntil (t);
+      assert (write (iRxMaster, &buf[i], len) == len);
+      ulLineBytes += len;
+      i += len;
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vSend (int seq) {
+
+  if (bTnc) {
+    uint8_t msg[TNC_MSG_LEN];
+
+    for (int i = 0; i < TNC_MSG_LEN; i++) {
+      msg[i] = seq + i;
+    }
+    memcpy (msg, &seq, sizeof (seq));
+    ullSent[seq] = ullNow();
+    assert (iTncWrite (xTncTx, msg, sizeof (msg)) == sizeof (msg));
+  }
+  else {
+    char cInfo[80];
+
+    iAx25FrameSetInfo (xTxFrame, cInfo, snprintf (cInfo, sizeof (cInfo), APRS_MSG, seq));
+    ullSent[seq] = ullNow();
+    assert (iAx25Send (xTx, xTxFrame) == AX25_SUCCESS);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Returns the sequence number of the frame received, -1 if none
+static int
+iReceive (void) {
+  int seq = -1;
+
+  if (bTnc) {
+
+    if ( (iTncPoll (xTncRx) == TNC_EOT) && (xTncRx->len == TNC_MSG_LEN)) {
+
+      memcpy (&seq, xTncRx->rxbuf, sizeof (seq));
+    }
+  }
+  else {
+
+    if (bAx25Poll (xRx)) {
+      char cInfo[80];
+
+      assert (iAx25Read (xRx, xRxFrame) == AX25_SUCCESS);
+      if (sscanf ( (const char *) xRxFrame->info, ">Test %05d", &seq) != 1) {
+        seq = -1;
+      }
+      snprintf (cInfo, sizeof (cInfo), APRS_MSG, seq);
+      assert ( (xRxFrame->info_len == strlen (cInfo)) &&
+               (memcmp (xRxFrame->info, cInfo, xRxFrame->info_len) == 0));
+    }
+  }
+  return ( (seq >= 0) && (seq < iFrames)) ? seq : -1;
+}
+
+// -----------------------------------------------------------------------------
+static void *
+pvSender (void *arg) {
+
+  for (int i = 0; i < iFrames; i++) {
+
+    vSend (i);
+  }
+  bTxDone = true;
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+static void
+vRun (bool tnc) {
+  uint64_t t0, t1, sum = 0, max = 0, idle;
+  unsigned long bytes;
+  int count = 0;
+  pthread_t sender;
+
+  bTnc = tnc;
+  memset (ullSent, 0, iFrames * sizeof (uint64_t));
+  printf ("%s transport at %d baud\n", tnc ? "TNC" : "AX25", iBaudrate);
+
+  // Latency: one frame at a time
+  for (int i = 0; i < PINGS; i++) {
+    int seq;
+    uint64_t lat;
+
+    vSend (i);
+    do {
+      seq = iReceive();
+    }
+    while ( (seq < 0) && (ullNow() - ullSent[i] < RX_IDLE_NS));
+    assert (seq == i);
+    lat = ullNow() - ullSent[i];
+    sum += lat;
+    max = (lat > max) ? lat : max;
+  }
+  printf ("  latency    : avg %.2f ms, max %.2f ms\n", sum / 1e6 / PINGS, max / 1e6);
+
+  // Throughput: frames sent back to back
+  memset (ullSent, 0, iFrames * sizeof (uint64_t));
+  bTxDone = false;
+  bytes = ulLineBytes;
+  t0 = idle = ullNow();
+  assert (pthread_create (&sender, NULL, pvSender, NULL) == 0);
+  while ( (count < iFrames) && ( (!bTxDone) || (ullNow() - idle < RX_IDLE_NS))) {
+
+    if (iReceive() >= 0) {
+
+      count++;
+      idle = ullNow();
+    }
+  }
+  t1 = ullNow();
+  pthread_join (sender, NULL);
+  bytes = ulLineBytes - bytes;
+
+  printf ("  throughput : %d/%d frames in %.3f s, %.1f frames/s, %.0f bytes/s"
+          " (%.0f%% of the line)\n", count, iFrames, (t1 - t0) / 1e9,
+          count / ( (t1 - t0) / 1e9), bytes / ( (t1 - t0) / 1e9),
+          100.0 * bytes * BITS_PER_BYTE / iBaudrate / ( (t1 - t0) / 1e9));
+  assert (count == iFrames);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  pthread_t modem;
+
+  if (argc > 1) {
+    iBaudrate = atoi (argv[1]);
+  }
+  if (argc > 2) {
+    iFrames = atoi (argv[2]);
+  }
+  assert ( (iBaudrate > 0) && (iFrames >= PINGS));
+  ullSent = calloc (iFrames, sizeof (uint64_t));
+  assert (ullSent);
+
+  assert (openpty (&iTxMaster, &iTxSlave, NULL, NULL, NULL) == 0);
+  assert (openpty (&iRxMaster, &iRxSlave, NULL, NULL, NULL) == 0);
+  vSetSerial (iTxSlave, 1, 0);
+  vSetSerial (iRxSlave, 0, RX_VTIME);
+  assert (pthread_create (&modem, NULL, pvModem, NULL) == 0);
+
+  xTx = xAx25New();
+  xRx = xAx25New();
+  xTxFrame = xAx25FrameNew();
+  xRxFrame = xAx25FrameNew();
+  xTncTx = xTncNew (TNC_MSG_LEN);
+  xTncRx = xTncNew (TNC_MSG_LEN);
+  assert (xTx && xRx && xTxFrame && xRxFrame && xTncTx && xTncRx);
+  iAx25SetFdout (xTx, iTxSlave);
+  iAx25SetFdin (xRx, iRxSlave);
+  iTncSetFdout (xTncTx, iTxSlave);
+  iTncSetFdin (xTncRx, iRxSlave);
+
+  iAx25FrameSetDst (xTxFrame, "APRS", 0);
+  iAx25FrameSetSrc (xTxFrame, "F4ABC", 15);
+  iAx25FrameAddRepeater (xTxFrame, "WIDE1", 1);
+
+  vRun (false);
+  vRun (true);
+
+  close (iTxSlave);
+  close (iTxMaster);
+  pthread_join (modem, NULL);
+  close (iRxSlave);
+  close (iRxMaster);
+  vAx25FrameDelete (xTxFrame);
+  vAx25FrameDelete (xRxFrame);
+  vAx25Delete (xTx);
+  vAx25Delete (xRx);
+  vTncDelete (xTncTx);
+  vTncDelete (xTncRx);
+  free (ullSent);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,218 @@
+/**
+ * @file test_tnc_decoder.c
+ * @brief TNC decoder and encoder test
+ *
+ * Messages are encoded by pieces of a few bytes with xTncEncoder: the size
+ * known up front and the bytes must be the same as the ones of the protocol,
+ * and as the ones sent by iTncWrite(). The messages are then decoded with
+ * xTncDecoder from spans of random lengths. A message with a CRC error must
+ * be reported and a message longer than the buffer dropped, without stopping
+ * the decoding. The characters of the text which are not digits are ignored
+ * and lowercase digits are decoded.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <ctype.h>
+
+#include <radio/tnc.h>
+#include <radio/crc.h>
+
+/* constants ================================================================ */
+#define MSGS 100
+#define MSG_MAX 300
+#define PIECE 5
+#define SSDV 256
+
+/* private variables ======================================================== */
+static uint8_t ucStream[MSGS * TNC_MSG_SIZE (MSG_MAX)];
+static size_t uStreamLen;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// Length and contents of the message i
+static size_t
+uMsg (uint8_t *msg, int i) {
+  size_t len = (i * 37) % MSG_MAX;
+
+  for (size_t j = 0; j < len; j++) {
+
+    msg[j] = i + j * 13;
+  }
+  return len;
+}
+
+// -----------------------------------------------------------------------------
+// Encoding of the protocol, character by character
+static size_t
+uRef (uint8_t *out, const uint8_t *msg, size_t len) {
+  uint16_t crc = CRC_CCITT_INIT_VAL;
+  size_t n = 0;
+  char hex[5];
+
+  out[n++] = TNC_SOH;
+  out[n++] = TNC_STX;
+  for (size_t j = 0; j < len; j++) {
+
+    sprintf (hex, "%02X", msg[j]);
+    crc = usCrcCcittUpdate (hex[0], crc);
+    crc = usCrcCcittUpdate (hex[1], crc);
+    out[n++] = hex[0];
+    out[n++] = hex[1];
+  }
+  out[n++] = TNC_ETX;
+  sprintf (hex, "%04X", crc);
+  memcpy (&out[n], hex, 4);
+  n += 4;
+  out[n++] = TNC_EOT;
+  return n;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2];
+  uint8_t msg[MSG_MAX], ref[TNC_MSG_SIZE (MSG_MAX)], buf[sizeof (ref)];
+  xTnc *xTnc = xTncNew (MSG_MAX);
+  xTncEncoder *e = xTncEncoderNew();
+  xTncDecoder *d = xTncDecoderNew (MSG_MAX);
+  size_t pos, len, got;
+  int n, ret;
+
+  assert (xTnc && e && d);
+  assert (pipe (io) == 0);
+  iTncSetFdout (xTnc, io[1]);
+
+  // Encoding by pieces
+  for (int i = 0; i < MSGS; i++) {
+    size_t size, reflen;
+
+    len = uMsg (msg, i);
+    reflen = uRef (ref, msg, len);
+    assert (iTncEncoderSetMsg (e, msg, len) == TNC_SUCCESS);
+    size = uTncEncoderSize (e);
+    assert ( (size == TNC_MSG_SIZE (len)) && (size == reflen));
+
+    len = 0;
+    while ( (got = uTncEncoderRead (e, &ucStream[uStreamLen + len], PIECE)) > 0) {
+
+      assert ( (got == PIECE) || (uTncEncoderSize (e) == 0));
+      len += got;
+    }
+    assert ( (len == size) && (memcmp (&ucStream[uStreamLen], ref, len) == 0));
+    assert ( (uTncEncode (buf, msg, uMsg (msg, i)) == len) && (memcmp (buf, ref, len) == 0));
+    uStreamLen += len;
+  }
+  printf ("%d messages encoded, %zu bytes\n", MSGS, uStreamLen);
+
+  // The longest message is written by pieces by iTncWrite()
+  len = uRef (ref, msg, MSG_MAX);
+  assert (iTncWrite (xTnc, msg, MSG_MAX) == MSG_MAX);
+  for (pos = 0; pos < len; pos += got) {
+    ssize_t r = read (io[0], &buf[pos], sizeof (buf) - pos);
+
+    assert (r > 0);
+    got = r;
+  }
+  printf ("iTncWrite: %zu bytes\n", pos);
+  assert ( (pos == len) && (memcmp (buf, ref, len) == 0));
+
+  // Decoding by spans of random lengths
+  pos = 0;
+  n = 0;
+  while (pos < uStreamLen) {
+    size_t used;
+
+    len = 1 + rand() % 64;
+    if (len > uStreamLen - pos) {
+      len = uStreamLen - pos;
+    }
+    ret = iTncDecoderFeed (d, &ucStream[pos], len, &used);
+    assert (ret >= 0);
+    if (ret == TNC_EOT) {
+
+      len = uMsg (msg, n++);
+      assert ( (d->len == len) && (memcmp (d->buf, msg, len) == 0));
+    }
+    pos += used;
+  }
+  printf ("%d messages decoded by spans\n", n);
+  assert (n == MSGS);
+
+  // A message with a CRC error, then a message too long for the buffer
+  len = uTncEncode (ucStream, msg, 4);
+  ucStream[len - 2] ^= 0x01;
+  len += uTncEncode (&ucStream[len], msg, MSG_MAX - 1);
+  {
+    xTncDecoder *small = xTncDecoderNew (8);
+
+    assert (small);
+    len += uTncEncode (&ucStream[len], msg, 8);
+    for (pos = 0, n = 0; pos < len; pos += got) {
+
+      ret = iTncDecoderFeed (small, &ucStream[pos], len - pos, &got);
+      if (ret == TNC_CRC_ERROR) {
+
+        assert (n == 0);
+        n++;
+      }
+      else if (ret == TNC_EOT) {
+
+        assert ( (n == 1) && (small->len == 8) && (memcmp (small->buf, msg, 8) == 0));
+        n++;
+      }
+    }
+    printf ("Errors: %d messages reported\n", n);
+    assert (n == 2);
+    vTncDecoderDelete (small);
+  }
+
+  // Line breaks in the text of a SSDV packet, then lowercase digits
+  for (int i = 0; i < SSDV; i++) {
+
+    msg[i] = i * 7;
+  }
+  len = uTncEncode (ref, msg, SSDV);
+  for (pos = 0, uStreamLen = 0; pos < len; pos++) {
+
+    ucStream[uStreamLen++] = ref[pos];
+    if ( (pos > 2) && (pos < TNC_MSG_SIZE (SSDV) - 6) && ( (pos % 37) == 0)) {
+
+      ucStream[uStreamLen++] = '\n';
+    }
+  }
+  for (pos = 2; pos < len - 6; pos++) {
+
+    ref[pos] = tolower (ref[pos]);
+  }
+  memcpy (&ucStream[uStreamLen], ref, len);
+  uStreamLen += len;
+  for (pos = 0, n = 0; pos < uStreamLen; pos += got) {
+
+    ret = iTncDecoderFeed (d, &ucStream[pos], uStreamLen - pos, &got);
+    if ( (ret == TNC_EOT) || (ret == TNC_CRC_ERROR)) {
+
+      // The CRC is computed on the characters received
+      assert (ret == (n == 0 ? TNC_EOT : TNC_CRC_ERROR));
+      assert ( (d->len == SSDV) && (memcmp (d->buf, msg, SSDV) == 0));
+      n++;
+    }
+  }
+  printf ("Text with line breaks and lowercase digits: %d messages\n", n);
+  assert (n == 2);
+
+  vTncDecoderDelete (d);
+  vTncEncoderDelete (e);
+  vTncDelete (xTnc);
+  close (io[0]);
+  close (io[1]);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
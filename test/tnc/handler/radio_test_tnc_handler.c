@@ -0,0 +1,83 @@
+/**
+ * @file test_tnc_handler.c
+ * @brief TNC receive handler test
+ *
+ * A receive handler is set with iTncSetRxHandler(): all the messages written
+ * in a pipe must be given to the handler, in order, by a single call to
+ * iTncPollTimeout(), then by a single call to iTncFeed(). A message with a
+ * CRC error must be dropped without stopping the decoding.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <radio/tnc.h>
+
+/* constants ================================================================ */
+#define MSGS 100
+#define TIMEOUT 50
+#define MSG ">Test handler %03d"
+
+/* private variables ======================================================== */
+static int iReceived;
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static void
+vHandler (xTnc *tnc, const uint8_t *msg, size_t len, void *ctx) {
+  char str[32];
+
+  assert (ctx == &iReceived);
+  // The corrupted message is the second one
+  snprintf (str, sizeof (str), MSG, iReceived < 1 ? iReceived : iReceived + 1);
+  assert ( (len == strlen (str)) && (memcmp (msg, str, len) == 0));
+  iReceived++;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2];
+  static uint8_t buf[MSGS * TNC_MSG_SIZE (32)];
+  size_t len = 0, used;
+  xTnc *xTnc;
+
+  assert (pipe (io) == 0);
+  xTnc = xTncNew (32);
+  assert (xTnc);
+  iTncSetFdin (xTnc, io[0]);
+  for (int i = 0; i < MSGS; i++) {
+    char str[32];
+
+    len += uTncEncode (&buf[len], str, snprintf (str, sizeof (str), MSG, i));
+    if (i == 1) {
+      // First of the 4 digits of the CRC, before EOT
+      buf[len - 5] = (buf[len - 5] == '0') ? '1' : '0';
+    }
+  }
+  assert (iTncSetRxHandler (xTnc, vHandler, &iReceived) == TNC_SUCCESS);
+
+  // All the messages are given to the handler by one call
+  assert (write (io[1], buf, len) == (ssize_t) len);
+  assert (iTncPollTimeout (xTnc, TIMEOUT) == TNC_EOT);
+  printf ("iTncPollTimeout: %d messages received\n", iReceived);
+  assert ( (iReceived == MSGS - 1) && (xTnc->rx_msgs == MSGS - 1));
+  assert (iTncPollTimeout (xTnc, 0) != TNC_EOT);
+
+  // Same with bytes given by the caller
+  iReceived = 0;
+  assert (iTncFeed (xTnc, buf, len, &used) == TNC_EOT);
+  printf ("iTncFeed: %d messages received\n", iReceived);
+  assert ( (iReceived == MSGS - 1) && (used == len));
+
+  vTncDelete (xTnc);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
+/* ========================================================================== */
@@ -0,0 +1,159 @@
+/**
+ * @file test_tnc_ssdv.c
+ * @brief SSDV reassembly cache test
+ *
+ * The packets of an image are fed out of order and with duplicates: the image
+ * must be partial until all the packets are received, then complete on the
+ * last missing packet. A packet whose id does not fit in the cache must be
+ * rejected. When all the slots are used, the least recently updated image is
+ * replaced and only the incomplete images are counted as evicted.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <radio/ssdvcache.h>
+
+/* constants ================================================================ */
+#define CALL "F4ABC"
+#define SLOTS 2
+#define MAX_PACKETS 8
+#define JPEG_SIZE 4096
+#define IMAGE_PACKETS 4
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+// Base 40 callsign used in the SSDV header
+static uint32_t
+ulEncodeCallsign (const char *call) {
+  uint32_t code = 0;
+
+  for (int i = strlen (call) - 1; i >= 0; i--) {
+    char c = call[i];
+
+    code *= 40;
+    if ( (c >= '0') && (c <= '9')) {
+      code += c - '0' + 1;
+    }
+    else if ( (c >= 'A') && (c <= 'Z')) {
+      code += c - 'A' + 14;
+    }
+  }
+  return code;
+}
+
+// -----------------------------------------------------------------------------
+// Packet of an image of IMAGE_PACKETS MCUs, one MCU per packet
+static void
+vPacket (uint8_t *pkt, uint32_t callsign, uint8_t image_id, uint16_t packet_id) {
+
+  memset (pkt, 0, SSDV_PKT_SIZE);
+  pkt[0] = 0x55;
+  pkt[1] = 0x66;
+  pkt[2] = callsign >> 24;
+  pkt[3] = callsign >> 16;
+  pkt[4] = callsign >> 8;
+  pkt[5] = callsign;
+  pkt[6] = image_id;
+  pkt[7] = packet_id >> 8;
+  pkt[8] = packet_id;
+  pkt[9] = IMAGE_PACKETS;   // width / 16
+  pkt[10] = 1;              // height / 16
+  pkt[11] = (packet_id == IMAGE_PACKETS - 1) ? 0x04 : 0; // EOI
+  pkt[12] = 0;              // MCU offset
+  pkt[13] = packet_id >> 8; // MCU index
+  pkt[14] = packet_id;
+}
+
+// -----------------------------------------------------------------------------
+static int
+iFeed (xSsdvCache *c, uint32_t callsign, uint8_t image_id, uint16_t packet_id) {
+  uint8_t pkt[SSDV_PKT_SIZE];
+
+  vPacket (pkt, callsign, image_id, packet_id);
+  return iSsdvCacheFeed (c, pkt);
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  static uint8_t jpeg[JPEG_SIZE];
+  uint32_t callsign = ulEncodeCallsign (CALL);
+  const xSsdvSlot *s;
+  xSsdvCache *c;
+  unsigned long tick;
+  size_t len;
+
+  c = xSsdvCacheNew (SLOTS, MAX_PACKETS, JPEG_SIZE);
+  assert (c);
+
+  // Packets out of order and duplicates, the image stays partial
+  assert (iFeed (c, callsign, 1, 2) == 0);
+  assert (iFeed (c, callsign, 1, 0) == 0);
+  assert (iFeed (c, callsign, 1, 2) == 0);
+  assert (iFeed (c, callsign, 1, 3) == 0);
+  assert (iFeed (c, callsign, 1, 0) == 0);
+  s = xSsdvCacheFind (c, callsign, 1);
+  assert (s && (strcmp (s->call, CALL) == 0));
+  assert ( (s->received == 3) && (s->last_id == IMAGE_PACKETS - 1) && (s->next_id == 1));
+  assert (!s->complete);
+  len = 0;
+  assert (iSsdvCacheGetImage (c, callsign, 1, jpeg, sizeof (jpeg), &len) == 0);
+  assert (len > 0);
+  printf ("Partial image: %zu bytes from %u packets\n", len, s->received);
+
+  // The last missing packet completes the image, the EOI packet was received
+  assert (iFeed (c, callsign, 1, 1) == 1);
+  assert (s->complete && (s->received == IMAGE_PACKETS) && (s->next_id == IMAGE_PACKETS));
+  assert (iSsdvCacheGetImage (c, callsign, 1, jpeg, sizeof (jpeg), &len) == 1);
+  assert ( (len == s->jpeg_len) && (memcmp (jpeg, s->jpeg, len) == 0));
+  assert (iSsdvCacheGetImage (c, callsign, 1, jpeg, len - 1, &len) == TNC_NOT_ENOUGH_MEMORY);
+  printf ("Complete image: %zu bytes\n", s->jpeg_len);
+
+  // The EOI packet received first, the image is complete on the last packet
+  for (uint16_t id = IMAGE_PACKETS; id > 1; id--) {
+
+    assert (iFeed (c, callsign, 2, id - 1) == 0);
+  }
+  assert (iFeed (c, callsign, 2, 0) == 1);
+  assert (xSsdvCacheFind (c, callsign, 2)->complete);
+
+  // Packet id out of the cache, no slot used
+  tick = c->tick;
+  assert (iFeed (c, callsign, 3, MAX_PACKETS) == TNC_NOT_ENOUGH_MEMORY);
+  assert (iFeed (c, callsign, 3, 0xFFFF) == TNC_NOT_ENOUGH_MEMORY);
+  assert ( (c->tick == tick) && (!xSsdvCacheFind (c, callsign, 3)));
+  assert (xSsdvCacheFind (c, callsign, 1) && xSsdvCacheFind (c, callsign, 2));
+  printf ("Packet %u rejected\n", MAX_PACKETS);
+
+  // LRU eviction, the complete images are not counted
+  assert (c->evicted == 0);
+  assert (iFeed (c, callsign, 3, 0) == 0);
+  assert ( (c->evicted == 0) && (!xSsdvCacheFind (c, callsign, 1)));
+  assert (iFeed (c, callsign, 4, 0) == 0);
+  assert ( (c->evicted == 0) && (!xSsdvCacheFind (c, callsign, 2)));
+  assert (iFeed (c, callsign, 3, 1) == 0);
+  assert (iFeed (c, callsign, 5, 0) == 0);
+  assert ( (c->evicted == 1) && (!xSsdvCacheFind (c, callsign, 4)));
+  assert (xSsdvCacheFind (c, callsign, 3)->received == 2);
+  assert (iFeed (c, callsign, 6, 0) == 0);
+  assert ( (c->evicted == 2) && (!xSsdvCacheFind (c, callsign, 3)));
+  assert (xSsdvCacheFind (c, callsign, 5) && xSsdvCacheFind (c, callsign, 6));
+  assert (iSsdvCacheGetImage (c, callsign, 3, jpeg, sizeof (jpeg), &len) == TNC_OBJECT_NOT_FOUND);
+  printf ("%lu images evicted\n", c->evicted);
+
+  // A released slot is used before any eviction
+  assert (iSsdvCacheRelease (c, callsign, 5) == TNC_SUCCESS);
+  assert (iSsdvCacheRelease (c, callsign, 5) == TNC_OBJECT_NOT_FOUND);
+  assert (iFeed (c, callsign, 7, 0) == 0);
+  assert ( (c->evicted == 2) && xSsdvCacheFind (c, callsign, 6));
+
+  vSsdvCacheDelete (c);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}
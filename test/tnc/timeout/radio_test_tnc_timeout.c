@@ -0,0 +1,103 @@
+/**
+ * @file test_tnc_timeout.c
+ * @brief TNC receive with deadline test
+ *
+ * iTncPollTimeout() is used on a blocking pipe: it must return on timeout
+ * when nothing is received or when only a part of a message is received,
+ * and return TNC_EOT as soon as a message is complete. A message with a bad
+ * CRC must be reported by iTncPoll() and iTncPollTimeout() without waiting
+ * for more data.
+ *
+ * Copyright © 2015 epsilonRT, All rights reserved.
+ * This software is governed by the CeCILL license <http://www.cecill.info>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <radio/tnc.h>
+
+/* constants ================================================================ */
+#define TIMEOUT 50
+#define MSG ">Test timeout"
+
+/* private functions ======================================================== */
+
+// -----------------------------------------------------------------------------
+static long
+lNowMs (void) {
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* internal public functions ================================================ */
+int
+main (int argc, char **argv) {
+  int io[2];
+  uint8_t buf[TNC_MSG_SIZE (sizeof (MSG))], bad[TNC_MSG_SIZE (sizeof (MSG))];
+  size_t len;
+  long t;
+  xTnc *xTnc;
+
+  assert (pipe (io) == 0);
+  xTnc = xTncNew (sizeof (MSG));
+  assert (xTnc);
+  iTncSetFdin (xTnc, io[0]);
+  len = uTncEncode (buf, MSG, strlen (MSG));
+
+  // Nothing received
+  t = lNowMs();
+  assert (iTncPollTimeout (xTnc, TIMEOUT) != TNC_EOT);
+  t = lNowMs() - t;
+  printf ("No data: timeout after %ld ms\n", t);
+  assert ( (t >= TIMEOUT - 1) && (t < TIMEOUT * 4));
+
+  // Part of a message received
+  assert (write (io[1], buf, len / 2) == len / 2);
+  t = lNowMs();
+  assert (iTncPollTimeout (xTnc, TIMEOUT) != TNC_EOT);
+  t = lNowMs() - t;
+  printf ("Partial message: timeout after %ld ms\n", t);
+  assert ( (t >= TIMEOUT - 1) && (t < TIMEOUT * 4));
+
+  // End of the message received
+  assert (write (io[1], &buf[len / 2], len - len / 2) == len - len / 2);
+  t = lNowMs();
+  assert (iTncPollTimeout (xTnc, TIMEOUT) == TNC_EOT);
+  t = lNowMs() - t;
+  printf ("Complete message: received after %ld ms\n", t);
+  assert (t < TIMEOUT);
+  assert ( (xTnc->len == strlen (MSG)) && (memcmp (xTnc->rxbuf, MSG, xTnc->len) == 0));
+
+  // Two messages written at once are both received
+  assert (write (io[1], buf, len) == len);
+  assert (write (io[1], buf, len) == len);
+  assert (iTncPollTimeout (xTnc, TIMEOUT) == TNC_EOT);
+  assert (iTncPollTimeout (xTnc, 0) == TNC_EOT);
+  assert (iTncPollTimeout (xTnc, 0) != TNC_EOT);
+
+  // A message with a bad CRC followed by a good one, the pipe stays open: the
+  // error must be returned at once, then the good message
+  memcpy (bad, buf, len);
+  bad[len - 2] = (bad[len - 2] == '0') ? '1' : '0';
+  assert (write (io[1], bad, len) == len);
+  assert (write (io[1], buf, len) == len);
+  assert (iTncPoll (xTnc) == TNC_CRC_ERROR);
+  assert (iTncPoll (xTnc) == TNC_EOT);
+  assert ( (xTnc->len == strlen (MSG)) && (memcmp (xTnc->rxbuf, MSG, xTnc->len) == 0));
+  assert (write (io[1], bad, len) == len);
+  assert (write (io[1], buf, len) == len);
+  assert (iTncPollTimeout (xTnc, TIMEOUT) == TNC_CRC_ERROR);
+  assert (iTncPollTimeout (xTnc, 0) == TNC_EOT);
+  assert (iTncPollTimeout (xTnc, 0) != TNC_EOT);
+  printf ("CRC error returned\n");
+
+  vTncDelete (xTnc);
+  printf ("Success ! Have a nice day !\n");
+  return 0;
+}